@@ -108,24 +108,35 @@ void btConvexTriangleCallback::processTriangle(btVector3* triangle,int partId, i
 		btTriangleShape tm(triangle[0],triangle[1],triangle[2]);	
 		tm.setMargin(m_collisionMarginTriangle);
 		
-		btCollisionShape* tmpShape = ob->getCollisionShape();
-		ob->internalSetTemporaryCollisionShape( &tm );
-
-		btCollisionAlgorithm* colAlgo = ci.m_dispatcher1->findAlgorithm(m_convexBody,m_triBody,m_manifoldPtr);
-
-		if (m_resultOut->getBody0Internal() == m_triBody)
+		// STK: do not temporarily replace the shape of the concave object
+		// (usually the track, which is part of many collision pairs), use
+		// a copy of it instead. This allows supertuxkart to process
+		// collision pairs in parallel threads.
+		btCollisionObject triObCopy(*ob);
+		triObCopy.internalSetTemporaryCollisionShape( &tm );
+
+		btCollisionAlgorithm* colAlgo = ci.m_dispatcher1->findAlgorithm(m_convexBody,&triObCopy,m_manifoldPtr);
+
+		// STK: btGjkPairDetector looks up the triangle shape through the
+		// bodies of the manifold result, so let the result refer to the
+		// copy while this triangle is processed.
+		btCollisionObject* resultBody0 = m_resultOut->getBody0Internal();
+		btCollisionObject* resultBody1 = m_resultOut->getBody1Internal();
+		if (resultBody0 == m_triBody)
 		{
 			m_resultOut->setShapeIdentifiersA(partId,triangleIndex);
+			m_resultOut->setBodiesInternal(&triObCopy,resultBody1);
 		}
 		else
 		{
 			m_resultOut->setShapeIdentifiersB(partId,triangleIndex);
+			m_resultOut->setBodiesInternal(resultBody0,&triObCopy);
 		}
 	
-		colAlgo->processCollision(m_convexBody,m_triBody,*m_dispatchInfoPtr,m_resultOut);
+		colAlgo->processCollision(m_convexBody,&triObCopy,*m_dispatchInfoPtr,m_resultOut);
+		m_resultOut->setBodiesInternal(resultBody0,resultBody1);
 		colAlgo->~btCollisionAlgorithm();
 		ci.m_dispatcher1->freeCollisionAlgorithm(colAlgo);
-		ob->internalSetTemporaryCollisionShape( tmpShape);
 	}
 
 
@@ -122,6 +122,24 @@ public:
 	{
 		return m_body1;
 	}
+
+	btCollisionObject* getBody0Internal()
+	{
+		return m_body0;
+	}
+
+	btCollisionObject* getBody1Internal()
+	{
+		return m_body1;
+	}
+
+	// STK: used by btConvexTriangleCallback to temporarily replace the
+	// concave object by a per-triangle copy.
+	void setBodiesInternal(btCollisionObject* body0,btCollisionObject* body1)
+	{
+		m_body0 = body0;
+		m_body1 = body1;
+	}
 	
 };
 
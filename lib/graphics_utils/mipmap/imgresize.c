@@ -2049,7 +2049,13 @@ static void imStaticKernelPoT4Plant( unsigned char *dst, int pointx, int pointy,
 
 int imReduceImageKaiserDataDivisor( unsigned char *dstdata, unsigned char *srcdata, int width, int height, int bytesperpixel, int bytesperline, int sizedivisor, imReduceOptions *options )
 {
-  int filter, x, y, pointx, pointy, basex, basey, pow2flag;
+  return imReduceImageKaiserDataDivisorRows( dstdata, srcdata, width, height, bytesperpixel, bytesperline, sizedivisor, options, 0, height );
+}
+
+
+int imReduceImageKaiserDataDivisorRows( unsigned char *dstdata, unsigned char *srcdata, int width, int height, int bytesperpixel, int bytesperline, int sizedivisor, imReduceOptions *options, int firstrow, int rowcount )
+{
+  int filter, x, y, pointx, pointy, basex, basey, pow2flag, endrow;
   int newwidth, newheight;
   unsigned char *dst;
   imStaticMatrixState state;
@@ -2206,12 +2212,19 @@ int imReduceImageKaiserDataDivisor( unsigned char *dstdata, unsigned char *srcda
   while( basey < 0 )
     basey += height;
 
+  /* Only the requested rows are computed, every pixel only depends on the source */
+  endrow = firstrow + rowcount;
+  if( endrow > newheight )
+    endrow = newheight;
+  dstdata += (size_t)firstrow * newwidth * bytesperpixel;
+  basey = (int)( ( basey + (long long)firstrow * sizedivisor ) % height );
+
 #if CPU_SSE2_SUPPORT
   if( applykernelcore )
   {
     dst = dstdata;
     pointy = basey;
-    for( y = 0 ; y < newheight ; y++ )
+    for( y = firstrow ; y < endrow ; y++ )
     {
       pointx = basex;
       for( x = 0 ; x < newwidth ; x++, dst += bytesperpixel )
@@ -2231,7 +2244,7 @@ int imReduceImageKaiserDataDivisor( unsigned char *dstdata, unsigned char *srcda
   {
     dst = dstdata;
     pointy = basey;
-    for( y = 0 ; y < newheight ; y++ )
+    for( y = firstrow ; y < endrow ; y++ )
     {
       pointx = basex;
       for( x = 0 ; x < newwidth ; x++, dst += bytesperpixel )
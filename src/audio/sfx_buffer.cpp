@@ -18,23 +18,11 @@
 
 #include "audio/sfx_buffer.hpp"
 #include "audio/sfx_manager.hpp"
+#include "audio/sfx_pcm_store.hpp"
 #include "config/user_config.hpp"
 #include "io/file_manager.hpp"
-#include "utils/constants.hpp"
 #include "utils/log.hpp"
 
-#ifdef ENABLE_SOUND
-#  include <vorbis/codec.h>
-#  include <vorbis/vorbisfile.h>
-#  ifdef __APPLE__
-#    include <OpenAL/al.h>
-#    include <OpenAL/alc.h>
-#  else
-#    include <AL/al.h>
-#    include <AL/alc.h>
-#  endif
-#endif
-
 //----------------------------------------------------------------------------
 /** Creates a sfx. The parameter are taken from the parameters:
  *  \param file File name of the buffer.
@@ -88,6 +76,10 @@ SFXBuffer::SFXBuffer(const std::string& file,
 
 //----------------------------------------------------------------------------
 /** \brief load the buffer from file into OpenAL.
+ *  The decoded data is shared with all other buffers of a file with the
+ *  same content, see SFXPCMStore. This is called in the sfx thread, either
+ *  in advance (SFX_LOAD_BUFFER) or when a sound source using this buffer
+ *  is initialised.
  *  \note If this buffer is already loaded, this call does nothing and 
   *       returns false.
  *  \return Whether loading was successful.
@@ -99,25 +91,23 @@ bool SFXBuffer::load()
 #ifdef ENABLE_SOUND
     if (UserConfigParams::m_enable_sound)
     {
+        std::lock_guard<std::mutex> lock(m_load_mutex);
         if (m_loaded) return false;
-    
-        alGetError(); // clear errors from previously
-    
-        alGenBuffers(1, &m_buffer);
-        if (!SFXManager::checkError("generating a buffer"))
-        {
-            return false;
-        }
-    
-        assert(alIsBuffer(m_buffer));
-    
-        if (!loadVorbisBuffer(m_file, m_buffer))
+
+        float duration = -1.0f;
+        m_buffer = SFXPCMStore::acquire(m_file, &duration);
+        if (m_buffer == 0)
         {
             Log::error("SFXBuffer", "Could not load sound effect %s",
                        m_file.c_str());
-            // TODO: free al buffer here?
             return false;
         }
+        // Allow the xml data to overwrite the duration, but if there is no
+        // duration (which is the norm), use the one of the data:
+        if (m_duration < 0)
+            m_duration = duration;
+        m_loaded = true;
+        return true;
     }
 #endif
 
@@ -136,106 +126,13 @@ void SFXBuffer::unload()
 #ifdef ENABLE_SOUND
     if (UserConfigParams::m_enable_sound)
     {
+        std::lock_guard<std::mutex> lock(m_load_mutex);
         if (m_loaded)
         {
-            alDeleteBuffers(1, &m_buffer);
+            SFXPCMStore::release(m_buffer);
             m_buffer = 0;
         }
     }
 #endif
     m_loaded = false;
 }   // unload
-
-//----------------------------------------------------------------------------
-/** Load a vorbis file into an OpenAL buffer
- *  based on a routine by Peter Mulholland, used with permission (quote :
- *  "Feel free to use")
- */
-bool SFXBuffer::loadVorbisBuffer(const std::string &name, ALuint buffer)
-{
-#ifdef ENABLE_SOUND
-    if (!UserConfigParams::m_enable_sound)
-        return false;
-        
-    const int ogg_endianness = (IS_LITTLE_ENDIAN ? 0 : 1);
-
-
-    bool success = false;
-    FILE *file;
-    vorbis_info *info;
-    OggVorbis_File oggFile;
-
-    if (alIsBuffer(buffer) == AL_FALSE)
-    {
-        Log::error("SFXBuffer", "Error, bad OpenAL buffer");
-        return false;
-    }
-
-    file = fopen(name.c_str(), "rb");
-
-    if(!file)
-    {
-        Log::error("SFXBuffer", "LoadVorbisBuffer() - couldn't open file!");
-        return false;
-    }
-
-    if (ov_open_callbacks(file, &oggFile, NULL, 0,  OV_CALLBACKS_NOCLOSE) != 0)
-    {
-        fclose(file);
-        Log::error("SFXBuffer", "LoadVorbisBuffer() - ov_open_callbacks() failed, "
-                                "file isn't vorbis?");
-        return false;
-    }
-
-    info = ov_info(&oggFile, -1);
-
-    // always 16 bit data
-    long len = (long)ov_pcm_total(&oggFile, -1) * info->channels * 2;
-
-    char *data = (char *) malloc(len);
-    if(!data)
-    {
-        ov_clear(&oggFile);
-        Log::error("SFXBuffer", "[SFXBuffer] Could not allocate decode buffer.");
-        return false;
-    }
-
-    int bs = -1;
-    long todo = len;
-    char *bufpt = data;
-
-    while (todo)
-    {
-        int read = ov_read(&oggFile, bufpt, todo, ogg_endianness, 2, 1, &bs);
-        todo -= read;
-        bufpt += read;
-    }
-
-    alBufferData(buffer, (info->channels == 1) ? AL_FORMAT_MONO16
-                 : AL_FORMAT_STEREO16,
-                 data, len, info->rate);
-    success = true;
-
-    free(data);
-
-    ov_clear(&oggFile);
-    fclose(file);
-
-    // Allow the xml data to overwrite the duration, but if there is no
-    // duration (which is the norm), compute it:
-    if(m_duration < 0)
-    {
-        ALint buffer_size, frequency, bits_per_sample, channels;
-        alGetBufferi(buffer, AL_SIZE,      &buffer_size    );
-        alGetBufferi(buffer, AL_FREQUENCY, &frequency      );
-        alGetBufferi(buffer, AL_CHANNELS,  &channels       );
-        alGetBufferi(buffer, AL_BITS,      &bits_per_sample);
-        m_duration = float(buffer_size) 
-                   / (frequency*channels*(bits_per_sample / 8));
-    }
-    return success;
-#else
-    return false;
-#endif
-}   // loadVorbisBuffer
-
@@ -33,6 +33,7 @@ typedef unsigned int ALuint;
 #include "utils/vec3.hpp"
 #include "utils/leak_check.hpp"
 
+#include <mutex>
 #include <string>
 
 class SFXBase;
@@ -72,7 +73,9 @@ private:
     /** Duration of the sfx. */
     float    m_duration;
 
-    bool loadVorbisBuffer(const std::string &name, ALuint buffer);
+    /** Buffers are loaded on demand in the sfx thread, but can be unloaded
+     *  from the main thread. */
+    std::mutex m_load_mutex;
 
 public:
 
@@ -20,6 +20,7 @@
 #include "audio/music_manager.hpp"
 #include "audio/sfx_openal.hpp"
 #include "audio/sfx_buffer.hpp"
+#include "audio/sfx_pcm_store.hpp"
 #include "config/user_config.hpp"
 #include "io/file_manager.hpp"
 #include "modes/world.hpp"
@@ -127,6 +128,15 @@ SFXManager::SFXManager()
         m_sfx_commands.lock();
         m_sfx_commands.getData().clear();
         m_sfx_commands.unlock();
+
+        // Decode the buffers from sfx.xml in the background now, so that
+        // the sfx thread does not have to decode them when they are first
+        // played.
+        if (m_initialized)
+        {
+            for (auto &sfx_type : m_all_sfx_types)
+                queue(SFX_LOAD_BUFFER, sfx_type.second);
+        }
     }
 #endif
 }  // SoundManager
@@ -144,6 +154,7 @@ SFXManager::~SFXManager()
         delete m_thread_id.getData();
         m_thread_id.unlock();
         pthread_cond_destroy(&m_cond_request);
+        SFXPCMStore::printStatistics();
     }
 #endif
 
@@ -256,6 +267,22 @@ void SFXManager::queue(SFXCommands command, SFXBase *sfx, const Vec3 &p, SFXBuff
 #endif
 }   // queue (Vec3)
 
+//----------------------------------------------------------------------------
+/** Adds a command for a sound buffer (e.g. to load it in the sfx thread).
+ *  \param command The command to execute.
+ *  \param buffer The sound buffer.
+ */
+void SFXManager::queue(SFXCommands command, SFXBuffer *buffer)
+{
+#ifdef ENABLE_SOUND
+    if (!UserConfigParams::m_enable_sound)
+        return;
+
+    SFXCommand *sfx_command = new SFXCommand(command, buffer);
+    queueCommand(sfx_command);
+#endif
+}   // queue(SFXBuffer)
+
 //----------------------------------------------------------------------------
 /** Adds a sound effect command with a float and a Vec3 parameter to the queue
  *  of the sfx manager. Openal commands can sometimes cause a 5ms delay, so it
@@ -466,6 +493,8 @@ void* SFXManager::mainLoop(void *obj)
         }
         case SFX_CREATE_SOURCE:
             current->m_sfx->init(); break;
+        case SFX_LOAD_BUFFER:
+            current->m_buffer->load(); break;
         default: assert("Not yet supported.");
         }
         delete current;
@@ -510,16 +539,10 @@ void* SFXManager::mainLoop(void *obj)
  */
 void SFXManager::toggleSound(const bool on)
 {
-    // When activating SFX, load all buffers
+    // When activating SFX, the buffers are loaded on demand when the sound
+    // sources are initialised again
     if (on)
     {
-        std::map<std::string, SFXBuffer*>::iterator i = m_all_sfx_types.begin();
-        for (; i != m_all_sfx_types.end(); i++)
-        {
-            SFXBuffer* buffer = (*i).second;
-            buffer->load();
-        }
-
         reallyResumeAllNow();
         m_all_sfx.lock();
         const int sfx_amount = (int)m_all_sfx.getData().size();
@@ -563,6 +586,7 @@ bool SFXManager::sfxAllowed()
  */
 void SFXManager::loadSfx()
 {
+    const double start = StkTime::getRealTime();
     std::string sfx_config_name = file_manager->getAsset(FileManager::SFX, "sfx.xml");
     XMLNode* root = file_manager->createXMLTree(sfx_config_name);
     if (!root || root->getName()!="sfx-config")
@@ -592,24 +616,11 @@ void SFXManager::loadSfx()
 
     delete root;
 
-    // Now load them in parallel
-    const int max = (int)m_all_sfx_types.size();
-    SFXBuffer **array = new SFXBuffer *[max];
-    i = 0;
-
-    for (std::map<std::string, SFXBuffer*>::iterator it = m_all_sfx_types.begin();
-         it != m_all_sfx_types.end(); it++)
-    {
-        SFXBuffer* const buffer = (*it).second;
-        array[i++] = buffer;
-    }
-
-    for (i = 0; i < max; i++)
-    {
-        array[i]->load();
-    }
-
-    delete [] array;
+    // The buffers are not loaded here, they are decoded in the sfx thread
+    // once it is started (see the constructor).
+    Log::info("SFXManager", "Loading %d sfx took %.1f ms.",
+              (int)m_all_sfx_types.size(),
+              (StkTime::getRealTime() - start) * 1000.0);
 }   // loadSfx
 
 // -----------------------------------------------------------------------------
@@ -619,7 +630,10 @@ void SFXManager::loadSfx()
  *  enumeration for each effect, for each kart.
  *  \param sfx_name
  *  \param sfxFile must be an absolute pathname
- *  \return        whether loading this sound effect was successful
+ *  \param load If true, the buffer is loaded in the background by the sfx
+ *         thread, otherwise it is loaded when it is first used.
+ *  \return        the buffer if load is true and sfx are initialised,
+ *                 NULL otherwise.
 
 */
 SFXBuffer* SFXManager::addSingleSfx(const std::string &sfx_name,
@@ -643,12 +657,15 @@ SFXBuffer* SFXManager::addSingleSfx(const std::string &sfx_name,
         return NULL;
     }
 
+    if (!load)
+        return NULL;
+
     if (UserConfigParams::logMisc())
         Log::debug("SFXManager", "Loading SFX %s", sfx_file.c_str());
 
-    if (load && buffer->load()) return buffer;
-
-    return NULL;
+    // Decode it in the sfx thread, so it is ready when it is first played
+    queue(SFX_LOAD_BUFFER, buffer);
+    return buffer;
 } // addSingleSFX
 
 //----------------------------------------------------------------------------
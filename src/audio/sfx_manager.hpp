@@ -88,7 +88,8 @@ public:
         SFX_MUSIC_WAITING,
         SFX_MUSIC_DEFAULT_VOLUME,
         SFX_EXIT,
-        SFX_CREATE_SOURCE
+        SFX_CREATE_SOURCE,
+        SFX_LOAD_BUFFER
     };   // SFXCommands
 
     /**
@@ -140,6 +141,14 @@ private:
             m_sfx       = base;
         }   // SFXCommand()
         // --------------------------------------------------------------------
+        /** Constructor for commands for a sound buffer. */
+        SFXCommand(SFXCommands command, SFXBuffer *buffer)
+        {
+            m_command   = command;
+            m_sfx       = NULL;
+            m_buffer    = buffer;
+        }   // SFXCommand(SFXBuffer*)
+        // --------------------------------------------------------------------
         /** Constructor for music information commands. */
         SFXCommand(SFXCommands command, MusicInformation *mi)
         {
@@ -242,6 +251,7 @@ public:
     void queue(SFXCommands command, MusicInformation *mi);
     void queue(SFXCommands command, MusicInformation *mi, float f);
     void queue(SFXCommands command, SFXBase *sfx, const Vec3 &p, SFXBuffer* buffer);
+    void queue(SFXCommands command, SFXBuffer *buffer);
 
     // ------------------------------------------------------------------------
     /** Static function to get the singleton sfx manager. */
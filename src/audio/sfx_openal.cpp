@@ -23,8 +23,10 @@
 #include "audio/sfx_openal.hpp"
 
 #include "audio/sfx_buffer.hpp"
+#include "audio/sfx_pcm_store.hpp"
 #include "config/user_config.hpp"
 #include "modes/world.hpp"
+#include "utils/time.hpp"
 #include "utils/vs.hpp"
 
 #ifdef __APPLE__
@@ -38,6 +40,21 @@
 #include <stdio.h>
 #include <string>
 
+namespace
+{
+    /** Loads a buffer which was not loaded in advance (see
+     *  SFXManager::loadSfx) and records how long this delayed the sfx
+     *  thread. */
+    void loadOnDemand(SFXBuffer *buffer)
+    {
+        if (buffer->isLoaded())
+            return;
+        const double start = StkTime::getRealTime();
+        if (buffer->load())
+            SFXPCMStore::addPlayLoad(StkTime::getRealTime() - start);
+    }   // loadOnDemand
+}   // namespace
+
 SFXOpenAL::SFXOpenAL(SFXBuffer* buffer, bool positional, float volume, 
                      bool owns_buffer) 
          : SFXBase()
@@ -87,6 +104,11 @@ bool SFXOpenAL::init()
 {
     m_status = SFX_UNKNOWN;
 
+    // Buffers are usually loaded in advance, otherwise load it now
+    loadOnDemand(m_sound_buffer);
+    if (!m_sound_buffer->isLoaded())
+        return false;
+
     alGenSources(1, &m_sound_source );
     if (!SFXManager::checkError("generating a source"))
         return false;
@@ -137,7 +159,10 @@ void SFXOpenAL::updatePlayingSFX(float dt)
 {
     assert(m_status==SFX_PLAYING);
     m_play_time += dt;
-    if(!m_loop && m_play_time > m_sound_buffer->getDuration())
+    // The buffer is loaded on demand when the sfx is played, until then its
+    // duration is unknown (-1)
+    if(!m_loop && m_sound_buffer->isLoaded() &&
+        m_play_time > m_sound_buffer->getDuration())
         m_status = SFX_STOPPED;
 }   // updatePlayingSFX
 
@@ -383,6 +408,9 @@ void SFXOpenAL::reallyPlayNow(SFXBuffer* buffer)
             reallyStopNow();
 
         m_sound_buffer = buffer;
+        loadOnDemand(m_sound_buffer);
+        if (!m_sound_buffer->isLoaded())
+            return;
         alSourcei(m_sound_source, AL_BUFFER, m_sound_buffer->getBufferID());
 
         if (!SFXManager::checkError("attaching the buffer to the source"))
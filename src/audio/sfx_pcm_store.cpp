@@ -0,0 +1,418 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "audio/sfx_pcm_store.hpp"
+
+#include "audio/sfx_manager.hpp"
+#include "io/file_manager.hpp"
+#include "utils/constants.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/time.hpp"
+
+#ifdef ENABLE_SOUND
+#  include <vorbis/codec.h>
+#  include <vorbis/vorbisfile.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+std::mutex                   SFXPCMStore::m_mutex;
+std::condition_variable      SFXPCMStore::m_loaded;
+std::set<uint64_t>           SFXPCMStore::m_loading;
+std::map<uint64_t, SFXPCMStore::Entry> SFXPCMStore::m_entries;
+std::map<ALuint, uint64_t>   SFXPCMStore::m_buffer_hash;
+int                          SFXPCMStore::m_num_decoded        = 0;
+int                          SFXPCMStore::m_num_cache_hits     = 0;
+int                          SFXPCMStore::m_num_shared         = 0;
+uint64_t                     SFXPCMStore::m_resident_size      = 0;
+uint64_t                     SFXPCMStore::m_peak_resident_size = 0;
+double                       SFXPCMStore::m_decode_time        = 0;
+double                       SFXPCMStore::m_cache_read_time    = 0;
+double                       SFXPCMStore::m_max_load_time      = 0;
+int                          SFXPCMStore::m_num_play_loads     = 0;
+double                       SFXPCMStore::m_play_load_time     = 0;
+double                       SFXPCMStore::m_max_play_load_time = 0;
+
+namespace
+{
+    /** Header of a file in the decoded sfx cache, followed by the 16 bit
+     *  PCM data. The data is in native byte order, the cache is not meant
+     *  to be shared between machines. */
+    struct CacheHeader
+    {
+        char     m_magic[4];
+        uint32_t m_version;
+        uint32_t m_channels;
+        uint32_t m_rate;
+        uint32_t m_size;
+    };
+    const uint32_t CACHE_VERSION = 1;
+
+#ifdef ENABLE_SOUND
+    /** An ogg file in memory, read by vorbisfile with the callbacks below. */
+    struct MemoryFile
+    {
+        const std::vector<char> *m_data;
+        size_t                   m_offset;
+    };
+    // ------------------------------------------------------------------------
+    size_t readMemory(void *ptr, size_t size, size_t nmemb, void *source)
+    {
+        MemoryFile *file = (MemoryFile*)source;
+        if (size == 0)
+            return 0;
+        size_t n = std::min(nmemb,
+                            (file->m_data->size() - file->m_offset) / size);
+        memcpy(ptr, file->m_data->data() + file->m_offset, n * size);
+        file->m_offset += n * size;
+        return n;
+    }   // readMemory
+    // ------------------------------------------------------------------------
+    int seekMemory(void *source, ogg_int64_t offset, int whence)
+    {
+        MemoryFile *file = (MemoryFile*)source;
+        ogg_int64_t base = 0;
+        if (whence == SEEK_CUR)
+            base = file->m_offset;
+        else if (whence == SEEK_END)
+            base = file->m_data->size();
+        if (base + offset < 0 || base + offset > (ogg_int64_t)file->m_data->size())
+            return -1;
+        file->m_offset = (size_t)(base + offset);
+        return 0;
+    }   // seekMemory
+    // ------------------------------------------------------------------------
+    long tellMemory(void *source)
+    {
+        return (long)((MemoryFile*)source)->m_offset;
+    }   // tellMemory
+#endif
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Returns a 64 bit FNV-1a hash of the data. */
+uint64_t SFXPCMStore::hash(const std::vector<char> &data)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : data)
+    {
+        h ^= (uint8_t)c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}   // hash
+
+// ----------------------------------------------------------------------------
+/** Reads a whole file into memory.
+ *  \return False if the file could not be read.
+ */
+bool SFXPCMStore::readFile(const std::string &name, std::vector<char> *data)
+{
+    FILE *file = fopen(name.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0)
+    {
+        fclose(file);
+        return false;
+    }
+    data->resize(size);
+    bool ok = size == 0 || fread(data->data(), size, 1, file) == 1;
+    fclose(file);
+    return ok;
+}   // readFile
+
+// ----------------------------------------------------------------------------
+/** Decodes a whole ogg file (already in memory) to 16 bit PCM data.
+ *  \param name File name, only used in error messages.
+ *  \param pcm On input the content of the ogg file, on output the PCM data.
+ */
+bool SFXPCMStore::decodeVorbis(const std::string &name,
+                               std::vector<char> *pcm, int *channels,
+                               int *rate)
+{
+#ifdef ENABLE_SOUND
+    const int ogg_endianness = (IS_LITTLE_ENDIAN ? 0 : 1);
+
+    std::vector<char> ogg;
+    ogg.swap(*pcm);
+    MemoryFile memory_file = { &ogg, 0 };
+    ov_callbacks callbacks = { readMemory, seekMemory, NULL, tellMemory };
+    OggVorbis_File ogg_file;
+    if (ov_open_callbacks(&memory_file, &ogg_file, NULL, 0, callbacks) != 0)
+    {
+        Log::error("SFXPCMStore", "ov_open_callbacks() failed, '%s' isn't "
+                   "vorbis?", name.c_str());
+        return false;
+    }
+
+    vorbis_info *info = ov_info(&ogg_file, -1);
+    *channels = info->channels;
+    *rate     = info->rate;
+
+    // always 16 bit data
+    long len = (long)ov_pcm_total(&ogg_file, -1) * info->channels * 2;
+    pcm->resize(len);
+
+    int bs = -1;
+    long todo = len;
+    char *bufpt = pcm->data();
+    while (todo)
+    {
+        long read = ov_read(&ogg_file, bufpt, todo, ogg_endianness, 2, 1,
+                            &bs);
+        if (read <= 0)
+        {
+            // Truncated or corrupt file, keep what was decoded
+            pcm->resize(len - todo);
+            break;
+        }
+        todo -= read;
+        bufpt += read;
+    }
+
+    ov_clear(&ogg_file);
+    return true;
+#else
+    return false;
+#endif
+}   // decodeVorbis
+
+// ----------------------------------------------------------------------------
+/** Returns the name of the cache file for the given hash. */
+std::string SFXPCMStore::getCacheFile(uint64_t hash)
+{
+    return file_manager->getCachedSFXDir() +
+           StringUtils::toString(hash) + ".pcm";
+}   // getCacheFile
+
+// ----------------------------------------------------------------------------
+/** Reads decoded PCM data from the disk cache.
+ *  \return False if there is no valid cache file for this hash.
+ */
+bool SFXPCMStore::readCache(uint64_t hash, std::vector<char> *pcm,
+                            int *channels, int *rate)
+{
+    std::vector<char> data;
+    if (!readFile(getCacheFile(hash), &data) ||
+        data.size() < sizeof(CacheHeader))
+        return false;
+    CacheHeader header;
+    memcpy(&header, data.data(), sizeof(CacheHeader));
+    if (memcmp(header.m_magic, "SPCM", 4) != 0 ||
+        header.m_version != CACHE_VERSION ||
+        data.size() != sizeof(CacheHeader) + header.m_size)
+        return false;
+    *channels = header.m_channels;
+    *rate     = header.m_rate;
+    pcm->assign(data.begin() + sizeof(CacheHeader), data.end());
+    return true;
+}   // readCache
+
+// ----------------------------------------------------------------------------
+/** Writes decoded PCM data to the disk cache. */
+void SFXPCMStore::writeCache(uint64_t hash, const std::vector<char> &pcm,
+                             int channels, int rate)
+{
+    const std::string name = getCacheFile(hash);
+    FILE *file = fopen(name.c_str(), "wb");
+    if (!file)
+    {
+        Log::warn("SFXPCMStore", "Can not write cache file '%s'.",
+                  name.c_str());
+        return;
+    }
+    CacheHeader header;
+    memcpy(header.m_magic, "SPCM", 4);
+    header.m_version  = CACHE_VERSION;
+    header.m_channels = channels;
+    header.m_rate     = rate;
+    header.m_size     = (uint32_t)pcm.size();
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (pcm.empty() || fwrite(pcm.data(), pcm.size(), 1, file) == 1);
+    fclose(file);
+    if (!ok)
+    {
+        Log::warn("SFXPCMStore", "Can not write cache file '%s'.",
+                  name.c_str());
+        file_manager->removeFile(name);
+    }
+}   // writeCache
+
+// ----------------------------------------------------------------------------
+/** Returns an OpenAL buffer with the content of the given ogg file. If a
+ *  file with the same content is already loaded, its buffer is shared,
+ *  otherwise the decoded data is read from the disk cache, or the file is
+ *  decoded (and the result cached). Each call must be matched with a
+ *  call to release().
+ *  \param name Name of the ogg file.
+ *  \param duration On return the duration of the sound in seconds.
+ *  \return The OpenAL buffer, or 0 if the file could not be loaded.
+ */
+ALuint SFXPCMStore::acquire(const std::string &name, float *duration)
+{
+#ifdef ENABLE_SOUND
+    std::vector<char> data;
+    if (!readFile(name, &data))
+    {
+        Log::error("SFXPCMStore", "Couldn't open file '%s'.", name.c_str());
+        return 0;
+    }
+    const uint64_t h = hash(data);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // If another thread is loading the same file, wait and share its buffer
+    m_loaded.wait(lock, [h]() { return m_loading.count(h) == 0; });
+    auto it = m_entries.find(h);
+    if (it != m_entries.end())
+    {
+        it->second.m_ref_count++;
+        m_num_shared++;
+        *duration = it->second.m_duration;
+        return it->second.m_buffer;
+    }
+    m_loading.insert(h);
+    lock.unlock();
+
+    // Read or decode the file without holding the lock, so that other
+    // sounds can be acquired and released in the meantime.
+    const double start = StkTime::getRealTime();
+    int channels = 0, rate = 0;
+    const bool cached = readCache(h, &data, &channels, &rate);
+    bool ok = cached;
+    if (!cached && decodeVorbis(name, &data, &channels, &rate))
+    {
+        ok = true;
+        writeCache(h, data, channels, rate);
+    }
+    const double time = StkTime::getRealTime() - start;
+
+    lock.lock();
+    m_loading.erase(h);
+    m_loaded.notify_all();
+    if (!ok)
+        return 0;
+    if (cached)
+    {
+        m_num_cache_hits++;
+        m_cache_read_time += time;
+    }
+    else
+    {
+        m_num_decoded++;
+        m_decode_time += time;
+    }
+    m_max_load_time = std::max(m_max_load_time, time);
+    if (channels < 1 || channels > 2 || rate <= 0)
+    {
+        Log::error("SFXPCMStore", "Unsupported format in '%s'.",
+                   name.c_str());
+        return 0;
+    }
+
+    alGetError(); // clear errors from previously
+    ALuint buffer = 0;
+    alGenBuffers(1, &buffer);
+    if (!SFXManager::checkError("generating a buffer"))
+        return 0;
+    alBufferData(buffer, channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16,
+                 data.data(), (ALsizei)data.size(), rate);
+    if (!SFXManager::checkError("filling a buffer"))
+    {
+        alDeleteBuffers(1, &buffer);
+        return 0;
+    }
+
+    Entry entry;
+    entry.m_buffer    = buffer;
+    entry.m_ref_count = 1;
+    entry.m_size      = (uint32_t)data.size();
+    entry.m_duration  = float(data.size()) / float(rate * channels * 2);
+    m_entries[h] = entry;
+    m_buffer_hash[buffer] = h;
+    m_resident_size += entry.m_size;
+    m_peak_resident_size = std::max(m_peak_resident_size, m_resident_size);
+    *duration = entry.m_duration;
+    return buffer;
+#else
+    return 0;
+#endif
+}   // acquire
+
+// ----------------------------------------------------------------------------
+/** Releases a buffer returned by acquire(). The OpenAL buffer is deleted
+ *  when it is not used anymore. */
+void SFXPCMStore::release(ALuint buffer)
+{
+#ifdef ENABLE_SOUND
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_buffer_hash.find(buffer);
+    if (it == m_buffer_hash.end())
+    {
+        Log::warn("SFXPCMStore", "Releasing unknown buffer %u.", buffer);
+        return;
+    }
+    Entry &entry = m_entries[it->second];
+    entry.m_ref_count--;
+    if (entry.m_ref_count > 0)
+        return;
+    alDeleteBuffers(1, &buffer);
+    m_resident_size -= entry.m_size;
+    m_entries.erase(it->second);
+    m_buffer_hash.erase(it);
+#endif
+}   // release
+
+// ----------------------------------------------------------------------------
+/** Records a buffer which was only loaded when a sound source using it was
+ *  initialised or played, i.e. which delayed the sfx thread.
+ *  \param time How long loading the buffer took in seconds.
+ */
+void SFXPCMStore::addPlayLoad(double time)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_num_play_loads++;
+    m_play_load_time += time;
+    m_max_play_load_time = std::max(m_max_play_load_time, time);
+}   // addPlayLoad
+
+// ----------------------------------------------------------------------------
+/** Prints how many sound effects were decoded, read from the cache and
+ *  shared, how long this took, and how much PCM data is (and was at most)
+ *  stored in OpenAL. */
+void SFXPCMStore::printStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Log::info("SFXPCMStore", "%d sfx decoded, %d read from cache, %d shared. "
+              "%d buffers with %d KB loaded, peak %d KB.", m_num_decoded,
+              m_num_cache_hits, m_num_shared, (int)m_entries.size(),
+              (int)(m_resident_size / 1024),
+              (int)(m_peak_resident_size / 1024));
+    Log::info("SFXPCMStore", "Decoding took %.1f ms, reading the cache "
+              "%.1f ms, slowest load %.1f ms.", m_decode_time * 1000.0,
+              m_cache_read_time * 1000.0, m_max_load_time * 1000.0);
+    Log::info("SFXPCMStore", "%d buffers loaded on first use, taking "
+              "%.1f ms in total, at most %.1f ms.", m_num_play_loads,
+              m_play_load_time * 1000.0, m_max_play_load_time * 1000.0);
+}   // printStatistics
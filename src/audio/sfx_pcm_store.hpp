@@ -0,0 +1,110 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_SFX_PCM_STORE_HPP
+#define HEADER_SFX_PCM_STORE_HPP
+
+#ifdef ENABLE_SOUND
+#  ifdef __APPLE__
+#    include <OpenAL/al.h>
+#  else
+#    include <AL/al.h>
+#  endif
+#else
+typedef unsigned int ALuint;
+#endif
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Decodes sound effects and shares the OpenAL buffers.
+ *  Files with identical content (e.g. the same sound used by several karts
+ *  or track objects) share one OpenAL buffer, which is reference counted.
+ *  The decoded PCM data is cached on disk, keyed by a hash of the ogg file,
+ *  so the decoding is only done once. The store is used from the main
+ *  thread and the sfx thread, so the tables are protected by a mutex. The
+ *  mutex is not held while a file is read or decoded, a second request
+ *  for the same file waits until the first one is finished.
+ * \ingroup audio
+ */
+class SFXPCMStore
+{
+private:
+    /** One shared OpenAL buffer. */
+    struct Entry
+    {
+        ALuint   m_buffer;
+        int      m_ref_count;
+        float    m_duration;
+        uint32_t m_size;
+    };
+
+    static std::mutex m_mutex;
+
+    /** Signalled when a file is removed from m_loading. */
+    static std::condition_variable m_loaded;
+
+    /** Hashes of the files which are currently read or decoded. */
+    static std::set<uint64_t> m_loading;
+
+    /** All buffers, indexed by the hash of the ogg file. */
+    static std::map<uint64_t, Entry> m_entries;
+
+    /** Maps an OpenAL buffer back to the hash of its file. */
+    static std::map<ALuint, uint64_t> m_buffer_hash;
+
+    /** Statistics: number of files decoded, read from the disk cache, and
+     *  buffers shared with an already loaded file. */
+    static int m_num_decoded, m_num_cache_hits, m_num_shared;
+
+    /** Statistics: current and peak size of all PCM data in OpenAL. */
+    static uint64_t m_resident_size, m_peak_resident_size;
+
+    /** Statistics: total time spent decoding files and reading them from
+     *  the disk cache, and the slowest single load (all in seconds). */
+    static double m_decode_time, m_cache_read_time, m_max_load_time;
+
+    /** Statistics: number and total and maximum time of loads which were
+     *  done when a sound source was initialised or played, i.e. which were
+     *  not loaded in advance. */
+    static int    m_num_play_loads;
+    static double m_play_load_time, m_max_play_load_time;
+
+    static bool readFile(const std::string &name, std::vector<char> *data);
+    static bool decodeVorbis(const std::string &name, std::vector<char> *pcm,
+                             int *channels, int *rate);
+    static std::string getCacheFile(uint64_t hash);
+    static bool readCache(uint64_t hash, std::vector<char> *pcm,
+                          int *channels, int *rate);
+    static void writeCache(uint64_t hash, const std::vector<char> &pcm,
+                           int channels, int rate);
+public:
+    static ALuint acquire(const std::string &name, float *duration);
+    static void   release(ALuint buffer);
+    static void   addPlayLoad(double time);
+    static void   printStatistics();
+    static uint64_t hash(const std::vector<char> &data);
+};   // SFXPCMStore
+
+#endif
@@ -874,6 +874,17 @@ namespace UserConfigParams
     PARAM_PREFIX BoolUserConfigParam        m_cache_overworld
             PARAM_DEFAULT(  BoolUserConfigParam(true, "cache-overworld") );
 
+    PARAM_PREFIX IntUserConfigParam         m_physics_threads
+            PARAM_DEFAULT(  IntUserConfigParam(0, "physics-threads",
+            "Number of threads for collision detection and constraint\n"
+            "solving in physics, 0 and 1 use no additional thread. The\n"
+            "results do not depend on the number of threads.") );
+
+    PARAM_PREFIX IntUserConfigParam         m_render_threads
+            PARAM_DEFAULT(  IntUserConfigParam(0, "render-threads",
+            "Number of threads for CPU work while rendering a frame, e.g.\n"
+            "the particle simulation. 0 uses all cores, but at most 4.") );
+
     // TODO : is this used with new code? does it still work?
     PARAM_PREFIX BoolUserConfigParam        m_crashed
             PARAM_DEFAULT(  BoolUserConfigParam(false, "crashed") );
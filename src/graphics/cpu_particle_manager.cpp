@@ -22,6 +22,7 @@
 #include "graphics/material.hpp"
 #include "graphics/material_manager.hpp"
 #include "utils/log.hpp"
+#include "utils/worker_pool.hpp"
 
 #include <algorithm>
 
@@ -187,15 +188,39 @@ void CPUParticleManager::addBillboardNode(scene::IBillboardSceneNode* node)
 // ----------------------------------------------------------------------------
 void CPUParticleManager::generateAll()
 {
+    // The emitters are independent, so they are simulated in parallel. Each
+    // writes into its own buffer, and the buffers are appended in the same
+    // order as the emitters are queued.
+    m_emitters.clear();
+    for (auto& p : m_particles_queue)
+    {
+        m_emitters.insert(m_emitters.end(), p.second.begin(), p.second.end());
+    }
+    if (m_emitter_particles.size() < m_emitters.size())
+    {
+        m_emitter_particles.resize(m_emitters.size());
+    }
+    irr_driver->getRenderWorkerPool()->parallelFor
+        ((unsigned)m_emitters.size(),
+        [this](unsigned int emitter, unsigned int thread)
+        {
+            m_emitter_particles[emitter].clear();
+            m_emitters[emitter]->generate(&m_emitter_particles[emitter]);
+        });
+
+    unsigned emitter = 0;
     for (auto& p : m_particles_queue)
     {
         if (p.second.empty())
         {
             continue;
         }
-        for (auto& q : p.second)
+        std::vector<CPUParticle>& generated = m_particles_generated[p.first];
+        for (unsigned i = 0; i < p.second.size(); i++, emitter++)
         {
-            q->generate(&m_particles_generated[p.first]);
+            generated.insert(generated.end(),
+                m_emitter_particles[emitter].begin(),
+                m_emitter_particles[emitter].end());
         }
         if (isFlipsMaterial(p.first))
         {
@@ -104,6 +104,13 @@ private:
     std::unordered_map<std::string, std::unique_ptr<GLParticle> >
         m_gl_particles;
 
+    /** All queued emitters of the current frame, in queue order. */
+    std::vector<STKParticle*> m_emitters;
+
+    /** The particles generated by each emitter in m_emitters, kept between
+     *  frames to avoid reallocations. */
+    std::vector<std::vector<CPUParticle> > m_emitter_particles;
+
     std::unordered_map<std::string, Material*> m_material_map;
 
     std::unordered_set<std::string> m_flips_material;
@@ -23,6 +23,7 @@
 #include "graphics/cpu_particle_manager.hpp"
 #include "graphics/irr_driver.hpp"
 #include "graphics/lod_node.hpp"
+#include "graphics/render_stats.hpp"
 #include "graphics/shaders.hpp"
 #include "graphics/stk_particle.hpp"
 #include "graphics/stk_text_billboard.hpp"
@@ -145,6 +146,8 @@ void DrawCalls::parseSceneManager(core::list<scene::ISceneNode*> &List,
         if (LODNode *node = dynamic_cast<LODNode *>(*I))
         {
             node->updateVisibility();
+            if (RenderStats::isEnabled() && node->isVisible())
+                RenderStats::addLodLevel(node->getLevel());
         }
         (*I)->updateAbsolutePosition();
         if (!(*I)->isVisible())
@@ -204,9 +207,12 @@ void DrawCalls::prepareDrawCalls(scene::ICameraSceneNode *camnode)
     TextBillboardDrawer::reset();
     PROFILER_PUSH_CPU_MARKER("- culling", 0xFF, 0xFF, 0x0);
     SP::prepareDrawCalls();
+    RenderStats::start(RenderStats::RT_SCENE_PARSE);
     parseSceneManager(
         irr_driver->getSceneManager()->getRootSceneNode()->getChildren(),
         camnode);
+    RenderStats::stop(RenderStats::RT_SCENE_PARSE);
+    SP::cullObjects();
     SP::handleDynamicDrawCall();
     SP::updateModelMatrix();
     PROFILER_POP_CPU_MARKER();
@@ -241,7 +247,9 @@ void DrawCalls::prepareDrawCalls(scene::ICameraSceneNode *camnode)
 
     PROFILER_PUSH_CPU_MARKER("- SP::upload instance and skinning matrices",
         0xFF, 0x0, 0xFF);
+    RenderStats::start(RenderStats::RT_UPLOAD);
     SP::uploadAll();
+    RenderStats::stop(RenderStats::RT_UPLOAD);
     PROFILER_POP_CPU_MARKER();
 }
 
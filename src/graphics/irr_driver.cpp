@@ -32,6 +32,7 @@
 #include "graphics/particle_kind_manager.hpp"
 #include "graphics/per_camera_node.hpp"
 #include "graphics/referee.hpp"
+#include "graphics/render_stats.hpp"
 #include "graphics/render_target.hpp"
 #include "graphics/shader_based_renderer.hpp"
 #include "graphics/shared_gpu_objects.hpp"
@@ -72,9 +73,13 @@
 #include "utils/log.hpp"
 #include "utils/profiler.hpp"
 #include "utils/vs.hpp"
+#include "utils/worker_pool.hpp"
 
 #include <irrlicht.h>
 
+#include <algorithm>
+#include <thread>
+
 #ifdef ENABLE_RECORDER
 #include <chrono>
 #include <openglrecorder.h>
@@ -164,6 +169,7 @@ IrrDriver::IrrDriver()
     m_request_screenshot = false;
     m_renderer            = NULL;
     m_wind                = new Wind();
+    m_render_worker_pool  = NULL;
     m_ssaoviz = false;
     m_shadowviz = false;
     m_boundingboxesviz = false;
@@ -192,6 +198,7 @@ IrrDriver::~IrrDriver()
 #endif
     STKTexManager::getInstance()->kill();
     delete m_wind;
+    delete m_render_worker_pool;
     delete m_renderer;
 #ifndef SERVER_ONLY
     for (unsigned i = 0; i < Q_LAST; i++)
@@ -216,6 +223,26 @@ const char* IrrDriver::getGPUQueryPhaseName(unsigned q)
 #endif
 }   // getGPUQueryPhaseName
 
+// ----------------------------------------------------------------------------
+/** Returns the threads used to split CPU work of a frame, e.g. the particle
+ *  simulation. The pool is created on first use, with the number of
+ *  threads from the user config (0 uses all cores, but at most 4).
+ */
+WorkerPool* IrrDriver::getRenderWorkerPool()
+{
+    if (m_render_worker_pool == NULL)
+    {
+        unsigned int threads = UserConfigParams::m_render_threads;
+        if (threads == 0)
+        {
+            threads = std::min(std::max(std::thread::hardware_concurrency(),
+                1u), 4u);
+        }
+        m_render_worker_pool = new WorkerPool("RenderWorker", threads);
+    }
+    return m_render_worker_pool;
+}   // getRenderWorkerPool
+
 // ----------------------------------------------------------------------------
 /** Called before a race is started, after all cameras are set up.
  */
@@ -1902,6 +1929,8 @@ void IrrDriver::update(float dt, bool is_loading)
     {
 #ifndef SERVER_ONLY
         m_renderer->render(dt, is_loading);
+        if (!is_loading)
+            RenderStats::endFrame();
 
         GUIEngine::Screen* current_screen = GUIEngine::getCurrentScreen();
         if (current_screen != NULL && current_screen->needs3D())
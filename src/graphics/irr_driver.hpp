@@ -74,6 +74,7 @@ class LightNode;
 class PerCameraNode;
 class RenderInfo;
 class RenderTarget;
+class WorkerPool;
 
 struct SHCoefficients;
 
@@ -101,6 +102,10 @@ private:
     /** Wind. */
     Wind                 *m_wind;
 
+    /** Threads which share CPU work while rendering a frame, created on
+     *  first use. */
+    WorkerPool           *m_render_worker_pool;
+
     core::dimension2du m_actual_screen_size;
 
     /** The main MRT setup. */
@@ -374,6 +379,8 @@ public:
     // ------------------------------------------------------------------------
     bool getBoundingBoxesViz()    { return m_boundingboxesviz;      }
     // ------------------------------------------------------------------------
+    WorkerPool* getRenderWorkerPool();
+    // ------------------------------------------------------------------------
     int getSceneComplexity() { return m_scene_complexity;           }
     void resetSceneComplexity() { m_scene_complexity = 0;           }
     void addSceneComplexity(int complexity)
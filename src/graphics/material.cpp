@@ -30,6 +30,7 @@
 #include "guiengine/engine.hpp"
 #include "graphics/central_settings.hpp"
 #include "graphics/irr_driver.hpp"
+#include "graphics/material_manager.hpp"
 #include "graphics/particle_kind_manager.hpp"
 #include "graphics/stk_tex_manager.hpp"
 #include "io/file_manager.hpp"
@@ -537,11 +538,14 @@ void Material::install(bool srgb, bool premul_alpha)
     if (m_texture == NULL) return;
 
     // now set the name to the basename, so that all tests work as expected
+    const std::string old_name = m_texname;
     m_texname  = StringUtils::getBasename(m_texname);
 
     core::stringc texfname(m_texname.c_str());
     texfname.make_lower();
     m_texname = texfname.c_str();
+    if (m_texname != old_name && material_manager)
+        material_manager->renameMaterial(this, old_name);
 
     m_texture->grab();
 }   // install
@@ -19,6 +19,7 @@
 
 #include "graphics/material_manager.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <sstream>
 
@@ -40,11 +41,28 @@
 
 MaterialManager *material_manager=0;
 
+namespace
+{
+    /** Removes the last material from the entries of a key in an index. */
+    void removeFromIndex(std::unordered_map<std::string,
+                                            std::vector<int> > *index,
+                         const std::string &key, int material_index)
+    {
+        auto it = index->find(key);
+        assert(it != index->end() && it->second.back() == material_index);
+        it->second.pop_back();
+        if (it->second.empty())
+            index->erase(it);
+    }   // removeFromIndex
+}   // namespace
+
 MaterialManager::MaterialManager()
 {
     /* Create list - and default material zero */
 
     m_materials.reserve(256);
+    m_num_lookups = 0;
+    m_num_compared = 0;
     // We can't call init/loadMaterial here, since the global variable
     // material_manager has not yet been initialised, and
     // material_manager is used in the Material constructor.
@@ -67,6 +85,8 @@ MaterialManager::~MaterialManager()
         delete m_materials[i];
     }
     m_materials.clear();
+    m_name_index.clear();
+    m_full_path_index.clear();
 
     for (std::map<std::string, Material*> ::iterator it =
          m_default_sp_materials.begin(); it != m_default_sp_materials.end();
@@ -100,46 +120,19 @@ Material* MaterialManager::getMaterialSPM(std::string lay_one_tex_lc,
     const bool is_full_path = !lay_one_tex_lc.empty() &&
         (lay_one_tex_lc.find('/') != std::string::npos ||
         lay_one_tex_lc.find('\\') != std::string::npos);
-    if (is_full_path)
+    if (!lay_one_tex_lc.empty())
     {
+        const std::vector<int>* indices =
+            findIndices(is_full_path ? m_full_path_index : m_name_index,
+                        lay_one_tex_lc);
         // Search backward so that temporary (track) textures are found first
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
+        for (int i = indices ? (int)indices->size() - 1 : -1; i >= 0; i--)
         {
-            if (m_materials[i]->getTexFullPath() == lay_one_tex_lc)
+            m_num_compared++;
+            Material* m = m_materials[(*indices)[i]];
+            if (m->getUVTwoTexture() == lay_two_tex_lc)
             {
-                const std::string& mat_lay_two = m_materials[i]->getUVTwoTexture();
-                if (mat_lay_two.empty() && lay_two_tex_lc.empty())
-                {
-                    return m_materials[i];
-                }
-                else if (!mat_lay_two.empty() && !lay_two_tex_lc.empty())
-                {
-                    if (mat_lay_two == lay_two_tex_lc)
-                    {
-                        return m_materials[i];
-                    }
-                }
-            }
-        }
-    }
-    else if (!lay_one_tex_lc.empty())
-    {
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
-        {
-            if (m_materials[i]->getTexFname() == lay_one_tex_lc)
-            {
-                const std::string& mat_lay_two = m_materials[i]->getUVTwoTexture();
-                if (mat_lay_two.empty() && lay_two_tex_lc.empty())
-                {
-                    return m_materials[i];
-                }
-                else if (!mat_lay_two.empty() && !lay_two_tex_lc.empty())
-                {
-                    if (mat_lay_two == lay_two_tex_lc)
-                    {
-                        return m_materials[i];
-                    }
-                }
+                return m;
             }
         }   // for i
     }
@@ -154,31 +147,22 @@ Material* MaterialManager::getMaterialFor(video::ITexture* t)
 {
     const io::path& img_path = t->getName().getInternalName();
 
+    const std::vector<int>* indices = NULL;
     if (!img_path.empty() && (img_path.findFirst('/') != -1 || img_path.findFirst('\\') != -1))
     {
-        // Search backward so that temporary (track) textures are found first
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
-        {
-            if (m_materials[i]->getTexFullPath() == img_path.c_str())
-            {
-                return m_materials[i];
-            }
-        }
+        indices = findIndices(m_full_path_index, img_path.c_str());
     }
     else
     {
         core::stringc image(StringUtils::getBasename(img_path.c_str()).c_str());
         image.make_lower();
-
-        for (int i = (int)m_materials.size() - 1; i >= 0; i--)
-        {
-            if (m_materials[i]->getTexFname() == image.c_str())
-            {
-                return m_materials[i];
-            }
-        }   // for i
+        indices = findIndices(m_name_index, image.c_str());
     }
-    return NULL;
+    if (indices == NULL)
+        return NULL;
+    // The last material shadows the others, e.g. temporary (track) textures
+    m_num_compared++;
+    return m_materials[indices->back()];
 }
 
 //-----------------------------------------------------------------------------
@@ -251,10 +235,63 @@ void MaterialManager::setAllUntexturedMaterialFlags(scene::IMeshBuffer *mb)
 //-----------------------------------------------------------------------------
 int MaterialManager::addEntity(Material *m)
 {
-    m_materials.push_back(m);
+    addMaterial(m);
     return (int)m_materials.size()-1;
 }
 
+//-----------------------------------------------------------------------------
+/** Appends a material and adds it to the indices, where it shadows all
+ *  older materials with the same texture.
+ */
+void MaterialManager::addMaterial(Material *m)
+{
+    const int index = (int)m_materials.size();
+    m_materials.push_back(m);
+    m_name_index[m->getTexFname()].push_back(index);
+    m_full_path_index[m->getTexFullPath()].push_back(index);
+}   // addMaterial
+
+//-----------------------------------------------------------------------------
+/** Deletes the last material and removes it from the indices. Since it is
+ *  the newest material, it is the last entry for its texture.
+ */
+void MaterialManager::removeLastMaterial()
+{
+    const int last = (int)m_materials.size() - 1;
+    Material* m = m_materials[last];
+    removeFromIndex(&m_name_index, m->getTexFname(), last);
+    removeFromIndex(&m_full_path_index, m->getTexFullPath(), last);
+    delete m;
+    m_materials.pop_back();
+}   // removeLastMaterial
+
+//-----------------------------------------------------------------------------
+/** Called when the texture name of a material changes (when its texture is
+ *  installed), to move it in the index.
+ *  \param m The material.
+ *  \param old_name The previous texture name of the material.
+ */
+void MaterialManager::renameMaterial(Material *m, const std::string& old_name)
+{
+    auto it = m_name_index.find(old_name);
+    if (it == m_name_index.end())
+        return;
+    std::vector<int>& old_indices = it->second;
+    for (unsigned int i = 0; i < old_indices.size(); i++)
+    {
+        const int index = old_indices[i];
+        if (m_materials[index] != m)
+            continue;
+        old_indices.erase(old_indices.begin() + i);
+        if (old_indices.empty())
+            m_name_index.erase(it);
+        std::vector<int>& new_indices = m_name_index[m->getTexFname()];
+        new_indices.insert(std::lower_bound(new_indices.begin(),
+            new_indices.end(), index), index);
+        return;
+    }
+}   // renameMaterial
+
 //-----------------------------------------------------------------------------
 void MaterialManager::loadMaterial()
 {
@@ -322,7 +359,7 @@ bool MaterialManager::pushTempMaterial(const XMLNode *root,
         }
         try
         {
-            m_materials.push_back(new Material(node, deprecated));
+            addMaterial(new Material(node, deprecated));
         }
         catch(std::exception& e)
         {
@@ -339,8 +376,7 @@ void MaterialManager::popTempMaterial()
 {
     for(int i=(int)m_materials.size()-1; i>=this->m_shared_material_index; i--)
     {
-        delete m_materials[i];
-        m_materials.pop_back();
+        removeLastMaterial();
     }   // for i6
 }   // popTempMaterial
 
@@ -385,16 +421,19 @@ Material *MaterialManager::getMaterial(const std::string& fname,
     core::stringc basename_lower(basename.c_str());
     basename_lower.make_lower();
 
-    // Search backward so that temporary (track) textures are found first
-    for (int i = (int)m_materials.size()-1; i>=0; i-- )
+    // The last material is found first, so that temporary (track) textures
+    // shadow the shared ones
+    const std::vector<int>* indices =
+        findIndices(m_name_index, basename_lower.c_str());
+    if (indices)
     {
-        if (m_materials[i]->getTexFname() == basename_lower.c_str())
-            return m_materials[i];
+        m_num_compared++;
+        return m_materials[indices->back()];
     }
 
     // Add the new material
     Material* m = new Material(fname, is_full_path, complain_if_not_found, install);
-    m_materials.push_back(m);
+    addMaterial(m);
     if(make_permanent)
     {
         assert(m_shared_material_index==(int)m_materials.size()-1);
@@ -440,11 +479,5 @@ void MaterialManager::unloadAllTextures()
 bool MaterialManager::hasMaterial(const std::string& fname)
 {
     std::string basename=StringUtils::getBasename(fname);
-
-    // Search backward so that temporary (track) textures are found first
-    for(int i = (int)m_materials.size()-1; i>=0; i-- )
-    {
-        if(m_materials[i]->getTexFname()==basename) return true;
-    }
-    return false;
+    return findIndices(m_name_index, basename) != NULL;
 }
@@ -31,6 +31,7 @@ using namespace irr;
 
 #include <irrlicht.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
@@ -50,8 +51,35 @@ private:
 
     std::vector<Material*> m_materials;
 
+    /** Indices in m_materials of all materials with a given texture name,
+     *  in increasing order. The last index shadows the others, the same as
+     *  a backward search through m_materials would. */
+    std::unordered_map<std::string, std::vector<int> > m_name_index;
+
+    /** Same as m_name_index, but for the full path of the textures. */
+    std::unordered_map<std::string, std::vector<int> > m_full_path_index;
+
     std::map<std::string, Material*> m_default_sp_materials;
 
+    /** Number of material lookups since the last reset. */
+    unsigned int m_num_lookups;
+
+    /** Number of materials compared in these lookups. */
+    unsigned int m_num_compared;
+
+    void      addMaterial(Material *m);
+    void      removeLastMaterial();
+    // ------------------------------------------------------------------------
+    /** Returns the indices of the materials with the given key, or NULL. */
+    const std::vector<int>* findIndices(
+              const std::unordered_map<std::string, std::vector<int> > &index,
+              const std::string &key)
+    {
+        m_num_lookups++;
+        auto it = index.find(key);
+        return it == index.end() ? NULL : &it->second;
+    }   // findIndices
+
 public:
               MaterialManager();
              ~MaterialManager();
@@ -82,6 +110,16 @@ public:
     bool      hasMaterial(const std::string& fname);
 
     void      unloadAllTextures();
+    void      renameMaterial(Material *m, const std::string& old_name);
+    // ------------------------------------------------------------------------
+    /** Returns the number of material lookups since the last reset. */
+    unsigned int getNumLookups() const { return m_num_lookups; }
+    // ------------------------------------------------------------------------
+    /** Returns the number of materials compared in these lookups, which
+     *  does not depend on the total number of materials. */
+    unsigned int getNumCompared() const { return m_num_compared; }
+    // ------------------------------------------------------------------------
+    void resetLookupStatistics() { m_num_lookups = m_num_compared = 0; }
 
     Material* getDefaultSPMaterial(const std::string& shader_name,
                                    const std::string& layer_one_lc = "",
@@ -335,8 +335,8 @@ void ParticleEmitter::addHeightMapAffector(Track* t)
     float track_z = aabb_min->getZ();
     const float track_x_len = aabb_max->getX() - aabb_min->getX();
     const float track_z_len = aabb_max->getZ() - aabb_min->getZ();
-    std::vector<std::vector<float> > array = t->buildHeightMap();
-    m_node->setHeightmap(array, track_x, track_z, track_x_len, track_z_len);
+    m_node->setHeightmap(t->getHeightMap(), track_x, track_z, track_x_len,
+                         track_z_len);
 }
 
 //-----------------------------------------------------------------------------
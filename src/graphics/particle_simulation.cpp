@@ -0,0 +1,607 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef SERVER_ONLY
+
+#include "graphics/particle_simulation.hpp"
+#include "utils/log.hpp"
+#include "utils/worker_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#if defined(__AVX__)
+#define PARTICLE_SIMD_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // ------------------------------------------------------------------------
+    inline float glslFract(float val)
+    {
+        return val - (float)floor(val);
+    }   // glslFract
+
+    // ------------------------------------------------------------------------
+    inline float glslMix(float x, float y, float a)
+    {
+        return x * (1.0f - a) + y * a;
+    }   // glslMix
+
+#if defined(PARTICLE_SIMD_AVX) || defined(PARTICLE_SIMD_SSE2)
+#define PARTICLE_SIMD
+    // The kernels below are written once against these wrappers, which
+    // compute exactly the same operations as the scalar code.
+#if defined(PARTICLE_SIMD_AVX)
+    typedef __m256 FloatV;
+    const unsigned int SIMD_WIDTH = 8;
+    inline FloatV loadV(const float* p)        { return _mm256_loadu_ps(p); }
+    inline void storeV(float* p, FloatV a)         { _mm256_storeu_ps(p, a); }
+    inline FloatV setV(float a)                  { return _mm256_set1_ps(a); }
+    inline FloatV addV(FloatV a, FloatV b)    { return _mm256_add_ps(a, b); }
+    inline FloatV subV(FloatV a, FloatV b)    { return _mm256_sub_ps(a, b); }
+    inline FloatV mulV(FloatV a, FloatV b)    { return _mm256_mul_ps(a, b); }
+    inline FloatV divV(FloatV a, FloatV b)    { return _mm256_div_ps(a, b); }
+    inline FloatV orV(FloatV a, FloatV b)      { return _mm256_or_ps(a, b); }
+    /** Returns b where mask is not set, else 0. */
+    inline FloatV andNotV(FloatV mask, FloatV b)
+                                        { return _mm256_andnot_ps(mask, b); }
+    inline FloatV greaterV(FloatV a, FloatV b)
+                                 { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    inline FloatV lessV(FloatV a, FloatV b)
+                                 { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    inline FloatV equalV(FloatV a, FloatV b)
+                                 { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    inline int maskV(FloatV a)                { return _mm256_movemask_ps(a); }
+#else
+    typedef __m128 FloatV;
+    const unsigned int SIMD_WIDTH = 4;
+    inline FloatV loadV(const float* p)           { return _mm_loadu_ps(p); }
+    inline void storeV(float* p, FloatV a)            { _mm_storeu_ps(p, a); }
+    inline FloatV setV(float a)                     { return _mm_set1_ps(a); }
+    inline FloatV addV(FloatV a, FloatV b)       { return _mm_add_ps(a, b); }
+    inline FloatV subV(FloatV a, FloatV b)       { return _mm_sub_ps(a, b); }
+    inline FloatV mulV(FloatV a, FloatV b)       { return _mm_mul_ps(a, b); }
+    inline FloatV divV(FloatV a, FloatV b)       { return _mm_div_ps(a, b); }
+    inline FloatV orV(FloatV a, FloatV b)         { return _mm_or_ps(a, b); }
+    /** Returns b where mask is not set, else 0. */
+    inline FloatV andNotV(FloatV mask, FloatV b)
+                                           { return _mm_andnot_ps(mask, b); }
+    inline FloatV greaterV(FloatV a, FloatV b) { return _mm_cmpgt_ps(a, b); }
+    inline FloatV lessV(FloatV a, FloatV b)    { return _mm_cmplt_ps(a, b); }
+    inline FloatV equalV(FloatV a, FloatV b)   { return _mm_cmpeq_ps(a, b); }
+    inline int maskV(FloatV a)                   { return _mm_movemask_ps(a); }
+#endif
+    // ------------------------------------------------------------------------
+    inline FloatV glslMixV(FloatV x, FloatV y, FloatV a)
+    {
+        return addV(mulV(x, subV(setV(1.0f), a)), mulV(y, a));
+    }   // glslMixV
+#endif
+}   // namespace
+
+// ----------------------------------------------------------------------------
+void ParticleSimulation::Arrays::resize(unsigned int n)
+{
+    for (std::vector<float>* a : { &m_x, &m_y, &m_z, &m_lifetime, &m_dir_x,
+                                   &m_dir_y, &m_dir_z, &m_size })
+    {
+        a->clear();
+        a->resize(n, 0.0f);
+    }
+}   // resize
+
+// ----------------------------------------------------------------------------
+/** Discards all particles and allocates n new ones, which must then be
+ *  initialised by the caller. */
+void ParticleSimulation::resize(unsigned int n)
+{
+    m_count = n;
+    m_generating.resize(n);
+    m_initial.resize(n);
+}   // resize
+
+// ----------------------------------------------------------------------------
+/** Updates one particle without a height map. */
+void ParticleSimulation::stimulateNormalScalar(unsigned int i, float dt,
+                                            unsigned int active_count,
+                                            const core::matrix4& previous_matrix,
+                                            const core::matrix4& cur_matrix)
+{
+    const float updated_lifetime = m_generating.m_lifetime[i] +
+        (dt / m_initial.m_lifetime[i]);
+    if (updated_lifetime > 1.0f)
+    {
+        resetNormal(i, dt, updated_lifetime, active_count, previous_matrix,
+            cur_matrix);
+        return;
+    }
+    m_generating.m_x[i] = m_generating.m_x[i] + m_generating.m_dir_x[i] * dt;
+    m_generating.m_y[i] = m_generating.m_y[i] + m_generating.m_dir_y[i] * dt;
+    m_generating.m_z[i] = m_generating.m_z[i] + m_generating.m_dir_z[i] * dt;
+    m_generating.m_lifetime[i] = updated_lifetime;
+    const float size_initial = m_initial.m_size[i];
+    m_generating.m_size[i] = (m_generating.m_size[i] == 0.0f) ? 0.0f :
+        glslMix(size_initial, size_initial * m_size_increase_factor,
+        updated_lifetime);
+}   // stimulateNormalScalar
+
+// ----------------------------------------------------------------------------
+/** Emits a particle again whose lifetime is over. Its new position is
+ *  interpolated between the emitter positions of the previous and the
+ *  current frame.
+ */
+void ParticleSimulation::resetNormal(unsigned int i, float dt,
+                                     float updated_lifetime,
+                                     unsigned int active_count,
+                                     const core::matrix4& previous_matrix,
+                                     const core::matrix4& cur_matrix)
+{
+    if (i >= active_count)
+    {
+        m_generating.setPosition(i, core::vector3df(0.0f));
+        m_generating.setDirection(i, core::vector3df(0.0f));
+        m_generating.m_lifetime[i] = glslFract(updated_lifetime);
+        m_generating.m_size[i] = 0.0f;
+        return;
+    }
+
+    const core::vector3df particle_position_initial =
+        m_initial.getPosition(i);
+    const core::vector3df particle_direction_initial =
+        m_initial.getDirection(i);
+    const float lifetime_initial = m_initial.m_lifetime[i];
+    const float size_initial = m_initial.m_size[i];
+
+    float dt_from_last_frame = glslFract(updated_lifetime) * lifetime_initial;
+    float coeff = dt_from_last_frame / dt;
+
+    core::vector3df previous_frame_position, current_frame_position,
+        previous_frame_direction, current_frame_direction;
+    previous_matrix.transformVect(previous_frame_position,
+        particle_position_initial);
+    cur_matrix.transformVect(current_frame_position,
+        particle_position_initial);
+
+    core::vector3df updated_position = previous_frame_position
+        .getInterpolated(current_frame_position, coeff);
+
+    previous_matrix.rotateVect(previous_frame_direction,
+        particle_direction_initial);
+    cur_matrix.rotateVect(current_frame_direction,
+        particle_direction_initial);
+
+    core::vector3df updated_direction = previous_frame_direction
+        .getInterpolated(current_frame_direction, coeff);
+    // + (current_frame_position - previous_frame_position) / dt;
+
+    // To be accurate, emitter speed should be added.
+    // But the simple formula
+    // ( (current_frame_position - previous_frame_position) / dt )
+    // with a constant speed between 2 frames creates visual
+    // artifacts when the framerate is low, and a more accurate
+    // formula would need more complex computations.
+
+    m_generating.setPosition(i, updated_position + dt_from_last_frame *
+        updated_direction);
+    m_generating.setDirection(i, updated_direction);
+    m_generating.m_lifetime[i] = glslFract(updated_lifetime);
+    m_generating.m_size[i] = glslMix(size_initial,
+        size_initial * m_size_increase_factor, glslFract(updated_lifetime));
+}   // resetNormal
+
+// ----------------------------------------------------------------------------
+/** Updates all particles of an emitter without a height map.
+ *  \param dt Time step in ms.
+ *  \param active_count Particles with a higher index are not emitted again.
+ *  \param previous_matrix Transform of the emitter in the previous frame.
+ *  \param cur_matrix Transform of the emitter in this frame.
+ */
+void ParticleSimulation::stimulateNormal(float dt, unsigned int active_count,
+                                         const core::matrix4& previous_matrix,
+                                         const core::matrix4& cur_matrix)
+{
+    unsigned int i = 0;
+#ifdef PARTICLE_SIMD
+    if (m_use_simd)
+    {
+        const FloatV dt_v = setV(dt);
+        const FloatV one = setV(1.0f);
+        const FloatV zero = setV(0.0f);
+        const FloatV factor = setV(m_size_increase_factor);
+        float updated[SIMD_WIDTH];
+        for (; i + SIMD_WIDTH <= m_count; i += SIMD_WIDTH)
+        {
+            const FloatV updated_lifetime =
+                addV(loadV(&m_generating.m_lifetime[i]),
+                divV(dt_v, loadV(&m_initial.m_lifetime[i])));
+            const int reset = maskV(greaterV(updated_lifetime, one));
+
+            storeV(&m_generating.m_x[i], addV(loadV(&m_generating.m_x[i]),
+                mulV(loadV(&m_generating.m_dir_x[i]), dt_v)));
+            storeV(&m_generating.m_y[i], addV(loadV(&m_generating.m_y[i]),
+                mulV(loadV(&m_generating.m_dir_y[i]), dt_v)));
+            storeV(&m_generating.m_z[i], addV(loadV(&m_generating.m_z[i]),
+                mulV(loadV(&m_generating.m_dir_z[i]), dt_v)));
+            storeV(&m_generating.m_lifetime[i], updated_lifetime);
+            const FloatV size_initial = loadV(&m_initial.m_size[i]);
+            const FloatV new_size = glslMixV(size_initial,
+                mulV(size_initial, factor), updated_lifetime);
+            storeV(&m_generating.m_size[i], andNotV(
+                equalV(loadV(&m_generating.m_size[i]), zero), new_size));
+
+            if (reset == 0)
+                continue;
+            // The reset particles overwrite the values computed above
+            storeV(updated, updated_lifetime);
+            for (unsigned int j = 0; j < SIMD_WIDTH; j++)
+            {
+                if ((reset & (1 << j)) != 0)
+                {
+                    resetNormal(i + j, dt, updated[j], active_count,
+                        previous_matrix, cur_matrix);
+                }
+            }
+        }
+    }
+#endif
+    for (; i < m_count; i++)
+    {
+        stimulateNormalScalar(i, dt, active_count, previous_matrix,
+            cur_matrix);
+    }
+}   // stimulateNormal
+
+// ----------------------------------------------------------------------------
+bool ParticleSimulation::isBelowHeightMap(unsigned int i,
+                                          const HeightMap& hm) const
+{
+    const int px = core::clamp((int)(256.0f *
+        (m_generating.m_x[i] - hm.m_x) / hm.m_x_len), 0, 255);
+    const int py = core::clamp((int)(256.0f *
+        (m_generating.m_z[i] - hm.m_z) / hm.m_z_len), 0, 255);
+    const float h = m_generating.m_y[i] - hm.m_heights[px * 256 + py];
+    return h < 0.0f;
+}   // isBelowHeightMap
+
+// ----------------------------------------------------------------------------
+/** Updates one particle which is killed below the height map. */
+void ParticleSimulation::stimulateHeightMapScalar(unsigned int i, float dt,
+                                               const core::matrix4& cur_matrix,
+                                               const HeightMap& hm)
+{
+    const float lifetime = m_generating.m_lifetime[i];
+    const float adjusted_lifetime = lifetime + (dt / m_initial.m_lifetime[i]);
+    if (isBelowHeightMap(i, hm) || adjusted_lifetime > 1.0f ||
+        lifetime < 0.0f)
+    {
+        resetHeightMap(i, cur_matrix);
+        return;
+    }
+    m_generating.m_x[i] = m_generating.m_x[i] + m_generating.m_dir_x[i] * dt;
+    m_generating.m_y[i] = m_generating.m_y[i] + m_generating.m_dir_y[i] * dt;
+    m_generating.m_z[i] = m_generating.m_z[i] + m_generating.m_dir_z[i] * dt;
+    m_generating.m_lifetime[i] = adjusted_lifetime;
+    const float size_initial = m_initial.m_size[i];
+    m_generating.m_size[i] = glslMix(size_initial,
+        size_initial * m_size_increase_factor, adjusted_lifetime);
+}   // stimulateHeightMapScalar
+
+// ----------------------------------------------------------------------------
+/** Moves a particle back to the emitter, it becomes visible in the next
+ *  frame. */
+void ParticleSimulation::resetHeightMap(unsigned int i,
+                                        const core::matrix4& cur_matrix)
+{
+    const core::vector3df particle_position_initial =
+        m_initial.getPosition(i);
+    core::vector3df initial_position, initial_new_position;
+    cur_matrix.transformVect(initial_position, particle_position_initial);
+    cur_matrix.transformVect(initial_new_position,
+        particle_position_initial + m_initial.getDirection(i));
+
+    m_generating.setPosition(i, initial_position);
+    m_generating.setDirection(i, initial_new_position - initial_position);
+    m_generating.m_lifetime[i] = 0.0f;
+    m_generating.m_size[i] = 0.0f;
+}   // resetHeightMap
+
+// ----------------------------------------------------------------------------
+/** Updates all particles of an emitter, particles below the height map
+ *  are emitted again.
+ *  \param dt Time step in ms.
+ *  \param cur_matrix Transform of the emitter in this frame.
+ *  \param hm The height map of the track.
+ */
+void ParticleSimulation::stimulateHeightMap(float dt,
+                                            const core::matrix4& cur_matrix,
+                                            const HeightMap& hm)
+{
+    unsigned int i = 0;
+#ifdef PARTICLE_SIMD
+    if (m_use_simd)
+    {
+        const FloatV dt_v = setV(dt);
+        const FloatV one = setV(1.0f);
+        const FloatV zero = setV(0.0f);
+        const FloatV factor = setV(m_size_increase_factor);
+        for (; i + SIMD_WIDTH <= m_count; i += SIMD_WIDTH)
+        {
+            // The height map lookup is a gather, so it is done per particle
+            // (and before the positions are updated).
+            int reset = 0;
+            for (unsigned int j = 0; j < SIMD_WIDTH; j++)
+            {
+                if (isBelowHeightMap(i + j, hm))
+                    reset |= 1 << j;
+            }
+            const FloatV lifetime = loadV(&m_generating.m_lifetime[i]);
+            const FloatV adjusted_lifetime = addV(lifetime,
+                divV(dt_v, loadV(&m_initial.m_lifetime[i])));
+            reset |= maskV(orV(greaterV(adjusted_lifetime, one),
+                lessV(lifetime, zero)));
+
+            storeV(&m_generating.m_x[i], addV(loadV(&m_generating.m_x[i]),
+                mulV(loadV(&m_generating.m_dir_x[i]), dt_v)));
+            storeV(&m_generating.m_y[i], addV(loadV(&m_generating.m_y[i]),
+                mulV(loadV(&m_generating.m_dir_y[i]), dt_v)));
+            storeV(&m_generating.m_z[i], addV(loadV(&m_generating.m_z[i]),
+                mulV(loadV(&m_generating.m_dir_z[i]), dt_v)));
+            storeV(&m_generating.m_lifetime[i], adjusted_lifetime);
+            const FloatV size_initial = loadV(&m_initial.m_size[i]);
+            storeV(&m_generating.m_size[i], glslMixV(size_initial,
+                mulV(size_initial, factor), adjusted_lifetime));
+
+            for (unsigned int j = 0; reset != 0 && j < SIMD_WIDTH; j++)
+            {
+                if ((reset & (1 << j)) != 0)
+                    resetHeightMap(i + j, cur_matrix);
+            }
+        }
+    }
+#endif
+    for (; i < m_count; i++)
+        stimulateHeightMapScalar(i, dt, cur_matrix, hm);
+}   // stimulateHeightMap
+
+// ----------------------------------------------------------------------------
+/** Returns the largest relative difference between the particles of two
+ *  simulations, used to compare the SIMD and the scalar code. */
+float ParticleSimulation::getMaxDifference(const ParticleSimulation& other)
+                                                                         const
+{
+    if (other.m_count != m_count)
+        return INFINITY;
+    const Arrays& a = m_generating;
+    const Arrays& b = other.m_generating;
+    const std::vector<float>* arrays[][2] =
+    {
+        { &a.m_x, &b.m_x }, { &a.m_y, &b.m_y }, { &a.m_z, &b.m_z },
+        { &a.m_lifetime, &b.m_lifetime }, { &a.m_dir_x, &b.m_dir_x },
+        { &a.m_dir_y, &b.m_dir_y }, { &a.m_dir_z, &b.m_dir_z },
+        { &a.m_size, &b.m_size }
+    };
+    float max_difference = 0.0f;
+    for (auto& pair : arrays)
+    {
+        for (unsigned int i = 0; i < m_count; i++)
+        {
+            const float x = (*pair[0])[i];
+            const float y = (*pair[1])[i];
+            if (std::isnan(x) || std::isnan(y))
+            {
+                if (std::isnan(x) != std::isnan(y))
+                    return INFINITY;
+                continue;
+            }
+            const float d = fabsf(x - y) / std::max(1.0f, fabsf(x));
+            max_difference = std::max(max_difference, d);
+        }
+    }
+    return max_difference;
+}   // getMaxDifference
+
+// ============================================================================
+namespace
+{
+    /** The emitters of one benchmark scenario. The values are similar to
+     *  the particle files used for weather, nitro and skidding. */
+    struct BenchmarkScenario
+    {
+        const char* m_name;
+        unsigned int m_num_emitters;
+        unsigned int m_count;
+        float m_min_lifetime;
+        float m_max_lifetime;
+        /** Extent of the box emitter, 0 for a point emitter. */
+        float m_box_size;
+        float m_speed;
+        bool m_weather;
+    };   // BenchmarkScenario
+
+    // ------------------------------------------------------------------------
+    /** Fills the simulation like STKParticle does it for the emitter type. */
+    void initBenchmarkEmitter(const BenchmarkScenario& s,
+                              ParticleSimulation* sim, std::mt19937* rng)
+    {
+        std::uniform_real_distribution<float> frand(0.0f, 1.0f);
+        sim->resize(s.m_count);
+        sim->setIncreaseFactor(s.m_weather ? 1.0f : 2.0f);
+        ParticleSimulation::Arrays& gen = sim->getGenerating();
+        ParticleSimulation::Arrays& init = sim->getInitial();
+        for (unsigned int i = 0; i < s.m_count; i++)
+        {
+            core::vector3df pos(0.0f);
+            if (s.m_box_size > 0.0f)
+            {
+                pos = core::vector3df(frand(*rng), frand(*rng), frand(*rng))
+                    * s.m_box_size - s.m_box_size * 0.5f;
+            }
+            gen.setPosition(i, pos);
+            init.setPosition(i, pos);
+            if (s.m_weather)
+                init.m_y[i] = frand(*rng) * 50.0f;
+            gen.m_lifetime[i] = s.m_weather ? frand(*rng) : 2.0f;
+            init.m_lifetime[i] = s.m_min_lifetime +
+                frand(*rng) * (s.m_max_lifetime - s.m_min_lifetime);
+            core::vector3df dir = s.m_weather ?
+                core::vector3df(0.0f, -s.m_speed, 0.0f) :
+                core::vector3df(frand(*rng) - 0.5f, 1.0f,
+                                frand(*rng) - 0.5f) * s.m_speed;
+            gen.setDirection(i, dir);
+            init.setDirection(i, dir);
+            gen.m_size[i] = init.m_size[i] = 0.1f + frand(*rng) * 0.2f;
+        }
+    }   // initBenchmarkEmitter
+
+    // ------------------------------------------------------------------------
+    /** Returns the transform of an emitter which moves around a track. */
+    core::matrix4 getBenchmarkMatrix(unsigned int emitter, unsigned int frame)
+    {
+        const float t = frame * 0.01f + emitter * 0.3f;
+        core::matrix4 m;
+        m.setRotationDegrees(core::vector3df(0.0f, t * 57.3f, 0.0f));
+        m.setTranslation(core::vector3df(cosf(t) * 50.0f, 0.0f,
+                                         sinf(t) * 50.0f));
+        return m;
+    }   // getBenchmarkMatrix
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Simulates emitters similar to weather, nitro and skidding without any
+ *  graphics with the scalar code, the SIMD code, and the SIMD code with all
+ *  emitters processed in parallel, and checks that the results are the
+ *  same within a small tolerance.
+ *  \param pool The threads for the parallel simulation.
+ *  \return 0 if all results are close enough, 1 otherwise.
+ */
+int ParticleSimulation::runBenchmark(WorkerPool* pool)
+{
+    const BenchmarkScenario scenarios[] =
+    {
+        // name, emitters, particles, lifetime, box size, speed, weather
+        { "weather", 1, 12000, 1500.0f, 2000.0f, 60.0f, 0.02f, true  },
+        { "nitro",  20,   150,  100.0f,  150.0f,  0.0f, 0.01f, false },
+        { "skid",   40,    80,  300.0f,  500.0f,  0.5f, 0.002f, false },
+    };
+    const unsigned int num_frames = 600;
+    const float dt = 1000.0f / 60.0f;
+
+    auto heights = std::make_shared<std::vector<float> >(256 * 256);
+    for (unsigned int x = 0; x < 256; x++)
+    {
+        for (unsigned int z = 0; z < 256; z++)
+        {
+            (*heights)[x * 256 + z] =
+                2.5f * (sinf(x * 0.1f) + cosf(z * 0.1f)) - 5.0f;
+        }
+    }
+    const HeightMap hm(heights, -128.0f, -128.0f, 256.0f, 256.0f);
+
+    int mismatches = 0;
+    for (const BenchmarkScenario& s : scenarios)
+    {
+        std::mt19937 rng(42);
+        std::vector<ParticleSimulation> initial(s.m_num_emitters);
+        for (ParticleSimulation& sim : initial)
+            initBenchmarkEmitter(s, &sim, &rng);
+
+        // 0: scalar, 1: SIMD, 2: SIMD with the emitters in parallel
+        double ms[3];
+        std::vector<ParticleSimulation> result[3];
+        for (unsigned int variant = 0; variant < 3; variant++)
+        {
+            std::vector<ParticleSimulation>& sims = result[variant];
+            sims = initial;
+            for (ParticleSimulation& sim : sims)
+                sim.setUseSIMD(variant > 0);
+            unsigned int frame = 0;
+            WorkerPool::Job job = [&sims, &s, &hm, &frame, dt]
+                (unsigned int e, unsigned int thread)
+            {
+                const core::matrix4 cur = getBenchmarkMatrix(e, frame + 1);
+                if (s.m_weather)
+                {
+                    sims[e].stimulateHeightMap(dt, cur, hm);
+                }
+                else
+                {
+                    sims[e].stimulateNormal(dt, s.m_count,
+                        getBenchmarkMatrix(e, frame), cur);
+                }
+            };
+            auto start = std::chrono::steady_clock::now();
+            for (frame = 0; frame < num_frames; frame++)
+            {
+                if (variant == 2)
+                {
+                    pool->parallelFor(s.m_num_emitters, job);
+                }
+                else
+                {
+                    for (unsigned int e = 0; e < s.m_num_emitters; e++)
+                        job(e, 0);
+                }
+            }
+            ms[variant] = std::chrono::duration<double, std::milli>
+                (std::chrono::steady_clock::now() - start).count()
+                / num_frames;
+        }
+
+        float max_difference = 0.0f;
+        for (unsigned int variant = 1; variant < 3; variant++)
+        {
+            for (unsigned int e = 0; e < s.m_num_emitters; e++)
+            {
+                max_difference = std::max(max_difference,
+                    result[0][e].getMaxDifference(result[variant][e]));
+            }
+        }
+        const bool close = max_difference <= 1e-4f;
+        if (!close)
+            mismatches++;
+        Log::info("ParticleSimulation", "%s: %u emitters with %u particles, "
+            "%.3f ms scalar, %.3f ms SIMD, %.3f ms parallel per frame, "
+            "max difference %g%s", s.m_name, s.m_num_emitters, s.m_count,
+            ms[0], ms[1], ms[2], max_difference,
+            close ? "" : ", results differ");
+    }
+    Log::info("ParticleSimulation", "SIMD width %u, %u threads.",
+#ifdef PARTICLE_SIMD
+        SIMD_WIDTH,
+#else
+        1u,
+#endif
+        pool->getNumThreads());
+    if (mismatches > 0)
+    {
+        Log::error("ParticleSimulation", "%d scenarios differ.", mismatches);
+        return 1;
+    }
+    return 0;
+}   // runBenchmark
+
+#endif   // !SERVER_ONLY
@@ -0,0 +1,173 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef SERVER_ONLY
+
+#ifndef HEADER_PARTICLE_SIMULATION_HPP
+#define HEADER_PARTICLE_SIMULATION_HPP
+
+#include <matrix4.h>
+#include <vector3d.h>
+
+#include <memory>
+#include <vector>
+
+using namespace irr;
+
+class WorkerPool;
+
+/**
+  * \brief Simulates the particles of one emitter on the CPU.
+  *  The particles are stored as structure of arrays, so that the update
+  *  kernels can process 4 (SSE2) or 8 (AVX) particles with each
+  *  instruction. Only particles which are reset to the emitter need
+  *  matrix transforms, they are handled one by one with the same code
+  *  that is used if no SIMD is available.
+  * \ingroup graphics
+  */
+class ParticleSimulation
+{
+public:
+    // ------------------------------------------------------------------------
+    /** The height map used to kill particles which fall below the track. */
+    struct HeightMap
+    {
+        /** 256 x 256 heights, row by row along the x axis, shared by all
+         *  emitters of a track (see Track::getHeightMap). */
+        const std::shared_ptr<const std::vector<float> > m_array;
+        const float* const m_heights;
+        const float m_x;
+        const float m_z;
+        const float m_x_len;
+        const float m_z_len;
+        // --------------------------------------------------------------------
+        HeightMap(std::shared_ptr<const std::vector<float> > array,
+                  float track_x, float track_z, float track_x_len,
+                  float track_z_len)
+            : m_array(array), m_heights(array->data()), m_x(track_x),
+              m_z(track_z), m_x_len(track_x_len), m_z_len(track_z_len) {}
+    };
+    // ------------------------------------------------------------------------
+    /** One array for each component of the particle data. */
+    struct Arrays
+    {
+        std::vector<float> m_x, m_y, m_z, m_lifetime;
+        std::vector<float> m_dir_x, m_dir_y, m_dir_z, m_size;
+        // --------------------------------------------------------------------
+        void resize(unsigned int n);
+        // --------------------------------------------------------------------
+        core::vector3df getPosition(unsigned int i) const
+        {
+            return core::vector3df(m_x[i], m_y[i], m_z[i]);
+        }
+        // --------------------------------------------------------------------
+        void setPosition(unsigned int i, const core::vector3df& p)
+        {
+            m_x[i] = p.X;
+            m_y[i] = p.Y;
+            m_z[i] = p.Z;
+        }
+        // --------------------------------------------------------------------
+        core::vector3df getDirection(unsigned int i) const
+        {
+            return core::vector3df(m_dir_x[i], m_dir_y[i], m_dir_z[i]);
+        }
+        // --------------------------------------------------------------------
+        void setDirection(unsigned int i, const core::vector3df& d)
+        {
+            m_dir_x[i] = d.X;
+            m_dir_y[i] = d.Y;
+            m_dir_z[i] = d.Z;
+        }
+    };
+
+private:
+    /** The current state of the particles. */
+    Arrays m_generating;
+
+    /** The state of the particles when they are (re-)emitted, relative
+     *  to the emitter. */
+    Arrays m_initial;
+
+    /** Number of particles. */
+    unsigned int m_count;
+
+    float m_size_increase_factor;
+
+    /** If false the scalar code is used for all particles. */
+    bool m_use_simd;
+
+    // ------------------------------------------------------------------------
+    void stimulateNormalScalar(unsigned int i, float dt,
+                               unsigned int active_count,
+                               const core::matrix4& previous_matrix,
+                               const core::matrix4& cur_matrix);
+    // ------------------------------------------------------------------------
+    void resetNormal(unsigned int i, float dt, float updated_lifetime,
+                     unsigned int active_count,
+                     const core::matrix4& previous_matrix,
+                     const core::matrix4& cur_matrix);
+    // ------------------------------------------------------------------------
+    bool isBelowHeightMap(unsigned int i, const HeightMap& hm) const;
+    // ------------------------------------------------------------------------
+    void stimulateHeightMapScalar(unsigned int i, float dt,
+                                  const core::matrix4& cur_matrix,
+                                  const HeightMap& hm);
+    // ------------------------------------------------------------------------
+    void resetHeightMap(unsigned int i, const core::matrix4& cur_matrix);
+
+public:
+    // ------------------------------------------------------------------------
+    ParticleSimulation()
+    {
+        m_count = 0;
+        m_size_increase_factor = 0.0f;
+        m_use_simd = true;
+    }
+    // ------------------------------------------------------------------------
+    void resize(unsigned int n);
+    // ------------------------------------------------------------------------
+    void stimulateNormal(float dt, unsigned int active_count,
+                         const core::matrix4& previous_matrix,
+                         const core::matrix4& cur_matrix);
+    // ------------------------------------------------------------------------
+    void stimulateHeightMap(float dt, const core::matrix4& cur_matrix,
+                            const HeightMap& hm);
+    // ------------------------------------------------------------------------
+    float getMaxDifference(const ParticleSimulation& other) const;
+    // ------------------------------------------------------------------------
+    static int runBenchmark(WorkerPool* pool);
+    // ------------------------------------------------------------------------
+    unsigned int getCount() const                         { return m_count; }
+    // ------------------------------------------------------------------------
+    Arrays& getGenerating()                          { return m_generating; }
+    // ------------------------------------------------------------------------
+    const Arrays& getGenerating() const              { return m_generating; }
+    // ------------------------------------------------------------------------
+    Arrays& getInitial()                                { return m_initial; }
+    // ------------------------------------------------------------------------
+    void setIncreaseFactor(float val)         { m_size_increase_factor = val; }
+    // ------------------------------------------------------------------------
+    /** Disables the SIMD kernels, used to compare the results. */
+    void setUseSIMD(bool val)                           { m_use_simd = val; }
+};   // ParticleSimulation
+
+#endif
+
+#endif  // !SERVER_ONLY
@@ -0,0 +1,251 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "graphics/render_stats.hpp"
+
+#include "utils/log.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+bool RenderStats::m_enabled = false;
+std::string RenderStats::m_file_name;
+std::array<RenderStats::Clock::time_point, RenderStats::RT_COUNT>
+                                             RenderStats::m_start;
+RenderStats::FrameSample RenderStats::m_current;
+std::vector<RenderStats::FrameSample> RenderStats::m_all_samples;
+
+// ----------------------------------------------------------------------------
+/** Enables recording of the render statistics.
+ *  \param file_name Name of the files (without extension) the statistics
+ *         are written to at the end of the profile run.
+ */
+void RenderStats::enable(const std::string &file_name)
+{
+    m_enabled = true;
+    m_file_name = file_name;
+    reset();
+}   // enable
+
+// ----------------------------------------------------------------------------
+/** Removes all recorded samples. */
+void RenderStats::reset()
+{
+    m_current.m_counts.fill(0);
+    m_current.m_times.fill(0.0f);
+    m_all_samples.clear();
+}   // reset
+
+// ----------------------------------------------------------------------------
+/** Stores the counts and times of the current frame as one sample, and
+ *  starts the next frame. */
+void RenderStats::endFrame()
+{
+    if (!m_enabled)
+        return;
+    m_all_samples.push_back(m_current);
+    m_current.m_counts.fill(0);
+    m_current.m_times.fill(0.0f);
+}   // endFrame
+
+// ----------------------------------------------------------------------------
+/** Returns a short name for a counter, used in the statistics files. */
+const char* RenderStats::getCounterName(Counter counter)
+{
+    switch (counter)
+    {
+    case RC_LOD_0:                  return "lod-0";
+    case RC_LOD_1:                  return "lod-1";
+    case RC_LOD_2_OR_MORE:          return "lod-2+";
+    case RC_LOD_HIDDEN:             return "lod-hidden";
+    case RC_NODES:                  return "nodes";
+    case RC_SKINNED_NODES:          return "skinned-nodes";
+    case RC_MESH_BUFFERS:           return "mesh-buffers";
+    case RC_CULLED_MESH_BUFFERS:    return "culled-mesh-buffers";
+    case RC_DYNAMIC_DRAW_CALLS:     return "dynamic-draw-calls";
+    case RC_SOLID_DRAW_CALLS:       return "solid-draw-calls";
+    case RC_SOLID_INSTANCES:        return "solid-instances";
+    case RC_SHADOW_DRAW_CALLS:      return "shadow-draw-calls";
+    case RC_SHADOW_INSTANCES:       return "shadow-instances";
+    case RC_TRANSPARENT_DRAW_CALLS: return "transparent-draw-calls";
+    case RC_TRANSPARENT_INSTANCES:  return "transparent-instances";
+    case RC_SOLID_POLYS:            return "solid-polys";
+    case RC_SHADOW_POLYS:           return "shadow-polys";
+    case RC_COUNT:                  break;
+    }
+    return "unknown";
+}   // getCounterName
+
+// ----------------------------------------------------------------------------
+/** Returns a short name for a timer, used in the statistics files. */
+const char* RenderStats::getTimerName(Timer timer)
+{
+    switch (timer)
+    {
+    case RT_SCENE_PARSE: return "scene-parse-us";
+    case RT_CULLING:     return "culling-us";
+    case RT_BUCKETING:   return "bucketing-us";
+    case RT_UPLOAD:      return "upload-us";
+    case RT_COUNT:       break;
+    }
+    return "unknown";
+}   // getTimerName
+
+// ----------------------------------------------------------------------------
+/** Returns the name of a column, the counters are followed by the timers. */
+const char* RenderStats::getColumnName(unsigned column)
+{
+    if (column < RC_COUNT)
+        return getCounterName((Counter)column);
+    return getTimerName((Timer)(column - RC_COUNT));
+}   // getColumnName
+
+// ----------------------------------------------------------------------------
+/** Computes min, median, p99, max and average of one column over all
+ *  recorded frames. There must be at least one sample.
+ */
+void RenderStats::getStatistics(unsigned column, float *min, float *median,
+                                float *p99, float *max, float *average)
+{
+    const size_t n = m_all_samples.size();
+    std::vector<float> values(n);
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const FrameSample &s = m_all_samples[i];
+        values[i] = column < RC_COUNT ? (float)s.m_counts[column]
+                                      : s.m_times[column - RC_COUNT];
+        sum += values[i];
+    }
+    std::sort(values.begin(), values.end());
+    // Nearest-rank percentiles
+    *min     = values[0];
+    *median  = values[(n - 1) / 2];
+    *p99     = values[std::min(n - 1, (size_t)std::ceil(0.99 * n) - 1)];
+    *max     = values[n - 1];
+    *average = (float)(sum / n);
+}   // getStatistics
+
+// ----------------------------------------------------------------------------
+/** Prints min, median, p99, max and average of all counters and times for
+ *  the frames recorded since the last reset. */
+void RenderStats::printStatistics()
+{
+    const size_t n = m_all_samples.size();
+    Log::info("RenderStats", "%d frames, times in microseconds.", (int)n);
+    if (n == 0)
+        return;
+
+    Log::info("RenderStats", "%-22s %9s %9s %9s %9s %9s", "value",
+              "min", "median", "p99", "max", "average");
+    for (unsigned column = 0; column < getNumColumns(); column++)
+    {
+        float min, median, p99, max, average;
+        getStatistics(column, &min, &median, &p99, &max, &average);
+        Log::info("RenderStats", "%-22s %9.1f %9.1f %9.1f %9.1f %9.1f",
+                  getColumnName(column), min, median, p99, max, average);
+    }
+}   // printStatistics
+
+// ----------------------------------------------------------------------------
+/** Writes one line with all counts and times for each recorded frame.
+ *  \return False if the file could not be written.
+ */
+bool RenderStats::writeCSV(const std::string &filename)
+{
+    FILE *fd = fopen(filename.c_str(), "w");
+    if (!fd)
+        return false;
+
+    fprintf(fd, "frame");
+    for (unsigned column = 0; column < getNumColumns(); column++)
+        fprintf(fd, ",%s", getColumnName(column));
+    fprintf(fd, "\n");
+
+    for (size_t i = 0; i < m_all_samples.size(); i++)
+    {
+        const FrameSample &s = m_all_samples[i];
+        fprintf(fd, "%d", (int)i);
+        for (unsigned counter = 0; counter < RC_COUNT; counter++)
+            fprintf(fd, ",%u", s.m_counts[counter]);
+        for (unsigned timer = 0; timer < RT_COUNT; timer++)
+            fprintf(fd, ",%.1f", s.m_times[timer]);
+        fprintf(fd, "\n");
+    }
+    return fclose(fd) == 0;
+}   // writeCSV
+
+// ----------------------------------------------------------------------------
+/** Writes the number of frames and the statistics of each counter and time
+ *  as a JSON object.
+ *  \return False if the file could not be written.
+ */
+bool RenderStats::writeJSON(const std::string &filename)
+{
+    FILE *fd = fopen(filename.c_str(), "w");
+    if (!fd)
+        return false;
+
+    const size_t n = m_all_samples.size();
+    fprintf(fd, "{\n  \"frames\": %d", (int)n);
+    if (n > 0)
+    {
+        fprintf(fd, ",\n  \"statistics\": {");
+        for (unsigned column = 0; column < getNumColumns(); column++)
+        {
+            float min, median, p99, max, average;
+            getStatistics(column, &min, &median, &p99, &max, &average);
+            fprintf(fd, "%s\n    \"%s\": { \"min\": %.1f, \"median\": %.1f, "
+                    "\"p99\": %.1f, \"max\": %.1f, \"average\": %.2f }",
+                    column == 0 ? "" : ",", getColumnName(column), min,
+                    median, p99, max, average);
+        }
+        fprintf(fd, "\n  }");
+    }
+    fprintf(fd, "\n}\n");
+    return fclose(fd) == 0;
+}   // writeJSON
+
+// ----------------------------------------------------------------------------
+/** Writes all recorded frames to <file name>.csv and their statistics to
+ *  <file name>.json.
+ *  \return False if one of the files could not be written.
+ */
+bool RenderStats::write()
+{
+    bool ok = true;
+    const std::string csv = m_file_name + ".csv";
+    const std::string json = m_file_name + ".json";
+    if (!writeCSV(csv))
+    {
+        Log::error("RenderStats", "Can't write '%s'.", csv.c_str());
+        ok = false;
+    }
+    if (!writeJSON(json))
+    {
+        Log::error("RenderStats", "Can't write '%s'.", json.c_str());
+        ok = false;
+    }
+    if (ok)
+    {
+        Log::info("RenderStats", "Wrote %d frames to '%s' and '%s'.",
+                  (int)m_all_samples.size(), csv.c_str(), json.c_str());
+    }
+    return ok;
+}   // write
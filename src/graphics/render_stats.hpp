@@ -0,0 +1,166 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_RENDER_STATS_HPP
+#define HEADER_RENDER_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/** \brief Records per frame statistics of the SP renderer in profile mode:
+ *  which level of detail the LOD nodes use, how many nodes and mesh buffers
+ *  are culled, how many instances are drawn in how many instanced draw
+ *  calls for each pass, and the CPU time of culling, bucketing and
+ *  uploading. One sample is kept per rendered frame, and at the end of a
+ *  profile run all samples are written to a CSV file and a summary of them
+ *  to a JSON file, so that renderer changes can be compared on the same
+ *  track. The recording calls only check a static flag when disabled.
+ * \ingroup graphics
+ */
+class RenderStats
+{
+public:
+    /** The values counted per frame. If several views are rendered in one
+     *  frame (split screen), the counts of all views are added. */
+    enum Counter
+    {
+        RC_LOD_0,
+        RC_LOD_1,
+        RC_LOD_2_OR_MORE,
+        RC_LOD_HIDDEN,
+        RC_NODES,
+        RC_SKINNED_NODES,
+        RC_MESH_BUFFERS,
+        RC_CULLED_MESH_BUFFERS,
+        RC_DYNAMIC_DRAW_CALLS,
+        RC_SOLID_DRAW_CALLS,
+        RC_SOLID_INSTANCES,
+        RC_SHADOW_DRAW_CALLS,
+        RC_SHADOW_INSTANCES,
+        RC_TRANSPARENT_DRAW_CALLS,
+        RC_TRANSPARENT_INSTANCES,
+        RC_SOLID_POLYS,
+        RC_SHADOW_POLYS,
+        RC_COUNT
+    };
+
+    /** The CPU times measured per frame. */
+    enum Timer
+    {
+        RT_SCENE_PARSE,
+        RT_CULLING,
+        RT_BUCKETING,
+        RT_UPLOAD,
+        RT_COUNT
+    };
+
+    /** The counts and times (in microseconds) of one frame. */
+    struct FrameSample
+    {
+        std::array<unsigned, RC_COUNT> m_counts;
+        std::array<float, RT_COUNT>    m_times;
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /** True if statistics should be recorded. */
+    static bool m_enabled;
+
+    /** The file name (without extension) the statistics are written to. */
+    static std::string m_file_name;
+
+    /** Start time of each timer in the current frame. */
+    static std::array<Clock::time_point, RT_COUNT> m_start;
+
+    /** The counts and times of the current frame. */
+    static FrameSample m_current;
+
+    /** One entry for each frame since the last reset. */
+    static std::vector<FrameSample> m_all_samples;
+
+    static unsigned    getNumColumns() { return RC_COUNT + RT_COUNT; }
+    static const char* getColumnName(unsigned column);
+    static void        getStatistics(unsigned column, float *min,
+                                     float *median, float *p99, float *max,
+                                     float *average);
+    static bool        writeCSV(const std::string &filename);
+    static bool        writeJSON(const std::string &filename);
+
+public:
+    static void enable(const std::string &file_name);
+    static void reset();
+    static void endFrame();
+    static void printStatistics();
+    static bool write();
+    static const char* getCounterName(Counter counter);
+    static const char* getTimerName(Timer timer);
+    // ------------------------------------------------------------------------
+    /** Returns true if render statistics are recorded. */
+    static bool isEnabled() { return m_enabled; }
+    // ------------------------------------------------------------------------
+    /** Returns all samples recorded since the last reset. */
+    static const std::vector<FrameSample>& getSamples()
+    {
+        return m_all_samples;
+    }   // getSamples
+    // ------------------------------------------------------------------------
+    /** Adds n to a counter of the current frame. */
+    static void add(Counter counter, unsigned n = 1)
+    {
+        if (m_enabled)
+            m_current.m_counts[counter] += n;
+    }   // add
+    // ------------------------------------------------------------------------
+    /** Counts a LOD node which uses the given level, -1 if all levels are
+     *  hidden because the node is too far away. */
+    static void addLodLevel(int level)
+    {
+        if (level < 0)
+            add(RC_LOD_HIDDEN);
+        else if (level == 0)
+            add(RC_LOD_0);
+        else if (level == 1)
+            add(RC_LOD_1);
+        else
+            add(RC_LOD_2_OR_MORE);
+    }   // addLodLevel
+    // ------------------------------------------------------------------------
+    /** Marks the start of a timer in the current frame. */
+    static void start(Timer timer)
+    {
+        if (m_enabled)
+            m_start[timer] = Clock::now();
+    }   // start
+    // ------------------------------------------------------------------------
+    /** Marks the end of a timer in the current frame. A timer can be
+     *  started and stopped several times per frame, the times are
+     *  accumulated. */
+    static void stop(Timer timer)
+    {
+        if (!m_enabled)
+            return;
+        std::chrono::duration<float, std::micro> d =
+            Clock::now() - m_start[timer];
+        m_current.m_times[timer] += d.count();
+    }   // stop
+};   // RenderStats
+
+#endif
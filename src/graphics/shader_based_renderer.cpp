@@ -34,6 +34,7 @@
 #include "graphics/skybox.hpp"
 #include "graphics/spherical_harmonics.hpp"
 #include "graphics/sp/sp_base.hpp"
+#include "graphics/sp/sp_mesh_node.hpp"
 #include "graphics/sp/sp_shader.hpp"
 #include "graphics/texture_shader.hpp"
 #include "graphics/text_billboard_drawer.hpp"
@@ -720,8 +721,10 @@ void ShaderBasedRenderer::render(float dt, bool is_loading)
 
     {
         PROFILER_PUSH_CPU_MARKER("Update scene", 0x0, 0xFF, 0x0);
+        SP::SPMeshNode::startSkinningBatch();
         static_cast<scene::CSceneManager *>(irr_driver->getSceneManager())
             ->OnAnimate(os::Timer::getTime());
+        SP::SPMeshNode::finishSkinningBatch(irr_driver->getRenderWorkerPool());
         PROFILER_POP_CPU_MARKER();
     }
 
@@ -844,8 +847,10 @@ void ShaderBasedRenderer::renderToTexture(GL3RenderTarget *render_target,
     assert(m_rtts != NULL);
 
     irr_driver->getSceneManager()->setActiveCamera(camera);
+    SP::SPMeshNode::startSkinningBatch();
     static_cast<scene::CSceneManager *>(irr_driver->getSceneManager())
         ->OnAnimate(os::Timer::getTime());
+    SP::SPMeshNode::finishSkinningBatch(irr_driver->getRenderWorkerPool());
     computeMatrixesAndCameras(camera, m_rtts->getWidth(), m_rtts->getHeight());
     if (CVS->isARBUniformBufferObjectUsable())
         uploadLightingData();
@@ -38,6 +38,8 @@
 #include "utils/constants.hpp"
 #include "utils/mini_glm.hpp"
 
+#include <algorithm>
+
 /** Creates the slip stream object
  *  \param kart Pointer to the kart to which the slip stream
  *              belongs to.
@@ -683,15 +685,22 @@ void SlipStream::update(int ticks)
     bool is_inner_sstreaming = false;
     bool is_outer_sstreaming = false;
     m_target_kart            = NULL;
-    std::vector<float> target_value;
+    std::vector<float> target_value(num_karts, 0.0f);
 
     // Note that this loop can not be simply replaced with a shorter loop
     // using only the karts with a better position - since a kart might
-    // be a lap behind
-    for(unsigned int i=0; i<num_karts; i++)
+    // be a lap behind. Only the karts whose slipstream can reach this kart
+    // are tested, the exact range is tested below.
+    std::vector<unsigned int> in_range;
+    world->getKartProximityIndex().getKartsReaching(m_kart->getXYZ(),
+        0.5f*m_kart->getKartLength(), &in_range);
+    if (m_previous_target_id >= 0 &&
+        !std::binary_search(in_range.begin(), in_range.end(),
+                            (unsigned int)m_previous_target_id))
+        m_previous_target_id = -1;
+    for(unsigned int i : in_range)
     {
         m_target_kart= world->getKart(i);
-        target_value.push_back(0);
 
         // Don't test for slipstream with itself, a kart that is being
         // rescued or exploding, a ghost kart or an eliminated kart
@@ -789,6 +798,9 @@ void SlipStream::update(int ticks)
         }
     }   // for i < num_karts
 
+    // Without a target the debug colors below are set for the last kart
+    m_target_kart = world->getKart(num_karts - 1);
+
     int best_target=-1;
     float best_target_value=0.0f;
     
@@ -895,6 +907,24 @@ void SlipStream::update(int ticks)
     m_slipstream_mode = SS_COLLECT;
 }   // update
 
+// ----------------------------------------------------------------------------
+/** Returns the maximum distance between this kart and another kart in its
+ *  slipstream until the next physics update (see the quick test in
+ *  update()). It is used to build the kart proximity index after the
+ *  physics update, when the speed of the kart is not updated yet, so the
+ *  speed of the physics body is used as well.
+ */
+float SlipStream::getMaxRange() const
+{
+    if (m_kart->isGhostKart())
+        return 0.0f;
+    const KartProperties *kp = m_kart->getKartProperties();
+    float speed = std::max(m_kart->getSpeed(),
+                           m_kart->getVelocity().length());
+    return kp->getSlipstreamLength() * 1.1f * speed
+         / kp->getSlipstreamBaseSpeed() + m_kart->getKartLength();
+}   // getMaxRange
+
 // ----------------------------------------------------------------------------
 void SlipStream::updateSpeedIncrease()
 {
@@ -127,6 +127,7 @@ public:
     void         update(int ticks);
     bool         isSlipstreamReady() const;
     void         updateSpeedIncrease();
+    float        getMaxRange() const;
     // ------------------------------------------------------------------------
     /** Returns the quad in which slipstreaming is effective for
      *  this kart. */
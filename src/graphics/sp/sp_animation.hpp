@@ -19,6 +19,7 @@
 #define HEADER_SP_ANIMATION_HPP
 
 #include "utils/log.hpp"
+#include "utils/mini_glm.hpp"
 #include "utils/types.hpp"
 
 #include <IReadFile.h>
@@ -63,6 +64,17 @@ struct LocRotScale
     }
 };
 
+/** The state of posing one armature, kept by each scene node, so that the
+ *  nodes sharing a mesh can be posed independently and in parallel. */
+struct ArmaturePose
+{
+    std::vector<core::matrix4> m_interpolated_matrices;
+
+    std::vector<core::matrix4> m_world_matrices;
+
+    std::vector<char> m_world_computed;
+};
+
 struct Armature
 {
     unsigned m_joint_used;
@@ -139,19 +151,28 @@ struct Armature
         }
     }
     // ------------------------------------------------------------------------
-    /* Because matrix4 in windows is not 64 bytes */
-    void getPose(float frame, std::array<float, 16>* dest)
+    /** Computes the skinning matrices of a frame without changing the
+     *  armature, all intermediate results are stored in pose. The world
+     *  matrices of joints which are not needed for skinning are copied from
+     *  the last pose computed in the armature itself (the bind frame).
+     *  Uses std::array because matrix4 in windows is not 64 bytes. */
+    void getPose(float frame, std::array<float, 16>* dest,
+                 ArmaturePose* pose) const
     {
-        getInterpolatedMatrices(frame);
-        for (auto& p : m_world_matrices)
+        const unsigned joints = (unsigned)m_joint_names.size();
+        pose->m_interpolated_matrices.resize(joints);
+        pose->m_world_matrices.resize(joints);
+        pose->m_world_computed.assign(joints, 0);
+        getInterpolatedMatrices(frame, &pose->m_interpolated_matrices);
+        for (unsigned i = 0; i < m_joint_used; i++)
         {
-            p.second = false;
+            MiniGLM::multiplyMatrix4(getWorldMatrix(pose, i).pointer(),
+                m_joint_matrices[i].pointer(), dest[i].data());
         }
-        for (unsigned i = 0; i < m_joint_used; i++)
+        for (unsigned i = 0; i < joints; i++)
         {
-            core::matrix4 m = getWorldMatrix(m_interpolated_matrices, i) *
-                m_joint_matrices[i];
-            memcpy(&dest[i], m.pointer(), 64);
+            if (!pose->m_world_computed[i])
+                pose->m_world_matrices[i] = m_world_matrices[i].first;
         }
     }
     // ------------------------------------------------------------------------
@@ -171,12 +192,19 @@ struct Armature
     // ------------------------------------------------------------------------
     void getInterpolatedMatrices(float frame)
     {
+        getInterpolatedMatrices(frame, &m_interpolated_matrices);
+    }
+    // ------------------------------------------------------------------------
+    void getInterpolatedMatrices(float frame,
+                                 std::vector<core::matrix4>* out) const
+    {
+        std::vector<core::matrix4>& interpolated_matrices = *out;
         if (frame < float(m_frame_pose_matrices.front().first) ||
             frame >= float(m_frame_pose_matrices.back().first))
         {
-            for (unsigned i = 0; i < m_interpolated_matrices.size(); i++)
+            for (unsigned i = 0; i < interpolated_matrices.size(); i++)
             {
-                m_interpolated_matrices[i] =
+                interpolated_matrices[i] =
                     frame >= float(m_frame_pose_matrices.back().first) ?
                     m_frame_pose_matrices.back().second[i].toMatrix() :
                     m_frame_pose_matrices.front().second[i].toMatrix();
@@ -203,7 +231,7 @@ struct Armature
         }
         assert(frame_1 != -1);
         assert(frame_2 != -1);
-        for (unsigned i = 0; i < m_interpolated_matrices.size(); i++)
+        for (unsigned i = 0; i < interpolated_matrices.size(); i++)
         {
             LocRotScale interpolated;
             interpolated.m_loc =
@@ -215,7 +243,7 @@ struct Armature
             interpolated.m_scale =
                 m_frame_pose_matrices[frame_2].second[i].m_scale.getInterpolated
                 (m_frame_pose_matrices[frame_1].second[i].m_scale, interpolation);
-            m_interpolated_matrices[i] = interpolated.toMatrix();
+            interpolated_matrices[i] = interpolated.toMatrix();
         }
     }
     // ------------------------------------------------------------------------
@@ -238,6 +266,29 @@ struct Armature
             std::make_pair(m_world_matrices[parent_id].first * mat, true);
         return m_world_matrices[id].first;
     }
+    // ------------------------------------------------------------------------
+    /** Returns the world matrix of a joint in pose, computing it and its
+     *  parents first if needed. */
+    const core::matrix4& getWorldMatrix(ArmaturePose* pose, unsigned id) const
+    {
+        if (pose->m_world_computed[id])
+        {
+            return pose->m_world_matrices[id];
+        }
+        int parent_id = m_parent_infos[id];
+        if (parent_id == -1)
+        {
+            pose->m_world_matrices[id] = pose->m_interpolated_matrices[id];
+        }
+        else
+        {
+            MiniGLM::multiplyMatrix4(getWorldMatrix(pose, parent_id)
+                .pointer(), pose->m_interpolated_matrices[id].pointer(),
+                pose->m_world_matrices[id].pointer());
+        }
+        pose->m_world_computed[id] = 1;
+        return pose->m_world_matrices[id];
+    }
 };
 
 }
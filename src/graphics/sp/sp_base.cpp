@@ -29,8 +29,10 @@
 #include "graphics/shader_based_renderer.hpp"
 #include "graphics/post_processing.hpp"
 #include "graphics/render_info.hpp"
+#include "graphics/render_stats.hpp"
 #include "graphics/rtts.hpp"
 #include "graphics/shaders.hpp"
+#include "graphics/sp/sp_culling.hpp"
 #include "graphics/sp/sp_dynamic_draw_call.hpp"
 #include "graphics/sp/sp_instanced_data.hpp"
 #include "graphics/sp/sp_per_object_uniform.hpp"
@@ -48,11 +50,13 @@
 #include "utils/helpers.hpp"
 #include "utils/profiler.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/worker_pool.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -87,11 +91,28 @@ std::vector<std::pair<SPShader*, std::vector<std::pair<std::array<GLuint, 6>,
     std::vector<std::pair<SPMeshBuffer*, int/*material_id*/> > > > > >
     g_final_draw_calls[DCT_FOR_VAO];
 // ----------------------------------------------------------------------------
-std::unordered_map<unsigned, std::pair<core::vector3df,
-    std::unordered_set<SPMeshBuffer*> > > g_glow_meshes;
+typedef std::unordered_map<unsigned, std::pair<core::vector3df,
+    std::unordered_set<SPMeshBuffer*> > > GlowMeshes;
+
+GlowMeshes g_glow_meshes;
 // ----------------------------------------------------------------------------
 std::unordered_set<SPMeshBuffer*> g_instances;
 // ----------------------------------------------------------------------------
+/** The draw calls of a part of the culled mesh buffers, filled in parallel
+ *  and merged in order afterwards. */
+struct DrawCallBucket
+{
+    DrawCall m_draw_calls[DCT_FOR_VAO];
+
+    std::vector<std::tuple<SPMeshBuffer*, DrawCallType, SPInstancedData> >
+        m_instance_data;
+
+    GlowMeshes m_glow_meshes;
+
+    std::unordered_set<SPMeshBuffer*> m_instances;
+};
+std::vector<DrawCallBucket> g_buckets;
+// ----------------------------------------------------------------------------
 std::array<GLuint, ST_COUNT> g_samplers;
 // ----------------------------------------------------------------------------
 // Check sp_shader.cpp for the name
@@ -103,7 +124,12 @@ std::vector<float> g_bounding_boxes;
 // ----------------------------------------------------------------------------
 std::vector<std::shared_ptr<SPDynamicDrawCall> > g_dy_dc;
 // ----------------------------------------------------------------------------
-float g_frustums[5][24] = { { } };
+SPCulling g_culling;
+// ----------------------------------------------------------------------------
+std::vector<SPMeshNode*> g_cull_nodes;
+// ----------------------------------------------------------------------------
+/** Node and mesh buffer index of each box in g_culling. */
+std::vector<std::pair<SPMeshNode*, unsigned> > g_cull_mesh_buffers;
 // ----------------------------------------------------------------------------
 unsigned sp_solid_poly_count = 0;
 // ----------------------------------------------------------------------------
@@ -637,65 +663,6 @@ SPShader* getNormalVisualizer()
     return g_normal_visualizer;
 }   // getNormalVisualizer
 
-// ----------------------------------------------------------------------------
-inline void mathPlaneNormf(float *p)
-{
-    float f = 1.0f / sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
-    p[0] *= f;
-    p[1] *= f;
-    p[2] *= f;
-    p[3] *= f;
-}   // mathPlaneNormf
-
-// ----------------------------------------------------------------------------
-inline void mathPlaneFrustumf(float* out, const core::matrix4& pvm)
-{
-    // return 6 planes, 24 floats
-    const float* m = pvm.pointer();
-
-    // near
-    out[0] = m[3] + m[2];
-    out[1] = m[7] + m[6];
-    out[2] = m[11] + m[10];
-    out[3] = m[15] + m[14];
-    mathPlaneNormf(&out[0]);
-
-    // right
-    out[4] = m[3] - m[0];
-    out[4 + 1] = m[7] - m[4];
-    out[4 + 2] = m[11] - m[8];
-    out[4 + 3] = m[15] - m[12];
-    mathPlaneNormf(&out[4]);
-
-    // left
-    out[2 * 4] = m[3] + m[0];
-    out[2 * 4 + 1] = m[7] + m[4];
-    out[2 * 4 + 2] = m[11] + m[8];
-    out[2 * 4 + 3] = m[15] + m[12];
-    mathPlaneNormf(&out[2 * 4]);
-
-    // bottom
-    out[3 * 4] = m[3] + m[1];
-    out[3 * 4 + 1] = m[7] + m[5];
-    out[3 * 4 + 2] = m[11] + m[9];
-    out[3 * 4 + 3] = m[15] + m[13];
-    mathPlaneNormf(&out[3 * 4]);
-
-    // top
-    out[4 * 4] = m[3] - m[1];
-    out[4 * 4 + 1] = m[7] - m[5];
-    out[4 * 4 + 2] = m[11] - m[9];
-    out[4 * 4 + 3] = m[15] - m[13];
-    mathPlaneNormf(&out[4 * 4]);
-
-    // far
-    out[5 * 4] = m[3] - m[2];
-    out[5 * 4 + 1] = m[7] - m[6];
-    out[5 * 4 + 2] = m[11] - m[10];
-    out[5 * 4 + 3] = m[15] - m[14];
-    mathPlaneNormf(&out[5 * 4]);
-}   // mathPlaneFrustumf
-
 // ----------------------------------------------------------------------------
 inline core::vector3df getCorner(const core::aabbox3df& bbox, unsigned n)
 {
@@ -742,6 +709,23 @@ void addEdgeForViz(const core::vector3df& p0, const core::vector3df& p1)
     g_bounding_boxes.push_back(p1.Z);
 }   // addEdgeForViz
 
+// ----------------------------------------------------------------------------
+void addBoxForViz(const core::aabbox3df& bb)
+{
+    addEdgeForViz(getCorner(bb, 0), getCorner(bb, 1));
+    addEdgeForViz(getCorner(bb, 1), getCorner(bb, 5));
+    addEdgeForViz(getCorner(bb, 5), getCorner(bb, 4));
+    addEdgeForViz(getCorner(bb, 4), getCorner(bb, 0));
+    addEdgeForViz(getCorner(bb, 2), getCorner(bb, 3));
+    addEdgeForViz(getCorner(bb, 3), getCorner(bb, 7));
+    addEdgeForViz(getCorner(bb, 7), getCorner(bb, 6));
+    addEdgeForViz(getCorner(bb, 6), getCorner(bb, 2));
+    addEdgeForViz(getCorner(bb, 0), getCorner(bb, 2));
+    addEdgeForViz(getCorner(bb, 1), getCorner(bb, 3));
+    addEdgeForViz(getCorner(bb, 5), getCorner(bb, 7));
+    addEdgeForViz(getCorner(bb, 4), getCorner(bb, 6));
+}   // addBoxForViz
+
 // ----------------------------------------------------------------------------
 void prepareDrawCalls()
 {
@@ -756,21 +740,18 @@ void prepareDrawCalls()
     // 1st one is identity
     g_skinning_offset = 1;
     g_skinning_mesh.clear();
-    mathPlaneFrustumf(g_frustums[0], irr_driver->getProjViewMatrix());
+    g_culling.setFrustum(0, irr_driver->getProjViewMatrix());
     g_handle_shadow = Track::getCurrentTrack() &&
         Track::getCurrentTrack()->hasShadows() && CVS->isDeferredEnabled() &&
         CVS->isShadowEnabled();
 
     if (g_handle_shadow)
     {
-        mathPlaneFrustumf(g_frustums[1],
-            g_stk_sbr->getShadowMatrices()->getSunOrthoMatrices()[0]);
-        mathPlaneFrustumf(g_frustums[2],
-            g_stk_sbr->getShadowMatrices()->getSunOrthoMatrices()[1]);
-        mathPlaneFrustumf(g_frustums[3],
-            g_stk_sbr->getShadowMatrices()->getSunOrthoMatrices()[2]);
-        mathPlaneFrustumf(g_frustums[4],
-            g_stk_sbr->getShadowMatrices()->getSunOrthoMatrices()[3]);
+        for (unsigned i = 1; i < SPCulling::MAX_FRUSTUMS; i++)
+        {
+            g_culling.setFrustum(i,
+                g_stk_sbr->getShadowMatrices()->getSunOrthoMatrices()[i - 1]);
+        }
     }
 
     for (auto& p : g_draw_calls)
@@ -786,6 +767,7 @@ void prepareDrawCalls()
 }
 
 // ----------------------------------------------------------------------------
+/** Adds a node to be culled and drawn in this frame, see cullObjects. */
 void addObject(SPMeshNode* node)
 {
     if (!sp_culling)
@@ -797,100 +779,112 @@ void addObject(SPMeshNode* node)
     {
         return;
     }
+    g_cull_nodes.push_back(node);
+}   // addObject
 
-    const core::matrix4& model_matrix = node->getAbsoluteTransformation();
-    bool added_for_skinning = false;
-    for (unsigned m = 0; m < node->getSPM()->getMeshBufferCount(); m++)
+// ----------------------------------------------------------------------------
+/** Culls the mesh buffers of all nodes added with addObject and adds the
+ *  visible ones to the draw calls. Culling and building the draw calls are
+ *  split over the render threads, each job fills its own bucket, and the
+ *  buckets are merged in the order of the nodes afterwards. So the result
+ *  is the same as adding one mesh buffer after another.
+ */
+void cullObjects()
+{
+    if (!sp_culling)
     {
-        SPMeshBuffer* mb = node->getSPM()->getSPMeshBuffer(m);
-        SPShader* shader = node->getShader(m);
-        if (shader == NULL)
-        {
-            continue;
-        }
-        core::aabbox3df bb = mb->getBoundingBox();
-        model_matrix.transformBoxEx(bb);
-        std::vector<bool> discard;
-        const bool handle_shadow = node->isInShadowPass() &&
-            g_handle_shadow && shader->hasShader(RP_SHADOW);
-        discard.resize((handle_shadow ? 5 : 1), false);
+        return;
+    }
 
-        for (int dc_type = 0; dc_type < (handle_shadow ? 5 : 1); dc_type++)
+    RenderStats::start(RenderStats::RT_CULLING);
+    g_cull_mesh_buffers.clear();
+    for (SPMeshNode* node : g_cull_nodes)
+    {
+        for (unsigned m = 0; m < node->getSPM()->getMeshBufferCount(); m++)
         {
-            for (int i = 0; i < 24; i += 4)
+            if (node->getShader(m) != NULL)
             {
-                bool outside = true;
-                for (int j = 0; j < 8; j++)
-                {
-                    const float dist =
-                        getCorner(bb, j).X * g_frustums[dc_type][i] +
-                        getCorner(bb, j).Y * g_frustums[dc_type][i + 1] +
-                        getCorner(bb, j).Z * g_frustums[dc_type][i + 2] +
-                        g_frustums[dc_type][i + 3];
-                    outside = outside && dist < 0.0f;
-                    if (!outside)
-                    {
-                        break;
-                    }
-                }
-                if (outside)
-                {
-                    discard[dc_type] = true;
-                    break;
-                }
+                g_cull_mesh_buffers.emplace_back(node, m);
             }
         }
-        if (handle_shadow ?
-            (discard[0] && discard[1] && discard[2] && discard[3] &&
-            discard[4]) : discard[0])
+    }
+    const unsigned count = (unsigned)g_cull_mesh_buffers.size();
+    RenderStats::add(RenderStats::RC_NODES, (unsigned)g_cull_nodes.size());
+    RenderStats::add(RenderStats::RC_MESH_BUFFERS, count);
+    g_culling.resize(count);
+    WorkerPool* pool = irr_driver->getRenderWorkerPool();
+    const unsigned num_jobs = pool->getNumThreads();
+    g_buckets.resize(num_jobs);
+
+    pool->parallelFor(num_jobs, [count, num_jobs](unsigned j, unsigned thread)
+    {
+        const unsigned first = count * j / num_jobs;
+        const unsigned last = count * (j + 1) / num_jobs;
+        for (unsigned i = first; i < last; i++)
+        {
+            SPMeshNode* node = g_cull_mesh_buffers[i].first;
+            const unsigned m = g_cull_mesh_buffers[i].second;
+            core::aabbox3df bb =
+                node->getSPM()->getSPMeshBuffer(m)->getBoundingBox();
+            node->getAbsoluteTransformation().transformBoxEx(bb);
+            const bool handle_shadow = node->isInShadowPass() &&
+                g_handle_shadow && node->getShader(m)->hasShader(RP_SHADOW);
+            g_culling.setBox(i, bb,
+                handle_shadow ? SPCulling::MAX_FRUSTUMS : 1);
+        }
+        g_culling.cull(first, last);
+    });
+    RenderStats::stop(RenderStats::RT_CULLING);
+
+    RenderStats::start(RenderStats::RT_BUCKETING);
+    // Uploading and the skinning offsets depend on the order of the nodes
+    SPMeshNode* skinning_node = NULL;
+    SPMeshNode* skipped_node = NULL;
+    for (unsigned i = 0; i < count; i++)
+    {
+        const uint8_t visible = g_culling.getVisible(i);
+        if (visible == 0)
+        {
+            RenderStats::add(RenderStats::RC_CULLED_MESH_BUFFERS);
+            continue;
+        }
+        SPMeshNode* node = g_cull_mesh_buffers[i].first;
+        if (node == skipped_node)
         {
+            g_culling.setInvisible(i);
             continue;
         }
-
+        SPMeshBuffer* mb =
+            node->getSPM()->getSPMeshBuffer(g_cull_mesh_buffers[i].second);
         if (irr_driver->getBoundingBoxesViz())
         {
-            addEdgeForViz(getCorner(bb, 0), getCorner(bb, 1));
-            addEdgeForViz(getCorner(bb, 1), getCorner(bb, 5));
-            addEdgeForViz(getCorner(bb, 5), getCorner(bb, 4));
-            addEdgeForViz(getCorner(bb, 4), getCorner(bb, 0));
-            addEdgeForViz(getCorner(bb, 2), getCorner(bb, 3));
-            addEdgeForViz(getCorner(bb, 3), getCorner(bb, 7));
-            addEdgeForViz(getCorner(bb, 7), getCorner(bb, 6));
-            addEdgeForViz(getCorner(bb, 6), getCorner(bb, 2));
-            addEdgeForViz(getCorner(bb, 0), getCorner(bb, 2));
-            addEdgeForViz(getCorner(bb, 1), getCorner(bb, 3));
-            addEdgeForViz(getCorner(bb, 5), getCorner(bb, 7));
-            addEdgeForViz(getCorner(bb, 4), getCorner(bb, 6));
+            addBoxForViz(g_culling.getBox(i));
         }
 
         mb->uploadGLMesh();
         // For first frame only need the vbo to be initialized
-        if (!added_for_skinning && node->getAnimationState())
+        if (node != skinning_node && node->getAnimationState())
         {
-            added_for_skinning = true;
+            skinning_node = node;
             int skinning_offset = g_skinning_offset + node->getTotalJoints();
             if (skinning_offset > int(stk_config->m_max_skinning_bones))
             {
                 Log::error("SPBase", "No enough space to render skinned"
                     " mesh %s! Max joints can hold: %d",
                     node->getName(), stk_config->m_max_skinning_bones);
-                return;
+                skipped_node = node;
+                g_culling.setInvisible(i);
+                continue;
             }
             node->setSkinningOffset(g_skinning_offset);
             g_skinning_mesh.push_back(node);
             g_skinning_offset = skinning_offset;
         }
 
-        float hue = node->getRenderInfo(m) ?
-            node->getRenderInfo(m)->getHue() : 0.0f;
-        SPInstancedData id = SPInstancedData
-            (node->getAbsoluteTransformation(), node->getTextureMatrix(m)[0],
-            node->getTextureMatrix(m)[1], hue,
-            (short)node->getSkinningOffset());
-
-        for (int dc_type = 0; dc_type < (handle_shadow ? 5 : 1); dc_type++)
+        for (unsigned dc_type = 0; dc_type < SPCulling::MAX_FRUSTUMS;
+             dc_type++)
         {
-            if (discard[dc_type])
+            if ((visible & (1 << dc_type)) == 0)
             {
                 continue;
             }
@@ -902,66 +896,140 @@ void addObject(SPMeshNode* node)
             {
                 sp_shadow_poly_count += mb->getIndexCount() / 3;
             }
-            if (shader->isTransparent())
+        }
+    }
+
+    const bool glow = UserConfigParams::m_glow && CVS->isDeferredEnabled();
+    pool->parallelFor(num_jobs, [count, num_jobs, glow]
+        (unsigned j, unsigned thread)
+    {
+        DrawCallBucket& bucket = g_buckets[j];
+        const unsigned first = count * j / num_jobs;
+        const unsigned last = count * (j + 1) / num_jobs;
+        for (unsigned i = first; i < last; i++)
+        {
+            const uint8_t visible = g_culling.getVisible(i);
+            if (visible == 0)
             {
-                // Transparent shader should always uses mesh samplers
-                // All transparent draw calls go DCT_TRANSPARENT
-                if (dc_type == 0)
-                {
-                    auto& ret = g_draw_calls[DCT_TRANSPARENT][shader];
-                    for (auto& p : mb->getTextureCompare())
-                    {
-                        ret[p.first].insert(mb);
-                    }
-                    mb->addInstanceData(id, DCT_TRANSPARENT);
-                }
-                else
-                {
-                    continue;
-                }
+                continue;
             }
-            else
+            SPMeshNode* node = g_cull_mesh_buffers[i].first;
+            const unsigned m = g_cull_mesh_buffers[i].second;
+            SPMeshBuffer* mb = node->getSPM()->getSPMeshBuffer(m);
+            SPShader* shader = node->getShader(m);
+            float hue = node->getRenderInfo(m) ?
+                node->getRenderInfo(m)->getHue() : 0.0f;
+            SPInstancedData id = SPInstancedData
+                (node->getAbsoluteTransformation(),
+                node->getTextureMatrix(m)[0], node->getTextureMatrix(m)[1],
+                hue, (short)node->getSkinningOffset());
+
+            for (unsigned dc_type = 0; dc_type < SPCulling::MAX_FRUSTUMS;
+                 dc_type++)
             {
-                // Check if shader for render pass uses mesh samplers
-                const RenderPass check_pass =
-                    dc_type == DCT_NORMAL ? RP_1ST : RP_SHADOW;
-                const bool sampler_less = shader->samplerLess(check_pass);
-                auto& ret = g_draw_calls[dc_type][shader];
-                if (sampler_less)
+                if ((visible & (1 << dc_type)) == 0)
                 {
-                    ret[""].insert(mb);
+                    continue;
                 }
-                else
+                if (shader->isTransparent())
                 {
-                    for (auto& p : mb->getTextureCompare())
+                    // Transparent shader should always uses mesh samplers
+                    // All transparent draw calls go DCT_TRANSPARENT
+                    if (dc_type == 0)
+                    {
+                        auto& ret =
+                            bucket.m_draw_calls[DCT_TRANSPARENT][shader];
+                        for (auto& p : mb->getTextureCompare())
+                        {
+                            ret[p.first].insert(mb);
+                        }
+                        bucket.m_instance_data.emplace_back(mb,
+                            DCT_TRANSPARENT, id);
+                    }
+                    else
                     {
-                        ret[p.first].insert(mb);
+                        continue;
                     }
                 }
-                mb->addInstanceData(id, (DrawCallType)dc_type);
-                if (UserConfigParams::m_glow && node->hasGlowColor() &&
-                    CVS->isDeferredEnabled() && dc_type == DCT_NORMAL)
+                else
                 {
-                    video::SColorf gc = node->getGlowColor();
-                    unsigned key = gc.toSColor().color;
-                    auto ret = g_glow_meshes.find(key);
-                    if (ret == g_glow_meshes.end())
+                    // Check if shader for render pass uses mesh samplers
+                    const RenderPass check_pass =
+                        dc_type == DCT_NORMAL ? RP_1ST : RP_SHADOW;
+                    const bool sampler_less =
+                        shader->samplerLess(check_pass);
+                    auto& ret = bucket.m_draw_calls[dc_type][shader];
+                    if (sampler_less)
+                    {
+                        ret[""].insert(mb);
+                    }
+                    else
                     {
-                        g_glow_meshes[key] = std::make_pair(
-                            core::vector3df(gc.r, gc.g, gc.b),
-                            std::unordered_set<SPMeshBuffer*>());
+                        for (auto& p : mb->getTextureCompare())
+                        {
+                            ret[p.first].insert(mb);
+                        }
                     }
-                    g_glow_meshes.at(key).second.insert(mb);
+                    bucket.m_instance_data.emplace_back(mb,
+                        (DrawCallType)dc_type, id);
+                    if (glow && node->hasGlowColor() &&
+                        dc_type == DCT_NORMAL)
+                    {
+                        video::SColorf gc = node->getGlowColor();
+                        auto& glow_mesh =
+                            bucket.m_glow_meshes[gc.toSColor().color];
+                        glow_mesh.first = core::vector3df(gc.r, gc.g, gc.b);
+                        glow_mesh.second.insert(mb);
+                    }
+                }
+                bucket.m_instances.insert(mb);
+            }
+        }
+    });
+
+    for (DrawCallBucket& bucket : g_buckets)
+    {
+        for (unsigned dc_type = 0; dc_type < DCT_FOR_VAO; dc_type++)
+        {
+            for (auto& p : bucket.m_draw_calls[dc_type])
+            {
+                auto& ret = g_draw_calls[dc_type][p.first];
+                for (auto& q : p.second)
+                {
+                    ret[q.first].insert(q.second.begin(), q.second.end());
                 }
             }
-            g_instances.insert(mb);
+            bucket.m_draw_calls[dc_type].clear();
+        }
+        // Instance data of each mesh buffer needs to be in the same order
+        // as the nodes
+        for (auto& p : bucket.m_instance_data)
+        {
+            std::get<0>(p)->addInstanceData(std::get<2>(p), std::get<1>(p));
         }
+        bucket.m_instance_data.clear();
+        for (auto& p : bucket.m_glow_meshes)
+        {
+            auto& ret = g_glow_meshes[p.first];
+            ret.first = p.second.first;
+            ret.second.insert(p.second.second.begin(),
+                p.second.second.end());
+        }
+        bucket.m_glow_meshes.clear();
+        g_instances.insert(bucket.m_instances.begin(),
+            bucket.m_instances.end());
+        bucket.m_instances.clear();
     }
-}
+    RenderStats::add(RenderStats::RC_SKINNED_NODES,
+        (unsigned)g_skinning_mesh.size());
+    g_cull_nodes.clear();
+    RenderStats::stop(RenderStats::RT_BUCKETING);
+}   // cullObjects
 
 // ----------------------------------------------------------------------------
 void handleDynamicDrawCall()
 {
+    RenderStats::start(RenderStats::RT_BUCKETING);
     for (unsigned dc_num = 0; dc_num < g_dy_dc.size(); dc_num++)
     {
         SPDynamicDrawCall* dydc = g_dy_dc[dc_num].get();
@@ -980,61 +1048,24 @@ void handleDynamicDrawCall()
         SPShader* shader = dydc->getShader();
         core::aabbox3df bb = dydc->getBoundingBox();
         dydc->getAbsoluteTransformation().transformBoxEx(bb);
-        std::vector<bool> discard;
         const bool handle_shadow =
             g_handle_shadow && shader->hasShader(RP_SHADOW);
-        discard.resize((handle_shadow ? 5 : 1), false);
-        for (int dc_type = 0; dc_type < (handle_shadow ? 5 : 1); dc_type++)
-        {
-            for (int i = 0; i < 24; i += 4)
-            {
-                bool outside = true;
-                for (int j = 0; j < 8; j++)
-                {
-                    const float dist =
-                        getCorner(bb, j).X * g_frustums[dc_type][i] +
-                        getCorner(bb, j).Y * g_frustums[dc_type][i + 1] +
-                        getCorner(bb, j).Z * g_frustums[dc_type][i + 2] +
-                        g_frustums[dc_type][i + 3];
-                    outside = outside && dist < 0.0f;
-                    if (!outside)
-                    {
-                        break;
-                    }
-                }
-                if (outside)
-                {
-                    discard[dc_type] = true;
-                    break;
-                }
-            }
-        }
-        if (handle_shadow ?
-            (discard[0] && discard[1] && discard[2] && discard[3] &&
-            discard[4]) : discard[0])
+        const uint8_t visible = g_culling.cullBox(bb,
+            handle_shadow ? SPCulling::MAX_FRUSTUMS : 1);
+        if (visible == 0)
         {
             continue;
         }
+        RenderStats::add(RenderStats::RC_DYNAMIC_DRAW_CALLS);
 
         if (irr_driver->getBoundingBoxesViz())
         {
-            addEdgeForViz(getCorner(bb, 0), getCorner(bb, 1));
-            addEdgeForViz(getCorner(bb, 1), getCorner(bb, 5));
-            addEdgeForViz(getCorner(bb, 5), getCorner(bb, 4));
-            addEdgeForViz(getCorner(bb, 4), getCorner(bb, 0));
-            addEdgeForViz(getCorner(bb, 2), getCorner(bb, 3));
-            addEdgeForViz(getCorner(bb, 3), getCorner(bb, 7));
-            addEdgeForViz(getCorner(bb, 7), getCorner(bb, 6));
-            addEdgeForViz(getCorner(bb, 6), getCorner(bb, 2));
-            addEdgeForViz(getCorner(bb, 0), getCorner(bb, 2));
-            addEdgeForViz(getCorner(bb, 1), getCorner(bb, 3));
-            addEdgeForViz(getCorner(bb, 5), getCorner(bb, 7));
-            addEdgeForViz(getCorner(bb, 4), getCorner(bb, 6));
+            addBoxForViz(bb);
         }
 
         for (int dc_type = 0; dc_type < (handle_shadow ? 5 : 1); dc_type++)
         {
-            if (discard[dc_type])
+            if ((visible & (1 << dc_type)) == 0)
             {
                 continue;
             }
@@ -1084,8 +1115,51 @@ void handleDynamicDrawCall()
             }
         }
     }
+    RenderStats::stop(RenderStats::RT_BUCKETING);
 }
 
+// ----------------------------------------------------------------------------
+/** Counts the instanced draw calls and the instances drawn by them in each
+ *  pass of this frame, see draw(). */
+void addRenderStats()
+{
+    for (unsigned i = 0; i < DCT_FOR_VAO; i++)
+    {
+        unsigned draw_calls = 0;
+        unsigned instances = 0;
+        for (auto& p : g_final_draw_calls[i])
+        {
+            for (auto& q : p.second)
+            {
+                draw_calls += (unsigned)q.second.size();
+                for (auto& r : q.second)
+                {
+                    instances += r.first->getInstanceCount((DrawCallType)i);
+                }
+            }
+        }
+        if (i == DCT_NORMAL)
+        {
+            RenderStats::add(RenderStats::RC_SOLID_DRAW_CALLS, draw_calls);
+            RenderStats::add(RenderStats::RC_SOLID_INSTANCES, instances);
+        }
+        else if (i == DCT_TRANSPARENT)
+        {
+            RenderStats::add(RenderStats::RC_TRANSPARENT_DRAW_CALLS,
+                draw_calls);
+            RenderStats::add(RenderStats::RC_TRANSPARENT_INSTANCES,
+                instances);
+        }
+        else
+        {
+            RenderStats::add(RenderStats::RC_SHADOW_DRAW_CALLS, draw_calls);
+            RenderStats::add(RenderStats::RC_SHADOW_INSTANCES, instances);
+        }
+    }
+    RenderStats::add(RenderStats::RC_SOLID_POLYS, sp_solid_poly_count);
+    RenderStats::add(RenderStats::RC_SHADOW_POLYS, sp_shadow_poly_count);
+}   // addRenderStats
+
 // ----------------------------------------------------------------------------
 void updateModelMatrix()
 {
@@ -1097,6 +1171,7 @@ void updateModelMatrix()
     }
     irr_driver->setSkinningJoint(g_skinning_offset - 1);
 
+    RenderStats::start(RenderStats::RT_BUCKETING);
     for (unsigned i = 0; i < DCT_FOR_VAO; i++)
     {
         DrawCall* dc = &g_draw_calls[(DrawCallType)i];
@@ -1163,6 +1238,11 @@ void updateModelMatrix()
             }
         }
     }
+    RenderStats::stop(RenderStats::RT_BUCKETING);
+    if (RenderStats::isEnabled())
+    {
+        addRenderStats();
+    }
 }
 
 // ----------------------------------------------------------------------------
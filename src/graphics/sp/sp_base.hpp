@@ -120,6 +120,8 @@ void drawSPDebugView();
 // ----------------------------------------------------------------------------
 void addObject(SPMeshNode*);
 // ----------------------------------------------------------------------------
+void cullObjects();
+// ----------------------------------------------------------------------------
 void initSTKRenderer(ShaderBasedRenderer*);
 // ----------------------------------------------------------------------------
 void prepareScene();
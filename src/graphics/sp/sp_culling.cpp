@@ -0,0 +1,378 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef SERVER_ONLY
+
+#include "graphics/sp/sp_culling.hpp"
+#include "utils/log.hpp"
+#include "utils/worker_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SP_CULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // ------------------------------------------------------------------------
+    inline void mathPlaneNormf(float *p)
+    {
+        float f = 1.0f / sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        p[0] *= f;
+        p[1] *= f;
+        p[2] *= f;
+        p[3] *= f;
+    }   // mathPlaneNormf
+}   // namespace
+
+namespace SP
+{
+// ----------------------------------------------------------------------------
+SPCulling::SPCulling()
+{
+    for (unsigned int i = 0; i < MAX_FRUSTUMS; i++)
+    {
+        for (unsigned int j = 0; j < 24; j++)
+            m_frustums[i][j] = 0.0f;
+    }
+    m_use_simd = true;
+}   // SPCulling
+
+// ----------------------------------------------------------------------------
+/** Computes the 6 planes of a frustum.
+ *  \param i Index of the frustum, 0 is the camera.
+ *  \param pvm The projection view matrix of the frustum.
+ */
+void SPCulling::setFrustum(unsigned int i, const core::matrix4& pvm)
+{
+    assert(i < MAX_FRUSTUMS);
+    float* out = m_frustums[i];
+    const float* m = pvm.pointer();
+
+    // near
+    out[0] = m[3] + m[2];
+    out[1] = m[7] + m[6];
+    out[2] = m[11] + m[10];
+    out[3] = m[15] + m[14];
+    mathPlaneNormf(&out[0]);
+
+    // right
+    out[4] = m[3] - m[0];
+    out[4 + 1] = m[7] - m[4];
+    out[4 + 2] = m[11] - m[8];
+    out[4 + 3] = m[15] - m[12];
+    mathPlaneNormf(&out[4]);
+
+    // left
+    out[2 * 4] = m[3] + m[0];
+    out[2 * 4 + 1] = m[7] + m[4];
+    out[2 * 4 + 2] = m[11] + m[8];
+    out[2 * 4 + 3] = m[15] + m[12];
+    mathPlaneNormf(&out[2 * 4]);
+
+    // bottom
+    out[3 * 4] = m[3] + m[1];
+    out[3 * 4 + 1] = m[7] + m[5];
+    out[3 * 4 + 2] = m[11] + m[9];
+    out[3 * 4 + 3] = m[15] + m[13];
+    mathPlaneNormf(&out[3 * 4]);
+
+    // top
+    out[4 * 4] = m[3] - m[1];
+    out[4 * 4 + 1] = m[7] - m[5];
+    out[4 * 4 + 2] = m[11] - m[9];
+    out[4 * 4 + 3] = m[15] - m[13];
+    mathPlaneNormf(&out[4 * 4]);
+
+    // far
+    out[5 * 4] = m[3] - m[2];
+    out[5 * 4 + 1] = m[7] - m[6];
+    out[5 * 4 + 2] = m[11] - m[10];
+    out[5 * 4 + 3] = m[15] - m[14];
+    mathPlaneNormf(&out[5 * 4]);
+}   // setFrustum
+
+// ----------------------------------------------------------------------------
+/** Sets the number of boxes, the content of the boxes is undefined until
+ *  setBox is called. */
+void SPCulling::resize(unsigned int n)
+{
+    m_min_x.resize(n);
+    m_min_y.resize(n);
+    m_min_z.resize(n);
+    m_max_x.resize(n);
+    m_max_y.resize(n);
+    m_max_z.resize(n);
+    m_num_frustums.resize(n);
+    m_visible.resize(n);
+}   // resize
+
+// ----------------------------------------------------------------------------
+/** Sets a box in world space. Different boxes can be set in parallel.
+ *  \param num_frustums 1 to test the camera frustum only, or MAX_FRUSTUMS
+ *         to test the shadow cascades too.
+ */
+void SPCulling::setBox(unsigned int i, const core::aabbox3df& bb,
+                       unsigned int num_frustums)
+{
+    assert(num_frustums == 1 || num_frustums == MAX_FRUSTUMS);
+    m_min_x[i] = bb.MinEdge.X;
+    m_min_y[i] = bb.MinEdge.Y;
+    m_min_z[i] = bb.MinEdge.Z;
+    m_max_x[i] = bb.MaxEdge.X;
+    m_max_y[i] = bb.MaxEdge.Y;
+    m_max_z[i] = bb.MaxEdge.Z;
+    m_num_frustums[i] = (uint8_t)num_frustums;
+}   // setBox
+
+// ----------------------------------------------------------------------------
+/** Tests one box against the frustums. A box is outside of a frustum if
+ *  all its corners are behind one plane, i.e. if the corner farthest in
+ *  the direction of the plane normal is behind it.
+ *  \return Bit i is set if the box is visible in frustum i.
+ */
+uint8_t SPCulling::cullBox(const core::aabbox3df& bb,
+                           unsigned int num_frustums) const
+{
+    uint8_t visible = 0;
+    for (unsigned int f = 0; f < num_frustums; f++)
+    {
+        const float* p = m_frustums[f];
+        bool outside = false;
+        for (unsigned int i = 0; i < 24; i += 4)
+        {
+            const float dist =
+                (p[i] >= 0.0f ? bb.MaxEdge.X : bb.MinEdge.X) * p[i] +
+                (p[i + 1] >= 0.0f ? bb.MaxEdge.Y : bb.MinEdge.Y) * p[i + 1] +
+                (p[i + 2] >= 0.0f ? bb.MaxEdge.Z : bb.MinEdge.Z) * p[i + 2] +
+                p[i + 3];
+            if (dist < 0.0f)
+            {
+                outside = true;
+                break;
+            }
+        }
+        if (!outside)
+            visible |= (uint8_t)(1 << f);
+    }
+    return visible;
+}   // cullBox
+
+// ----------------------------------------------------------------------------
+void SPCulling::cullScalar(unsigned int first, unsigned int last)
+{
+    for (unsigned int i = first; i < last; i++)
+        m_visible[i] = cullBox(getBox(i), m_num_frustums[i]);
+}   // cullScalar
+
+// ----------------------------------------------------------------------------
+/** Tests the boxes first to last - 1 against the frustums. Different
+ *  ranges can be culled in parallel.
+ */
+void SPCulling::cull(unsigned int first, unsigned int last)
+{
+#ifdef SP_CULLING_SSE2
+    if (!m_use_simd)
+    {
+        cullScalar(first, last);
+        return;
+    }
+    unsigned int i = first;
+    for (; i + 4 <= last; i += 4)
+    {
+        const __m128 min_x = _mm_loadu_ps(&m_min_x[i]);
+        const __m128 min_y = _mm_loadu_ps(&m_min_y[i]);
+        const __m128 min_z = _mm_loadu_ps(&m_min_z[i]);
+        const __m128 max_x = _mm_loadu_ps(&m_max_x[i]);
+        const __m128 max_y = _mm_loadu_ps(&m_max_y[i]);
+        const __m128 max_z = _mm_loadu_ps(&m_max_z[i]);
+        const unsigned int num_frustums = std::max(
+            std::max(m_num_frustums[i], m_num_frustums[i + 1]),
+            std::max(m_num_frustums[i + 2], m_num_frustums[i + 3]));
+        uint8_t visible[4] = {};
+        for (unsigned int f = 0; f < num_frustums; f++)
+        {
+            const float* p = m_frustums[f];
+            __m128 outside = _mm_setzero_ps();
+            for (unsigned int j = 0; j < 24; j += 4)
+            {
+                // Same operations in the same order as in cullBox
+                __m128 dist = _mm_mul_ps(p[j] >= 0.0f ? max_x : min_x,
+                    _mm_set1_ps(p[j]));
+                dist = _mm_add_ps(dist, _mm_mul_ps(
+                    p[j + 1] >= 0.0f ? max_y : min_y, _mm_set1_ps(p[j + 1])));
+                dist = _mm_add_ps(dist, _mm_mul_ps(
+                    p[j + 2] >= 0.0f ? max_z : min_z, _mm_set1_ps(p[j + 2])));
+                dist = _mm_add_ps(dist, _mm_set1_ps(p[j + 3]));
+                outside = _mm_or_ps(outside,
+                    _mm_cmplt_ps(dist, _mm_setzero_ps()));
+                if (_mm_movemask_ps(outside) == 0xf)
+                    break;
+            }
+            const int mask = _mm_movemask_ps(outside);
+            for (unsigned int k = 0; k < 4; k++)
+            {
+                if ((mask & (1 << k)) == 0)
+                    visible[k] |= (uint8_t)(1 << f);
+            }
+        }
+        for (unsigned int k = 0; k < 4; k++)
+        {
+            m_visible[i + k] =
+                visible[k] & ((1 << m_num_frustums[i + k]) - 1);
+        }
+    }
+    cullScalar(i, last);
+#else
+    cullScalar(first, last);
+#endif
+}   // cull
+
+// ============================================================================
+namespace
+{
+    // ------------------------------------------------------------------------
+    /** Sets up a camera looking along a track with 4 shadow cascades of
+     *  increasing size. */
+    void setBenchmarkFrustums(SPCulling* culling, unsigned int frame)
+    {
+        const float angle = frame * 0.01f;
+        const core::vector3df position(300.0f * cosf(angle), 10.0f,
+                                       300.0f * sinf(angle));
+        const core::vector3df target = position +
+            core::vector3df(-sinf(angle), -0.1f, cosf(angle));
+        core::matrix4 proj, view;
+        proj.buildProjectionMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f,
+                                                   1.0f, 1000.0f);
+        view.buildCameraLookAtMatrixLH(position, target,
+                                       core::vector3df(0.0f, 1.0f, 0.0f));
+        culling->setFrustum(0, proj * view);
+
+        const core::vector3df sun(0.3f, -1.0f, 0.5f);
+        view.buildCameraLookAtMatrixLH(position - sun * 200.0f, position,
+                                       core::vector3df(0.0f, 1.0f, 0.0f));
+        for (unsigned int i = 1; i < SPCulling::MAX_FRUSTUMS; i++)
+        {
+            const float size = 20.0f * float(1 << (2 * i));
+            proj.buildProjectionMatrixOrthoLH(size, size, 1.0f, 500.0f);
+            culling->setFrustum(i, proj * view);
+        }
+    }   // setBenchmarkFrustums
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Culls a scene similar to a large track without any graphics with the
+ *  scalar code, the SIMD code, and the SIMD code split over all threads,
+ *  and checks that the results are identical.
+ *  \param pool The threads for the parallel culling.
+ *  \return 0 if all results are identical, 1 otherwise.
+ */
+int SPCulling::runBenchmark(WorkerPool* pool)
+{
+    const unsigned int num_boxes = 20000;
+    const unsigned int num_frames = 300;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 20.0f);
+
+    // 0: scalar, 1: SIMD, 2: SIMD in parallel
+    SPCulling culling[3];
+    for (SPCulling& c : culling)
+        c.resize(num_boxes);
+    for (unsigned int i = 0; i < num_boxes; i++)
+    {
+        const core::vector3df p(position(rng), position(rng) * 0.05f,
+                                position(rng));
+        const core::vector3df s(size(rng), size(rng), size(rng));
+        const unsigned int num_frustums = i % 3 == 0 ? 1 : MAX_FRUSTUMS;
+        for (SPCulling& c : culling)
+            c.setBox(i, core::aabbox3df(p - s, p + s), num_frustums);
+    }
+
+    double ms[3];
+    int mismatches = 0;
+    unsigned int visible[MAX_FRUSTUMS] = {};
+    for (unsigned int variant = 0; variant < 3; variant++)
+    {
+        SPCulling& c = culling[variant];
+        c.setUseSIMD(variant > 0);
+        const unsigned int num_jobs = pool->getNumThreads();
+        WorkerPool::Job job = [&c, num_boxes, num_jobs]
+            (unsigned int j, unsigned int thread)
+        {
+            c.cull(num_boxes * j / num_jobs, num_boxes * (j + 1) / num_jobs);
+        };
+        double total = 0.0;
+        for (unsigned int frame = 0; frame < num_frames; frame++)
+        {
+            setBenchmarkFrustums(&c, frame);
+            auto start = std::chrono::steady_clock::now();
+            if (variant == 2)
+                pool->parallelFor(num_jobs, job);
+            else
+                c.cull(0, num_boxes);
+            total += std::chrono::duration<double, std::milli>
+                (std::chrono::steady_clock::now() - start).count();
+            if (variant == 0)
+            {
+                for (unsigned int i = 0; i < num_boxes; i++)
+                {
+                    for (unsigned int f = 0; f < MAX_FRUSTUMS; f++)
+                        visible[f] += (c.getVisible(i) >> f) & 1;
+                }
+                continue;
+            }
+            // Compare with the scalar code for the same frame
+            SPCulling& scalar = culling[0];
+            setBenchmarkFrustums(&scalar, frame);
+            scalar.cull(0, num_boxes);
+            for (unsigned int i = 0; i < num_boxes; i++)
+            {
+                if (c.getVisible(i) != scalar.getVisible(i))
+                    mismatches++;
+            }
+        }
+        ms[variant] = total / num_frames;
+    }
+
+    Log::info("SPCulling", "%u boxes, %.3f ms scalar, %.3f ms SIMD, "
+        "%.3f ms parallel per frame, %u threads.", num_boxes, ms[0], ms[1],
+        ms[2], pool->getNumThreads());
+    Log::info("SPCulling", "Average visible boxes: camera %u, shadow "
+        "cascades %u %u %u %u.", visible[0] / num_frames,
+        visible[1] / num_frames, visible[2] / num_frames,
+        visible[3] / num_frames, visible[4] / num_frames);
+    if (mismatches > 0)
+    {
+        Log::error("SPCulling", "%d culling results differ.", mismatches);
+        return 1;
+    }
+    return 0;
+}   // runBenchmark
+
+}
+
+#endif  // !SERVER_ONLY
@@ -0,0 +1,116 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef SERVER_ONLY
+
+#ifndef HEADER_SP_CULLING_HPP
+#define HEADER_SP_CULLING_HPP
+
+#include <aabbox3d.h>
+#include <matrix4.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace irr;
+
+class WorkerPool;
+
+namespace SP
+{
+
+/**
+  * \brief Tests the bounding boxes of all mesh buffers of a frame against
+  *  the camera frustum and the shadow cascade frustums. The boxes are
+  *  stored as structure of arrays, so that 4 boxes are tested against a
+  *  plane with each SSE2 instruction. Only the corner of a box which is
+  *  farthest in the direction of the plane normal is tested, which gives
+  *  the same result as testing all 8 corners one after another. This does
+  *  not need any GL context, so it can be benchmarked on its own.
+  * \ingroup graphics
+  */
+class SPCulling
+{
+public:
+    /** Camera frustum and the 4 shadow cascade frustums. */
+    static const unsigned int MAX_FRUSTUMS = 5;
+
+private:
+    /** Planes of each frustum: near, right, left, bottom, top and far,
+     *  each with normal and distance. */
+    float m_frustums[MAX_FRUSTUMS][24];
+
+    std::vector<float> m_min_x, m_min_y, m_min_z;
+
+    std::vector<float> m_max_x, m_max_y, m_max_z;
+
+    /** Number of frustums each box is tested against, 1 or MAX_FRUSTUMS. */
+    std::vector<uint8_t> m_num_frustums;
+
+    /** Bit i is set if a box is visible in frustum i. */
+    std::vector<uint8_t> m_visible;
+
+    /** If false the scalar code is used for all boxes. */
+    bool m_use_simd;
+
+    // ------------------------------------------------------------------------
+    void cullScalar(unsigned int first, unsigned int last);
+
+public:
+    // ------------------------------------------------------------------------
+    SPCulling();
+    // ------------------------------------------------------------------------
+    void setFrustum(unsigned int i, const core::matrix4& pvm);
+    // ------------------------------------------------------------------------
+    void resize(unsigned int n);
+    // ------------------------------------------------------------------------
+    void setBox(unsigned int i, const core::aabbox3df& bb,
+                unsigned int num_frustums);
+    // ------------------------------------------------------------------------
+    void cull(unsigned int first, unsigned int last);
+    // ------------------------------------------------------------------------
+    uint8_t cullBox(const core::aabbox3df& bb,
+                    unsigned int num_frustums) const;
+    // ------------------------------------------------------------------------
+    static int runBenchmark(WorkerPool* pool);
+    // ------------------------------------------------------------------------
+    unsigned int size() const       { return (unsigned int)m_visible.size(); }
+    // ------------------------------------------------------------------------
+    /** Returns the frustums box i is visible in as bit mask, valid after
+     *  cull was called for it. */
+    uint8_t getVisible(unsigned int i) const         { return m_visible[i]; }
+    // ------------------------------------------------------------------------
+    /** Hides a box in all frustums. */
+    void setInvisible(unsigned int i)                   { m_visible[i] = 0; }
+    // ------------------------------------------------------------------------
+    core::aabbox3df getBox(unsigned int i) const
+    {
+        return core::aabbox3df(m_min_x[i], m_min_y[i], m_min_z[i],
+                               m_max_x[i], m_max_y[i], m_max_z[i]);
+    }
+    // ------------------------------------------------------------------------
+    /** Disables the SIMD code, used to compare the results. */
+    void setUseSIMD(bool val)                           { m_use_simd = val; }
+};   // SPCulling
+
+}
+
+#endif
+
+#endif  // !SERVER_ONLY
@@ -80,6 +80,8 @@ public:
 #endif
     }
     // ------------------------------------------------------------------------
+    virtual unsigned getInstanceCount(DrawCallType dct) const { return 1; }
+    // ------------------------------------------------------------------------
     virtual void uploadInstanceData()
     {
 #ifndef SERVER_ONLY
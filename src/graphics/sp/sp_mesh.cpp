@@ -119,12 +119,21 @@ s32 SPMesh::getJointIDWithArm(const c8* name, unsigned* arm_id) const
 }   // getJointIDWithArm
 
 // ----------------------------------------------------------------------------
-void SPMesh::getSkinningMatrices(f32 frame, std::array<float, 16>* dest)
+/** Computes the skinning matrices of all armatures for a frame. The mesh
+ *  is not changed, so this can be called for several nodes sharing the mesh
+ *  in parallel.
+ *  \param dest Receives one matrix for each used joint.
+ *  \param poses The state of each armature for the calling node.
+ */
+void SPMesh::getSkinningMatrices(f32 frame, std::array<float, 16>* dest,
+                                 std::vector<ArmaturePose>* poses) const
 {
+    poses->resize(m_all_armatures.size());
     unsigned accumulated_joints = 0;
     for (unsigned i = 0; i < m_all_armatures.size(); i++)
     {
-        m_all_armatures[i].getPose(frame, &dest[accumulated_joints]);
+        m_all_armatures[i].getPose(frame, &dest[accumulated_joints],
+            &(*poses)[i]);
         accumulated_joints += m_all_armatures[i].m_joint_used;
     }
 
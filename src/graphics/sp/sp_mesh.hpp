@@ -35,6 +35,7 @@ namespace SP
 {
 class SPMeshBuffer;
 struct Armature;
+struct ArmaturePose;
 
 class SPMesh : public ISkinnedMesh
 {
@@ -152,7 +153,8 @@ public:
     // ------------------------------------------------------------------------
     std::vector<Armature>& getArmatures() { return m_all_armatures; }
     // ------------------------------------------------------------------------
-    void getSkinningMatrices(f32 frame, std::array<float, 16>* dest);
+    void getSkinningMatrices(f32 frame, std::array<float, 16>* dest,
+                             std::vector<ArmaturePose>* poses) const;
     // ------------------------------------------------------------------------
     s32 getJointIDWithArm(const c8* name, unsigned* arm_id) const;
     // ------------------------------------------------------------------------
@@ -133,6 +133,13 @@ public:
 #endif
     }
     // ------------------------------------------------------------------------
+    /** Returns the number of instances drawn by one draw call of this mesh
+     *  buffer in the given pass. */
+    virtual unsigned getInstanceCount(DrawCallType dct) const
+    {
+        return (unsigned)m_ins_dat[dct].size();
+    }
+    // ------------------------------------------------------------------------
     virtual void uploadGLMesh();
     // ------------------------------------------------------------------------
     virtual void uploadInstanceData();
@@ -26,13 +26,21 @@
 #include "graphics/irr_driver.hpp"
 #include "graphics/material.hpp"
 #include "graphics/render_info.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+#include "utils/worker_pool.hpp"
 
 #include "../../../lib/irrlicht/source/Irrlicht/CBoneSceneNode.h"
 #include <algorithm>
+#include <cstring>
+#include <random>
 
 namespace SP
 {
 // ----------------------------------------------------------------------------
+std::vector<SPMeshNode*> SPMeshNode::m_skinning_batch;
+bool SPMeshNode::m_batch_skinning = false;
+// ----------------------------------------------------------------------------
 SPMeshNode::SPMeshNode(IAnimatedMesh* mesh, ISceneNode* parent,
                        ISceneManager* mgr, s32 id,
                        const std::string& debug_name,
@@ -49,6 +57,7 @@ SPMeshNode::SPMeshNode(IAnimatedMesh* mesh, ISceneNode* parent,
     m_animated = false;
     m_skinning_offset = -32768;
     m_is_in_shadowpass = true;
+    m_in_skinning_batch = false;
 }   // SPMeshNode
 
 // ----------------------------------------------------------------------------
@@ -167,19 +176,83 @@ IMesh* SPMeshNode::getMeshForCurrentFrame()
     {
         return m_mesh;
     }
-    m_mesh->getSkinningMatrices(getFrameNr(), m_skinning_matrices.data());
-    updateAbsolutePosition();
+    if (m_batch_skinning)
+    {
+        if (!m_in_skinning_batch)
+        {
+            m_in_skinning_batch = true;
+            grab();
+            m_skinning_batch.push_back(this);
+        }
+        return m_mesh;
+    }
+    m_mesh->getSkinningMatrices(getFrameNr(), m_skinning_matrices.data(),
+        &m_armature_poses);
+    updateJointNodes();
+    return m_mesh;
+}   // getMeshForCurrentFrame
 
-    for (Armature& arm : m_mesh->getArmatures())
+// ----------------------------------------------------------------------------
+/** Moves the joint nodes (and everything attached to them) to the pose
+ *  computed last. */
+void SPMeshNode::updateJointNodes()
+{
+    updateAbsolutePosition();
+    std::vector<Armature>& armatures = m_mesh->getArmatures();
+    for (unsigned a = 0; a < armatures.size(); a++)
     {
+        const Armature& arm = armatures[a];
         for (unsigned i = 0; i < arm.m_joint_names.size(); i++)
         {
             m_joint_nodes.at(arm.m_joint_names[i])->setAbsoluteTransformation
-                (AbsoluteTransformation * arm.m_world_matrices[i].first);
+                (AbsoluteTransformation *
+                m_armature_poses[a].m_world_matrices[i]);
         }
     }
-    return m_mesh;
-}   // getMeshForCurrentFrame
+}   // updateJointNodes
+
+// ----------------------------------------------------------------------------
+/** Starts collecting the animated nodes during a scene update instead of
+ *  computing their skinning matrices one after another, see
+ *  finishSkinningBatch.
+ */
+void SPMeshNode::startSkinningBatch()
+{
+    assert(!m_batch_skinning);
+    m_batch_skinning = true;
+}   // startSkinningBatch
+
+// ----------------------------------------------------------------------------
+/** Computes the skinning matrices of all collected nodes in parallel, the
+ *  meshes are only read so nodes sharing a mesh can be posed at the same
+ *  time. Then the joint nodes and the nodes attached to them are moved in
+ *  the order the nodes were animated, so that a node attached to a joint of
+ *  another animated node uses the updated joint.
+ *  \param pool The threads to use.
+ */
+void SPMeshNode::finishSkinningBatch(WorkerPool* pool)
+{
+    assert(m_batch_skinning);
+    m_batch_skinning = false;
+    pool->parallelFor((unsigned)m_skinning_batch.size(),
+        [](unsigned int n, unsigned int thread)
+        {
+            SPMeshNode* node = m_skinning_batch[n];
+            node->m_mesh->getSkinningMatrices(node->getFrameNr(),
+                node->m_skinning_matrices.data(), &node->m_armature_poses);
+        });
+    for (SPMeshNode* node : m_skinning_batch)
+    {
+        node->updateJointNodes();
+        for (auto& p : node->m_joint_nodes)
+        {
+            p.second->updateAbsolutePositionOfAllChildren();
+        }
+        node->m_in_skinning_batch = false;
+        node->drop();
+    }
+    m_skinning_batch.clear();
+}   // finishSkinningBatch
 
 // ----------------------------------------------------------------------------
 int SPMeshNode::getTotalJoints() const
@@ -211,4 +284,127 @@ SPShader* SPMeshNode::getShader(unsigned mesh_buffer_id) const
     return NULL;
 }   // getShader
 
+// ----------------------------------------------------------------------------
+/** Checks that the skinning matrices and joint world matrices computed for
+ *  many nodes in parallel (as done by finishSkinningBatch) are bitwise the
+ *  same as computing them one node after another, and as the immediate
+ *  pose of the armature itself. Also prints the time of both ways.
+ */
+void SPMeshNode::unitTesting()
+{
+    // A sample armature: a root with two chains, and a second root whose
+    // joint is not used for skinning.
+    const int parents[] = { -1, 0, 1, 2, 1, 4, -1 };
+    const unsigned joints = 7;
+    std::mt19937 rng(45);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    Armature arm;
+    arm.m_joint_used = 6;
+    for (unsigned i = 0; i < joints; i++)
+    {
+        arm.m_joint_names.push_back("joint" + std::to_string(i));
+        arm.m_parent_infos.push_back(parents[i]);
+    }
+    arm.m_joint_matrices.resize(joints);
+    arm.m_interpolated_matrices.resize(joints);
+    arm.m_world_matrices.resize(joints,
+        std::make_pair(core::matrix4(), false));
+    for (int frame = 0; frame <= 40; frame += 10)
+    {
+        std::vector<LocRotScale> lrs(joints);
+        for (LocRotScale& l : lrs)
+        {
+            l.m_loc = core::vector3df(value(rng), value(rng), value(rng));
+            l.m_rot = core::quaternion(value(rng), value(rng), value(rng),
+                                       value(rng));
+            l.m_rot.normalize();
+            l.m_scale = core::vector3df(1.0f + 0.5f * value(rng));
+        }
+        arm.m_frame_pose_matrices.emplace_back(frame, lrs);
+    }
+    SPMesh* mesh = new SPMesh();
+    mesh->getArmatures().push_back(arm);
+    mesh->finalize();
+    const Armature& bind = mesh->getArmatures()[0];
+
+    // One frame for each node, including frames outside of the animation
+    const unsigned nodes = 256;
+    std::vector<float> frames(nodes);
+    for (unsigned n = 0; n < nodes; n++)
+        frames[n] = -2.0f + 44.0f * float(n) / float(nodes - 1);
+
+    typedef std::vector<std::array<float, 16> > Matrices;
+    std::vector<Matrices> immediate(nodes, Matrices(arm.m_joint_used));
+    std::vector<Matrices> batched(nodes, Matrices(arm.m_joint_used));
+    std::vector<std::vector<ArmaturePose> > immediate_poses(nodes);
+    std::vector<std::vector<ArmaturePose> > batched_poses(nodes);
+
+    WorkerPool pool("SkinningTest", 4);
+    const int iterations = 100;
+    double start = StkTime::getRealTime();
+    for (int it = 0; it < iterations; it++)
+    {
+        for (unsigned n = 0; n < nodes; n++)
+        {
+            mesh->getSkinningMatrices(frames[n], immediate[n].data(),
+                                      &immediate_poses[n]);
+        }
+    }
+    const double immediate_time = StkTime::getRealTime() - start;
+    start = StkTime::getRealTime();
+    for (int it = 0; it < iterations; it++)
+    {
+        pool.parallelFor(nodes, [&](unsigned int n, unsigned int thread)
+            {
+                mesh->getSkinningMatrices(frames[n], batched[n].data(),
+                                          &batched_poses[n]);
+            });
+    }
+    const double batched_time = StkTime::getRealTime() - start;
+    Log::info("SPMeshNode", "Posing %d nodes %d times took %.2f ms "
+              "immediately, %.2f ms with %d threads.", nodes, iterations,
+              immediate_time * 1000.0, batched_time * 1000.0,
+              pool.getNumThreads());
+
+    auto check = [](bool ok, const char* what, float frame)
+    {
+        if (!ok)
+        {
+            Log::fatal("SPMeshNode", "Test failed: %s at frame %f.", what,
+                       frame);
+        }
+    };
+    for (unsigned n = 0; n < nodes; n++)
+    {
+        Armature reference = bind;
+        std::vector<core::matrix4> expected(arm.m_joint_used);
+        reference.getPose(frames[n], expected.data());
+        for (unsigned i = 0; i < arm.m_joint_used; i++)
+        {
+            check(memcmp(immediate[n][i].data(), expected[i].pointer(),
+                         64) == 0,
+                  "immediate skinning matrix differs from armature",
+                  frames[n]);
+            check(memcmp(batched[n][i].data(), expected[i].pointer(),
+                         64) == 0,
+                  "batched skinning matrix differs from armature",
+                  frames[n]);
+        }
+        for (unsigned i = 0; i < joints; i++)
+        {
+            // Joints which are not needed for skinning keep the bind pose
+            const core::matrix4& world = reference.m_world_matrices[i].second
+                                       ? reference.m_world_matrices[i].first
+                                       : bind.m_world_matrices[i].first;
+            check(memcmp(immediate_poses[n][0].m_world_matrices[i].pointer(),
+                         world.pointer(), 64) == 0,
+                  "immediate joint matrix differs from armature", frames[n]);
+            check(memcmp(batched_poses[n][0].m_world_matrices[i].pointer(),
+                         world.pointer(), 64) == 0,
+                  "batched joint matrix differs from armature", frames[n]);
+        }
+    }
+    mesh->drop();
+}   // unitTesting
+
 }
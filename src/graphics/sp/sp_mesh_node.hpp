@@ -18,6 +18,7 @@
 #ifndef HEADER_SP_MESH_NODE_HPP
 #define HEADER_SP_MESH_NODE_HPP
 
+#include "graphics/sp/sp_animation.hpp"
 #include "../../../lib/irrlicht/source/Irrlicht/CAnimatedMeshSceneNode.h"
 #include <array>
 #include <cassert>
@@ -29,6 +30,7 @@
 using namespace irr;
 using namespace scene;
 class RenderInfo;
+class WorkerPool;
 
 namespace SP
 {
@@ -52,8 +54,21 @@ private:
 
     bool m_is_in_shadowpass;
 
+    /** True if this node is in m_skinning_batch. */
+    bool m_in_skinning_batch;
+
     std::vector<std::array<float, 16> > m_skinning_matrices;
 
+    /** The state of each armature of the mesh for this node. */
+    std::vector<ArmaturePose> m_armature_poses;
+
+    /** Animated nodes whose skinning matrices are computed at the end of
+     *  the scene update, see startSkinningBatch. */
+    static std::vector<SPMeshNode*> m_skinning_batch;
+
+    /** True between startSkinningBatch and finishSkinningBatch. */
+    static bool m_batch_skinning;
+
     video::SColorf m_glow_color;
 
     std::vector<std::array<float, 2> > m_texture_matrices;
@@ -69,7 +84,10 @@ private:
         }
         m_joint_nodes.clear();
         m_skinning_matrices.clear();
+        m_armature_poses.clear();
     }
+    // ------------------------------------------------------------------------
+    void updateJointNodes();
 
 public:
     // ------------------------------------------------------------------------
@@ -167,6 +185,12 @@ public:
         assert(mb_id < m_texture_matrices.size());
         m_texture_matrices[mb_id] = tm;
     }
+    // ------------------------------------------------------------------------
+    static void startSkinningBatch();
+    // ------------------------------------------------------------------------
+    static void finishSkinningBatch(WorkerPool* pool);
+    // ------------------------------------------------------------------------
+    static void unitTesting();
 };
 
 }
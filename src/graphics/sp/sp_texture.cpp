@@ -26,6 +26,7 @@
 #include "graphics/central_settings.hpp"
 #include "graphics/irr_driver.hpp"
 #include "graphics/material.hpp"
+#include "io/cache_archive.hpp"
 #include "utils/log.hpp"
 #include "utils/string_utils.hpp"
 
@@ -44,12 +45,20 @@ extern "C"
 }
 #endif
 
+#include <cstring>
 #include <numeric>
 
 #if !defined(ANDROID)
 static const uint8_t CACHE_VERSION = 1;
 #endif
 
+/** Textures with at least this many pixels are compressed and reduced in
+ *  bands of rows on all texture loading threads. */
+static const unsigned PARALLEL_MIN_AREA = 512 * 512;
+
+/** Number of pixel rows in each band, a multiple of the 4x4 blocks. */
+static const unsigned BAND_ROWS = 64;
+
 namespace SP
 {
 // ----------------------------------------------------------------------------
@@ -86,9 +95,12 @@ SPTexture::SPTexture(const std::string& path, Material* m, bool undo_srgb,
     }
 #endif
 
-    m_cache_directory = file_manager->getCachedTexturesDir() +
-        cache_subdir + "/" + container_id;
+    // All textures with the same settings share one archive, the cache key
+    // contains the full path so container_id is not needed to tell them apart
+    m_cache_directory = file_manager->getCachedTexturesDir() + cache_subdir;
     file_manager->checkAndCreateDirectoryP(m_cache_directory);
+    m_cache_archive =
+        SPTextureManager::get()->getCacheArchive(m_cache_directory);
 
 #endif
 }   // SPTexture
@@ -232,6 +244,19 @@ bool SPTexture::compressedTexImage2d(std::shared_ptr<video::IImage> texture,
                                      const std::vector<std::pair
                                      <core::dimension2du, unsigned> >&
                                      mipmap_sizes)
+{
+    return compressedTexImage2d((const uint8_t*)texture->lock(),
+        mipmap_sizes);
+}   // compressedTexImage2d
+
+// ----------------------------------------------------------------------------
+/** Uploads compressed mipmaps which are stored one after the other, e.g.
+ *  directly from the mapped texture cache archive.
+ */
+bool SPTexture::compressedTexImage2d(const uint8_t* compressed,
+                                     const std::vector<std::pair
+                                     <core::dimension2du, unsigned> >&
+                                     mipmap_sizes)
 {
 #if !defined(SERVER_ONLY) && !defined(ANDROID)
     unsigned format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
@@ -242,7 +267,6 @@ bool SPTexture::compressedTexImage2d(std::shared_ptr<video::IImage> texture,
     glDeleteTextures(1, &m_texture_name);
     glGenTextures(1, &m_texture_name);
     glBindTexture(GL_TEXTURE_2D, m_texture_name);
-    uint8_t* compressed = (uint8_t*)texture->lock();
     unsigned cur_mipmap_size = 0;
     for (unsigned i = 0; i < mipmap_sizes.size(); i++)
     {
@@ -326,123 +350,124 @@ bool SPTexture::texImage2d(std::shared_ptr<video::IImage> texture,
 }   // texImage2d
 
 // ----------------------------------------------------------------------------
+/** Appends the compressed texture to the cache archive, in the same format
+ *  as the old one file per texture cache: version, number of mipmaps, their
+ *  sizes and then the compressed data.
+ */
 bool SPTexture::saveCompressedTexture(std::shared_ptr<video::IImage> texture,
                                       const std::vector<std::pair
                                       <core::dimension2du, unsigned> >& sizes,
-                                      const std::string& cache_location)
+                                      const std::string& cache_key)
 {
 #if !defined(SERVER_ONLY) && !defined(ANDROID)
     const unsigned total_size = std::accumulate(sizes.begin(), sizes.end(), 0,
         [] (const unsigned int previous, const std::pair
         <core::dimension2du, unsigned>& cur_sizes)
        { return previous + cur_sizes.second; });
-    io::IWriteFile* file = irr::io::createWriteFile(cache_location.c_str(),
-        false);
-    if (file == NULL)
-    {
-        return true;
-    }
-    file->write(&CACHE_VERSION, 1);
+    std::vector<uint8_t> header(5 + sizes.size() * 12);
+    header[0] = CACHE_VERSION;
     const unsigned mm_sizes = (unsigned)sizes.size();
-    file->write(&mm_sizes, 4);
-    for (auto& p : sizes)
+    memcpy(&header[1], &mm_sizes, 4);
+    for (unsigned i = 0; i < mm_sizes; i++)
     {
-        file->write(&p.first.Width, 4);
-        file->write(&p.first.Height, 4);
-        file->write(&p.second, 4);
+        memcpy(&header[5 + i * 12], &sizes[i].first.Width, 4);
+        memcpy(&header[9 + i * 12], &sizes[i].first.Height, 4);
+        memcpy(&header[13 + i * 12], &sizes[i].second, 4);
     }
-    file->write(texture->lock(), total_size);
-    file->drop();
+    std::vector<std::pair<const void*, uint32_t> > parts;
+    parts.emplace_back(header.data(), (uint32_t)header.size());
+    parts.emplace_back(texture->lock(), total_size);
+    m_cache_archive->add(cache_key, parts);
 #endif
     return true;
 }   // saveCompressedTexture
 
 // ----------------------------------------------------------------------------
-bool SPTexture::useTextureCache(const std::string& full_path,
-                                std::string* cache_loc)
+/** Returns the key of this texture in the cache archive. It contains the
+ *  modification times of the texture and its mask, so a changed texture
+ *  gets a new entry.
+ *  \return The key, or an empty string if the texture is not cached.
+ */
+std::string SPTexture::getCacheKey() const
 {
-#ifndef SERVER_ONLY
-    if (!CVS->isTextureCompressionEnabled() || m_cache_directory.empty())
+    std::string key;
+#if !(defined(SERVER_ONLY) || defined(ANDROID))
+    if (!CVS->isTextureCompressionEnabled() || m_cache_archive == NULL)
     {
-        return false;
+        return key;
     }
 
-    std::string basename = StringUtils::getBasename(m_path);
-    *cache_loc = m_cache_directory + "/" + basename + ".sptz";
-
-    if (file_manager->fileExists(*cache_loc) &&
-        file_manager->fileIsNewer(*cache_loc, m_path))
+    key = m_path + "|" +
+        StringUtils::toString(file_manager->getModificationTime(m_path));
+    if (m_material && (!m_material->getColorizationMask().empty() ||
+        !m_material->getAlphaMask().empty()))
     {
-        if (m_material && (!m_material->getColorizationMask().empty() ||
-            m_material->getAlphaMask().empty()))
-        {
-            std::string mask_path = StringUtils::getPath(m_path) + "/" +
-                (!m_material->getColorizationMask().empty() ?
-                m_material->getColorizationMask() :
-                m_material->getAlphaMask());
-            if (!file_manager->fileIsNewer(*cache_loc, mask_path))
-            {
-                return false;
-            }
-        }
-        return true;
-    }
+        std::string mask_path = StringUtils::getPath(m_path) + "/" +
+            (!m_material->getColorizationMask().empty() ?
+            m_material->getColorizationMask() :
+            m_material->getAlphaMask());
+        key += "|" + mask_path + "|" + StringUtils::toString(
+            file_manager->getModificationTime(mask_path));
+    }
+    key += StringUtils::insertValues("|%d|%d", (int)m_undo_srgb,
+        (int)CACHE_VERSION);
 #endif
-    return false;
-}   // useTextureCache
+    return key;
+}   // getCacheKey
 
 // ----------------------------------------------------------------------------
-std::shared_ptr<video::IImage> SPTexture::getTextureCache(const std::string& p,
+/** Returns the compressed mipmaps of this texture in the cache archive,
+ *  without copying them.
+ *  \param cache_key Key of the texture in the archive.
+ *  \param sizes Returns the dimensions and sizes of the mipmaps.
+ *  \return Pointer to the mapped data, or NULL if it is not cached.
+ */
+const uint8_t* SPTexture::getTextureCache(const std::string& cache_key,
     std::vector<std::pair<core::dimension2du, unsigned> >* sizes)
 {
-    std::shared_ptr<video::IImage> cache;
 #if !(defined(SERVER_ONLY) || defined(ANDROID))
-    io::IReadFile* file = irr::io::createReadFile(p.c_str());
-    if (file == NULL)
+    uint32_t size = 0;
+    const uint8_t* data = m_cache_archive->get(cache_key, &size);
+    if (data == NULL || size < 5 || data[0] != CACHE_VERSION)
     {
-        return cache;
+        return NULL;
     }
 
-    uint8_t cache_version;
-    file->read(&cache_version, 1);
-    if (cache_version != CACHE_VERSION)
+    unsigned mm_sizes;
+    memcpy(&mm_sizes, data + 1, 4);
+    if (mm_sizes == 0 || size < 5 + (uint64_t)mm_sizes * 12)
     {
-        return cache;
+        return NULL;
     }
-
-    unsigned mm_sizes;
-    file->read(&mm_sizes, 4);
     sizes->resize(mm_sizes);
+    uint64_t total_cache_size = 0;
     for (unsigned i = 0; i < mm_sizes; i++)
     {
-        file->read(&((*sizes)[i].first.Width), 4);
-        file->read(&((*sizes)[i].first.Height), 4);
-        file->read(&((*sizes)[i].second), 4);
+        memcpy(&((*sizes)[i].first.Width), data + 5 + i * 12, 4);
+        memcpy(&((*sizes)[i].first.Height), data + 9 + i * 12, 4);
+        memcpy(&((*sizes)[i].second), data + 13 + i * 12, 4);
+        total_cache_size += (*sizes)[i].second;
     }
-
-    const unsigned total_cache_size = std::accumulate(sizes->begin(),
-        sizes->end(), 0,[] (const unsigned int previous, const std::pair
-        <core::dimension2du, unsigned>& cur_sizes)
-       { return previous + cur_sizes.second; });
-    cache.reset(irr_driver->getVideoDriver()->createImage(video::ECF_A8R8G8B8,
-        (*sizes)[0].first));
-    assert(cache->getReferenceCount() == 1);
-    file->read(cache->lock(), total_cache_size);
-    file->drop();
+    const unsigned header_size = 5 + mm_sizes * 12;
+    if (header_size + total_cache_size != size)
+    {
+        return NULL;
+    }
+    return data + header_size;
+#else
+    return NULL;
 #endif
-    return cache;
 }   // getTextureCache
 
 // ----------------------------------------------------------------------------
 bool SPTexture::threadedLoad()
 {
 #ifndef SERVER_ONLY
-    std::string cache_loc;
-    if (useTextureCache(m_path, &cache_loc))
+    const std::string cache_key = getCacheKey();
+    if (!cache_key.empty())
     {
         std::vector<std::pair<core::dimension2du, unsigned> > sizes;
-        std::shared_ptr<video::IImage> cache = getTextureCache(cache_loc,
-            &sizes);
+        const uint8_t* cache = getTextureCache(cache_key, &sizes);
         if (cache)
         {
             SPTextureManager::get()->increaseGLCommandFunctionCount(1);
@@ -475,12 +500,12 @@ bool SPTexture::threadedLoad()
         SPTextureManager::get()->addGLCommandFunction(
             [this, image, r]()->bool
             { return compressedTexImage2d(image, r); });
-        if (!cache_loc.empty())
+        if (!cache_key.empty())
         {
             SPTextureManager::get()->addThreadedFunction(
-                [this, image, r, cache_loc]()->bool
+                [this, image, r, cache_key]()->bool
                 {
-                    return saveCompressedTexture(image, r, cache_loc);
+                    return saveCompressedTexture(image, r, cache_key);
                 });
         }
     }
@@ -678,45 +703,75 @@ void SPTexture::generateQuickMipmap(std::shared_ptr<video::IImage> first_image,
 #endif
 }   // generateQuickMipmap
 
+#if !(defined(SERVER_ONLY) || defined(ANDROID))
 // ----------------------------------------------------------------------------
-void SPTexture::generateHQMipmap(void* in,
-                                 const std::vector<std::pair
-                                 <core::dimension2du, unsigned> >& mms,
-                                 uint8_t* out)
+/** Generates the same mipmaps as imBuildMipmapCascade (same source level
+ *  and filter for each level), but the large levels are reduced in bands of
+ *  rows in parallel, and directly into the output. The filters used by STK
+ *  compute each pixel from the source level only, so the result is
+ *  identical.
+ */
+static void generateHQMipmapInBands(void* in,
+                                    const std::vector<std::pair
+                                    <core::dimension2du, unsigned> >& mms,
+                                    uint8_t* out,
+                                    imReduceOptions* reduce_options)
 {
-#if !(defined(SERVER_ONLY) || defined(ANDROID))
-    imMipmapCascade cascade;
-    imReduceOptions options;
-    imReduceSetOptions(&options,
-        m_path.find("_Normal.") != std::string::npos ?
-        IM_REDUCE_FILTER_NORMALMAP: IM_REDUCE_FILTER_LINEAR/*filter*/,
-        2/*hopcount*/, 2.0f/*alpha*/, 1.0f/*amplifynormal*/,
-        0.0f/*normalsustainfactor*/);
-#ifdef DEBUG
-    int ret = imBuildMipmapCascade(&cascade, in, mms[0].first.Width,
-        mms[0].first.Height, 1/*layercount*/, 4, mms[0].first.Width * 4,
-        &options, 0);
-    assert(ret == 1);
-#else
-    imBuildMipmapCascade(&cascade, in, mms[0].first.Width,
-        mms[0].first.Height, 1/*layercount*/, 4, mms[0].first.Width * 4,
-        &options, 0);
-#endif
-    for (unsigned int i = 1; i < mms.size(); i++)
+    std::vector<uint8_t*> levels(mms.size());
+    levels[0] = (uint8_t*)in;
+    for (unsigned i = 1; i < mms.size(); i++)
     {
-        const unsigned copy_size = mms[i].first.getArea() * 4;
-        memcpy(out, cascade.mipmap[i], copy_size);
-        out += copy_size;
+        levels[i] = out;
+        out += mms[i].first.getArea() * 4;
     }
-    imFreeMipmapCascade(&cascade);
-#endif
-}   // generateHQMipmap
+
+    for (unsigned i = 1; i < mms.size(); i++)
+    {
+        const int width = mms[i].first.Width;
+        const int height = mms[i].first.Height;
+        unsigned src_level = i - 1;
+        int method = 0;
+        if ((width | height) >= 16)
+        {
+            src_level = i < 2 ? 0 : i - 2;
+            method = 1;
+        }
+        const int src_width = mms[src_level].first.Width;
+        const int src_height = mms[src_level].first.Height;
+        const int divisor = 1 << (i - src_level);
+        if (width * divisor != src_width || height * divisor != src_height)
+            method = 2;
+
+        uint8_t* src = levels[src_level];
+        uint8_t* dst = levels[i];
+        if (method == 1)
+        {
+            SPTextureManager::get()->parallelFor(
+                (height + BAND_ROWS - 1) / BAND_ROWS,
+                [=](unsigned band)
+                {
+                    imReduceImageKaiserDataDivisorRows(dst, src, src_width,
+                        src_height, 4, src_width * 4, divisor,
+                        reduce_options, band * BAND_ROWS, BAND_ROWS);
+                });
+        }
+        else if (method == 2)
+        {
+            imReduceImageKaiserData(dst, src, src_width, src_height, 4,
+                src_width * 4, width, height, reduce_options);
+        }
+        else
+        {
+            imReduceImageHalfBoxData(dst, src, src_width, src_height, 4,
+                src_width * 4, reduce_options);
+        }
+    }
+}   // generateHQMipmapInBands
 
 // ----------------------------------------------------------------------------
-void SPTexture::squishCompressImage(uint8_t* rgba, int width, int height,
-                                    int pitch, void* blocks, unsigned flags)
+static void squishCompressRows(uint8_t* rgba, int width, int height,
+                               int pitch, void* blocks, unsigned flags)
 {
-#if !(defined(SERVER_ONLY) || defined(ANDROID))
     // This function is copied from CompressImage in libsquish to avoid omp
     // if enabled by shared libsquish, because we are already using
     // multiple thread
@@ -757,6 +812,73 @@ void SPTexture::squishCompressImage(uint8_t* rgba, int width, int height,
             target_block += 16;
         }
     }
+}   // squishCompressRows
+#endif
+
+// ----------------------------------------------------------------------------
+void SPTexture::generateHQMipmap(void* in,
+                                 const std::vector<std::pair
+                                 <core::dimension2du, unsigned> >& mms,
+                                 uint8_t* out)
+{
+#if !(defined(SERVER_ONLY) || defined(ANDROID))
+    imReduceOptions options;
+    imReduceSetOptions(&options,
+        m_path.find("_Normal.") != std::string::npos ?
+        IM_REDUCE_FILTER_NORMALMAP: IM_REDUCE_FILTER_LINEAR/*filter*/,
+        2/*hopcount*/, 2.0f/*alpha*/, 1.0f/*amplifynormal*/,
+        0.0f/*normalsustainfactor*/);
+    if (mms[0].first.getArea() >= PARALLEL_MIN_AREA)
+    {
+        generateHQMipmapInBands(in, mms, out, &options);
+        return;
+    }
+
+    imMipmapCascade cascade;
+#ifdef DEBUG
+    int ret = imBuildMipmapCascade(&cascade, in, mms[0].first.Width,
+        mms[0].first.Height, 1/*layercount*/, 4, mms[0].first.Width * 4,
+        &options, 0);
+    assert(ret == 1);
+#else
+    imBuildMipmapCascade(&cascade, in, mms[0].first.Width,
+        mms[0].first.Height, 1/*layercount*/, 4, mms[0].first.Width * 4,
+        &options, 0);
+#endif
+    for (unsigned int i = 1; i < mms.size(); i++)
+    {
+        const unsigned copy_size = mms[i].first.getArea() * 4;
+        memcpy(out, cascade.mipmap[i], copy_size);
+        out += copy_size;
+    }
+    imFreeMipmapCascade(&cascade);
+#endif
+}   // generateHQMipmap
+
+// ----------------------------------------------------------------------------
+/** Compresses an image, large images are split into bands of block rows
+ *  which are compressed in parallel. Each block is compressed on its own,
+ *  so the result does not depend on the number of threads.
+ */
+void SPTexture::squishCompressImage(uint8_t* rgba, int width, int height,
+                                    int pitch, void* blocks, unsigned flags)
+{
+#if !(defined(SERVER_ONLY) || defined(ANDROID))
+    if ((unsigned)(width * height) < PARALLEL_MIN_AREA)
+    {
+        squishCompressRows(rgba, width, height, pitch, blocks, flags);
+        return;
+    }
+    const int blocks_per_row = (width + 3) >> 2;
+    SPTextureManager::get()->parallelFor(
+        (height + BAND_ROWS - 1) / BAND_ROWS,
+        [=](unsigned band)
+        {
+            const int y = band * BAND_ROWS;
+            squishCompressRows(rgba + pitch * y, width,
+                std::min((int)BAND_ROWS, height - y), pitch,
+                (uint8_t*)blocks + (y >> 2) * blocks_per_row * 16, flags);
+        });
 #endif
 }   // squishCompressImage
 
@@ -34,6 +34,7 @@ namespace irr
     namespace video { class IImageLoader; class IImage; }
 }
 
+class CacheArchive;
 class Material;
 
 using namespace irr;
@@ -48,6 +49,9 @@ private:
 
     std::string m_cache_directory;
 
+    /** Archive which stores the compressed texture, NULL if not cached. */
+    CacheArchive* m_cache_archive = NULL;
+
     GLuint m_texture_name = 0;
 
     std::atomic_uint m_width;
@@ -144,17 +148,18 @@ private:
                               const std::vector<std::pair<core::dimension2du,
                               unsigned> >& mipmap_sizes);
     // ------------------------------------------------------------------------
+    bool compressedTexImage2d(const uint8_t* compressed,
+                              const std::vector<std::pair<core::dimension2du,
+                              unsigned> >& mipmap_sizes);
+    // ------------------------------------------------------------------------
     bool saveCompressedTexture(std::shared_ptr<video::IImage> texture,
                               const std::vector<std::pair<core::dimension2du,
                               unsigned> >& sizes,
-                              const std::string& cache_location);
-    // ------------------------------------------------------------------------
-    std::vector<std::pair<core::dimension2du, unsigned> >
-                       compressTexture(std::shared_ptr<video::IImage> texture);
+                              const std::string& cache_key);
     // ------------------------------------------------------------------------
-    bool useTextureCache(const std::string& full_path, std::string* cache_loc);
+    std::string getCacheKey() const;
     // ------------------------------------------------------------------------
-    std::shared_ptr<video::IImage> getTextureCache(const std::string& path,
+    const uint8_t* getTextureCache(const std::string& cache_key,
         std::vector<std::pair<core::dimension2du, unsigned> >* sizes);
 
 public:
@@ -191,6 +196,9 @@ public:
     unsigned getHeight() const                      { return m_height.load(); }
     // ------------------------------------------------------------------------
     bool threadedLoad();
+    // ------------------------------------------------------------------------
+    std::vector<std::pair<core::dimension2du, unsigned> >
+                       compressTexture(std::shared_ptr<video::IImage> texture);
 
 
 };
@@ -22,9 +22,15 @@
 #include "graphics/sp/sp_texture.hpp"
 #include "graphics/central_settings.hpp"
 #include "graphics/irr_driver.hpp"
+#include "io/cache_archive.hpp"
+#include "io/file_manager.hpp"
 #include "utils/string_utils.hpp"
 #include "utils/vs.hpp"
 
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <set>
 #include <string>
 
 namespace SP
@@ -34,7 +40,7 @@ SPTextureManager* SPTextureManager::m_sptm = NULL;
 SPTextureManager::SPTextureManager()
                 : m_max_threaded_load_obj
                   ((unsigned)std::thread::hardware_concurrency()),
-                  m_gl_cmd_function_count(0)
+                  m_gl_cmd_function_count(0), m_parallel_jobs(true)
 {
     if (m_max_threaded_load_obj.load() == 0)
     {
@@ -88,6 +94,152 @@ SPTextureManager::~SPTextureManager()
 #endif
 }   // ~SPTextureManager
 
+// ----------------------------------------------------------------------------
+/** Returns the archive which stores the compressed textures in a cache
+ *  directory, opening it if necessary.
+ *  \param dir The cache directory.
+ *  \return The archive, or NULL if it can not be opened.
+ */
+CacheArchive* SPTextureManager::getCacheArchive(const std::string& dir)
+{
+    std::lock_guard<std::mutex> lock(m_cache_archives_mutex);
+    std::unique_ptr<CacheArchive>& archive = m_cache_archives[dir];
+    if (!archive)
+        archive.reset(new CacheArchive(dir + "/textures.sparc"));
+    return archive->isOpen() ? archive.get() : NULL;
+}   // getCacheArchive
+
+// ----------------------------------------------------------------------------
+/** Runs independent jobs (e.g. bands of a large texture) on the calling
+ *  thread and on the idle loading threads, and returns once all jobs are
+ *  done. The calling thread takes part in the work, so this can be used
+ *  from a loading thread even if all other loading threads are busy.
+ *  \param num_jobs Number of jobs.
+ *  \param job Function called with the index of each job.
+ */
+void SPTextureManager::parallelFor(unsigned num_jobs,
+                                   const std::function<void(unsigned)>& job)
+{
+    const unsigned threads = m_max_threaded_load_obj.load();
+    const unsigned helpers = m_parallel_jobs.load() && threads > 1 ?
+        std::min(num_jobs, threads) - 1 : 0;
+    if (num_jobs < 2 || helpers == 0)
+    {
+        for (unsigned i = 0; i < num_jobs; i++)
+            job(i);
+        return;
+    }
+
+    // Helpers which only start after all jobs are taken find nothing to do,
+    // the shared state is kept alive for them
+    struct ParallelJobs
+    {
+        std::function<void(unsigned)> m_job;
+        unsigned m_num_jobs;
+        std::atomic_uint m_next_job, m_done_jobs;
+        std::mutex m_mutex;
+        std::condition_variable m_done_cv;
+        // --------------------------------------------------------------------
+        void run()
+        {
+            unsigned i;
+            while ((i = m_next_job.fetch_add(1)) < m_num_jobs)
+            {
+                m_job(i);
+                if (m_done_jobs.fetch_add(1) + 1 == m_num_jobs)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done_cv.notify_all();
+                }
+            }
+        }   // run
+    };
+    std::shared_ptr<ParallelJobs> jobs = std::make_shared<ParallelJobs>();
+    jobs->m_job = job;
+    jobs->m_num_jobs = num_jobs;
+    jobs->m_next_job.store(0);
+    jobs->m_done_jobs.store(0);
+    for (unsigned i = 0; i < helpers; i++)
+    {
+        addThreadedFunction([jobs]()->bool
+            {
+                jobs->run();
+                return true;
+            });
+    }
+    jobs->run();
+    std::unique_lock<std::mutex> ul(jobs->m_mutex);
+    jobs->m_done_cv.wait(ul, [&jobs]()
+        {
+            return jobs->m_done_jobs.load() == jobs->m_num_jobs;
+        });
+}   // parallelFor
+
+// ----------------------------------------------------------------------------
+/** Compresses all images in a directory with and without splitting large
+ *  textures into bands which are processed in parallel, and checks that
+ *  the results are identical. Only the work done on the CPU is measured,
+ *  nothing is uploaded.
+ *  \param dir The directory with the textures, e.g. of a track.
+ *  \return 0 if all results are identical, 1 otherwise.
+ */
+int SPTextureManager::benchmarkCompression(const std::string& dir)
+{
+    std::set<std::string> files;
+    file_manager->listFiles(files, dir, /*make_full_path*/true);
+    video::IVideoDriver* driver = irr_driver->getVideoDriver();
+    double total[2] = { 0.0, 0.0 };
+    int mismatches = 0;
+    for (const std::string& file : files)
+    {
+        if (driver->getImageLoaderForFile(file.c_str()) == NULL)
+            continue;
+        SPTexture texture(file, NULL, false/*undo_srgb*/, ""/*container_id*/);
+        std::shared_ptr<video::IImage> image = texture.getTextureImage();
+        if (!image || image->getDimension().Width < 4 ||
+            image->getDimension().Height < 4)
+            continue;
+
+        double ms[2];
+        std::vector<uint8_t> result[2];
+        for (int parallel = 0; parallel < 2; parallel++)
+        {
+            std::shared_ptr<video::IImage> copy(driver->createImage(
+                video::ECF_A8R8G8B8, image->getDimension()));
+            image->copyTo(copy.get());
+            setParallelJobs(parallel == 1);
+            auto start = std::chrono::steady_clock::now();
+            auto sizes = texture.compressTexture(copy);
+            ms[parallel] = std::chrono::duration<double, std::milli>
+                (std::chrono::steady_clock::now() - start).count();
+            total[parallel] += ms[parallel];
+            const unsigned size = std::accumulate(sizes.begin(),
+                sizes.end(), 0u, [] (unsigned previous, const std::pair
+                <core::dimension2du, unsigned>& cur_sizes)
+                { return previous + cur_sizes.second; });
+            const uint8_t* data = (const uint8_t*)copy->lock();
+            result[parallel].assign(data, data + size);
+        }
+        const bool identical = result[0] == result[1];
+        if (!identical)
+            mismatches++;
+        Log::info("SPTextureManager", "%s %dx%d: %.1f ms serial, %.1f ms "
+            "parallel%s", StringUtils::getBasename(file).c_str(),
+            image->getDimension().Width, image->getDimension().Height,
+            ms[0], ms[1], identical ? "" : ", results differ");
+    }
+    setParallelJobs(true);
+    Log::info("SPTextureManager", "Total: %.1f ms serial, %.1f ms parallel "
+        "with %d threads.", total[0], total[1],
+        (int)m_max_threaded_load_obj.load());
+    if (mismatches > 0)
+    {
+        Log::error("SPTextureManager", "%d textures differ.", mismatches);
+        return 1;
+    }
+    return 0;
+}   // benchmarkCompression
+
 // ----------------------------------------------------------------------------
 void SPTextureManager::checkForGLCommand(bool before_scene)
 {
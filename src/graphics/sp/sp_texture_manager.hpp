@@ -37,6 +37,7 @@
 
 #include "irrString.h"
 
+class CacheArchive;
 class Material;
 
 namespace SP
@@ -54,6 +55,9 @@ private:
 
     std::atomic_int m_gl_cmd_function_count;
 
+    /** If false, parallelFor runs all jobs on the calling thread. */
+    std::atomic_bool m_parallel_jobs;
+
     std::list<std::function<bool()> > m_threaded_functions;
 
     std::list<std::function<bool()> > m_gl_cmd_functions;
@@ -64,6 +68,12 @@ private:
 
     std::list<std::thread> m_threaded_load_obj;
 
+    /** The compressed texture cache archives, one for each cache directory.
+     */
+    std::map<std::string, std::unique_ptr<CacheArchive> > m_cache_archives;
+
+    std::mutex m_cache_archives_mutex;
+
 public:
     // ------------------------------------------------------------------------
     static SPTextureManager* get()
@@ -114,6 +124,14 @@ public:
         m_gl_cmd_functions.push_back(function);
     }
     // ------------------------------------------------------------------------
+    void parallelFor(unsigned num_jobs,
+                     const std::function<void(unsigned)>& job);
+    // ------------------------------------------------------------------------
+    /** Enables or disables splitting work with parallelFor. */
+    void setParallelJobs(bool enable)         { m_parallel_jobs.store(enable); }
+    // ------------------------------------------------------------------------
+    int benchmarkCompression(const std::string& dir);
+    // ------------------------------------------------------------------------
     void increaseGLCommandFunctionCount(int count)
                                   { m_gl_cmd_function_count.fetch_add(count); }
     // ------------------------------------------------------------------------
@@ -123,6 +141,8 @@ public:
                                           Material* m, bool undo_srgb,
                                           const std::string& container_id);
     // ------------------------------------------------------------------------
+    CacheArchive* getCacheArchive(const std::string& dir);
+    // ------------------------------------------------------------------------
     void dumpAllTextures();
     // ------------------------------------------------------------------------
     irr::core::stringw reloadTexture(const irr::core::stringw& name);
@@ -22,17 +22,125 @@
 #include "graphics/central_settings.hpp"
 #include "graphics/material_manager.hpp"
 #include "graphics/stk_tex_manager.hpp"
+#include "io/cache_archive.hpp"
+#include "io/file_manager.hpp"
 #include "utils/constants.hpp"
 #include "utils/mini_glm.hpp"
+#include "utils/string_utils.hpp"
 
 #include "../../lib/irrlicht/source/Irrlicht/CSkinnedMesh.h"
 const uint8_t VERSION_NOW = 1;
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <IVideoDriver.h>
 #include <IFileSystem.h>
 
+namespace
+{
+    /** Increase if the layout of the cached meshes changes. */
+    const uint32_t MESH_CACHE_VERSION = 1;
+
+    // ------------------------------------------------------------------------
+    void putData(std::vector<uint8_t>* out, const void* data, size_t size)
+    {
+        const uint8_t* p = (const uint8_t*)data;
+        out->insert(out->end(), p, p + size);
+    }   // putData
+
+    // ------------------------------------------------------------------------
+    template<typename T> void putValue(std::vector<uint8_t>* out, T val)
+    {
+        putData(out, &val, sizeof(T));
+    }   // putValue
+
+    // ------------------------------------------------------------------------
+    void putString(std::vector<uint8_t>* out, const std::string& str)
+    {
+        putValue(out, (uint32_t)str.size());
+        putData(out, str.data(), str.size());
+    }   // putString
+
+    // ------------------------------------------------------------------------
+    /** Reads the values of a cached mesh one after another, and detects if
+     *  the record is shorter than expected. */
+    class CacheReader
+    {
+    private:
+        const uint8_t* m_data;
+        uint32_t m_size;
+        uint32_t m_pos;
+        bool m_ok;
+
+    public:
+        CacheReader(const uint8_t* data, uint32_t size)
+            : m_data(data), m_size(size), m_pos(0), m_ok(true) {}
+        // --------------------------------------------------------------------
+        void getData(void* out, size_t size)
+        {
+            if (!m_ok || size > m_size - m_pos)
+            {
+                m_ok = false;
+                memset(out, 0, size);
+                return;
+            }
+            memcpy(out, m_data + m_pos, size);
+            m_pos += (uint32_t)size;
+        }
+        // --------------------------------------------------------------------
+        template<typename T> T get()
+        {
+            T val;
+            getData(&val, sizeof(T));
+            return val;
+        }
+        // --------------------------------------------------------------------
+        /** Returns a count of elements of the given size, or 0 if the
+         *  record is too short for them. */
+        uint32_t getCount(size_t element_size)
+        {
+            uint32_t count = get<uint32_t>();
+            if (m_ok && count * (uint64_t)element_size > m_size - m_pos)
+                m_ok = false;
+            return m_ok ? count : 0;
+        }
+        // --------------------------------------------------------------------
+        std::string getString()
+        {
+            std::string str;
+            str.resize(getCount(1));
+            if (!str.empty())
+                getData(&str.front(), str.size());
+            return str;
+        }
+        // --------------------------------------------------------------------
+        bool isOk() const             { return m_ok && m_pos == m_size; }
+    };   // CacheReader
+}   // namespace
+
+// ----------------------------------------------------------------------------
+SPMeshLoader::SPMeshLoader(scene::ISceneManager* smgr)
+            : m_scene_manager(smgr)
+{
+    m_decoded_meshes = m_cached_meshes = 0;
+    m_decode_time = m_cache_time = 0.0;
+    m_geometry_bytes = 0;
+}   // SPMeshLoader
+
+// ----------------------------------------------------------------------------
+SPMeshLoader::~SPMeshLoader()
+{
+    if (m_decoded_meshes + m_cached_meshes > 0)
+    {
+        Log::info("SPMeshLoader", "Decoded %u meshes in %.1f ms, loaded %u "
+            "meshes from cache in %.1f ms, %u KB of geometry allocated.",
+            m_decoded_meshes, m_decode_time, m_cached_meshes, m_cache_time,
+            (unsigned)(m_geometry_bytes / 1024));
+    }
+}   // ~SPMeshLoader
+
 // ----------------------------------------------------------------------------
 bool SPMeshLoader::isALoadableFileExtension(const io::path& filename) const
 {
@@ -40,6 +148,10 @@ bool SPMeshLoader::isALoadableFileExtension(const io::path& filename) const
 }   // isALoadableFileExtension
 
 // ----------------------------------------------------------------------------
+/** Loads a spm file. Meshes for the SP renderer are looked up in the mesh
+ *  cache first, which stores the decoded vertices, indices and armatures
+ *  of each file identified by its content hash.
+ */
 scene::IAnimatedMesh* SPMeshLoader::createMesh(io::IReadFile* f)
 {
 #ifndef SERVER_ONLY
@@ -56,13 +168,101 @@ scene::IAnimatedMesh* SPMeshLoader::createMesh(io::IReadFile* f)
     {
         return NULL;
     }
+    auto start = std::chrono::steady_clock::now();
+    // Read the whole file at once, the many small reads while decoding are
+    // much faster from memory
+    std::vector<uint8_t> data(f->getSize());
+    if (data.empty() ||
+        f->read(data.data(), (u32)data.size()) != (s32)data.size())
+    {
+        Log::error("SPMeshLoader", "Can't read %s.",
+            f->getFileName().c_str());
+        return NULL;
+    }
+    io::IFileSystem* fs = m_scene_manager->getFileSystem();
+    std::string base_path = fs->getFileDir(f->getFileName()).c_str();
+
+    std::string cache_key;
+    CacheArchive* cache = real_spm ? getCache() : NULL;
+    if (cache)
+    {
+        cache_key = StringUtils::insertValues("%s %x %d %d",
+            f->getFileName().c_str(),
+            CacheArchive::checksum(data.data(), data.size()),
+            MESH_CACHE_VERSION, (int)sizeof(video::S3DVertexSkinnedMesh));
+        uint32_t size = 0;
+        const uint8_t* cached = cache->get(cache_key, &size);
+        if (cached)
+        {
+            if (loadFromCache(cached, size, base_path))
+            {
+                m_cached_meshes++;
+                m_cache_time += std::chrono::duration<double, std::milli>
+                    (std::chrono::steady_clock::now() - start).count();
+                return m_mesh;
+            }
+            Log::warn("SPMeshLoader", "Damaged mesh cache entry for %s.",
+                f->getFileName().c_str());
+        }
+    }
+
+    io::IReadFile* mf = fs->createMemoryReadFile(data.data(),
+        (s32)data.size(), f->getFileName(), false);
+    scene::IAnimatedMesh* mesh = decodeMesh(mf, base_path, real_spm,
+                                            cache_key);
+    mf->drop();
+    m_decoded_meshes++;
+    m_decode_time += std::chrono::duration<double, std::milli>
+        (std::chrono::steady_clock::now() - start).count();
+    return mesh;
+}   // createMesh
+
+// ----------------------------------------------------------------------------
+/** Returns the archive of decoded meshes, or NULL if it can't be opened. */
+CacheArchive* SPMeshLoader::getCache()
+{
+    if (!m_cache)
+    {
+        m_cache.reset(new CacheArchive(file_manager->getCachedMeshesDir() +
+            "meshes.sparc"));
+    }
+    return m_cache->isOpen() ? m_cache.get() : NULL;
+}   // getCache
+
+// ----------------------------------------------------------------------------
+/** Returns the material of a texture pair in a spm file, the first texture
+ *  is searched next to the spm file first. */
+Material* SPMeshLoader::getSPMaterial(const std::string& base_path,
+                                      std::string tex_name_1,
+                                      const std::string& tex_name_2)
+{
+    if (!tex_name_1.empty())
+    {
+        std::string full_path = base_path + "/" + tex_name_1;
+        if (m_scene_manager->getFileSystem()->existFile(full_path.c_str()))
+        {
+            tex_name_1 = full_path;
+        }
+    }
+    return material_manager->getMaterialSPM(tex_name_1, tex_name_2);
+}   // getSPMaterial
+
+// ----------------------------------------------------------------------------
+/** Decodes a spm file.
+ *  \param cache_key If not empty the decoded mesh is added to the mesh
+ *         cache with this key.
+ */
+scene::IAnimatedMesh* SPMeshLoader::decodeMesh(io::IReadFile* f,
+                                               const std::string& base_path,
+                                               bool real_spm,
+                                               const std::string& cache_key)
+{
     m_bind_frame = 0;
     m_joint_count = 0;
     m_frame_count = 0;
     m_mesh = NULL;
     m_mesh = real_spm ? new SP::SPMesh() : m_scene_manager->createSkinnedMesh();
     io::IFileSystem* fs = m_scene_manager->getFileSystem();
-    std::string base_path = fs->getFileDir(f->getFileName()).c_str();
     std::string header;
     header.resize(2);
     f->read(&header.front(), 2);
@@ -123,18 +323,10 @@ scene::IAnimatedMesh* SPMeshLoader::createMesh(io::IReadFile* f)
         }
         if (real_spm)
         {
-            if (!tex_name_1.empty())
-            {
-                std::string full_path = base_path + "/" + tex_name_1;
-                if (fs->existFile(full_path.c_str()))
-                {
-                    tex_name_1 = full_path;
-                }
-            }
+            m_material_names.emplace_back(tex_name_1, tex_name_2);
             sp_mat_map[id] =
-                std::make_tuple(
-                material_manager->getMaterialSPM(tex_name_1, tex_name_2),
-                !tex_name_1.empty(), !tex_name_2.empty());
+                std::make_tuple(getSPMaterial(base_path, tex_name_1,
+                tex_name_2), !tex_name_1.empty(), !tex_name_2.empty());
         }
         else
         {
@@ -201,6 +393,7 @@ scene::IAnimatedMesh* SPMeshLoader::createMesh(io::IReadFile* f)
             if (real_spm)
             {
                 assert(mat_id < sp_mat_map.size());
+                m_buffer_materials.push_back(mat_id);
                 decompressSPM(f, vertices_count, indices_count, read_normal,
                     read_vcolor, read_tangent, std::get<1>(sp_mat_map[mat_id]),
                     std::get<2>(sp_mat_map[mat_id]), vt,
@@ -239,21 +432,11 @@ scene::IAnimatedMesh* SPMeshLoader::createMesh(io::IReadFile* f)
     const bool has_armature = !m_all_armatures.empty();
     if (real_spm)
     {
-        SP::SPMesh* spm = static_cast<SP::SPMesh*>(m_mesh);
-        spm->m_bind_frame = m_bind_frame;
-        spm->m_joint_using = m_joint_count;
-        // Because the last frame in spm is usable
-        if (has_armature)
+        if (!cache_key.empty())
         {
-            spm->m_frame_count = m_frame_count + 1;
+            addToCache(cache_key);
         }
-        for (unsigned i = 0; i < m_all_armatures.size(); i++)
-        {
-            // This is diffferent from m_joint_using
-            spm->m_total_joints +=
-                (unsigned)m_all_armatures[i].m_joint_names.size();
-        }
-        spm->m_all_armatures = std::move(m_all_armatures);
+        finishSPMesh();
     }
     m_mesh->finalize();
     if (!real_spm && has_armature)
@@ -265,8 +448,185 @@ scene::IAnimatedMesh* SPMeshLoader::createMesh(io::IReadFile* f)
     m_all_armatures.clear();
     m_to_bind_pose_matrices.clear();
     m_joints.clear();
+    m_material_names.clear();
+    m_buffer_materials.clear();
     return m_mesh;
-}   // createMesh
+}   // decodeMesh
+
+// ----------------------------------------------------------------------------
+/** Moves the armatures and animation data into the SPMesh. */
+void SPMeshLoader::finishSPMesh()
+{
+    SP::SPMesh* spm = static_cast<SP::SPMesh*>(m_mesh);
+    spm->m_bind_frame = m_bind_frame;
+    spm->m_joint_using = m_joint_count;
+    // Because the last frame in spm is usable
+    if (!m_all_armatures.empty())
+    {
+        spm->m_frame_count = m_frame_count + 1;
+    }
+    for (unsigned i = 0; i < m_all_armatures.size(); i++)
+    {
+        // This is diffferent from m_joint_using
+        spm->m_total_joints +=
+            (unsigned)m_all_armatures[i].m_joint_names.size();
+    }
+    spm->m_all_armatures = std::move(m_all_armatures);
+}   // finishSPMesh
+
+// ----------------------------------------------------------------------------
+/** Adds the decoded mesh buffers and armatures of the current mesh to the
+ *  mesh cache. All values are stored one after another without any
+ *  pointers, so the record can be used directly from the mapped file.
+ */
+void SPMeshLoader::addToCache(const std::string& cache_key)
+{
+    SP::SPMesh* spm = static_cast<SP::SPMesh*>(m_mesh);
+    assert(m_buffer_materials.size() == spm->m_buffer.size());
+    std::vector<uint8_t> out;
+    putValue(&out, (uint32_t)m_material_names.size());
+    for (auto& p : m_material_names)
+    {
+        putString(&out, p.first);
+        putString(&out, p.second);
+    }
+    putValue(&out, (uint32_t)spm->m_buffer.size());
+    for (unsigned i = 0; i < spm->m_buffer.size(); i++)
+    {
+        SP::SPMeshBuffer* mb = spm->m_buffer[i];
+        putValue(&out, (uint32_t)m_buffer_materials[i]);
+        putValue(&out, (uint32_t)mb->getVertexCount());
+        putData(&out, mb->getSPMVertex(), mb->getVertexCount() *
+            sizeof(video::S3DVertexSkinnedMesh));
+        putValue(&out, (uint32_t)mb->getIndexCount());
+        putData(&out, mb->getIndices(), mb->getIndexCount() * 2);
+    }
+    putValue(&out, (uint32_t)m_bind_frame);
+    putValue(&out, (uint32_t)m_joint_count);
+    putValue(&out, (uint32_t)m_frame_count);
+    putValue(&out, (uint32_t)m_all_armatures.size());
+    for (const SP::Armature& arm : m_all_armatures)
+    {
+        const unsigned joints = (unsigned)arm.m_joint_names.size();
+        putValue(&out, (uint32_t)arm.m_joint_used);
+        putValue(&out, (uint32_t)joints);
+        for (unsigned i = 0; i < joints; i++)
+        {
+            putString(&out, arm.m_joint_names[i]);
+            putData(&out, arm.m_joint_matrices[i].pointer(), 64);
+            putValue(&out, (int32_t)arm.m_parent_infos[i]);
+        }
+        putValue(&out, (uint32_t)arm.m_frame_pose_matrices.size());
+        for (auto& frame : arm.m_frame_pose_matrices)
+        {
+            putValue(&out, (int32_t)frame.first);
+            for (const SP::LocRotScale& lrs : frame.second)
+            {
+                const float tmp[10] =
+                {
+                    lrs.m_loc.X, lrs.m_loc.Y, lrs.m_loc.Z,
+                    lrs.m_rot.X, lrs.m_rot.Y, lrs.m_rot.Z, lrs.m_rot.W,
+                    lrs.m_scale.X, lrs.m_scale.Y, lrs.m_scale.Z
+                };
+                putData(&out, tmp, 40);
+            }
+        }
+    }
+    m_cache->add(cache_key, out.data(), (uint32_t)out.size());
+}   // addToCache
+
+// ----------------------------------------------------------------------------
+/** Creates a SPMesh from a record of the mesh cache. The vertices and
+ *  indices are copied with one allocation per mesh buffer.
+ *  \return False if the record is damaged, in which case the file needs to
+ *          be decoded.
+ */
+bool SPMeshLoader::loadFromCache(const uint8_t* data, uint32_t size,
+                                 const std::string& base_path)
+{
+    using namespace SP;
+    CacheReader reader(data, size);
+    std::vector<Material*> materials(reader.getCount(2 * 4));
+    for (unsigned i = 0; i < materials.size(); i++)
+    {
+        const std::string tex_name_1 = reader.getString();
+        const std::string tex_name_2 = reader.getString();
+        materials[i] = getSPMaterial(base_path, tex_name_1, tex_name_2);
+    }
+
+    SPMesh* spm = new SPMesh();
+    m_mesh = spm;
+    const uint32_t buffer_count = reader.getCount(3 * 4);
+    for (unsigned i = 0; i < buffer_count; i++)
+    {
+        const uint32_t mat_id = reader.get<uint32_t>();
+        std::vector<video::S3DVertexSkinnedMesh> vertices
+            (reader.getCount(sizeof(video::S3DVertexSkinnedMesh)));
+        reader.getData(vertices.data(),
+            vertices.size() * sizeof(video::S3DVertexSkinnedMesh));
+        std::vector<uint16_t> indices(reader.getCount(2));
+        reader.getData(indices.data(), indices.size() * 2);
+        if (mat_id >= materials.size() || vertices.empty() ||
+            indices.empty())
+        {
+            break;
+        }
+        m_geometry_bytes += vertices.size() *
+            sizeof(video::S3DVertexSkinnedMesh) + indices.size() * 2;
+        SPMeshBuffer* mb = new SPMeshBuffer();
+        spm->m_buffer.push_back(mb);
+        mb->setSPMVertices(vertices);
+        mb->setIndices(indices);
+        mb->setSTKMaterial(materials[mat_id]);
+    }
+
+    m_bind_frame = reader.get<uint32_t>();
+    m_joint_count = reader.get<uint32_t>();
+    m_frame_count = reader.get<uint32_t>();
+    m_all_armatures.resize(reader.getCount(2 * 4));
+    for (Armature& arm : m_all_armatures)
+    {
+        arm.m_joint_used = reader.get<uint32_t>();
+        const unsigned joints = reader.getCount(4 + 64 + 4);
+        arm.m_joint_names.resize(joints);
+        arm.m_joint_matrices.resize(joints);
+        arm.m_interpolated_matrices.resize(joints);
+        arm.m_world_matrices.resize(joints,
+            std::make_pair(core::matrix4(), false));
+        arm.m_parent_infos.resize(joints);
+        for (unsigned i = 0; i < joints; i++)
+        {
+            arm.m_joint_names[i] = reader.getString();
+            reader.getData(arm.m_joint_matrices[i].pointer(), 64);
+            arm.m_parent_infos[i] = reader.get<int32_t>();
+        }
+        arm.m_frame_pose_matrices.resize(reader.getCount(4 + joints * 40));
+        for (auto& frame : arm.m_frame_pose_matrices)
+        {
+            frame.first = reader.get<int32_t>();
+            frame.second.resize(joints);
+            for (LocRotScale& lrs : frame.second)
+            {
+                float tmp[10];
+                reader.getData(tmp, 40);
+                lrs.m_loc = core::vector3df(tmp[0], tmp[1], tmp[2]);
+                lrs.m_rot = core::quaternion(tmp[3], tmp[4], tmp[5], tmp[6]);
+                lrs.m_scale = core::vector3df(tmp[7], tmp[8], tmp[9]);
+            }
+        }
+    }
+
+    if (!reader.isOk() || spm->m_buffer.size() != buffer_count)
+    {
+        m_all_armatures.clear();
+        spm->drop();
+        m_mesh = NULL;
+        return false;
+    }
+    finishSPMesh();
+    m_mesh->finalize();
+    return true;
+}   // loadFromCache
 
 // ----------------------------------------------------------------------------
 void SPMeshLoader::decompressSPM(irr::io::IReadFile* spm,
@@ -283,6 +643,8 @@ void SPMeshLoader::decompressSPM(irr::io::IReadFile* spm,
     SPMeshBuffer* mb = new SPMeshBuffer();
     static_cast<SPMesh*>(m_mesh)->m_buffer.push_back(mb);
     const unsigned idx_size = vertices_count > 255 ? 2 : 1;
+    std::vector<video::S3DVertexSkinnedMesh> vertices;
+    vertices.reserve(vertices_count);
     for (unsigned i = 0; i < vertices_count; i++)
     {
         video::S3DVertexSkinnedMesh vertex = {};
@@ -350,8 +712,9 @@ void SPMeshLoader::decompressSPM(irr::io::IReadFile* spm,
                 vertex.m_weight[0] = 15360;
             }
         }
-        mb->addSPMVertex(vertex);
+        vertices.push_back(vertex);
     }
+    mb->setSPMVertices(vertices);
 
     std::vector<uint16_t> indices;
     indices.resize(indices_count);
@@ -369,6 +732,8 @@ void SPMeshLoader::decompressSPM(irr::io::IReadFile* spm,
             indices[i] = tmp_idx[i];
         }
     }
+    m_geometry_bytes += vertices_count *
+        sizeof(video::S3DVertexSkinnedMesh) + indices_count * 2;
     mb->setIndices(indices);
     mb->setSTKMaterial(m);
 
@@ -25,10 +25,13 @@
 #include <ISkinnedMesh.h>
 #include <IReadFile.h>
 #include <array>
+#include <memory>
+#include <string>
 #include <vector>
 
 using namespace irr;
 
+class CacheArchive;
 class Material;
 
 class SPMeshLoader : public scene::IMeshLoader
@@ -62,6 +65,24 @@ private:
     void createAnimationData(irr::io::IReadFile* spm);
     // ------------------------------------------------------------------------
     void convertIrrlicht();
+    // ------------------------------------------------------------------------
+    scene::IAnimatedMesh* decodeMesh(io::IReadFile* f,
+                                     const std::string& base_path,
+                                     bool real_spm,
+                                     const std::string& cache_key);
+    // ------------------------------------------------------------------------
+    Material* getSPMaterial(const std::string& base_path,
+                            std::string tex_name_1,
+                            const std::string& tex_name_2);
+    // ------------------------------------------------------------------------
+    void finishSPMesh();
+    // ------------------------------------------------------------------------
+    CacheArchive* getCache();
+    // ------------------------------------------------------------------------
+    void addToCache(const std::string& cache_key);
+    // ------------------------------------------------------------------------
+    bool loadFromCache(const uint8_t* data, uint32_t size,
+                       const std::string& base_path);
 
     scene::ISkinnedMesh* m_mesh;
 
@@ -70,9 +91,27 @@ private:
     std::vector<std::vector<
         std::pair<std::array<short, 4>, std::array<float, 4> > > > m_joints;
 
+    /** The texture names of each material of the current spm file, and the
+     *  material index of each mesh buffer, stored in the mesh cache. */
+    std::vector<std::pair<std::string, std::string> > m_material_names;
+
+    std::vector<uint16_t> m_buffer_materials;
+
+    /** The decoded meshes for the SP renderer, opened on first use. */
+    std::unique_ptr<CacheArchive> m_cache;
+
+    /** Statistics printed when the loader is deleted. */
+    unsigned m_decoded_meshes, m_cached_meshes;
+
+    double m_decode_time, m_cache_time;
+
+    uint64_t m_geometry_bytes;
+
 public:
     // ------------------------------------------------------------------------
-    SPMeshLoader(scene::ISceneManager* smgr) : m_scene_manager(smgr) {}
+    SPMeshLoader(scene::ISceneManager* smgr);
+    // ------------------------------------------------------------------------
+    ~SPMeshLoader();
     // ------------------------------------------------------------------------
     virtual bool isALoadableFileExtension(const io::path& filename) const;
     // ------------------------------------------------------------------------
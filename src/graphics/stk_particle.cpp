@@ -44,7 +44,6 @@ STKParticle::STKParticle(bool randomize_initial_y, ISceneNode* parent, s32 id,
     m_hm = NULL;
     m_color_to = core::vector3df(1.0f);
     m_color_from = m_color_to;
-    m_size_increase_factor = 0.0f;
     m_first_execution = true;
     m_pre_generating = true;
     m_randomize_initial_y = randomize_initial_y;
@@ -84,23 +83,21 @@ static void generateLifetimeSizeDirection(scene::IParticleEmitter *emitter,
 void STKParticle::generateParticlesFromPointEmitter
     (scene::IParticlePointEmitter *emitter)
 {
-    m_particles_generating.clear();
-    m_initial_particles.clear();
-    m_particles_generating.resize(m_max_count);
-    m_initial_particles.resize(m_max_count);
+    m_simulation.resize(m_max_count);
+    ParticleSimulation::Arrays& generating = m_simulation.getGenerating();
+    ParticleSimulation::Arrays& initial = m_simulation.getInitial();
     for (unsigned i = 0; i < m_max_count; i++)
     {
         // Initial lifetime is > 1
-        m_particles_generating[i].m_lifetime = 2.0f;
+        generating.m_lifetime[i] = 2.0f;
 
-        generateLifetimeSizeDirection(emitter,
-            m_initial_particles[i].m_lifetime,
-            m_particles_generating[i].m_size,
-            m_particles_generating[i].m_direction);
+        core::vector3df direction;
+        generateLifetimeSizeDirection(emitter, initial.m_lifetime[i],
+            generating.m_size[i], direction);
 
-        m_initial_particles[i].m_direction =
-            m_particles_generating[i].m_direction;
-        m_initial_particles[i].m_size = m_particles_generating[i].m_size;
+        generating.setDirection(i, direction);
+        initial.setDirection(i, direction);
+        initial.m_size[i] = generating.m_size[i];
     }
 }   // generateParticlesFromPointEmitter
 
@@ -108,42 +105,38 @@ void STKParticle::generateParticlesFromPointEmitter
 void STKParticle::generateParticlesFromBoxEmitter
     (scene::IParticleBoxEmitter *emitter)
 {
-    m_particles_generating.clear();
-    m_initial_particles.clear();
-    m_particles_generating.resize(m_max_count);
-    m_initial_particles.resize(m_max_count);
+    m_simulation.resize(m_max_count);
+    ParticleSimulation::Arrays& generating = m_simulation.getGenerating();
+    ParticleSimulation::Arrays& initial = m_simulation.getInitial();
     const core::vector3df& extent = emitter->getBox().getExtent();
     for (unsigned i = 0; i < m_max_count; i++)
     {
-        m_particles_generating[i].m_position.X =
+        generating.m_x[i] =
             emitter->getBox().MinEdge.X + os::Randomizer::frand() * extent.X;
-        m_particles_generating[i].m_position.Y =
+        generating.m_y[i] =
             emitter->getBox().MinEdge.Y + os::Randomizer::frand() * extent.Y;
-        m_particles_generating[i].m_position.Z =
+        generating.m_z[i] =
             emitter->getBox().MinEdge.Z + os::Randomizer::frand() * extent.Z;
 
         // Initial lifetime is random
-        m_particles_generating[i].m_lifetime = os::Randomizer::frand();
+        generating.m_lifetime[i] = os::Randomizer::frand();
         if (!m_randomize_initial_y)
         {
-            m_particles_generating[i].m_lifetime += 1.0f;
+            generating.m_lifetime[i] += 1.0f;
         }
-        m_initial_particles[i].m_position =
-            m_particles_generating[i].m_position;
+        initial.setPosition(i, generating.getPosition(i));
 
-        generateLifetimeSizeDirection(emitter,
-            m_initial_particles[i].m_lifetime,
-            m_particles_generating[i].m_size,
-            m_particles_generating[i].m_direction);
+        core::vector3df direction;
+        generateLifetimeSizeDirection(emitter, initial.m_lifetime[i],
+            generating.m_size[i], direction);
 
-        m_initial_particles[i].m_direction =
-            m_particles_generating[i].m_direction;
-        m_initial_particles[i].m_size = m_particles_generating[i].m_size;
+        generating.setDirection(i, direction);
+        initial.setDirection(i, direction);
+        initial.m_size[i] = generating.m_size[i];
 
         if (m_randomize_initial_y)
         {
-            m_initial_particles[i].m_position.Y =
-                os::Randomizer::frand() * 50.0f; // -100.0f;
+            initial.m_y[i] = os::Randomizer::frand() * 50.0f; // -100.0f;
         }
     }
 }   // generateParticlesFromBoxEmitter
@@ -152,10 +145,9 @@ void STKParticle::generateParticlesFromBoxEmitter
 void STKParticle::generateParticlesFromSphereEmitter
     (scene::IParticleSphereEmitter *emitter)
 {
-    m_particles_generating.clear();
-    m_initial_particles.clear();
-    m_particles_generating.resize(m_max_count);
-    m_initial_particles.resize(m_max_count);
+    m_simulation.resize(m_max_count);
+    ParticleSimulation::Arrays& generating = m_simulation.getGenerating();
+    ParticleSimulation::Arrays& initial = m_simulation.getInitial();
     for (unsigned i = 0; i < m_max_count; i++)
     {
         // Random distance from center
@@ -167,21 +159,19 @@ void STKParticle::generateParticlesFromSphereEmitter
         pos.rotateYZBy(os::Randomizer::frand() * 360.f, emitter->getCenter());
         pos.rotateXZBy(os::Randomizer::frand() * 360.f, emitter->getCenter());
 
-        m_particles_generating[i].m_position = pos;
+        generating.setPosition(i, pos);
 
         // Initial lifetime is > 1
-        m_particles_generating[i].m_lifetime = 2.0f;
-        m_initial_particles[i].m_position =
-            m_particles_generating[i].m_position;
-
-        generateLifetimeSizeDirection(emitter,
-            m_initial_particles[i].m_lifetime,
-            m_particles_generating[i].m_size,
-            m_particles_generating[i].m_direction);
-
-        m_initial_particles[i].m_direction =
-            m_particles_generating[i].m_direction;
-        m_initial_particles[i].m_size = m_particles_generating[i].m_size;
+        generating.m_lifetime[i] = 2.0f;
+        initial.setPosition(i, pos);
+
+        core::vector3df direction;
+        generateLifetimeSizeDirection(emitter, initial.m_lifetime[i],
+            generating.m_size[i], direction);
+
+        generating.setDirection(i, direction);
+        initial.setDirection(i, direction);
+        initial.m_size[i] = generating.m_size[i];
     }
 }   // generateParticlesFromSphereEmitter
 
@@ -251,26 +241,16 @@ void STKParticle::generate(std::vector<CPUParticle>* out)
         for (int i = 0; i <
             (m_max_count > 5000 ? 5 : m_pre_generating ? 100 : 0); i++)
         {
-            if (m_hm != NULL)
-            {
-                stimulateHeightMap((float)i, active_count, NULL);
-            }
-            else
-            {
-                stimulateNormal((float)i, active_count, NULL);
-            }
+            stimulate((float)i, active_count);
         }
         m_first_execution = false;
     }
 
     float dt = GUIEngine::getLatestDt() * 1000.f;
-    if (m_hm != NULL)
+    stimulate(dt, active_count);
+    if (out != NULL)
     {
-        stimulateHeightMap(dt, active_count, out);
-    }
-    else
-    {
-        stimulateNormal(dt, active_count, out);
+        emitParticles(out);
     }
     m_previous_frame_matrix = AbsoluteTransformation;
 
@@ -280,196 +260,47 @@ void STKParticle::generate(std::vector<CPUParticle>* out)
 }   // generate
 
 // ----------------------------------------------------------------------------
-inline float glslFract(float val)
-{
-    return val - (float)floor(val);
-}   // glslFract
-
-// ----------------------------------------------------------------------------
-inline float glslMix(float x, float y, float a)
+/** Updates all particles, see ParticleSimulation.
+ *  \param dt Time step in ms.
+ *  \param active_count Number of particles which are emitted again after
+ *         their lifetime.
+ */
+void STKParticle::stimulate(float dt, unsigned int active_count)
 {
-    return x * (1.0f - a) + y * a;
-}   // glslMix
-
-// ----------------------------------------------------------------------------
-void STKParticle::stimulateHeightMap(float dt, unsigned int active_count,
-                                     std::vector<CPUParticle>* out)
-{
-    assert(m_hm != NULL);
-    const core::matrix4 cur_matrix = AbsoluteTransformation;
-    for (unsigned i = 0; i < m_max_count; i++)
+    if (m_hm != NULL)
     {
-        core::vector3df new_particle_position;
-        core::vector3df new_particle_direction;
-        float new_size = 0.0f;
-        float new_lifetime = 0.0f;
-
-        const core::vector3df particle_position =
-            m_particles_generating[i].m_position;
-        const float lifetime = m_particles_generating[i].m_lifetime;
-        const core::vector3df particle_direction =
-            m_particles_generating[i].m_direction;
-
-        const core::vector3df particle_position_initial =
-            m_initial_particles[i].m_position;
-        const float lifetime_initial = m_initial_particles[i].m_lifetime;
-        const core::vector3df particle_direction_initial =
-            m_initial_particles[i].m_direction;
-        const float size_initial = m_initial_particles[i].m_size;
-
-        bool reset = false;
-        const int px = core::clamp((int)(256.0f *
-            (particle_position.X - m_hm->m_x) / m_hm->m_x_len), 0, 255);
-        const int py = core::clamp((int)(256.0f *
-            (particle_position.Z - m_hm->m_z) / m_hm->m_z_len), 0, 255);
-        const float h = particle_position.Y - m_hm->m_array[px][py];
-        reset = h < 0.0f;
-
-        core::vector3df initial_position, initial_new_position;
-        cur_matrix.transformVect(initial_position, particle_position_initial);
-        cur_matrix.transformVect(initial_new_position,
-            particle_position_initial + particle_direction_initial);
-
-        core::vector3df adjusted_initial_direction =
-            initial_new_position - initial_position;
-        float adjusted_lifetime = lifetime + (dt / lifetime_initial);
-        reset = reset || adjusted_lifetime > 1.0f;
-        reset = reset || lifetime < 0.0f;
-
-        new_particle_position = !reset ?
-            (particle_position + particle_direction * dt) : initial_position;
-        new_lifetime = !reset ? adjusted_lifetime : 0.0f;
-        new_particle_direction = !reset ?
-            particle_direction : adjusted_initial_direction;
-        new_size = !reset ?
-            glslMix(size_initial, size_initial * m_size_increase_factor,
-            adjusted_lifetime) : 0.0f;
-
-        m_particles_generating[i].m_position = new_particle_position;
-        m_particles_generating[i].m_lifetime = new_lifetime;
-        m_particles_generating[i].m_direction = new_particle_direction;
-        m_particles_generating[i].m_size = new_size;
-        if (out != NULL)
-        {
-            if (m_flips || new_size != 0.0f)
-            {
-                if (new_size != 0.0f)
-                {
-                    Buffer->BoundingBox.addInternalPoint
-                        (new_particle_position);
-                }
-                out->emplace_back(new_particle_position, m_color_from,
-                    m_color_to, new_lifetime, new_size);
-            }
-        }
+        m_simulation.stimulateHeightMap(dt, AbsoluteTransformation, *m_hm);
     }
-}   // stimulateHeightMap
+    else
+    {
+        m_simulation.stimulateNormal(dt, active_count,
+            m_previous_frame_matrix, AbsoluteTransformation);
+    }
+}   // stimulate
 
 // ----------------------------------------------------------------------------
-void STKParticle::stimulateNormal(float dt, unsigned int active_count,
-                                  std::vector<CPUParticle>* out)
+/** Appends the visible particles (and all particles of flips materials, so
+ *  that each particle keeps its flip) to out and updates the bounding box.
+ */
+void STKParticle::emitParticles(std::vector<CPUParticle>* out)
 {
-    const core::matrix4 cur_matrix = AbsoluteTransformation;
-    core::vector3df previous_frame_position, current_frame_position,
-        previous_frame_direction, current_frame_direction;
-    for (unsigned i = 0; i < m_max_count; i++)
+    const ParticleSimulation::Arrays& particles =
+        m_simulation.getGenerating();
+    for (unsigned i = 0; i < m_simulation.getCount(); i++)
     {
-        core::vector3df new_particle_position;
-        core::vector3df new_particle_direction;
-        float new_size = 0.0f;
-        float new_lifetime = 0.0f;
-
-        const core::vector3df particle_position =
-            m_particles_generating[i].m_position;
-        const float lifetime = m_particles_generating[i].m_lifetime;
-        const core::vector3df particle_direction =
-            m_particles_generating[i].m_direction;
-        const float size = m_particles_generating[i].m_size;
-
-        const core::vector3df particle_position_initial =
-            m_initial_particles[i].m_position;
-        const float lifetime_initial = m_initial_particles[i].m_lifetime;
-        const core::vector3df particle_direction_initial =
-            m_initial_particles[i].m_direction;
-        const float size_initial = m_initial_particles[i].m_size;
-
-        float updated_lifetime = lifetime + (dt / lifetime_initial);
-        if (updated_lifetime > 1.0f)
-        {
-            if (i < active_count)
-            {
-                float dt_from_last_frame =
-                    glslFract(updated_lifetime) * lifetime_initial;
-                float coeff = dt_from_last_frame / dt;
-
-                m_previous_frame_matrix.transformVect(previous_frame_position,
-                    particle_position_initial);
-                cur_matrix.transformVect(current_frame_position,
-                    particle_position_initial);
-
-                core::vector3df updated_position = previous_frame_position
-                    .getInterpolated(current_frame_position, coeff);
-
-                m_previous_frame_matrix.rotateVect(previous_frame_direction,
-                    particle_direction_initial);
-                cur_matrix.rotateVect(current_frame_direction,
-                    particle_direction_initial);
-
-                core::vector3df updated_direction = previous_frame_direction
-                    .getInterpolated(current_frame_direction, coeff);
-                // + (current_frame_position - previous_frame_position) / dt;
-
-                // To be accurate, emitter speed should be added.
-                // But the simple formula
-                // ( (current_frame_position - previous_frame_position) / dt )
-                // with a constant speed between 2 frames creates visual
-                // artifacts when the framerate is low, and a more accurate
-                // formula would need more complex computations.
-
-                new_particle_position = updated_position + dt_from_last_frame *
-                    updated_direction;
-                new_particle_direction = updated_direction;
-
-                new_lifetime = glslFract(updated_lifetime);
-                new_size = glslMix(size_initial,
-                    size_initial * m_size_increase_factor,
-                    glslFract(updated_lifetime));
-            }
-            else
-            {
-                new_lifetime = glslFract(updated_lifetime);
-                new_size = 0.0f;
-            }
-        }
-        else
-        {
-            new_particle_position = particle_position +
-                particle_direction * dt;
-            new_particle_direction = particle_direction;
-            new_lifetime = updated_lifetime;
-            new_size = (size == 0.0f) ? 0.0f :
-                glslMix(size_initial, size_initial * m_size_increase_factor,
-                updated_lifetime);
-        }
-        m_particles_generating[i].m_position = new_particle_position;
-        m_particles_generating[i].m_lifetime = new_lifetime;
-        m_particles_generating[i].m_direction = new_particle_direction;
-        m_particles_generating[i].m_size = new_size;
-        if (out != NULL)
+        const float size = particles.m_size[i];
+        if (m_flips || size != 0.0f)
         {
-            if (m_flips || new_size != 0.0f)
+            const core::vector3df position = particles.getPosition(i);
+            if (size != 0.0f)
             {
-                if (new_size != 0.0f)
-                {
-                    Buffer->BoundingBox.addInternalPoint
-                        (new_particle_position);
-                }
-                out->emplace_back(new_particle_position, m_color_from,
-                    m_color_to, new_lifetime, new_size);
+                Buffer->BoundingBox.addInternalPoint(position);
             }
+            out->emplace_back(position, m_color_from, m_color_to,
+                particles.m_lifetime[i], size);
         }
     }
-}   // stimulateNormal
+}   // emitParticles
 
 // ----------------------------------------------------------------------------
 void STKParticle::updateFlips(unsigned maximum_particle_count)
@@ -506,9 +337,11 @@ void STKParticle::OnRegisterSceneNode()
     generate(NULL);
     Particles.clear();
     Buffer->BoundingBox.reset(AbsoluteTransformation.getTranslation());
-    for (unsigned i = 0; i < m_particles_generating.size(); i++)
+    const ParticleSimulation::Arrays& particles =
+        m_simulation.getGenerating();
+    for (unsigned i = 0; i < m_simulation.getCount(); i++)
     {
-        if (m_particles_generating[i].m_size == 0.0f)
+        if (particles.m_size[i] == 0.0f)
         {
             continue;
         }
@@ -517,12 +350,12 @@ void STKParticle::OnRegisterSceneNode()
         p.endTime = 0;
         p.color = 0;
         p.startColor = 0;
-        p.pos = m_particles_generating[i].m_position;
+        p.pos = particles.getPosition(i);
         Buffer->BoundingBox.addInternalPoint(p.pos);
-        p.size = core::dimension2df(m_particles_generating[i].m_size,
-            m_particles_generating[i].m_size);
+        p.size = core::dimension2df(particles.m_size[i],
+            particles.m_size[i]);
         core::vector3df ret = m_color_from + (m_color_to - m_color_from) *
-            m_particles_generating[i].m_lifetime;
+            particles.m_lifetime[i];
         p.color.setRed(core::clamp((int)(ret.X * 255.0f), 0, 255));
         p.color.setBlue(core::clamp((int)(ret.Y * 255.0f), 0, 255));
         p.color.setGreen(core::clamp((int)(ret.Z * 255.0f), 0, 255));
@@ -21,6 +21,7 @@
 #define HEADER_STK_PARTICLE_HPP
 
 #include "graphics/gl_headers.hpp"
+#include "graphics/particle_simulation.hpp"
 #include "../lib/irrlicht/source/Irrlicht/CParticleSystemSceneNode.h"
 #include <cassert>
 #include <vector>
@@ -32,38 +33,13 @@ struct CPUParticle;
 class STKParticle : public scene::CParticleSystemSceneNode
 {
 private:
-    // ------------------------------------------------------------------------
-    struct HeightMapData
-    {
-        const std::vector<std::vector<float> > m_array;
-        const float m_x;
-        const float m_z;
-        const float m_x_len;
-        const float m_z_len;
-        // --------------------------------------------------------------------
-        HeightMapData(std::vector<std::vector<float> >& array,
-                      float track_x, float track_z, float track_x_len,
-                      float track_z_len)
-            : m_array(std::move(array)), m_x(track_x), m_z(track_z),
-              m_x_len(track_x_len), m_z_len(track_z_len) {}
-    };
-    // ------------------------------------------------------------------------
-    struct ParticleData
-    {
-        core::vector3df m_position;
-        float m_lifetime;
-        core::vector3df m_direction;
-        float m_size;
-    };
-    // ------------------------------------------------------------------------
-    HeightMapData* m_hm;
+    ParticleSimulation::HeightMap* m_hm;
 
-    std::vector<ParticleData> m_particles_generating, m_initial_particles;
+    /** The particles of this emitter. */
+    ParticleSimulation m_simulation;
 
     core::vector3df m_color_from, m_color_to;
 
-    float m_size_increase_factor;
-
     bool m_first_execution, m_randomize_initial_y, m_flips, m_pre_generating;
 
     /** Previous frame particles emitter source matrix */
@@ -83,9 +59,9 @@ private:
     // ------------------------------------------------------------------------
     void generateParticlesFromSphereEmitter(scene::IParticleSphereEmitter*);
     // ------------------------------------------------------------------------
-    void stimulateHeightMap(float, unsigned int, std::vector<CPUParticle>*);
+    void stimulate(float dt, unsigned int active_count);
     // ------------------------------------------------------------------------
-    void stimulateNormal(float, unsigned int, std::vector<CPUParticle>*);
+    void emitParticles(std::vector<CPUParticle>* out);
 
 public:
     // ------------------------------------------------------------------------
@@ -118,13 +94,14 @@ public:
     // ------------------------------------------------------------------------
     virtual void OnRegisterSceneNode();
     // ------------------------------------------------------------------------
-    void setIncreaseFactor(float val)         { m_size_increase_factor = val; }
+    void setIncreaseFactor(float val)  { m_simulation.setIncreaseFactor(val); }
     // ------------------------------------------------------------------------
-    void setHeightmap(std::vector<std::vector<float> >& array, float track_x,
-                      float track_z, float track_x_len, float track_z_len)
+    void setHeightmap(std::shared_ptr<const std::vector<float> > array,
+                      float track_x, float track_z, float track_x_len,
+                      float track_z_len)
     {
-        m_hm = new HeightMapData(array, track_x, track_z, track_x_len,
-            track_z_len);
+        m_hm = new ParticleSimulation::HeightMap(array, track_x, track_z,
+            track_x_len, track_z_len);
     }
     // ------------------------------------------------------------------------
     void generate(std::vector<CPUParticle>* out);
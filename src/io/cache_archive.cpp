@@ -0,0 +1,721 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "io/cache_archive.hpp"
+
+#include "io/file_manager.hpp"
+#include "utils/log.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+
+#ifdef WIN32
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <sys/file.h>
+#  include <sys/mman.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+#endif
+
+namespace
+{
+    /** Header at the start of an archive. */
+    struct FileHeader
+    {
+        char     m_magic[4];
+        uint32_t m_version;
+    };
+
+    /** Header of each record, followed by the key and the data. The
+     *  archive is in native byte order, it is not meant to be shared
+     *  between machines. */
+    struct RecordHeader
+    {
+        char     m_magic[4];
+        uint32_t m_key_size;
+        uint32_t m_data_size;
+        uint32_t m_checksum;
+    };
+
+    const uint32_t ARCHIVE_VERSION = 1;
+    const char FILE_MAGIC[4]   = { 'S', 'T', 'K', 'A' };
+    const char RECORD_MAGIC[4] = { 'S', 'T', 'K', 'R' };
+
+    /** Mapped views start at a multiple of this, which is the allocation
+     *  granularity of windows and a multiple of the page size elsewhere. */
+    const uint64_t MAP_ALIGNMENT = 64 * 1024;
+
+    /** Views reach this far past the end of the file (except on windows,
+     *  where a read only view can not be larger than the file), so records
+     *  which are appended later are usually in an existing view. */
+    const uint64_t MAP_RESERVE_SIZE = 16 * 1024 * 1024;
+
+    /** The archive is rewritten without replaced records when it is opened
+     *  and at least half of it, and more than this, is replaced records. */
+    const uint64_t COMPACT_MIN_STALE_SIZE = 16 * 1024 * 1024;
+
+    // ------------------------------------------------------------------------
+    bool seekFile(FILE *file, uint64_t offset)
+    {
+#ifdef WIN32
+        return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+        return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+    }   // seekFile
+
+    // ------------------------------------------------------------------------
+    uint64_t getFileSize(FILE *file)
+    {
+#ifdef WIN32
+        _fseeki64(file, 0, SEEK_END);
+        return (uint64_t)_ftelli64(file);
+#else
+        fseeko(file, 0, SEEK_END);
+        return (uint64_t)ftello(file);
+#endif
+    }   // getFileSize
+
+    // ------------------------------------------------------------------------
+    bool truncateFile(FILE *file, uint64_t size)
+    {
+        fflush(file);
+#ifdef WIN32
+        return _chsize_s(_fileno(file), (__int64)size) == 0;
+#else
+        return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+    }   // truncateFile
+
+    // ------------------------------------------------------------------------
+    /** Locks a file against other processes (not against other threads).
+     *  \param exclusive True for an exclusive lock, false for a shared one.
+     *  \param wait True to wait until a conflicting lock of another process
+     *         is released, false to fail instead.
+     *  \return False if the file could not be locked.
+     */
+    bool lockFile(FILE *file, bool exclusive, bool wait)
+    {
+#ifdef WIN32
+        // Lock a byte far behind the end, locked bytes can not be read
+        OVERLAPPED overlapped = {};
+        overlapped.Offset     = 0xFFFFFFFF;
+        overlapped.OffsetHigh = 0x7FFFFFFF;
+        const DWORD flags = (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0) |
+                            (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+        return LockFileEx((HANDLE)_get_osfhandle(_fileno(file)), flags, 0, 1,
+                          0, &overlapped) != 0;
+#else
+        return flock(fileno(file), (exclusive ? LOCK_EX : LOCK_SH) |
+                                   (wait ? 0 : LOCK_NB)) == 0;
+#endif
+    }   // lockFile
+
+    // ------------------------------------------------------------------------
+    void unlockFile(FILE *file)
+    {
+#ifdef WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset     = 0xFFFFFFFF;
+        overlapped.OffsetHigh = 0x7FFFFFFF;
+        UnlockFileEx((HANDLE)_get_osfhandle(_fileno(file)), 0, 1, 0,
+                     &overlapped);
+#else
+        flock(fileno(file), LOCK_UN);
+#endif
+    }   // unlockFile
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Returns a 32 bit FNV-1a hash of the data.
+ *  \param h The hash of the previous data, to hash several blocks.
+ */
+uint32_t CacheArchive::checksum(const uint8_t *data, size_t size, uint32_t h)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}   // checksum
+
+// ----------------------------------------------------------------------------
+/** Opens the archive, or creates it if it does not exist. If another
+ *  process already writes to the archive, it is only read.
+ *  \param filename Full path of the archive.
+ */
+CacheArchive::CacheArchive(const std::string &filename)
+            : m_filename(filename)
+{
+    m_file       = NULL;
+    m_lock_file  = NULL;
+    m_file_size  = 0;
+    m_stale_size = 0;
+
+    // The lock file is kept locked as long as this process can write
+    m_lock_file = fopen((m_filename + ".lock").c_str(), "ab");
+    if (m_lock_file && !lockFile(m_lock_file, /*exclusive*/true,
+                                 /*wait*/false))
+    {
+        Log::info("CacheArchive", "%s is used by another process, new "
+                  "entries are not stored.", m_filename.c_str());
+        setReadOnly();
+    }
+    if (!open())
+    {
+        Log::warn("CacheArchive", "Can not open %s, caching is disabled.",
+                  m_filename.c_str());
+        close();
+        return;
+    }
+    compact();
+}   // CacheArchive
+
+// ----------------------------------------------------------------------------
+CacheArchive::~CacheArchive()
+{
+    close();
+    setReadOnly();
+}   // ~CacheArchive
+
+// ----------------------------------------------------------------------------
+/** Releases the lock file, so that another process can write. */
+void CacheArchive::setReadOnly()
+{
+    if (m_lock_file)
+        fclose(m_lock_file);
+    m_lock_file = NULL;
+}   // setReadOnly
+
+// ----------------------------------------------------------------------------
+/** Opens the file and builds the index. The file is kept locked with a
+ *  shared lock, which tells other processes that it is mapped.
+ *  \return False if the file can not be opened or created.
+ */
+bool CacheArchive::open()
+{
+    if (isReadOnly())
+    {
+        m_file = fopen(m_filename.c_str(), "rb");
+    }
+    else
+    {
+        m_file = fopen(m_filename.c_str(), "r+b");
+        if (m_file == NULL)
+            m_file = fopen(m_filename.c_str(), "w+b");
+    }
+    if (m_file == NULL)
+        return false;
+    lockFile(m_file, /*exclusive*/false, /*wait*/true);
+    return scan();
+}   // open
+
+// ----------------------------------------------------------------------------
+/** Unmaps and closes the file. */
+void CacheArchive::close()
+{
+    unmapAll();
+    if (m_file)
+        fclose(m_file);
+    m_file = NULL;
+    m_file_size = 0;
+    m_stale_size = 0;
+    m_index.clear();
+}   // close
+
+// ----------------------------------------------------------------------------
+/** Changes the shared lock of the file into an exclusive one, which only
+ *  succeeds if no other process has the file open. Truncating or replacing
+ *  a file which another process has mapped would crash that process.
+ *  \return False if the file is still only locked with a shared lock.
+ */
+bool CacheArchive::lockExclusive()
+{
+    unlockFile(m_file);
+    if (lockFile(m_file, /*exclusive*/true, /*wait*/false))
+        return true;
+    lockFile(m_file, /*exclusive*/false, /*wait*/true);
+    return false;
+}   // lockExclusive
+
+// ----------------------------------------------------------------------------
+/** Changes the exclusive lock of the file back into a shared one. */
+void CacheArchive::unlockExclusive()
+{
+    unlockFile(m_file);
+    lockFile(m_file, /*exclusive*/false, /*wait*/true);
+}   // unlockExclusive
+
+// ----------------------------------------------------------------------------
+/** Builds the index from the headers of all records. An archive of another
+ *  version is emptied, and broken records at the end (e.g. if STK was
+ *  killed while writing) are cut off. Both only happen if no other process
+ *  has the file open. Otherwise an archive of another version is only
+ *  read (without entries), and new records overwrite the broken ones.
+ *  \return False if the file can not be written.
+ */
+bool CacheArchive::scan()
+{
+    m_index.clear();
+    m_stale_size = 0;
+    const uint64_t size = getFileSize(m_file);
+
+    bool valid_header = false;
+    if (size >= sizeof(FileHeader) && map(0, size))
+    {
+        FileHeader header;
+        memcpy(&header, m_mappings.back().m_address, sizeof(header));
+        valid_header = memcmp(header.m_magic, FILE_MAGIC, 4) == 0 &&
+                       header.m_version == ARCHIVE_VERSION;
+    }
+    if (!valid_header)
+    {
+        unmapAll();
+        m_file_size = 0;
+        // Nobody can have mapped an empty file
+        if (!isReadOnly() && size > 0 && !lockExclusive())
+        {
+            Log::warn("CacheArchive", "%s is of another version and used by "
+                      "another process.", m_filename.c_str());
+            setReadOnly();
+        }
+        if (isReadOnly())
+            return true;
+        FileHeader header;
+        memcpy(header.m_magic, FILE_MAGIC, 4);
+        header.m_version = ARCHIVE_VERSION;
+        m_file_size = sizeof(header);
+        const bool ok = truncateFile(m_file, 0) && seekFile(m_file, 0) &&
+            fwrite(&header, sizeof(header), 1, m_file) == 1 &&
+            fflush(m_file) == 0;
+        if (size > 0)
+            unlockExclusive();
+        return ok;
+    }
+
+    const uint8_t *base = m_mappings.back().m_address;
+    uint64_t offset = sizeof(FileHeader);
+    while (offset + sizeof(RecordHeader) <= size)
+    {
+        RecordHeader rh;
+        memcpy(&rh, base + offset, sizeof(rh));
+        const uint64_t record_size =
+            sizeof(rh) + (uint64_t)rh.m_key_size + rh.m_data_size;
+        if (memcmp(rh.m_magic, RECORD_MAGIC, 4) != 0 ||
+            offset + record_size > size)
+            break;
+        std::string key((const char*)base + offset + sizeof(rh),
+                        rh.m_key_size);
+        Entry &entry = m_index[key];
+        if (entry.m_record_size > 0)
+            m_stale_size += entry.m_record_size;
+        entry.m_offset      = offset + sizeof(rh) + rh.m_key_size;
+        entry.m_size        = rh.m_data_size;
+        entry.m_checksum    = rh.m_checksum;
+        entry.m_record_size = (uint32_t)record_size;
+        entry.m_verified    = false;
+        offset += record_size;
+    }
+    m_file_size = offset;
+    if (offset < size && !isReadOnly() && lockExclusive())
+    {
+        Log::warn("CacheArchive", "Removing %d broken bytes at the end of %s.",
+                  (int)(size - offset), m_filename.c_str());
+        unmapAll();
+        const bool ok = truncateFile(m_file, offset);
+        unlockExclusive();
+        return ok;
+    }
+    return true;
+}   // scan
+
+// ----------------------------------------------------------------------------
+/** Rewrites the archive without the replaced records if they use too much
+ *  space. Only called when the archive is opened, so no other thread can
+ *  use it, and only done if no other process has the file open.
+ */
+void CacheArchive::compact()
+{
+    if (isReadOnly() || m_stale_size < COMPACT_MIN_STALE_SIZE ||
+        m_stale_size * 2 < m_file_size || !lockExclusive())
+        return;
+
+    // Keep the order of the records in the file
+    std::map<uint64_t, const std::pair<const std::string, Entry>*> sorted;
+    for (auto &e : m_index)
+        sorted[e.second.m_offset] = &e;
+
+    const std::string tmp = m_filename + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "wb");
+    bool ok = out != NULL;
+    if (ok)
+    {
+        FileHeader header;
+        memcpy(header.m_magic, FILE_MAGIC, 4);
+        header.m_version = ARCHIVE_VERSION;
+        ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    }
+    for (auto &s : sorted)
+    {
+        if (!ok)
+            break;
+        const std::string &key = s.second->first;
+        const Entry &entry = s.second->second;
+        const uint8_t *data = getMappedData(entry.m_offset, entry.m_size);
+        RecordHeader rh;
+        memcpy(rh.m_magic, RECORD_MAGIC, 4);
+        rh.m_key_size  = (uint32_t)key.size();
+        rh.m_data_size = entry.m_size;
+        rh.m_checksum  = entry.m_checksum;
+        ok = data != NULL && fwrite(&rh, sizeof(rh), 1, out) == 1 &&
+             fwrite(key.data(), 1, key.size(), out) == key.size() &&
+             fwrite(data, 1, entry.m_size, out) == entry.m_size;
+    }
+    if (out && fclose(out) != 0)
+        ok = false;
+
+    const uint64_t old_size = m_file_size;
+    // Other processes which open the file now wait for the shared lock, and
+    // then map the old file until they reopen it
+    close();
+    if (ok)
+    {
+        ok = remove(m_filename.c_str()) == 0 &&
+             rename(tmp.c_str(), m_filename.c_str()) == 0;
+    }
+    if (!ok)
+        remove(tmp.c_str());
+    if (!open())
+    {
+        close();
+        return;
+    }
+    Log::info("CacheArchive", "Compacted %s from %d to %d bytes.",
+              m_filename.c_str(), (int)old_size, (int)m_file_size);
+}   // compact
+
+// ----------------------------------------------------------------------------
+/** Maps a part of the file into memory. Except on windows, the view reaches
+ *  MAP_RESERVE_SIZE past the end of the part. The pages after the end of the
+ *  file are not accessed until records are appended there, and the file is
+ *  never truncated while it is mapped by another process.
+ *  \param start Offset of the part, a multiple of MAP_ALIGNMENT.
+ *  \param end End of the part, at most the file size.
+ *  \return False if the part could not be mapped.
+ */
+bool CacheArchive::map(uint64_t start, uint64_t end)
+{
+    assert(start % MAP_ALIGNMENT == 0);
+    if (end <= start)
+        return false;
+    Mapping mapping;
+    mapping.m_start = start;
+    mapping.m_size  = end - start;
+    mapping.m_handle = NULL;
+#ifndef WIN32
+    mapping.m_size += MAP_RESERVE_SIZE;
+#endif
+    fflush(m_file);
+#ifdef WIN32
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(m_file));
+    HANDLE handle = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (handle == NULL)
+        return false;
+    void *address = MapViewOfFile(handle, FILE_MAP_READ, (DWORD)(start >> 32),
+        (DWORD)(start & 0xFFFFFFFF), (SIZE_T)mapping.m_size);
+    if (address == NULL)
+    {
+        CloseHandle(handle);
+        return false;
+    }
+    mapping.m_handle = handle;
+#else
+    void *address = mmap(NULL, (size_t)mapping.m_size, PROT_READ,
+                         MAP_SHARED, fileno(m_file), (off_t)start);
+    if (address == MAP_FAILED)
+        return false;
+#endif
+    mapping.m_address = (uint8_t*)address;
+    m_mappings.push_back(mapping);
+    return true;
+}   // map
+
+// ----------------------------------------------------------------------------
+/** Removes all mapped views. */
+void CacheArchive::unmapAll()
+{
+    for (Mapping &mapping : m_mappings)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(mapping.m_address);
+        CloseHandle((HANDLE)mapping.m_handle);
+#else
+        munmap(mapping.m_address, (size_t)mapping.m_size);
+#endif
+    }
+    m_mappings.clear();
+}   // unmapAll
+
+// ----------------------------------------------------------------------------
+/** Returns a pointer to mapped data of the file. If the data was appended
+ *  after the end of all views, the rest of the file is mapped. Must be
+ *  called with the mutex locked.
+ *  \return NULL if the data could not be mapped.
+ */
+const uint8_t* CacheArchive::getMappedData(uint64_t offset, uint64_t size)
+{
+    if (offset + size > m_file_size)
+        return NULL;
+    for (auto m = m_mappings.rbegin(); m != m_mappings.rend(); m++)
+    {
+        if (offset >= m->m_start && offset + size <= m->m_start + m->m_size)
+            return m->m_address + (offset - m->m_start);
+    }
+    const uint64_t start = offset / MAP_ALIGNMENT * MAP_ALIGNMENT;
+    if (!map(start, m_file_size))
+        return NULL;
+    return m_mappings.back().m_address + (offset - start);
+}   // getMappedData
+
+// ----------------------------------------------------------------------------
+/** Returns the data of an entry.
+ *  \param key The key of the entry.
+ *  \param size Returns the size of the data.
+ *  \return A pointer to the data, or NULL if there is no entry for the key
+ *          or its checksum is wrong.
+ */
+const uint8_t* CacheArchive::get(const std::string &key, uint32_t *size)
+{
+    std::unique_lock<std::mutex> ul(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+        return NULL;
+    const Entry entry = it->second;
+    const uint8_t *data = getMappedData(entry.m_offset, entry.m_size);
+    if (data == NULL)
+        return NULL;
+
+    if (!entry.m_verified)
+    {
+        // Other threads can read other entries in the meantime
+        ul.unlock();
+        const bool ok = checksum(data, entry.m_size) == entry.m_checksum;
+        ul.lock();
+        it = m_index.find(key);
+        if (it != m_index.end() && it->second.m_offset == entry.m_offset)
+        {
+            if (ok)
+            {
+                it->second.m_verified = true;
+            }
+            else
+            {
+                Log::warn("CacheArchive", "Wrong checksum of %s in %s.",
+                          key.c_str(), m_filename.c_str());
+                m_stale_size += entry.m_record_size;
+                m_index.erase(it);
+            }
+        }
+        if (!ok)
+            return NULL;
+    }
+    *size = entry.m_size;
+    return data;
+}   // get
+
+// ----------------------------------------------------------------------------
+/** Appends an entry, which replaces any older entry with the same key.
+ *  \param key The key of the entry.
+ *  \param parts Pointers to and sizes of the data, which are stored one
+ *         after the other.
+ *  \return False if the entry could not be written, or if another process
+ *          writes to the archive.
+ */
+bool CacheArchive::add(const std::string &key,
+                       const std::vector<std::pair<const void*, uint32_t> >
+                       &parts)
+{
+    uint64_t data_size = 0;
+    uint32_t hash = checksum(NULL, 0);
+    for (auto &p : parts)
+    {
+        data_size += p.second;
+        hash = checksum((const uint8_t*)p.first, p.second, hash);
+    }
+    const uint64_t record_size = sizeof(RecordHeader) + key.size() +
+                                 data_size;
+    if (record_size > 0xFFFFFFFFu)
+        return false;
+
+    RecordHeader rh;
+    memcpy(rh.m_magic, RECORD_MAGIC, 4);
+    rh.m_key_size  = (uint32_t)key.size();
+    rh.m_data_size = (uint32_t)data_size;
+    rh.m_checksum  = hash;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file == NULL || isReadOnly())
+        return false;
+    bool ok = seekFile(m_file, m_file_size) &&
+        fwrite(&rh, sizeof(rh), 1, m_file) == 1 &&
+        fwrite(key.data(), 1, key.size(), m_file) == key.size();
+    for (auto &p : parts)
+    {
+        ok = ok && fwrite(p.first, 1, p.second, m_file) == p.second;
+    }
+    ok = ok && fflush(m_file) == 0;
+    if (!ok)
+    {
+        Log::warn("CacheArchive", "Can not write %s to %s.", key.c_str(),
+                  m_filename.c_str());
+        // The file is not truncated since other processes might have mapped
+        // it, the next record overwrites the broken one
+        clearerr(m_file);
+        return false;
+    }
+
+    Entry &entry = m_index[key];
+    if (entry.m_record_size > 0)
+        m_stale_size += entry.m_record_size;
+    entry.m_offset      = m_file_size + sizeof(rh) + key.size();
+    entry.m_size        = (uint32_t)data_size;
+    entry.m_checksum    = hash;
+    entry.m_record_size = (uint32_t)record_size;
+    entry.m_verified    = true;
+    m_file_size += record_size;
+    return true;
+}   // add
+
+// ----------------------------------------------------------------------------
+/** Appends an entry with the data in one block. */
+bool CacheArchive::add(const std::string &key, const void *data,
+                       uint32_t size)
+{
+    std::vector<std::pair<const void*, uint32_t> > parts;
+    parts.emplace_back(data, size);
+    return add(key, parts);
+}   // add
+
+// ----------------------------------------------------------------------------
+void CacheArchive::unitTesting()
+{
+    auto check = [](bool ok, const char* what)
+    {
+        if (!ok)
+            Log::fatal("CacheArchive", "Test failed: %s.", what);
+    };
+    const std::string name =
+        file_manager->getUserConfigFile("cache_archive_test.bin");
+    remove(name.c_str());
+    uint32_t size = 0;
+    {
+        CacheArchive ca(name);
+        check(ca.isOpen() && !ca.isReadOnly() && ca.getNumEntries() == 0,
+              "open new archive");
+        check(ca.get("a", &size) == NULL, "get missing entry");
+        check(ca.add("a", "hello", 5), "add a");
+        std::vector<std::pair<const void*, uint32_t> > parts;
+        parts.emplace_back("wor", 3);
+        parts.emplace_back("ld", 2);
+        check(ca.add("b", parts), "add b");
+        const uint8_t *a = ca.get("a", &size);
+        check(a && size == 5 && memcmp(a, "hello", 5) == 0, "get a");
+        const uint8_t *b = ca.get("b", &size);
+        check(b && size == 5 && memcmp(b, "world", 5) == 0, "get b");
+        // A newer entry replaces the old one, old pointers stay valid
+        check(ca.add("a", "HELLO!", 6), "replace a");
+        const uint8_t *a2 = ca.get("a", &size);
+        check(a2 && size == 6 && memcmp(a2, "HELLO!", 6) == 0,
+              "get replaced a");
+        check(memcmp(a, "hello", 5) == 0, "old pointer");
+        check(ca.getNumEntries() == 2, "number of entries");
+    }
+    {
+        // Reopen, and add garbage at the end
+        CacheArchive ca(name);
+        check(ca.getNumEntries() == 2, "number of entries after reopen");
+        const uint8_t *a = ca.get("a", &size);
+        check(a && size == 6 && memcmp(a, "HELLO!", 6) == 0,
+              "get a after reopen");
+        FILE *f = fopen(name.c_str(), "ab");
+        fwrite("STKRgarbage", 1, 11, f);
+        fclose(f);
+    }
+    {
+        // The garbage is removed, and new entries can be added
+        CacheArchive ca(name);
+        check(ca.getNumEntries() == 2, "number of entries after garbage");
+        check(ca.add("c", "!", 1), "add c");
+    }
+    {
+        CacheArchive ca(name);
+        check(ca.getNumEntries() == 3, "number of entries with c");
+        const uint8_t *c = ca.get("c", &size);
+        check(c && size == 1 && c[0] == '!', "get c");
+    }
+    {
+        // Corrupt the data of b, which is then not returned anymore
+        FILE *f = fopen(name.c_str(), "r+b");
+        std::vector<char> content(4096);
+        content.resize(fread(content.data(), 1, content.size(), f));
+        auto pos = std::search(content.begin(), content.end(), "world",
+                               "world" + 5);
+        check(pos != content.end(), "find b");
+        seekFile(f, pos - content.begin());
+        fwrite("W", 1, 1, f);
+        fclose(f);
+        CacheArchive ca(name);
+        check(ca.get("b", &size) == NULL, "get corrupt b");
+        check(ca.get("c", &size) != NULL, "get c after corrupt b");
+        check(ca.getNumEntries() == 2, "number of entries after corrupt b");
+    }
+    {
+        // A second archive of the same file, like one in another process,
+        // only reads the entries which existed when it was opened. Garbage
+        // at the end is kept while the file is used by the other archive.
+        CacheArchive ca(name);
+        FILE *f = fopen(name.c_str(), "ab");
+        fwrite("STKRgarbage", 1, 11, f);
+        fclose(f);
+        CacheArchive reader(name);
+        check(reader.isOpen() && reader.isReadOnly(), "open read only");
+        check(!reader.add("d", "?", 1), "add to read only");
+        check(ca.add("d", "new", 3), "add d");
+        const uint8_t *d = ca.get("d", &size);
+        check(d && size == 3 && memcmp(d, "new", 3) == 0, "get d");
+        const uint8_t *c = reader.get("c", &size);
+        check(c && size == 1 && c[0] == '!', "get c read only");
+        check(reader.get("d", &size) == NULL, "get d read only");
+    }
+    {
+        // Once the first archive is closed, another one can write again
+        CacheArchive ca(name);
+        check(!ca.isReadOnly(), "open writable again");
+        const uint8_t *d = ca.get("d", &size);
+        check(d && size == 3 && memcmp(d, "new", 3) == 0, "get d again");
+        check(ca.add("e", "!", 1), "add e");
+    }
+    remove(name.c_str());
+    remove((name + ".lock").c_str());
+}   // unitTesting
@@ -0,0 +1,140 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_CACHE_ARCHIVE_HPP
+#define HEADER_CACHE_ARCHIVE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** \brief A single file which stores many cache entries (e.g. compressed
+ *  textures), each identified by a key string. New entries are only
+ *  appended, an entry with the same key as an older one replaces it. The
+ *  file is memory mapped, so reading an entry only returns a pointer into
+ *  the mapped pages instead of opening and reading a file. The index of
+ *  all entries is a hash map built from the record headers when the
+ *  archive is opened. The checksum of an entry is verified when it is
+ *  read the first time.
+ *  Only one process at a time can add entries, which is ensured with a
+ *  locked lock file next to the archive. Archives opened by other processes
+ *  only read the entries which existed when they were opened. Each process
+ *  keeps a shared lock on the archive while it is mapped, so the archive is
+ *  only truncated or replaced if no other process uses it.
+ *  All functions can be called from several threads at the same time.
+ *  Returned pointers stay valid until the archive is deleted.
+ * \ingroup io
+ */
+class CacheArchive : public NoCopy
+{
+private:
+    /** Position of an entry in the file. */
+    struct Entry
+    {
+        /** Offset of the data in the file. */
+        uint64_t m_offset;
+        /** Size of the data. */
+        uint32_t m_size;
+        /** Checksum of the data. */
+        uint32_t m_checksum;
+        /** Size of the whole record including header and key. */
+        uint32_t m_record_size;
+        /** True once the checksum was verified. */
+        bool     m_verified;
+    };   // Entry
+
+    /** A memory mapped view of m_size bytes of the file at m_start. Older
+     *  views are kept when the file grows, since pointers into them might
+     *  still be used. Views reach past the end of the file where possible,
+     *  so that appended records are usually in an existing view. */
+    struct Mapping
+    {
+        uint8_t *m_address;
+        uint64_t m_start;
+        uint64_t m_size;
+        void    *m_handle;
+    };   // Mapping
+
+    std::string m_filename;
+
+    /** The open archive, used to append new records. */
+    FILE *m_file;
+
+    /** The locked lock file if this process writes to the archive, NULL if
+     *  another process does. */
+    FILE *m_lock_file;
+
+    /** End of the last valid record. */
+    uint64_t m_file_size;
+
+    /** Bytes used by records which were replaced by newer ones. */
+    uint64_t m_stale_size;
+
+    std::unordered_map<std::string, Entry> m_index;
+
+    std::vector<Mapping> m_mappings;
+
+    mutable std::mutex m_mutex;
+
+    bool     open();
+    void     close();
+    void     setReadOnly();
+    bool     lockExclusive();
+    void     unlockExclusive();
+    bool     scan();
+    void     compact();
+    bool     map(uint64_t start, uint64_t end);
+    void     unmapAll();
+    const uint8_t* getMappedData(uint64_t offset, uint64_t size);
+
+public:
+    static uint32_t checksum(const uint8_t *data, size_t size,
+                             uint32_t h = 2166136261u);
+    // ------------------------------------------------------------------------
+         CacheArchive(const std::string &filename);
+        ~CacheArchive();
+    const uint8_t* get(const std::string &key, uint32_t *size);
+    bool add(const std::string &key,
+             const std::vector<std::pair<const void*, uint32_t> > &parts);
+    bool add(const std::string &key, const void *data, uint32_t size);
+    // ------------------------------------------------------------------------
+    /** Returns true if the archive file could be opened. */
+    bool isOpen() const { return m_file != NULL; }
+    // ------------------------------------------------------------------------
+    /** Returns true if another process writes to the archive, so that no
+     *  entries can be added. */
+    bool isReadOnly() const { return m_lock_file == NULL; }
+    // ------------------------------------------------------------------------
+    /** Returns the number of entries in the archive. */
+    size_t getNumEntries() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_index.size();
+    }   // getNumEntries
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+};   // CacheArchive
+
+#endif
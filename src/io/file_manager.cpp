@@ -247,6 +247,8 @@ FileManager::FileManager()
     checkAndCreateScreenshotDir();
     checkAndCreateReplayDir();
     checkAndCreateCachedTexturesDir();
+    checkAndCreateCachedSFXDir();
+    checkAndCreateCachedMeshesDir();
     checkAndCreateGPDir();
 
     redirectOutput();
@@ -724,6 +726,22 @@ std::string FileManager::getCachedTexturesDir() const
     return m_cached_textures_dir;
 }   // getCachedTexturesDir
 
+//-----------------------------------------------------------------------------
+/** Returns the directory in which decoded sound effects should be cached.
+*/
+std::string FileManager::getCachedSFXDir() const
+{
+    return m_cached_sfx_dir;
+}   // getCachedSFXDir
+
+//-----------------------------------------------------------------------------
+/** Returns the directory in which decoded meshes should be cached.
+*/
+std::string FileManager::getCachedMeshesDir() const
+{
+    return m_cached_meshes_dir;
+}   // getCachedMeshesDir
+
 //-----------------------------------------------------------------------------
 /** Returns the directory in which user-defined grand prix should be stored.
  */
@@ -1062,6 +1080,56 @@ void FileManager::checkAndCreateCachedTexturesDir()
 
 }   // checkAndCreateCachedTexturesDir
 
+// ----------------------------------------------------------------------------
+/** Creates the directory for decoded sound effects. This will set
+*  m_cached_sfx_dir with the appropriate path.
+*/
+void FileManager::checkAndCreateCachedSFXDir()
+{
+#if defined(WIN32) || defined(__CYGWIN__)
+    m_cached_sfx_dir = m_user_config_dir + "cached-sfx/";
+#elif defined(__APPLE__)
+    m_cached_sfx_dir = getenv("HOME");
+    m_cached_sfx_dir += "/Library/Application Support/SuperTuxKart/CachedSFX/";
+#else
+    m_cached_sfx_dir = checkAndCreateLinuxDir("XDG_CACHE_HOME", "supertuxkart", ".cache/", ".");
+    m_cached_sfx_dir += "cached-sfx/";
+#endif
+
+    if (!checkAndCreateDirectory(m_cached_sfx_dir))
+    {
+        Log::error("FileManager", "Can not create cached sfx directory '%s', "
+            "falling back to '.'.", m_cached_sfx_dir.c_str());
+        m_cached_sfx_dir = "./";
+    }
+
+}   // checkAndCreateCachedSFXDir
+
+// ----------------------------------------------------------------------------
+/** Creates the directory for decoded meshes. This will set
+*  m_cached_meshes_dir with the appropriate path.
+*/
+void FileManager::checkAndCreateCachedMeshesDir()
+{
+#if defined(WIN32) || defined(__CYGWIN__)
+    m_cached_meshes_dir = m_user_config_dir + "cached-meshes/";
+#elif defined(__APPLE__)
+    m_cached_meshes_dir = getenv("HOME");
+    m_cached_meshes_dir += "/Library/Application Support/SuperTuxKart/CachedMeshes/";
+#else
+    m_cached_meshes_dir = checkAndCreateLinuxDir("XDG_CACHE_HOME", "supertuxkart", ".cache/", ".");
+    m_cached_meshes_dir += "cached-meshes/";
+#endif
+
+    if (!checkAndCreateDirectory(m_cached_meshes_dir))
+    {
+        Log::error("FileManager", "Can not create cached meshes directory '%s', "
+            "falling back to '.'.", m_cached_meshes_dir.c_str());
+        m_cached_meshes_dir = "./";
+    }
+
+}   // checkAndCreateCachedMeshesDir
+
 // ----------------------------------------------------------------------------
 /** Creates the directories for user-defined grand prix. This will set m_gp_dir
  *  with the appropriate path.
@@ -1484,3 +1552,14 @@ bool FileManager::fileIsNewer(const std::string& f1, const std::string& f2) cons
     stat(f2.c_str(), &stat2);
     return stat1.st_mtime > stat2.st_mtime;
 }   // fileIsNewer
+
+// ----------------------------------------------------------------------------
+/** Returns the modification time of a file, or 0 if the file does not exist.
+ */
+uint64_t FileManager::getModificationTime(const std::string& f) const
+{
+    struct stat s;
+    if (stat(f.c_str(), &s) != 0)
+        return 0;
+    return (uint64_t)s.st_mtime;
+}   // getModificationTime
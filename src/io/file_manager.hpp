@@ -26,6 +26,7 @@
  */
 
 #include <mutex>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <set>
@@ -99,6 +100,12 @@ private:
     /** Directory where resized textures are cached. */
     std::string       m_cached_textures_dir;
 
+    /** Directory where decoded sound effects are cached. */
+    std::string       m_cached_sfx_dir;
+
+    /** Directory where decoded meshes are cached. */
+    std::string       m_cached_meshes_dir;
+
     /** Directory where user-defined grand prix are stored. */
     std::string       m_gp_dir;
 
@@ -126,6 +133,8 @@ private:
     void              checkAndCreateScreenshotDir();
     void              checkAndCreateReplayDir();
     void              checkAndCreateCachedTexturesDir();
+    void              checkAndCreateCachedSFXDir();
+    void              checkAndCreateCachedMeshesDir();
     void              checkAndCreateGPDir();
     void              discoverPaths();
 #if !defined(WIN32) && !defined(__CYGWIN__) && !defined(__APPLE__)
@@ -149,6 +158,8 @@ public:
     std::string       getScreenshotDir() const;
     std::string       getReplayDir() const;
     std::string       getCachedTexturesDir() const;
+    std::string       getCachedSFXDir() const;
+    std::string       getCachedMeshesDir() const;
     std::string       getGPDir() const;
     bool              checkAndCreateDirectory(const std::string &path);
     bool              checkAndCreateDirectoryP(const std::string &path);
@@ -204,6 +215,7 @@ public:
     void       redirectOutput();
 
     bool       fileIsNewer(const std::string& f1, const std::string& f2) const;
+    uint64_t   getModificationTime(const std::string& f) const;
     // ------------------------------------------------------------------------
     const std::string& getUserConfigDir() const   { return m_user_config_dir; }
     // ------------------------------------------------------------------------
@@ -39,6 +39,7 @@
 #include "karts/cannon_animation.hpp"
 #include "karts/controller/controller.hpp"
 #include "karts/explosion_animation.hpp"
+#include "karts/kart_proximity_index.hpp"
 #include "modes/linear_world.hpp"
 #include "network/compress_network_body.hpp"
 #include "network/network_config.hpp"
@@ -257,27 +258,28 @@ void Flyable::getClosestKart(const AbstractKart **minKart,
     *minKart = NULL;
 
     World *world = World::getWorld();
-    for(unsigned int i=0 ; i<world->getNumKarts(); i++ )
+    // Returns the distance used for aiming at a kart, or a negative value if
+    // the kart can not be targeted
+    auto aim_distance2 = [&](const AbstractKart *kart, Vec3 *delta)
     {
-        AbstractKart *kart = world->getKart(i);
         // If a kart has star effect shown, the kart is immune, so
         // it is not considered a target anymore.
         if(kart->isEliminated() || kart == m_owner ||
             kart->isInvulnerable()                 ||
-            kart->getKartAnimation()                   ) continue;
+            kart->getKartAnimation()                   ) return -1.0f;
 
         // Don't hit teammates in team world
         if (world->hasTeam() &&
             world->getKartTeam(kart->getWorldKartId()) ==
             world->getKartTeam(m_owner->getWorldKartId()))
-            continue;
+            return -1.0f;
 
         btTransform t=kart->getTrans();
 
-        Vec3 delta      = t.getOrigin()-trans_projectile.getOrigin();
+        *delta          = t.getOrigin()-trans_projectile.getOrigin();
         // the Y distance is added again because karts above or below should//
         // not be prioritized when aiming
-        float distance2 = delta.length2() + std::abs(t.getOrigin().getY()
+        float distance2 = delta->length2() + std::abs(t.getOrigin().getY()
                         - trans_projectile.getOrigin().getY())*2;
 
         if(inFrontOf != NULL)
@@ -285,7 +287,7 @@ void Flyable::getClosestKart(const AbstractKart **minKart,
             // Ignore karts behind the current one
             Vec3 to_target       = kart->getXYZ() - inFrontOf->getXYZ();
             const float distance = to_target.length();
-            if(distance > 50) continue; // kart too far, don't aim at it
+            if(distance > 50) return -1.0f; // kart too far, don't aim at it
 
             btTransform trans = inFrontOf->getTrans();
             // get heading=trans.getBasis*(0,0,1) ... so save the multiplication:
@@ -299,8 +301,39 @@ void Flyable::getClosestKart(const AbstractKart **minKart,
             float c = to_target.dot(v)/s;
             // Original test was: fabsf(acos(c))>1,  which is the same as
             // c<cos(1) (acos returns values in [0, pi] anyway)
-            if(c<0.54) continue;
+            if(c<0.54) return -1.0f;
         }
+        return distance2;
+    };
+
+    // Only test the karts in front of (or behind) the kart, using a slightly
+    // larger cone than the exact test above, or the kart nearest to the
+    // projectile. The aiming distance is not less than the squared
+    // euclidean distance, as required by getNearestKarts.
+    const KartProximityIndex &index = world->getKartProximityIndex();
+    std::vector<unsigned int> candidates;
+    if (inFrontOf != NULL)
+    {
+        Vec3 direction(inFrontOf->getTrans().getBasis().getColumn(2));
+        index.getKartsInCone(inFrontOf->getXYZ(),
+                             backwards ? -direction : direction,
+                             0.53f, 51.0f, &candidates);
+    }
+    else
+    {
+        Vec3 delta;
+        index.getNearestKarts(trans_projectile.getOrigin(), 1, &candidates,
+            [&](unsigned int id)
+            { return aim_distance2(world->getKart(id), &delta); });
+    }
+
+    for (unsigned int i : candidates)
+    {
+        AbstractKart *kart = world->getKart(i);
+        Vec3 delta;
+        float distance2 = aim_distance2(kart, &delta);
+        if (distance2 < 0.0f)
+            continue;
 
         if(distance2 < *minDistSquared)
         {
@@ -308,7 +341,7 @@ void Flyable::getClosestKart(const AbstractKart **minKart,
             *minKart  = kart;
             *minDelta = delta;
         }
-    }  // for i<getNumKarts
+    }  // for i in candidates
 
 }   // getClosestKart
 
@@ -676,6 +709,15 @@ BareNetworkString* Flyable::saveState(std::vector<std::string>* ru)
     return buffer;
 }   // saveState
 
+// ----------------------------------------------------------------------------
+btRigidBody* Flyable::getNetworkBody(btMotionState** ms)
+{
+    if (m_has_hit_something || hasAnimation())
+        return NULL;
+    *ms = m_motion_state.get();
+    return m_body.get();
+}   // getNetworkBody
+
 // ----------------------------------------------------------------------------
 void Flyable::restoreState(BareNetworkString *buffer, int count)
 {
@@ -260,6 +260,8 @@ public:
     virtual BareNetworkString* saveState(std::vector<std::string>* ru)
         OVERRIDE;
     // ------------------------------------------------------------------------
+    virtual btRigidBody* getNetworkBody(btMotionState** ms) OVERRIDE;
+    // ------------------------------------------------------------------------
     virtual void restoreState(BareNetworkString *buffer, int count) OVERRIDE;
     // ------------------------------------------------------------------------
     /* Return true if still in game state, or otherwise can be deleted. */
@@ -325,31 +325,31 @@ void Swatter::chooseTarget()
     // TODO: for the moment, only handle karts...
     const World*  world         = World::getWorld();
     AbstractKart* closest_kart  = NULL;
-    float         min_dist2     = FLT_MAX;
 
-    for(unsigned int i=0; i<world->getNumKarts(); i++)
+    auto distance2 = [this, world](unsigned int i)
     {
         AbstractKart *kart = world->getKart(i);
         // TODO: isSwatterReady(), isSquashable()?
         if(kart->isEliminated() || kart==m_kart || kart->getKartAnimation())
-            continue;
+            return -1.0f;
         // don't squash an already hurt kart
         if (kart->isInvulnerable() || kart->isSquashed())
-            continue;
+            return -1.0f;
 
         // Don't hit teammates in team world
         if (world->hasTeam() &&
             world->getKartTeam(kart->getWorldKartId()) ==
             world->getKartTeam(m_kart->getWorldKartId()))
-            continue;
+            return -1.0f;
+
+        return (kart->getXYZ()-m_kart->getXYZ()).length2();
+    };
+    std::vector<unsigned int> nearest;
+    World::getWorld()->getKartProximityIndex().getNearestKarts(
+        m_kart->getXYZ(), 1, &nearest, distance2);
+    if (!nearest.empty())
+        closest_kart = world->getKart(nearest[0]);
 
-        float dist2 = (kart->getXYZ()-m_kart->getXYZ()).length2();
-        if(dist2<min_dist2)
-        {
-            min_dist2 = dist2;
-            closest_kart = kart;
-        }
-    }
     // Not larger than 2^5 - 1 for kart id for optimizing state saving
     if (closest_kart && closest_kart->getWorldKartId() < 31)
         m_closest_kart = closest_kart;
@@ -18,186 +18,98 @@
 
 #include "karts/cached_characteristic.hpp"
 
-#include "utils/interpolation_array.hpp"
+#include "karts/kart_properties_manager.hpp"
+#include "utils/log.hpp"
+
+#include <chrono>
+
+#define CACHED_CHARACTERISTIC_ONE(TYPE, NAME, FIELD) + 1
+static_assert(0 CACHED_CHARACTERISTICS(CACHED_CHARACTERISTIC_ONE) ==
+              AbstractCharacteristic::CHARACTERISTIC_COUNT,
+              "CACHED_CHARACTERISTICS is incomplete, regenerate it with "
+              "tools/update_characteristics.py");
+#undef CACHED_CHARACTERISTIC_ONE
 
 CachedCharacteristic::CachedCharacteristic(const AbstractCharacteristic *origin) :
-    m_values(CHARACTERISTIC_COUNT),
     m_origin(origin)
 {
     updateSource();
 }
 
-// ----------------------------------------------------------------------------
-/** Deletes all allocated values. */
-CachedCharacteristic::~CachedCharacteristic()
-{
-    // Delete all not-null values
-    for (int i = 0; i < CHARACTERISTIC_COUNT; i++)
-    {
-        SaveValue &v = m_values[i];
-        if (v.content)
-        {
-            switch (getType(static_cast<CharacteristicType>(i)))
-            {
-            case TYPE_FLOAT:
-                delete static_cast<float*>(v.content);
-                break;
-            case TYPE_FLOAT_VECTOR:
-                delete static_cast<std::vector<float>*>(v.content);
-                break;
-            case TYPE_INTERPOLATION_ARRAY:
-                delete static_cast<InterpolationArray*>(v.content);
-                break;
-            case TYPE_BOOL:
-                delete static_cast<bool*>(v.content);
-                break;
-            }
-            v.content = nullptr;
-        }
-    }
-}   // ~CachedCharacteristic
-
 // ----------------------------------------------------------------------------
 /** Recompute the values of all characteristics based on the list of
- *  source-characteristics.
+ *  source-characteristics. Each getter of the origin aborts with a fatal
+ *  error if its characteristic is not set, so after this call all values
+ *  are valid.
  */
 void CachedCharacteristic::updateSource()
 {
-    for (int i = 0; i < CHARACTERISTIC_COUNT; i++)
-    {
-        SaveValue &v = m_values[i];
-        
-        bool is_set = false;
-        switch (getType(static_cast<CharacteristicType>(i)))
-        {
-        case TYPE_FLOAT:
-        {
-            float value;
-            float *ptr = static_cast<float*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    float *newPtr = new float();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
-            break;
-        }
-        case TYPE_FLOAT_VECTOR:
-        {
-            std::vector<float> value;
-            std::vector<float> *ptr = static_cast<std::vector<float>*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    std::vector<float> *newPtr = new std::vector<float>();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
-            break;
-        }
-        case TYPE_INTERPOLATION_ARRAY:
-        {
-            InterpolationArray value;
-            InterpolationArray *ptr = static_cast<InterpolationArray*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    InterpolationArray *newPtr = new InterpolationArray();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
-            break;
-        }
-        case TYPE_BOOL:
-        {
-            bool value;
-            bool *ptr = static_cast<bool*>(v.content);
-            m_origin->process(static_cast<CharacteristicType>(i), &value, &is_set);
-            if (is_set)
-            {
-                if (!ptr)
-                {
-                    bool *newPtr = new bool();
-                    v.content = newPtr;
-                    ptr = newPtr;
-                }
-                *ptr = value;
-            }
-            else
-            {
-                if (ptr)
-                {
-                    delete ptr;
-                    v.content = nullptr;
-                }
-            }
-            break;
-        }
-        }   // switch (type)
-    }   // foreach characteristic
+#define CACHED_CHARACTERISTIC_RESOLVE(TYPE, NAME, FIELD) \
+    m_values.m_##FIELD = m_origin->get##NAME();
+    CACHED_CHARACTERISTICS(CACHED_CHARACTERISTIC_RESOLVE)
+#undef CACHED_CHARACTERISTIC_RESOLVE
 }   // updateSource
 
 // ----------------------------------------------------------------------------
-/** Returns the stored value. */
+/** Forwards to the origin. The typed values are only meant to be read with
+ *  getValues(), this is only used by the (slow) generic getters, e.g. in the
+ *  GUI, so it's not worth to convert the values back.
+ */
 void CachedCharacteristic::process(CharacteristicType type, Value value,
                                    bool *is_set) const
 {
-    void *v = m_values[type].content;
-    if (v)
+    m_origin->process(type, value, is_set);
+}   // process
+
+// ============================================================================
+/** Checks that the flat values are identical to the values computed by the
+ *  generic process() path, and compares the time needed to read them both
+ *  ways (the numbers are only printed, they are not checked).
+ */
+void CachedCharacteristic::unitTesting()
+{
+    const AbstractCharacteristic *base =
+        kart_properties_manager->getBaseCharacteristic();
+    CachedCharacteristic cc(base);
+    const Values &v = cc.getValues();
+
+#define CACHED_CHARACTERISTIC_COMPARE(TYPE, NAME, FIELD)                      \
+    if (!(v.m_##FIELD == base->get##NAME()))                                  \
+        Log::fatal("CachedCharacteristic", "Value of %s differs.", #NAME);
+    CACHED_CHARACTERISTICS(CACHED_CHARACTERISTIC_COMPARE)
+#undef CACHED_CHARACTERISTIC_COMPARE
+
+    // Microbenchmark of the getters mostly used in the physics step
+    const int iterations = 100000;
+    float sum_generic = 0.0f, sum_flat = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
     {
-        switch (getType(type))
-        {
-        case TYPE_FLOAT:
-            *value.f = *static_cast<float*>(v);
-            break;
-        case TYPE_FLOAT_VECTOR:
-            *value.fv = *static_cast<std::vector<float>*>(v);
-            break;
-        case TYPE_INTERPOLATION_ARRAY:
-            *value.ia = *static_cast<InterpolationArray*>(v);
-            break;
-        case TYPE_BOOL:
-            *value.b = *static_cast<bool*>(v);
-            break;
-        }
-        *is_set = true;
+        sum_generic += base->getSuspensionStiffness()
+                     + base->getEngineMaxSpeed()
+                     + base->getSkidMax()
+                     + base->getWheelsDampingRelaxation()
+                     + base->getTurnRadius().get((float)(i % 30));
     }
-}   // process
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        // Re-read through a volatile pointer so the loads are not hoisted
+        const Values * volatile values = &v;
+        sum_flat += values->m_suspension_stiffness
+                  + values->m_engine_max_speed
+                  + values->m_skid_max
+                  + values->m_wheels_damping_relaxation
+                  + values->m_turn_radius.get((float)(i % 30));
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sum_generic != sum_flat)
+        Log::fatal("CachedCharacteristic", "Benchmark sums differ.");
 
+    using us = std::chrono::microseconds;
+    Log::info("CachedCharacteristic",
+              "%d iterations: generic getters %d us, flat values %d us.",
+              iterations,
+              (int)std::chrono::duration_cast<us>(mid - start).count(),
+              (int)std::chrono::duration_cast<us>(end - mid).count());
+}   // unitTesting
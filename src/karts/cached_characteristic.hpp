@@ -20,23 +20,152 @@
 #define HEADER_CACHED_CHARACTERISTICS_HPP
 
 #include "karts/abstract_characteristic.hpp"
+#include "utils/interpolation_array.hpp"
 
 #include <assert.h>
 
+/** List of all characteristics as (type, getter name, field name), in the
+ *  same order as AbstractCharacteristic::CharacteristicType. The type is
+ *  the return type of the AbstractCharacteristic getter, so times that are
+ *  converted to ticks there are stored as ticks here as well.
+ *  This is used to generate the layout of CachedCharacteristic::Values and
+ *  the code that fills it, so both can never get out of sync.
+ *  The list is generated by tools/create_kart_properties.py cached. */
+/* <characteristics-start cached> */
+#define CACHED_CHARACTERISTICS(X) \
+    X(float,               SuspensionStiffness,             suspension_stiffness)              \
+    X(float,               SuspensionRest,                  suspension_rest)                   \
+    X(float,               SuspensionTravel,                suspension_travel)                 \
+    X(bool,                SuspensionExpSpringResponse,     suspension_exp_spring_response)    \
+    X(float,               SuspensionMaxForce,              suspension_max_force)              \
+    X(float,               StabilityRollInfluence,          stability_roll_influence)          \
+    X(float,               StabilityChassisLinearDamping,   stability_chassis_linear_damping)  \
+    X(float,               StabilityChassisAngularDamping,  stability_chassis_angular_damping) \
+    X(float,               StabilityDownwardImpulseFactor,  stability_downward_impulse_factor) \
+    X(float,               StabilityTrackConnectionAccel,   stability_track_connection_accel)  \
+    X(std::vector<float>,  StabilityAngularFactor,          stability_angular_factor)          \
+    X(float,               StabilitySmoothFlyingImpulse,    stability_smooth_flying_impulse)   \
+    X(InterpolationArray,  TurnRadius,                      turn_radius)                       \
+    X(float,               TurnTimeResetSteer,              turn_time_reset_steer)             \
+    X(InterpolationArray,  TurnTimeFullSteer,               turn_time_full_steer)              \
+    X(float,               EnginePower,                     engine_power)                      \
+    X(float,               EngineMaxSpeed,                  engine_max_speed)                  \
+    X(float,               EngineGenericMaxSpeed,           engine_generic_max_speed)          \
+    X(float,               EngineBrakeFactor,               engine_brake_factor)               \
+    X(float,               EngineBrakeTimeIncrease,         engine_brake_time_increase)        \
+    X(float,               EngineMaxSpeedReverseRatio,      engine_max_speed_reverse_ratio)    \
+    X(std::vector<float>,  GearSwitchRatio,                 gear_switch_ratio)                 \
+    X(std::vector<float>,  GearPowerIncrease,               gear_power_increase)               \
+    X(float,               Mass,                            mass)                              \
+    X(float,               WheelsDampingRelaxation,         wheels_damping_relaxation)         \
+    X(float,               WheelsDampingCompression,        wheels_damping_compression)        \
+    X(float,               CameraDistance,                  camera_distance)                   \
+    X(float,               CameraForwardUpAngle,            camera_forward_up_angle)           \
+    X(float,               CameraBackwardUpAngle,           camera_backward_up_angle)          \
+    X(float,               JumpAnimationTime,               jump_animation_time)               \
+    X(float,               LeanMax,                         lean_max)                          \
+    X(float,               LeanSpeed,                       lean_speed)                        \
+    X(float,               AnvilDuration,                   anvil_duration)                    \
+    X(float,               AnvilWeight,                     anvil_weight)                      \
+    X(float,               AnvilSpeedFactor,                anvil_speed_factor)                \
+    X(float,               ParachuteFriction,               parachute_friction)                \
+    X(int,                 ParachuteDuration,               parachute_duration)                \
+    X(int,                 ParachuteDurationOther,          parachute_duration_other)          \
+    X(float,               ParachuteDurationRankMult,       parachute_duration_rank_mult)      \
+    X(float,               ParachuteDurationSpeedMult,      parachute_duration_speed_mult)     \
+    X(float,               ParachuteLboundFraction,         parachute_lbound_fraction)         \
+    X(float,               ParachuteUboundFraction,         parachute_ubound_fraction)         \
+    X(float,               ParachuteMaxSpeed,               parachute_max_speed)               \
+    X(float,               FrictionKartFriction,            friction_kart_friction)            \
+    X(float,               BubblegumDuration,               bubblegum_duration)                \
+    X(float,               BubblegumSpeedFraction,          bubblegum_speed_fraction)          \
+    X(float,               BubblegumTorque,                 bubblegum_torque)                  \
+    X(float,               BubblegumFadeInTime,             bubblegum_fade_in_time)            \
+    X(float,               BubblegumShieldDuration,         bubblegum_shield_duration)         \
+    X(float,               ZipperDuration,                  zipper_duration)                   \
+    X(float,               ZipperForce,                     zipper_force)                      \
+    X(float,               ZipperSpeedGain,                 zipper_speed_gain)                 \
+    X(float,               ZipperMaxSpeedIncrease,          zipper_max_speed_increase)         \
+    X(float,               ZipperFadeOutTime,               zipper_fade_out_time)              \
+    X(float,               SwatterDuration,                 swatter_duration)                  \
+    X(float,               SwatterDistance,                 swatter_distance)                  \
+    X(float,               SwatterSquashDuration,           swatter_squash_duration)           \
+    X(float,               SwatterSquashSlowdown,           swatter_squash_slowdown)           \
+    X(float,               PlungerBandMaxLength,            plunger_band_max_length)           \
+    X(float,               PlungerBandForce,                plunger_band_force)                \
+    X(float,               PlungerBandDuration,             plunger_band_duration)             \
+    X(float,               PlungerBandSpeedIncrease,        plunger_band_speed_increase)       \
+    X(float,               PlungerBandFadeOutTime,          plunger_band_fade_out_time)        \
+    X(float,               PlungerInFaceTime,               plunger_in_face_time)              \
+    X(std::vector<float>,  StartupTime,                     startup_time)                      \
+    X(std::vector<float>,  StartupBoost,                    startup_boost)                     \
+    X(float,               RescueDuration,                  rescue_duration)                   \
+    X(float,               RescueVertOffset,                rescue_vert_offset)                \
+    X(float,               RescueHeight,                    rescue_height)                     \
+    X(float,               ExplosionDuration,               explosion_duration)                \
+    X(float,               ExplosionRadius,                 explosion_radius)                  \
+    X(float,               ExplosionInvulnerabilityTime,    explosion_invulnerability_time)    \
+    X(float,               NitroDuration,                   nitro_duration)                    \
+    X(float,               NitroEngineForce,                nitro_engine_force)                \
+    X(float,               NitroEngineMult,                 nitro_engine_mult)                 \
+    X(float,               NitroConsumption,                nitro_consumption)                 \
+    X(float,               NitroSmallContainer,             nitro_small_container)             \
+    X(float,               NitroBigContainer,               nitro_big_container)               \
+    X(float,               NitroMaxSpeedIncrease,           nitro_max_speed_increase)          \
+    X(float,               NitroFadeOutTime,                nitro_fade_out_time)               \
+    X(float,               NitroMax,                        nitro_max)                         \
+    X(float,               SlipstreamDurationFactor,        slipstream_duration_factor)        \
+    X(float,               SlipstreamBaseSpeed,             slipstream_base_speed)             \
+    X(float,               SlipstreamLength,                slipstream_length)                 \
+    X(float,               SlipstreamWidth,                 slipstream_width)                  \
+    X(float,               SlipstreamInnerFactor,           slipstream_inner_factor)           \
+    X(float,               SlipstreamMinCollectTime,        slipstream_min_collect_time)       \
+    X(float,               SlipstreamMaxCollectTime,        slipstream_max_collect_time)       \
+    X(float,               SlipstreamAddPower,              slipstream_add_power)              \
+    X(float,               SlipstreamMinSpeed,              slipstream_min_speed)              \
+    X(float,               SlipstreamMaxSpeedIncrease,      slipstream_max_speed_increase)     \
+    X(float,               SlipstreamFadeOutTime,           slipstream_fade_out_time)          \
+    X(float,               SkidIncrease,                    skid_increase)                     \
+    X(float,               SkidDecrease,                    skid_decrease)                     \
+    X(float,               SkidMax,                         skid_max)                          \
+    X(float,               SkidTimeTillMax,                 skid_time_till_max)                \
+    X(float,               SkidVisual,                      skid_visual)                       \
+    X(float,               SkidVisualTime,                  skid_visual_time)                  \
+    X(float,               SkidRevertVisualTime,            skid_revert_visual_time)           \
+    X(float,               SkidMinSpeed,                    skid_min_speed)                    \
+    X(std::vector<float>,  SkidTimeTillBonus,               skid_time_till_bonus)              \
+    X(std::vector<float>,  SkidBonusSpeed,                  skid_bonus_speed)                  \
+    X(std::vector<float>,  SkidBonusTime,                   skid_bonus_time)                   \
+    X(std::vector<float>,  SkidBonusForce,                  skid_bonus_force)                  \
+    X(float,               SkidPhysicalJumpTime,            skid_physical_jump_time)           \
+    X(float,               SkidGraphicalJumpTime,           skid_graphical_jump_time)          \
+    X(float,               SkidPostSkidRotateFactor,        skid_post_skid_rotate_factor)      \
+    X(float,               SkidReduceTurnMin,               skid_reduce_turn_min)              \
+    X(float,               SkidReduceTurnMax,               skid_reduce_turn_max)              \
+    X(bool,                SkidEnabled,                     skid_enabled)
+
+/* <characteristics-end cached> */
+
+/** A characteristic that resolves all values of its origin once (e.g. when
+ *  KartProperties combines the characteristics for a kart) into a flat
+ *  struct with one typed field per characteristic. The getters of
+ *  KartProperties read these fields directly, so they are plain loads
+ *  instead of a virtual process() call with a type switch and copy.
+ */
 class CachedCharacteristic : public AbstractCharacteristic
 {
-private:
-    /** Used to store a value. */
-    struct SaveValue
+public:
+    /** All resolved characteristic values. */
+    struct Values
     {
-        void *content;
-
-        SaveValue() : content(nullptr) {}
-        SaveValue(void *content) : content(content) {}
+#define CACHED_CHARACTERISTIC_FIELD(TYPE, NAME, FIELD) TYPE m_##FIELD;
+        CACHED_CHARACTERISTICS(CACHED_CHARACTERISTIC_FIELD)
+#undef CACHED_CHARACTERISTIC_FIELD
     };
 
-    /** All values for a characteristic. A nullptr means it is not set. */
-    std::vector<SaveValue> m_values;
+private:
+    /** All values for a characteristic. */
+    Values m_values;
 
     /** The characteristics that hold the original values. */
     const AbstractCharacteristic *m_origin;
@@ -44,12 +173,17 @@ private:
 public:
     CachedCharacteristic(const AbstractCharacteristic *origin);
     CachedCharacteristic(const CachedCharacteristic &characteristics) = delete;
-    virtual ~CachedCharacteristic();
+    virtual ~CachedCharacteristic() {}
 
     /** Fetches all cached values from the original source. */
     void updateSource();
     virtual void copyFrom(const AbstractCharacteristic *other) { assert(false); }
     virtual void process(CharacteristicType type, Value value, bool *is_set) const;
+    // ------------------------------------------------------------------------
+    /** Returns all resolved values. */
+    const Values& getValues() const { return m_values; }
+    // ------------------------------------------------------------------------
+    static void unitTesting();
 };
 
 #endif
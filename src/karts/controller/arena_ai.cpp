@@ -47,6 +47,9 @@ void ArenaAI::reset()
     m_target_node = Graph::UNKNOWN_SECTOR;
     m_current_forward_node = Graph::UNKNOWN_SECTOR;
     m_current_forward_point = Vec3(0, 0, 0);
+    m_path.clear();
+    m_path_start = Graph::UNKNOWN_SECTOR;
+    m_path_target = Graph::UNKNOWN_SECTOR;
     m_closest_kart = NULL;
     m_closest_kart_node = Graph::UNKNOWN_SECTOR;
     m_closest_kart_point = Vec3(0, 0, 0);
@@ -207,36 +210,76 @@ bool ArenaAI::updateAimingPosition(Vec3* target_point)
         return true;
     }
 
-    std::vector<int> path;
-    int next_node = m_graph->getNextNode(forward, m_target_node);
-
-    if (next_node == Graph::UNKNOWN_SECTOR)
+    if (!updatePath(forward))
     {
         Log::error("ArenaAI", "Next node is unknown, did you forget to link"
                    " adjacent face in navmesh?");
         return false;
     }
 
-    path.push_back(next_node);
-    while (m_target_node != next_node)
+    std::vector<int> path = m_path;
+    determinePath(forward, &path);
+    *target_point = m_graph->getNode(path.front())->getCenter();
+
+    return true;
+
+}   // updateAimingPosition
+
+//-----------------------------------------------------------------------------
+/** Updates \ref m_path to be the shortest path from the forward node to the
+ *  target node. The path of the last update is reused if the AI is still
+ *  on it, and shortened if the target moved onto it, otherwise it is
+ *  computed again.
+ *  \param forward Forward node of current AI position, not the target node.
+ *  \return False if the target can't be reached.
+ */
+bool ArenaAI::updatePath(int forward)
+{
+    if (m_path_target != m_target_node &&
+        m_path_target != Graph::UNKNOWN_SECTOR)
     {
-        int previous_node = next_node;
-        next_node = m_graph->getNextNode(previous_node, m_target_node);
-        if (next_node == Graph::UNKNOWN_SECTOR)
+        // A part of a shortest path is a shortest path too
+        std::vector<int>::iterator it =
+            std::find(m_path.begin(), m_path.end(), m_target_node);
+        if (it != m_path.end())
         {
-            Log::error("ArenaAI", "Next node is unknown, did you forget to"
-                       " link adjacent face in navmesh?");
-            return false;
+            m_path.erase(it + 1, m_path.end());
+            m_path_target = m_target_node;
         }
-        path.push_back(next_node);
     }
 
-    determinePath(forward, &path);
-    *target_point = m_graph->getNode(path.front())->getCenter();
+    if (m_path_target == m_target_node && !m_path.empty())
+    {
+        if (forward == m_path_start)
+            return true;
+        // Skip the nodes which have been passed
+        std::vector<int>::iterator it =
+            std::find(m_path.begin(), m_path.end(), forward);
+        if (it != m_path.end() && it + 1 != m_path.end())
+        {
+            m_path.erase(m_path.begin(), it + 1);
+            m_path_start = forward;
+            return true;
+        }
+    }
 
+    m_path.clear();
+    m_path_start = forward;
+    m_path_target = m_target_node;
+    int next_node = forward;
+    while (next_node != m_target_node)
+    {
+        next_node = m_graph->getNextNode(next_node, m_target_node);
+        if (next_node == Graph::UNKNOWN_SECTOR)
+        {
+            m_path.clear();
+            m_path_target = Graph::UNKNOWN_SECTOR;
+            return false;
+        }
+        m_path.push_back(next_node);
+    }
     return true;
-
-}   // updateAimingPosition
+}   // updatePath
 
 //-----------------------------------------------------------------------------
 /** This function config the steering (\ref m_steering_angle) of AI.
@@ -130,6 +130,17 @@ private:
     /** The \ref ArenaNode at which the forward point located on. */
     int m_current_forward_node;
 
+    /** The path of the last update from \ref m_path_start to
+     *  \ref m_path_target (without the start node). It is reused as long
+     *  as the AI follows it. */
+    std::vector<int> m_path;
+
+    /** The node at which \ref m_path starts. */
+    int m_path_start;
+
+    /** The node at which \ref m_path ends. */
+    int m_path_target;
+
     void          configSpeed();
     // ------------------------------------------------------------------------
     void          configSteering();
@@ -146,6 +157,8 @@ private:
     // ------------------------------------------------------------------------
     bool          updateAimingPosition(Vec3* target_point);
     // ------------------------------------------------------------------------
+    bool          updatePath(int forward);
+    // ------------------------------------------------------------------------
     void          useItems(const float dt);
     // ------------------------------------------------------------------------
     virtual bool  canSkid(float steer_fraction) OVERRIDE
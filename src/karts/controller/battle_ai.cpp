@@ -77,6 +77,7 @@ void BattleAI::findClosestKart(bool consider_difficulty, bool find_sta)
     float distance = 99999.9f;
     int closest_kart_num = 0;
     const int end = m_world->getNumKarts();
+    const int current_node = getCurrentNode();
 
     for (int start_id =
         find_sta ? end - race_manager->getNumSpareTireKarts() : 0;
@@ -113,8 +114,10 @@ void BattleAI::findClosestKart(bool consider_difficulty, bool find_sta)
                 continue;
         }
 
-        float dist_to_kart = m_graph->getDistance(getCurrentNode(),
-            m_world->getSectorForKart(kart));
+        // Use the path tree of this kart's node for all karts, instead of
+        // computing one for the node of each kart
+        float dist_to_kart = m_graph->getDistance(
+            m_world->getSectorForKart(kart), current_node);
         if (dist_to_kart <= distance)
         {
             distance = dist_to_kart;
@@ -189,8 +192,8 @@ bool BattleAI::isWaiting() const
 //-----------------------------------------------------------------------------
 float BattleAI::getKartDistance(const AbstractKart* kart) const
 {
-    return m_graph->getDistance(getCurrentNode(),
-        m_world->getSectorForKart(kart));
+    return m_graph->getDistance(m_world->getSectorForKart(kart),
+        getCurrentNode());
 }   // getKartDistance
 
 //-----------------------------------------------------------------------------
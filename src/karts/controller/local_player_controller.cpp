@@ -109,8 +109,7 @@ void LocalPlayerController::initParticleEmitter()
                                 m_kart->getNode(),
                                 true));
 
-        // FIXME: in multiplayer mode, this will result in several instances
-        //        of the heightmap being calculated and kept in memory
+        // The height map is shared by the emitters of all local players
         m_sky_particles_emitter->addHeightMapAffector(track);
     }
 #endif
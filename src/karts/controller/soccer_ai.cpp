@@ -506,8 +506,8 @@ bool SoccerAI::isWaiting() const
 //-----------------------------------------------------------------------------
 float SoccerAI::getKartDistance(const AbstractKart* kart) const
 {
-    return m_graph->getDistance(getCurrentNode(),
-        m_world->getSectorForKart(kart));
+    return m_graph->getDistance(m_world->getSectorForKart(kart),
+        getCurrentNode());
 }   // getKartDistance
 
 //-----------------------------------------------------------------------------
@@ -73,6 +73,7 @@
 #include "network/race_event_manager.hpp"
 #include "network/rewind_info.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/tick_budget_monitor.hpp"
 #include "physics/btKart.hpp"
 #include "physics/btKartRaycast.hpp"
 #include "physics/physics.hpp"
@@ -87,6 +88,7 @@
 #include "utils/log.hpp" //TODO: remove after debugging is done
 #include "utils/vs.hpp"
 #include "utils/profiler.hpp"
+#include "utils/tick_profiler.hpp"
 
 #include <ICameraSceneNode.h>
 #include <ISceneManager.h>
@@ -324,6 +326,7 @@ void Kart::reset()
 
     m_network_finish_check_ticks = 0;
     m_network_confirmed_finish_ticks = 0;
+    m_skipped_controller_ticks = 0;
     m_enabled_network_spectator = false;
     // Add karts back in case that they have been removed (i.e. in battle
     // mode) - but only if they actually have a body (e.g. ghost karts
@@ -741,7 +744,7 @@ void Kart::createPhysics()
     trans.setIdentity();
     createBody(mass, trans, m_kart_chassis.get(),
                m_kart_properties->getRestitution(0.0f));
-    std::vector<float> ang_fact = m_kart_properties->getStabilityAngularFactor();
+    const std::vector<float>& ang_fact = m_kart_properties->getStabilityAngularFactor();
     // The angular factor (with X and Z values <1) helps to keep the kart
     // upright, especially in case of a collision.
     m_body->setAngularFactor(Vec3(ang_fact[0], ang_fact[1], ang_fact[2]));
@@ -1187,7 +1190,7 @@ float Kart::getStartupBoostFromStartTicks(int ticks) const
     if (ticks_since_ready < 0)
         return 0.0f;
     float t = stk_config->ticks2Time(ticks_since_ready);
-    std::vector<float> startup_times = m_kart_properties->getStartupTime();
+    const std::vector<float>& startup_times = m_kart_properties->getStartupTime();
     for (unsigned int i = 0; i < startup_times.size(); i++)
     {
         if (t <= startup_times[i])
@@ -1471,7 +1474,19 @@ void Kart::update(int ticks)
     // based on the collision speed.
     m_body->setRestitution(m_kart_properties->getRestitution(fabsf(m_speed)));
 
-    m_controller->update(ticks);
+    // A server over its tick budget updates the AI only every few ticks,
+    // spread over the karts
+    m_skipped_controller_ticks += ticks;
+    if (m_controller->isPlayerController() ||
+        TickBudgetMonitor::isDue(TickBudgetMonitor::DS_AI,
+                                 World::getWorld()->getTicksSinceStart(),
+                                 getWorldKartId()))
+    {
+        TickProfiler::start(TickProfiler::TP_AI);
+        m_controller->update(m_skipped_controller_ticks);
+        TickProfiler::stop(TickProfiler::TP_AI);
+        m_skipped_controller_ticks = 0;
+    }
 
 #ifndef SERVER_ONLY
 #undef DEBUG_CAMERA_SHAKE
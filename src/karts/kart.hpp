@@ -71,6 +71,9 @@ class Kart : public AbstractKart
 private:
     int m_network_finish_check_ticks;
     int m_network_confirmed_finish_ticks;
+    /** Ticks for which the AI controller was not updated because the server
+     *  is over its tick budget, they are added to the next update. */
+    int m_skipped_controller_ticks;
 protected:
     /** Offset of the graphical kart chassis from the physical chassis. */
     float m_graphical_y_offset;
@@ -73,6 +73,36 @@ void SpeedWeightedObject::Properties::loadFromXMLNode(const XMLNode* xml_node)
     xml_node->get("texture-speed-y", &m_texture_speed.Y);
 }   // SpeedWeightedObject::Properties::loadFromXMLNode
 
+// ============================================================================
+/** Initialises the shared data of a kart model with defaults, which are
+ *  then overwritten by the master copy in loadInfo and loadModels.
+ */
+KartModel::SharedData::SharedData()
+{
+    m_version = 0;
+    for(unsigned int i=0; i<4; i++)
+    {
+        m_wheel_graphics_position[i] = Vec3(UNDEFINED);
+        m_wheel_graphics_radius[i]   = 0.0f;   // for kart without separate wheels
+
+        // default value for kart suspensions. move to config file later
+        // if we find each kart needs custom values
+        m_min_suspension[i] = -0.07f;
+        m_max_suspension[i] = 0.20f;
+        m_dampen_suspension_amplitude[i] = 2.5f;
+    }
+    for(unsigned int i=AF_BEGIN; i<=AF_END; i++)
+        m_animation_frame[i]=-1;
+    m_animation_speed      = 25;
+    m_has_nitro_emitter    = false;
+    m_kart_width           = 0.0f;
+    m_kart_length          = 0.0f;
+    m_kart_height          = 0.0f;
+    m_kart_highest_point   = 0.0f;
+    m_kart_lowest_point    = 0.0f;
+    m_support_colorization = false;
+}   // SharedData
+
 // ============================================================================
 /** Default constructor which initialises all variables with defaults.
  *  Note that the KartModel is copied, so make sure to update makeCopy
@@ -91,8 +121,9 @@ void SpeedWeightedObject::Properties::loadFromXMLNode(const XMLNode* xml_node)
  *  used when actually displaying the karts (e.g. in race). They must
  *  be copied since otherwise (if the same kart is used more than once)
  *  shared variables in KartModel (esp. animation status) will cause
- *  incorrect animations. The mesh is shared (between the master instance
- *  and all of its copies).
+ *  incorrect animations. The mesh and all data that does not change
+ *  after loading (see SharedData) are shared between the master instance
+ *  and all of its copies.
  *  Technically the scene node and mesh should be grab'ed on copy,
  *  and dropped when the copy is deleted. But since the master copy
  *  in the kart_properties_manager is always kept, there is no risk of
@@ -100,39 +131,24 @@ void SpeedWeightedObject::Properties::loadFromXMLNode(const XMLNode* xml_node)
  */
 KartModel::KartModel(bool is_master)
 {
-    m_version    = 0;
+    // Copies get the shared data of their master in makeCopy
+    if (is_master)
+        m_shared = std::make_shared<SharedData>();
     m_is_master  = is_master;
     m_kart       = NULL;
     m_mesh       = NULL;
-    m_hat_location = NULL;
 
     for(unsigned int i=0; i<4; i++)
     {
-        m_wheel_graphics_position[i] = Vec3(UNDEFINED);
-        m_wheel_graphics_radius[i]   = 0.0f;   // for kart without separate wheels
-        m_wheel_model[i]             = NULL;
-        m_wheel_node[i]              = NULL;
-
-        // default value for kart suspensions. move to config file later
-        // if we find each kart needs custom values
-        m_min_suspension[i] = -0.07f;
-        m_max_suspension[i] = 0.20f;
-        m_dampen_suspension_amplitude[i] = 2.5f;
+        m_wheel_model[i]                = NULL;
+        m_wheel_node[i]                 = NULL;
         m_default_physics_suspension[i] = 0.25f;
     }
-    m_wheel_filename[0] = "";
-    m_wheel_filename[1] = "";
-    m_wheel_filename[2] = "";
-    m_wheel_filename[3] = "";
     m_speed_weighted_objects.clear();
     m_headlight_objects.clear();
     m_animated_node     = NULL;
-    for(unsigned int i=AF_BEGIN; i<=AF_END; i++)
-        m_animation_frame[i]=-1;
-    m_animation_speed   = 25;
     m_current_animation = AF_DEFAULT;
     m_play_non_loop     = false;
-    m_support_colorization = false;
 }   // KartModel
 
 // ----------------------------------------------------------------------------
@@ -142,31 +158,32 @@ KartModel::KartModel(bool is_master)
  */
 void KartModel::loadInfo(const XMLNode &node)
 {
-    node.get("model-file", &m_model_filename);
+    node.get("model-file", &m_shared->m_model_filename);
+    int *anim_frame = m_shared->m_animation_frame;
     if(const XMLNode *animation_node=node.getNode("animations"))
     {
-        animation_node->get("left",           &m_animation_frame[AF_LEFT]      );
-        animation_node->get("straight",       &m_animation_frame[AF_STRAIGHT]  );
-        animation_node->get("right",          &m_animation_frame[AF_RIGHT]     );
-        animation_node->get("start-winning",  &m_animation_frame[AF_WIN_START] );
+        animation_node->get("left",           &anim_frame[AF_LEFT]      );
+        animation_node->get("straight",       &anim_frame[AF_STRAIGHT]  );
+        animation_node->get("right",          &anim_frame[AF_RIGHT]     );
+        animation_node->get("start-winning",  &anim_frame[AF_WIN_START] );
         animation_node->get("start-winning-loop",
-                                              &m_animation_frame[AF_WIN_LOOP_START] );
-        animation_node->get("end-winning",    &m_animation_frame[AF_WIN_END]   );
-        animation_node->get("start-losing",   &m_animation_frame[AF_LOSE_START]);
+                                              &anim_frame[AF_WIN_LOOP_START] );
+        animation_node->get("end-winning",    &anim_frame[AF_WIN_END]   );
+        animation_node->get("start-losing",   &anim_frame[AF_LOSE_START]);
         animation_node->get("start-losing-loop",
-                                             &m_animation_frame[AF_LOSE_LOOP_START]);
-        animation_node->get("end-losing",     &m_animation_frame[AF_LOSE_END]  );
-        animation_node->get("start-explosion",&m_animation_frame[AF_LOSE_START]);
-        animation_node->get("end-explosion",  &m_animation_frame[AF_LOSE_END]  );
-        animation_node->get("start-jump",     &m_animation_frame[AF_JUMP_START]);
-        animation_node->get("start-jump-loop",&m_animation_frame[AF_JUMP_LOOP] );
-        animation_node->get("end-jump",       &m_animation_frame[AF_JUMP_END]  );
-        animation_node->get("selection-start", &m_animation_frame[AF_SELECTION_START]);
-        animation_node->get("selection-end",   &m_animation_frame[AF_SELECTION_END]  );
-        animation_node->get("backpedal-left", &m_animation_frame[AF_BACK_LEFT]);
-        animation_node->get("backpedal",      &m_animation_frame[AF_BACK_STRAIGHT]);
-        animation_node->get("backpedal-right",&m_animation_frame[AF_BACK_RIGHT]);
-        animation_node->get("speed",          &m_animation_speed               );
+                                             &anim_frame[AF_LOSE_LOOP_START]);
+        animation_node->get("end-losing",     &anim_frame[AF_LOSE_END]  );
+        animation_node->get("start-explosion",&anim_frame[AF_LOSE_START]);
+        animation_node->get("end-explosion",  &anim_frame[AF_LOSE_END]  );
+        animation_node->get("start-jump",     &anim_frame[AF_JUMP_START]);
+        animation_node->get("start-jump-loop",&anim_frame[AF_JUMP_LOOP] );
+        animation_node->get("end-jump",       &anim_frame[AF_JUMP_END]  );
+        animation_node->get("selection-start", &anim_frame[AF_SELECTION_START]);
+        animation_node->get("selection-end",   &anim_frame[AF_SELECTION_END]  );
+        animation_node->get("backpedal-left", &anim_frame[AF_BACK_LEFT]);
+        animation_node->get("backpedal",      &anim_frame[AF_BACK_STRAIGHT]);
+        animation_node->get("backpedal-right",&anim_frame[AF_BACK_RIGHT]);
+        animation_node->get("speed",          &m_shared->m_animation_speed);
     }
 
     if(const XMLNode *wheels_node=node.getNode("wheels"))
@@ -177,19 +194,19 @@ void KartModel::loadInfo(const XMLNode &node)
         loadWheelInfo(*wheels_node, "rear-left",   3);
     }
 
-    m_nitro_emitter_position[0] = Vec3 (0,0.1f,0);
-    m_nitro_emitter_position[1] = Vec3 (0,0.1f,0);
-    m_has_nitro_emitter = false;
+    m_shared->m_nitro_emitter_position[0] = Vec3 (0,0.1f,0);
+    m_shared->m_nitro_emitter_position[1] = Vec3 (0,0.1f,0);
+    m_shared->m_has_nitro_emitter = false;
 
     if(const XMLNode *nitroEmitter_node=node.getNode("nitro-emitter"))
     {
         loadNitroEmitterInfo(*nitroEmitter_node, "nitro-emitter-a", 0);
         loadNitroEmitterInfo(*nitroEmitter_node, "nitro-emitter-b", 1);
-        m_has_nitro_emitter = true;
+        m_shared->m_has_nitro_emitter = true;
     }
 
-    node.get("version", &m_version);
-    if (m_version > 2)
+    node.get("version", &m_shared->m_version);
+    if (m_shared->m_version > 2)
     {
         if (const XMLNode *speed_weighted_objects_node = node.getNode("speed-weighted-objects"))
         {
@@ -212,14 +229,14 @@ void KartModel::loadInfo(const XMLNode &node)
             lm.setTranslation(position);
             sm.setScale(scale);
             rm.setRotationDegrees(rotation);
-            m_hat_location = new core::matrix4(lm * rm * sm);
-            hat_node->get("bone", &m_hat_bone);
+            m_shared->m_hat_location.reset(new core::matrix4(lm * rm * sm));
+            hat_node->get("bone", &m_shared->m_hat_bone);
         }
     }
 
     if (const XMLNode* exhaust = node.getNode("exhaust"))
     {
-        exhaust->get("file", &m_exhaust_xml);
+        exhaust->get("file", &m_shared->m_exhaust_xml);
     }
 }   // loadInfo
 
@@ -300,7 +317,6 @@ KartModel::~KartModel()
         }
     }
 
-    delete m_hat_location;
 #ifdef DEBUG
 #if SKELETON_DEBUG
     irr_driver->clearDebugMeshes();
@@ -324,44 +340,20 @@ KartModel* KartModel::makeCopy(std::shared_ptr<RenderInfo> ri)
     assert(!m_render_info);
     assert(!m_animated_node);
     KartModel *km               = new KartModel(/*is master*/ false);
-    km->m_kart_width            = m_kart_width;
-    km->m_kart_length           = m_kart_length;
-    km->m_kart_height           = m_kart_height;
-    km->m_kart_highest_point    = m_kart_highest_point;
-    km->m_kart_lowest_point     = m_kart_lowest_point;
+    // All data that does not change after loading is shared, only the
+    // nodes and animation state are per instance.
+    km->m_shared                = m_shared;
     km->m_mesh                  = m_mesh;
-    km->m_model_filename        = m_model_filename;
-    km->m_animation_speed       = m_animation_speed;
     km->m_current_animation     = AF_DEFAULT;
     km->m_animated_node         = NULL;
     km->m_hat_name              = m_hat_name;
-    km->m_hat_bone              = m_hat_bone;
-    km->m_support_colorization  = m_support_colorization;
     km->m_render_info           = ri;
-    km->m_inverse_bone_matrices = m_inverse_bone_matrices;
-    km->m_version               = m_version;
-    km->m_exhaust_xml           = m_exhaust_xml;
-
-    km->m_nitro_emitter_position[0] = m_nitro_emitter_position[0];
-    km->m_nitro_emitter_position[1] = m_nitro_emitter_position[1];
-    km->m_has_nitro_emitter = m_has_nitro_emitter;
-    if (m_hat_location)
-    {
-        km->m_hat_location = new core::matrix4();
-        *(km->m_hat_location) = *m_hat_location;
-    }
 
     for(unsigned int i=0; i<4; i++)
     {
         // Master should not have any wheel nodes.
         assert(!m_wheel_node[i]);
         km->m_wheel_model[i]                = m_wheel_model[i];
-        km->m_wheel_filename[i]             = m_wheel_filename[i];
-        km->m_wheel_graphics_position[i]    = m_wheel_graphics_position[i];
-        km->m_wheel_graphics_radius[i]      = m_wheel_graphics_radius[i];
-        km->m_min_suspension[i]             = m_min_suspension[i];
-        km->m_max_suspension[i]             = m_max_suspension[i];
-        km->m_dampen_suspension_amplitude[i]= m_dampen_suspension_amplitude[i];
     }
 
     km->m_speed_weighted_objects.resize(m_speed_weighted_objects.size());
@@ -380,9 +372,6 @@ KartModel* KartModel::makeCopy(std::shared_ptr<RenderInfo> ri)
         km->m_headlight_objects[i] = m_headlight_objects[i];
     }
 
-    for(unsigned int i=AF_BEGIN; i<=AF_END; i++)
-        km->m_animation_frame[i] = m_animation_frame[i];
-
     return km;
 }   // makeCopy
 
@@ -403,7 +392,8 @@ scene::ISceneNode* KartModel::attachModel(bool animated_models, bool human_playe
                NULL/*parent*/, getRenderInfo());
         node = m_animated_node;
 #ifdef DEBUG
-        std::string debug_name = m_model_filename+" (animated-kart-model)";
+        std::string debug_name =
+            m_shared->m_model_filename + " (animated-kart-model)";
         node->setName(debug_name.c_str());
 #endif
         m_animated_node->setLoopMode(false);
@@ -413,8 +403,8 @@ scene::ISceneNode* KartModel::attachModel(bool animated_models, bool human_playe
     {
         // If no animations are shown, make sure to pick the frame
         // with a straight ahead animation (if exist).
-        int straight_frame = m_animation_frame[AF_STRAIGHT]>=0
-                           ? m_animation_frame[AF_STRAIGHT]
+        int straight_frame = m_shared->m_animation_frame[AF_STRAIGHT]>=0
+                           ? m_shared->m_animation_frame[AF_STRAIGHT]
                            : 0;
 
         scene::IMesh* main_frame = m_mesh;
@@ -423,7 +413,7 @@ scene::ISceneNode* KartModel::attachModel(bool animated_models, bool human_playe
         std::string debug_name;
 
 #ifdef DEBUG
-        debug_name = m_model_filename + " (kart-model)";
+        debug_name = m_shared->m_model_filename + " (kart-model)";
 #endif
 
         node = irr_driver->addMesh(main_frame, debug_name,
@@ -441,17 +431,14 @@ scene::ISceneNode* KartModel::attachModel(bool animated_models, bool human_playe
         if(!m_wheel_model[i]) continue;
         m_wheel_node[i] = irr_driver->addMesh(m_wheel_model[i], "wheel",
                           node, getRenderInfo());
-        Vec3 wheel_min, wheel_max;
-        MeshTools::minMax3D(m_wheel_model[i], &wheel_min, &wheel_max);
-        m_wheel_graphics_radius[i] = 0.5f*(wheel_max.getY() - wheel_min.getY());
-
         m_wheel_node[i]->grab();
         ((scene::IMeshSceneNode *) m_wheel_node[i])->setReadOnlyMaterials(true);
 #ifdef DEBUG
-        std::string debug_name = m_wheel_filename[i]+" (wheel)";
+        std::string debug_name = m_shared->m_wheel_filename[i]+" (wheel)";
         m_wheel_node[i]->setName(debug_name.c_str());
 #endif
-        m_wheel_node[i]->setPosition(m_wheel_graphics_position[i].toIrrVector());
+        m_wheel_node[i]->setPosition(
+            m_shared->m_wheel_graphics_position[i].toIrrVector());
     }
 
     // Attach the speed weighted objects + set the animation state
@@ -515,19 +502,20 @@ scene::ISceneNode* KartModel::attachModel(bool animated_models, bool human_playe
         }
     }
 
-    if (m_hat_location && !m_hat_name.empty())
+    if (m_shared->m_hat_location && !m_hat_name.empty())
     {
         file_manager->pushTextureSearchPath
             (file_manager->getAsset(FileManager::MODEL,""), "models");
-        const bool bone_attachment = m_animated_node && !m_hat_bone.empty();
+        const bool bone_attachment =
+            m_animated_node && !m_shared->m_hat_bone.empty();
         scene::ISceneNode* parent = bone_attachment ?
-            m_animated_node->getJointNode(m_hat_bone.c_str()) : node;
+            m_animated_node->getJointNode(m_shared->m_hat_bone.c_str()) : node;
         scene::IMesh* hat_mesh = irr_driver->getAnimatedMesh
             (file_manager->getAsset(FileManager::MODEL, m_hat_name));
         scene::ISceneNode* node = irr_driver->addMesh(hat_mesh, "hat", parent,
             getRenderInfo());
-        configNode(node, *m_hat_location, bone_attachment ?
-                getInverseBoneMatrix(m_hat_bone) : core::matrix4());
+        configNode(node, *m_shared->m_hat_location, bone_attachment ?
+                getInverseBoneMatrix(m_shared->m_hat_bone) : core::matrix4());
         file_manager->popTextureSearchPath();
     }
 
@@ -562,11 +550,13 @@ void HeadlightObject::setLight(scene::ISceneNode* parent,
 bool KartModel::loadModels(const KartProperties &kart_properties)
 {
     assert(m_is_master);
-    std::string  full_path = kart_properties.getKartDir()+m_model_filename;
+    std::string  full_path =
+        kart_properties.getKartDir()+m_shared->m_model_filename;
     // For b3d loader only
-    if (m_animation_frame[AF_STRAIGHT] > -1)
+    const int straight_frame = m_shared->m_animation_frame[AF_STRAIGHT];
+    if (straight_frame > -1)
     {
-        B3DMeshLoader::m_straight_frame = m_animation_frame[AF_STRAIGHT];
+        B3DMeshLoader::m_straight_frame = straight_frame;
     }
     m_mesh                 = irr_driver->getAnimatedMesh(full_path);
     B3DMeshLoader::m_straight_frame = 0;
@@ -584,7 +574,7 @@ bool KartModel::loadModels(const KartProperties &kart_properties)
     irr_driver->grabAllTextures(m_mesh);
 
     Vec3 kart_min, kart_max;
-    MeshTools::minMax3D(m_mesh->getMesh(m_animation_frame[AF_STRAIGHT]),
+    MeshTools::minMax3D(m_mesh->getMesh(straight_frame),
                         &kart_min, &kart_max);
 
 #ifndef SERVER_ONLY
@@ -600,8 +590,8 @@ bool KartModel::loadModels(const KartProperties &kart_properties)
             std::vector<Material*> mbs = mb->getAllSTKMaterials();
             for (Material* m : mbs)
             {
-                m_support_colorization =
-                    m_support_colorization || m->isColorizable();
+                m_shared->m_support_colorization =
+                    m_shared->m_support_colorization || m->isColorizable();
             }
         }
     }
@@ -622,11 +612,11 @@ bool KartModel::loadModels(const KartProperties &kart_properties)
     core::matrix4 translate(core::matrix4::EM4CONST_IDENTITY);
     translate.setTranslation(offset_from_center.toIrrVector());
     mani->transform(m_mesh, translate);
-    MeshTools::minMax3D(m_mesh->getMesh(m_animation_frame[AF_STRAIGHT]),
+    MeshTools::minMax3D(m_mesh->getMesh(straight_frame),
                         &kart_min, &kart_max);
 #endif
-    m_kart_highest_point = kart_max.getY();
-    m_kart_lowest_point  = kart_min.getY();
+    m_shared->m_kart_highest_point = kart_max.getY();
+    m_shared->m_kart_lowest_point  = kart_min.getY();
     initInverseBoneMatrices();
 
     if (ProfileWorld::isNoGraphics())
@@ -694,31 +684,31 @@ bool KartModel::loadModels(const KartProperties &kart_properties)
     }
 
     Vec3 size     = kart_max-kart_min;
-    m_kart_width  = size.getX();
-    m_kart_height = size.getY();
-    m_kart_length = size.getZ();
+    m_shared->m_kart_width  = size.getX();
+    m_shared->m_kart_height = size.getY();
+    m_shared->m_kart_length = size.getZ();
 
     // TODO: Client and server get slightly different sizes, which
     // affets the physics (size determines inertia, which is used
     // in steering). So by rounding to three decimals we get
     // more consistent physics results.
-    m_kart_width  = int(m_kart_width  * 1000) / 1000.0f;
-    m_kart_height = int(m_kart_height * 1000) / 1000.0f;
-    m_kart_length = int(m_kart_length * 1000) / 1000.0f;
+    m_shared->m_kart_width  = int(m_shared->m_kart_width  * 1000) / 1000.0f;
+    m_shared->m_kart_height = int(m_shared->m_kart_height * 1000) / 1000.0f;
+    m_shared->m_kart_length = int(m_shared->m_kart_length * 1000) / 1000.0f;
 
     // Now set default some default parameters (if not defined) that
     // depend on the size of the kart model (wheel position, center
     // of gravity shift)
     for(unsigned int i=0; i<4; i++)
     {
-        if(m_wheel_graphics_position[i].getX()==UNDEFINED)
+        Vec3 &position = m_shared->m_wheel_graphics_position[i];
+        if(position.getX()==UNDEFINED)
         {
-            m_wheel_graphics_position[i].setX( ( i==1||i==3)
-                                               ? -0.5f*m_kart_width
-                                               :  0.5f*m_kart_width  );
-            m_wheel_graphics_position[i].setY(0);
-            m_wheel_graphics_position[i].setZ( (i<2) ?  0.5f*m_kart_length
-                                                     : -0.5f*m_kart_length);
+            position.setX( ( i==1||i==3) ? -0.5f*m_shared->m_kart_width
+                                         :  0.5f*m_shared->m_kart_width  );
+            position.setY(0);
+            position.setZ( (i<2) ?  0.5f*m_shared->m_kart_length
+                                 : -0.5f*m_shared->m_kart_length);
         }
     }
 
@@ -728,13 +718,19 @@ bool KartModel::loadModels(const KartProperties &kart_properties)
     for(unsigned int i=0; i<4; i++)
     {
         // For kart models without wheels.
-        if(m_wheel_filename[i]=="") continue;
+        if(m_shared->m_wheel_filename[i]=="") continue;
         std::string full_wheel =
-            kart_properties.getKartDir()+m_wheel_filename[i];
+            kart_properties.getKartDir()+m_shared->m_wheel_filename[i];
         m_wheel_model[i] = irr_driver->getMesh(full_wheel);
 #ifndef SERVER_ONLY
         SP::uploadSPM(m_wheel_model[i]);
 #endif
+        // The radius only depends on the wheel mesh, so compute it once
+        // for all copies (and before the vertex buffer might be freed).
+        Vec3 wheel_min, wheel_max;
+        MeshTools::minMax3D(m_wheel_model[i], &wheel_min, &wheel_max);
+        m_shared->m_wheel_graphics_radius[i] =
+            0.5f*(wheel_max.getY() - wheel_min.getY());
         // Grab all textures. This is done for the master only, so
         // the destructor will only free the textures if a master
         // copy is freed.
@@ -760,15 +756,15 @@ void KartModel::loadNitroEmitterInfo(const XMLNode &node,
     {
         // Only print the warning if a model filename is given. Otherwise the
         // stk_config file is read (which has no model information).
-        if(m_model_filename!="")
+        if(m_shared->m_model_filename!="")
         {
             Log::error("Kart_Model", "Missing nitro emitter information for model"
-                       "'%s'.", m_model_filename.c_str());
+                       "'%s'.", m_shared->m_model_filename.c_str());
             Log::error("Kart_Model", "This can be ignored, but the nitro particles will not work");
         }
         return;
     }
-    emitter_node->get("position", &m_nitro_emitter_position[index]);
+    emitter_node->get("position", &m_shared->m_nitro_emitter_position[index]);
 }   // loadNitroEmitterInfo
 
 // ----------------------------------------------------------------------------
@@ -816,10 +812,11 @@ void KartModel::loadWheelInfo(const XMLNode &node,
     // Ignore in case of karts with missing wheels (e.g. Sara)
     if(!wheel_node) return;
 
-    wheel_node->get("model",            &m_wheel_filename[index]         );
-    wheel_node->get("position",         &m_wheel_graphics_position[index]);
-    wheel_node->get("min-suspension",   &m_min_suspension[index]         );
-    wheel_node->get("max-suspension",   &m_max_suspension[index]         );
+    SharedData *data = m_shared.get();
+    wheel_node->get("model",          &data->m_wheel_filename[index]         );
+    wheel_node->get("position",       &data->m_wheel_graphics_position[index]);
+    wheel_node->get("min-suspension", &data->m_min_suspension[index]         );
+    wheel_node->get("max-suspension", &data->m_max_suspension[index]         );
 }   // loadWheelInfo
 
 // ----------------------------------------------------------------------------
@@ -908,43 +905,44 @@ void KartModel::setAnimation(AnimationFrameType type, bool play_non_loop)
 
     m_play_non_loop = play_non_loop;
     m_current_animation = type;
+    const int *anim_frame = m_shared->m_animation_frame;
     if(m_current_animation==AF_DEFAULT)
     {
         m_animated_node->setLoopMode(false);
         const bool support_backpedal =
-            m_animation_frame[AF_BACK_STRAIGHT] > -1 &&
-            m_animation_frame[AF_BACK_LEFT] > -1 &&
-            m_animation_frame[AF_BACK_RIGHT] > -1;
+            anim_frame[AF_BACK_STRAIGHT] > -1 &&
+            anim_frame[AF_BACK_LEFT] > -1 &&
+            anim_frame[AF_BACK_RIGHT] > -1;
         if (support_backpedal)
         {
-            int start_frame = std::min(m_animation_frame[AF_LEFT],
-                m_animation_frame[AF_RIGHT]);
-            int end_frame = std::max(m_animation_frame[AF_BACK_LEFT],
-                m_animation_frame[AF_BACK_RIGHT]);
+            int start_frame = std::min(anim_frame[AF_LEFT],
+                anim_frame[AF_RIGHT]);
+            int end_frame = std::max(anim_frame[AF_BACK_LEFT],
+                anim_frame[AF_BACK_RIGHT]);
             m_animated_node->setFrameLoop(start_frame, end_frame);
         }
         else
         {
-            if(m_animation_frame[AF_LEFT] <= m_animation_frame[AF_RIGHT])
-                m_animated_node->setFrameLoop(m_animation_frame[AF_LEFT],
-                                              m_animation_frame[AF_RIGHT] );
+            if(anim_frame[AF_LEFT] <= anim_frame[AF_RIGHT])
+                m_animated_node->setFrameLoop(anim_frame[AF_LEFT],
+                                              anim_frame[AF_RIGHT] );
             else
-                m_animated_node->setFrameLoop(m_animation_frame[AF_RIGHT],
-                                              m_animation_frame[AF_LEFT] );
+                m_animated_node->setFrameLoop(anim_frame[AF_RIGHT],
+                                              anim_frame[AF_LEFT] );
         }
         m_animated_node->setAnimationEndCallback(NULL);
         m_animated_node->setAnimationSpeed(0);
     }
-    else if(m_animation_frame[type]>-1)
+    else if(anim_frame[type]>-1)
     {
         // 'type' is the start frame of the animation, type + 1 the frame
         // to begin the loop with, type + 2 to end the frame with
         AnimationFrameType end = (AnimationFrameType)(type+2);
-        if(m_animation_frame[end]==-1)
+        if(anim_frame[end]==-1)
             end = (AnimationFrameType)((int)end-1);
-        m_animated_node->setAnimationSpeed(m_animation_speed);
-        m_animated_node->setFrameLoop(m_animation_frame[type],
-                                      m_animation_frame[end]    );
+        m_animated_node->setAnimationSpeed(m_shared->m_animation_speed);
+        m_animated_node->setFrameLoop(anim_frame[type],
+                                      anim_frame[end]    );
         // Loop mode must be set to false so that we get a callback when
         // the first iteration is finished.
         m_animated_node->setLoopMode(false);
@@ -972,23 +970,24 @@ void KartModel::OnAnimationEnd(scene::IAnimatedMeshSceneNode *node)
     // It should only be called for the animated node of this
     // kart_model
     assert(node==m_animated_node);
+    const int *anim_frame = m_shared->m_animation_frame;
 
     // 'type' is the start frame of the animation, type + 1 the frame
     // to begin the loop with, type + 2 to end the frame with
     AnimationFrameType start = (AnimationFrameType)(m_current_animation+1);
     // If there is no loop-start defined (i.e. no 'introductory' sequence)
     // use the normal start frame.
-    if(m_animation_frame[start]==-1)
+    if(anim_frame[start]==-1)
         start = m_current_animation;
     AnimationFrameType end   = (AnimationFrameType)(m_current_animation+2);
 
     // Switch to loop mode if the current animation has a loop defined
     // (else just disable the callback, and the last frame will be shown).
-    if(m_animation_frame[end]>-1)
+    if(anim_frame[end]>-1)
     {
-        m_animated_node->setAnimationSpeed(m_animation_speed);
-        m_animated_node->setFrameLoop(m_animation_frame[start],
-                                      m_animation_frame[end]   );
+        m_animated_node->setAnimationSpeed(m_shared->m_animation_speed);
+        m_animated_node->setFrameLoop(anim_frame[start],
+                                      anim_frame[end]   );
         m_animated_node->setLoopMode(true);
     }
     m_animated_node->setAnimationEndCallback(NULL);
@@ -1043,7 +1042,8 @@ void KartModel::update(float dt, float distance, float steer, float speed,
             m_wheel_node[i]->setVisible(wi.m_raycastInfo.m_isInContact);
         }
 #endif
-        core::vector3df pos =  m_wheel_graphics_position[i].toIrrVector();
+        core::vector3df pos =
+            m_shared->m_wheel_graphics_position[i].toIrrVector();
 
         float suspension_length = m_default_physics_suspension[i];
         GhostKart* gk = dynamic_cast<GhostKart*>(m_kart);
@@ -1064,13 +1064,14 @@ void KartModel::update(float dt, float distance, float steer, float speed,
         // Check documentation of Kart::updateGraphics for the following line
         pos.Y +=   m_default_physics_suspension[i]
                  - suspension_length
-                 - m_kart_lowest_point;
+                 - m_shared->m_kart_lowest_point;
 
         m_wheel_node[i]->setPosition(pos);
 
         // Now calculate the new rotation: (old + change) mod 360
         float new_rotation = m_wheel_node[i]->getRotation().X
-                           + distance / m_wheel_graphics_radius[i] * RAD_TO_DEGREE;
+                           + distance / m_shared->m_wheel_graphics_radius[i]
+                           * RAD_TO_DEGREE;
         new_rotation = fmodf(new_rotation, 360);
         core::vector3df wheel_rotation(new_rotation, 0, 0);
         // Only apply steer to first 2 wheels.
@@ -1081,7 +1082,8 @@ void KartModel::update(float dt, float distance, float steer, float speed,
         // Undo lean angle applied by parent
         core::matrix4 parent_m;
         parent_m.setInverseTranslation(core::vector3df
-            (0, fabsf(tanf(current_lean_angle)) * m_kart_width * 0.5f, 0));
+            (0, fabsf(tanf(current_lean_angle)) * m_shared->m_kart_width * 0.5f,
+             0));
         parent_m.setInverseRotationRadians(core::vector3df
             (0, 0, -current_lean_angle));
 
@@ -1173,27 +1175,28 @@ void KartModel::update(float dt, float distance, float steer, float speed,
     // play steering animation.
     if(m_current_animation!=AF_DEFAULT) return;
 
-    if(m_animation_frame[AF_LEFT]<0) return;   // no animations defined
+    const int *anim_frame = m_shared->m_animation_frame;
+    if(anim_frame[AF_LEFT]<0) return;   // no animations defined
 
     // Update animation if necessary
     // -----------------------------
-    const bool back = m_animation_frame[AF_BACK_STRAIGHT] > -1 && speed < 0.0f;
+    const bool back = anim_frame[AF_BACK_STRAIGHT] > -1 && speed < 0.0f;
     float frame;
-    if(steer>0.0f && back) frame = m_animation_frame[AF_BACK_STRAIGHT]
-                                 - ( ( m_animation_frame[AF_BACK_STRAIGHT]
-                                   -m_animation_frame[AF_BACK_RIGHT]  )*steer);
-    else if(steer<0.0f && back) frame = m_animation_frame[AF_BACK_STRAIGHT]
-                              + ( (m_animation_frame[AF_BACK_STRAIGHT]
-                                   -m_animation_frame[AF_BACK_LEFT]   )*steer);
-    else if(steer>0.0f) frame = m_animation_frame[AF_STRAIGHT]
-                              - ( ( m_animation_frame[AF_STRAIGHT]
-                                        -m_animation_frame[AF_RIGHT]  )*steer);
-    else if(steer<0.0f) frame = m_animation_frame[AF_STRAIGHT]
-                              + ( (m_animation_frame[AF_STRAIGHT]
-                                        -m_animation_frame[AF_LEFT]   )*steer);
+    if(steer>0.0f && back) frame = anim_frame[AF_BACK_STRAIGHT]
+                                 - ( ( anim_frame[AF_BACK_STRAIGHT]
+                                   -anim_frame[AF_BACK_RIGHT]  )*steer);
+    else if(steer<0.0f && back) frame = anim_frame[AF_BACK_STRAIGHT]
+                              + ( (anim_frame[AF_BACK_STRAIGHT]
+                                   -anim_frame[AF_BACK_LEFT]   )*steer);
+    else if(steer>0.0f) frame = anim_frame[AF_STRAIGHT]
+                              - ( ( anim_frame[AF_STRAIGHT]
+                                        -anim_frame[AF_RIGHT]  )*steer);
+    else if(steer<0.0f) frame = anim_frame[AF_STRAIGHT]
+                              + ( (anim_frame[AF_STRAIGHT]
+                                        -anim_frame[AF_LEFT]   )*steer);
     else                frame = (float)(back ?
-                                m_animation_frame[AF_BACK_STRAIGHT] :
-                                m_animation_frame[AF_STRAIGHT]);
+                                anim_frame[AF_BACK_STRAIGHT] :
+                                anim_frame[AF_STRAIGHT]);
     m_animated_node->setCurrentFrame(frame);
 }   // update
 
@@ -1214,7 +1217,7 @@ void KartModel::resetVisualWheelPosition()
 //-----------------------------------------------------------------------------
 std::shared_ptr<RenderInfo> KartModel::getRenderInfo()
 {
-    return m_support_colorization ? m_render_info : NULL;
+    return m_shared->m_support_colorization ? m_render_info : NULL;
 }   // getRenderInfo
 
 //-----------------------------------------------------------------------------
@@ -1239,16 +1242,16 @@ void KartModel::toggleHeadlights(bool on)
  */
 void KartModel::initInverseBoneMatrices()
 {
-    if (m_version < 3)
+    if (m_shared->m_version < 3)
     {
         // Only need for >= 3 version of kart
         return;
     }
-    float striaght_frame = (float)m_animation_frame[AF_STRAIGHT];
-    if (m_animation_frame[AF_STRAIGHT] == -1)
+    float striaght_frame = (float)m_shared->m_animation_frame[AF_STRAIGHT];
+    if (m_shared->m_animation_frame[AF_STRAIGHT] == -1)
     {
         Log::warn("KartModel", "%s has no striaght frame defined.",
-            m_model_filename.c_str());
+            m_shared->m_model_filename.c_str());
         striaght_frame = 0.0f;
     }
     using namespace SP;
@@ -1267,7 +1270,7 @@ void KartModel::initInverseBoneMatrices()
                 core::matrix4 m;
                 arm.getWorldMatrix(arm.m_interpolated_matrices, i)
                     .getInverse(m);
-                m_inverse_bone_matrices[arm.m_joint_names[i]] = m;
+                m_shared->m_inverse_bone_matrices[arm.m_joint_names[i]] = m;
             }
         }
     }
@@ -1291,14 +1294,14 @@ void KartModel::initInverseBoneMatrices()
             core::matrix4 inv;
             bone->getAbsoluteTransformation().getInverse(inv);
             const std::string bone_name = bone->getName();
-            auto ret = m_inverse_bone_matrices.find(bone_name);
-            if (ret != m_inverse_bone_matrices.end())
+            auto ret = m_shared->m_inverse_bone_matrices.find(bone_name);
+            if (ret != m_shared->m_inverse_bone_matrices.end())
             {
                 Log::warn("KartModel", "%s has duplicated bone, name: %s,"
                     " attachment may not work correctly.",
-                    m_model_filename.c_str(), bone_name.c_str());
+                    m_shared->m_model_filename.c_str(), bone_name.c_str());
             }
-            m_inverse_bone_matrices[bone_name] = inv;
+            m_shared->m_inverse_bone_matrices[bone_name] = inv;
         }
         node->remove();
     }
@@ -1308,8 +1311,8 @@ void KartModel::initInverseBoneMatrices()
 const core::matrix4& KartModel::getInverseBoneMatrix
                                            (const std::string& bone_name) const
 {
-    assert(m_version >= 3);
-    auto ret = m_inverse_bone_matrices.find(bone_name);
-    assert(ret != m_inverse_bone_matrices.end());
+    assert(m_shared->m_version >= 3);
+    auto ret = m_shared->m_inverse_bone_matrices.find(bone_name);
+    assert(ret != m_shared->m_inverse_bone_matrices.end());
     return ret->second;
 }   // getInverseBoneMatrix
@@ -193,11 +193,96 @@ public:
             AF_COUNT};             // Number of entries here
 
 private:
-    /** Which frame number starts/end which animation. */
-    int m_animation_frame[AF_COUNT];
+    /** Value used to indicate undefined entries. */
+    static float UNDEFINED;
+
+    /** The data of a kart model that does not change once the master copy
+     *  is loaded. It is allocated once per kart type by the master copy
+     *  and shared by all copies made with makeCopy, so that adding a kart
+     *  to a race only creates the scene nodes and animation state. */
+    struct SharedData
+    {
+        /** Which frame number starts/end which animation. */
+        int m_animation_frame[AF_COUNT];
+
+        /** Animation speed. */
+        float m_animation_speed;
+
+        /** Location of hat in object space, NULL if not defined. */
+        std::unique_ptr<core::matrix4> m_hat_location;
+
+        /** Name of the bone for hat attachment. */
+        std::string m_hat_bone;
+
+        /** Name of the 3d model file. */
+        std::string m_model_filename;
+
+        /** Filename of the wheel models. */
+        std::string m_wheel_filename[4];
+
+        /** The position of all four wheels in the 3d model. */
+        Vec3 m_wheel_graphics_position[4];
+
+        /** Radius of the graphical wheels.  */
+        float m_wheel_graphics_radius[4];
+
+        /** The position of the nitro emitters */
+        Vec3 m_nitro_emitter_position[2];
+
+        /** True if kart has nitro emitters */
+        bool m_has_nitro_emitter;
+
+        /** Minimum suspension length (i.e. most compressed). If the
+         *  displayed suspension is shorter than this, the wheel would look
+         *  wrong. */
+        float m_min_suspension[4];
+
+        /** Maximum suspension length (i.e. most extended). If the displayed
+         *  suspension is any longer, the wheel would look too far away from
+         *  the chassis. */
+        float m_max_suspension[4];
+
+        /** value used to divide the visual movement of wheels (because the
+         *  actual movement of wheels in bullet is too large and looks
+         *  strange). 1=no change, 2=half the amplitude */
+        float m_dampen_suspension_amplitude[4];
+
+        /** Width of kart.  */
+        float m_kart_width;
+
+        /** Length of kart. */
+        float m_kart_length;
+
+        /** Height of kart. */
+        float m_kart_height;
+
+        /** Largest coordinate on up axis. */
+        float m_kart_highest_point;
+
+        /** Smallest coordinate on up axis. */
+        float m_kart_lowest_point;
+
+        /** True if this kart model can be colorization in red / blue (now
+         *  only used in soccer mode). */
+        bool m_support_colorization;
+
+        /** Used to cache inverse bone matrices for each bone in straight
+         *  frame for attachment. */
+        std::unordered_map<std::string, core::matrix4> m_inverse_bone_matrices;
+
+        /** Version of kart model (in kart.xml).  */
+        unsigned m_version;
+
+        /** Exhaust particle file (xml) for the kart, empty if disabled.  */
+        std::string m_exhaust_xml;
 
-    /** Animation speed. */
-    float m_animation_speed;
+        SharedData();
+    };   // SharedData
+
+    /** The read-only data of this kart model, owned by the master copy
+     *  and shared with all copies. Only the master writes to it while
+     *  loading. */
+    std::shared_ptr<SharedData> m_shared;
 
     /** The mesh of the model. */
     scene::IAnimatedMesh *m_mesh;
@@ -207,42 +292,15 @@ private:
      *  (i.e. neither read nor written) if animations are disabled. */
     scene::IAnimatedMeshSceneNode *m_animated_node;
 
-    /** Location of hat in object space. */
-    core::matrix4* m_hat_location;
-
-    /** Name of the bone for hat attachment. */
-    std::string m_hat_bone;
-
     /** Name of the hat to use for this kart. "" if no hat. */
     std::string m_hat_name;
 
-    /** Value used to indicate undefined entries. */
-    static float UNDEFINED;
-
-    /** Name of the 3d model file. */
-    std::string   m_model_filename;
-
     /** The four wheel models. */
     scene::IMesh *m_wheel_model[4];
 
     /** The four scene nodes the wheels are attached to */
     scene::ISceneNode *m_wheel_node[4];
 
-    /** Filename of the wheel models. */
-    std::string   m_wheel_filename[4];
-
-    /** The position of all four wheels in the 3d model. */
-    Vec3          m_wheel_graphics_position[4];
-
-    /** Radius of the graphical wheels.  */
-    float         m_wheel_graphics_radius[4];
-    
-    /** The position of the nitro emitters */
-    Vec3          m_nitro_emitter_position[2];
-
-    /** True if kart has nitro emitters */
-    bool          m_has_nitro_emitter;
-
     /** The speed weighted objects. */
     SpeedWeightedObjectList     m_speed_weighted_objects;
     
@@ -251,39 +309,11 @@ private:
     /** Length of the physics suspension when the kart is at rest. */
     float m_default_physics_suspension[4];
 
-    /** Minimum suspension length (i.e. most compressed). If the displayed
-     *  suspension is shorter than this, the wheel would look wrong. */
-    float         m_min_suspension[4];
-
-    /** Maximum suspension length (i.e. most extended). If the displayed
-     *  suspension is any longer, the wheel would look too far away from the
-     *  chassis. */
-    float         m_max_suspension[4];
-
-    /** value used to divide the visual movement of wheels (because the actual movement
-        of wheels in bullet is too large and looks strange). 1=no change, 2=half the amplitude */
-    float         m_dampen_suspension_amplitude[4];
-
     /** Which animation is currently being played. This is used to overwrite
      *  the default steering animations while being in race. If this is set
      *  to AF_DEFAULT the default steering animation is shown. */
     AnimationFrameType m_current_animation;
 
-    /** Width of kart.  */
-    float m_kart_width;
-
-    /** Length of kart. */
-    float m_kart_length;
-
-    /** Height of kart. */
-    float m_kart_height;
-
-    /** Largest coordinate on up axis. */
-    float m_kart_highest_point;
-
-    /** Smallest coordinate on up axis. */
-    float m_kart_lowest_point;
-
     /** True if this is the master copy, managed by KartProperties. This
      *  is mainly used for debugging, e.g. the master copies might not have
      *  anything attached to it etc. */
@@ -312,20 +342,6 @@ private:
     /** For our engine to get the desired hue for colorization. */
     std::shared_ptr<RenderInfo> m_render_info;
 
-    /** True if this kart model can be colorization in red / blue (now only
-     *  used in soccer mode). */
-    bool m_support_colorization;
-
-    /** Used to cache inverse bone matrices for each bone in straight frame
-     *  for attachment. */
-    std::unordered_map<std::string, core::matrix4> m_inverse_bone_matrices;
-
-    /** Version of kart model (in kart.xml).  */
-    unsigned m_version;
-
-    /** Exhaust particle file (xml) for the kart, empty if disabled.  */
-    std::string m_exhaust_xml;
-
     // ------------------------------------------------------------------------
     void initInverseBoneMatrices();
     // ------------------------------------------------------------------------
@@ -368,38 +384,39 @@ public:
     // ------------------------------------------------------------------------
     /** Since karts might be animated, we might need to know which base frame
      *  to use. */
-    int  getBaseFrame() const   { return m_animation_frame[AF_STRAIGHT];  }
+    int  getBaseFrame() const   { return m_shared->m_animation_frame[AF_STRAIGHT]; }
     // ------------------------------------------------------------------------
-    int  getFrame(AnimationFrameType f) const  { return m_animation_frame[f]; }
+    int  getFrame(AnimationFrameType f) const
+                             { return m_shared->m_animation_frame[f]; }
     // ------------------------------------------------------------------------
-    float  getAnimationSpeed() const              { return m_animation_speed; }
+    float  getAnimationSpeed() const  { return m_shared->m_animation_speed; }
     // ------------------------------------------------------------------------
     /** Returns the position of a wheel relative to the kart.
      *  \param i Index of the wheel: 0=front right, 1 = front left, 2 = rear
      *           right, 3 = rear left.  */
     const Vec3& getWheelGraphicsPosition(unsigned int i) const
-                {assert(i<4); return m_wheel_graphics_position[i];}
+                {assert(i<4); return m_shared->m_wheel_graphics_position[i];}
     // ------------------------------------------------------------------------
     /** Returns the position of wheels relative to the kart.
      */
     const Vec3* getWheelsGraphicsPosition() const
-                {return m_wheel_graphics_position;}
+                {return m_shared->m_wheel_graphics_position;}
     // ------------------------------------------------------------------------
     /** Returns the radius of the graphical wheels.
      *  \param i Index of the wheel: 0=front right, 1 = front left, 2 = rear
      *           right, 3 = rear left.  */
     float       getWheelGraphicsRadius(unsigned int i) const
-                {assert(i<4); return m_wheel_graphics_radius[i]; }
+                {assert(i<4); return m_shared->m_wheel_graphics_radius[i]; }
     // ------------------------------------------------------------------------
     /** Returns the position of nitro emitter relative to the kart.
      *  \param i Index of the emitter: 0 = right, 1 = left
      */
     const Vec3& getNitroEmittersPositon(unsigned int i) const
-                { assert(i<2);  return m_nitro_emitter_position[i]; }
+                { assert(i<2);  return m_shared->m_nitro_emitter_position[i]; }
     // ------------------------------------------------------------------------
     /** Returns true if kart has nitro emitters */
     const bool hasNitroEmitters() const
-                {return m_has_nitro_emitter;}
+                {return m_shared->m_has_nitro_emitter;}
     // ------------------------------------------------------------------------
     /** Returns the number of speed weighted objects for this kart */
     size_t      getSpeedWeightedObjectsCount() const
@@ -411,19 +428,19 @@ public:
                 {return m_speed_weighted_objects[i];}
     // ------------------------------------------------------------------------
     /** Returns the length of the kart model. */
-    float getLength                 () const {return m_kart_length;      }
+    float getLength       () const { return m_shared->m_kart_length;        }
     // ------------------------------------------------------------------------
     /** Returns the width of the kart model. */
-    float getWidth                  () const {return m_kart_width;       }
+    float getWidth        () const { return m_shared->m_kart_width;         }
     // ------------------------------------------------------------------------
     /** Returns the height of the kart. */
-    float getHeight                 () const {return m_kart_height;      }
+    float getHeight       () const { return m_shared->m_kart_height;        }
     // ------------------------------------------------------------------------
     /** Highest coordinate on up axis */
-    float getHighestPoint           () const { return m_kart_highest_point;  }
+    float getHighestPoint () const { return m_shared->m_kart_highest_point; }
     // ------------------------------------------------------------------------
     /** Lowest coordinate on up axis */
-    float getLowestPoint           () const { return m_kart_lowest_point;  }
+    float getLowestPoint  () const { return m_shared->m_kart_lowest_point;  }
     // ------------------------------------------------------------------------
     /** Returns information about currently played animation */
     AnimationFrameType getAnimation() { return m_current_animation; }
@@ -444,14 +461,16 @@ public:
     // ------------------------------------------------------------------------
     std::shared_ptr<RenderInfo> getRenderInfo();
     // ------------------------------------------------------------------------
-    bool supportColorization() const         { return m_support_colorization; }
+    bool supportColorization() const
+                                { return m_shared->m_support_colorization; }
     // ------------------------------------------------------------------------
     void toggleHeadlights(bool on);
     // ------------------------------------------------------------------------
     const core::matrix4&
                       getInverseBoneMatrix(const std::string& bone_name) const;
     // ------------------------------------------------------------------------
-    const std::string& getExhaustXML() const          { return m_exhaust_xml; }
+    const std::string& getExhaustXML() const
+                                         { return m_shared->m_exhaust_xml; }
 
 };   // KartModel
 #endif
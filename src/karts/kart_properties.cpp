@@ -577,673 +577,27 @@ float KartProperties::getAccelerationEfficiency() const
 }   // getAccelerationEfficiency
 
 // ----------------------------------------------------------------------------
-// Script-generated content generated by tools/create_kart_properties.py getter
-// Please don't change the following tag. It will be automatically detected
-// by the script and replace the contained content.
-// To update the code, use tools/update_characteristics.py
-/* <characteristics-start kpgetter> */
-// ----------------------------------------------------------------------------
-float KartProperties::getSuspensionStiffness() const
-{
-    return m_cached_characteristic->getSuspensionStiffness();
-}  // getSuspensionStiffness
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSuspensionRest() const
-{
-    return m_cached_characteristic->getSuspensionRest();
-}  // getSuspensionRest
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSuspensionTravel() const
-{
-    return m_cached_characteristic->getSuspensionTravel();
-}  // getSuspensionTravel
-
-// ----------------------------------------------------------------------------
-bool KartProperties::getSuspensionExpSpringResponse() const
-{
-    return m_cached_characteristic->getSuspensionExpSpringResponse();
-}  // getSuspensionExpSpringResponse
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSuspensionMaxForce() const
-{
-    return m_cached_characteristic->getSuspensionMaxForce();
-}  // getSuspensionMaxForce
-
-// ----------------------------------------------------------------------------
-float KartProperties::getStabilityRollInfluence() const
-{
-    return m_cached_characteristic->getStabilityRollInfluence();
-}  // getStabilityRollInfluence
-
-// ----------------------------------------------------------------------------
-float KartProperties::getStabilityChassisLinearDamping() const
-{
-    return m_cached_characteristic->getStabilityChassisLinearDamping();
-}  // getStabilityChassisLinearDamping
-
-// ----------------------------------------------------------------------------
-float KartProperties::getStabilityChassisAngularDamping() const
-{
-    return m_cached_characteristic->getStabilityChassisAngularDamping();
-}  // getStabilityChassisAngularDamping
-
-// ----------------------------------------------------------------------------
-float KartProperties::getStabilityDownwardImpulseFactor() const
-{
-    return m_cached_characteristic->getStabilityDownwardImpulseFactor();
-}  // getStabilityDownwardImpulseFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getStabilityTrackConnectionAccel() const
-{
-    return m_cached_characteristic->getStabilityTrackConnectionAccel();
-}  // getStabilityTrackConnectionAccel
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getStabilityAngularFactor() const
-{
-    return m_cached_characteristic->getStabilityAngularFactor();
-}  // getStabilityAngularFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getStabilitySmoothFlyingImpulse() const
-{
-    return m_cached_characteristic->getStabilitySmoothFlyingImpulse();
-}  // getStabilitySmoothFlyingImpulse
-
-// ----------------------------------------------------------------------------
-InterpolationArray KartProperties::getTurnRadius() const
-{
-    return m_cached_characteristic->getTurnRadius();
-}  // getTurnRadius
-
-// ----------------------------------------------------------------------------
-float KartProperties::getTurnTimeResetSteer() const
-{
-    return m_cached_characteristic->getTurnTimeResetSteer();
-}  // getTurnTimeResetSteer
-
-// ----------------------------------------------------------------------------
-InterpolationArray KartProperties::getTurnTimeFullSteer() const
-{
-    return m_cached_characteristic->getTurnTimeFullSteer();
-}  // getTurnTimeFullSteer
-
-// ----------------------------------------------------------------------------
-float KartProperties::getEnginePower() const
-{
-    return m_cached_characteristic->getEnginePower();
-}  // getEnginePower
-
-// ----------------------------------------------------------------------------
-float KartProperties::getEngineMaxSpeed() const
-{
-    return m_cached_characteristic->getEngineMaxSpeed();
-}  // getEngineMaxSpeed
-
-// ----------------------------------------------------------------------------
-float KartProperties::getEngineGenericMaxSpeed() const
-{
-    return m_cached_characteristic->getEngineGenericMaxSpeed();
-}  // getEngineMaxSpeed
-
-// ----------------------------------------------------------------------------
-float KartProperties::getEngineBrakeFactor() const
-{
-    return m_cached_characteristic->getEngineBrakeFactor();
-}  // getEngineBrakeFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getEngineBrakeTimeIncrease() const
-{
-    return m_cached_characteristic->getEngineBrakeTimeIncrease();
-}  // getEngineBrakeTimeIncrease
-
-// ----------------------------------------------------------------------------
-float KartProperties::getEngineMaxSpeedReverseRatio() const
-{
-    return m_cached_characteristic->getEngineMaxSpeedReverseRatio();
-}  // getEngineMaxSpeedReverseRatio
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getGearSwitchRatio() const
-{
-    return m_cached_characteristic->getGearSwitchRatio();
-}  // getGearSwitchRatio
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getGearPowerIncrease() const
-{
-    return m_cached_characteristic->getGearPowerIncrease();
-}  // getGearPowerIncrease
-
-// ----------------------------------------------------------------------------
-float KartProperties::getMass() const
-{
-    return m_cached_characteristic->getMass();
-}  // getMass
-
-// ----------------------------------------------------------------------------
-float KartProperties::getWheelsDampingRelaxation() const
-{
-    return m_cached_characteristic->getWheelsDampingRelaxation();
-}  // getWheelsDampingRelaxation
-
-// ----------------------------------------------------------------------------
-float KartProperties::getWheelsDampingCompression() const
-{
-    return m_cached_characteristic->getWheelsDampingCompression();
-}  // getWheelsDampingCompression
-
-// ----------------------------------------------------------------------------
-float KartProperties::getCameraDistance() const
-{
-    return m_cached_characteristic->getCameraDistance();
-}  // getCameraDistance
-
-// ----------------------------------------------------------------------------
-float KartProperties::getCameraForwardUpAngle() const
-{
-    return m_cached_characteristic->getCameraForwardUpAngle();
-}  // getCameraForwardUpAngle
-
-// ----------------------------------------------------------------------------
-float KartProperties::getCameraBackwardUpAngle() const
-{
-    return m_cached_characteristic->getCameraBackwardUpAngle();
-}  // getCameraBackwardUpAngle
-
-// ----------------------------------------------------------------------------
-float KartProperties::getJumpAnimationTime() const
-{
-    return m_cached_characteristic->getJumpAnimationTime();
-}  // getJumpAnimationTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getLeanMax() const
-{
-    return m_cached_characteristic->getLeanMax();
-}  // getLeanMax
-
-// ----------------------------------------------------------------------------
-float KartProperties::getLeanSpeed() const
-{
-    return m_cached_characteristic->getLeanSpeed();
-}  // getLeanSpeed
-
-// ----------------------------------------------------------------------------
-float KartProperties::getAnvilDuration() const
-{
-    return m_cached_characteristic->getAnvilDuration();
-}  // getAnvilDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getAnvilWeight() const
-{
-    return m_cached_characteristic->getAnvilWeight();
-}  // getAnvilWeight
-
-// ----------------------------------------------------------------------------
-float KartProperties::getAnvilSpeedFactor() const
-{
-    return m_cached_characteristic->getAnvilSpeedFactor();
-}  // getAnvilSpeedFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getParachuteFriction() const
-{
-    return m_cached_characteristic->getParachuteFriction();
-}  // getParachuteFriction
-
-// ----------------------------------------------------------------------------
-int KartProperties::getParachuteDuration() const
-{
-    return m_cached_characteristic->getParachuteDuration();
-}  // getParachuteDuration
-
-// ----------------------------------------------------------------------------
-int KartProperties::getParachuteDurationOther() const
-{
-    return m_cached_characteristic->getParachuteDurationOther();
-}  // getParachuteDurationOther
-
-// ----------------------------------------------------------------------------
-float KartProperties::getParachuteDurationRankMult() const
-{
-    return m_cached_characteristic->getParachuteDurationRankMult();
-}  // getParachuteDurationRankMult
-
-// ----------------------------------------------------------------------------
-float KartProperties::getParachuteDurationSpeedMult() const
-{
-    return m_cached_characteristic->getParachuteDurationSpeedMult();
-}  // getParachuteDurationSpeedMult
-
-// ----------------------------------------------------------------------------
-float KartProperties::getParachuteLboundFraction() const
-{
-    return m_cached_characteristic->getParachuteLboundFraction();
-}  // getParachuteLboundFraction
-
-// ----------------------------------------------------------------------------
-float KartProperties::getParachuteUboundFraction() const
-{
-    return m_cached_characteristic->getParachuteUboundFraction();
-}  // getParachuteUboundFraction
-
-// ----------------------------------------------------------------------------
-float KartProperties::getParachuteMaxSpeed() const
-{
-    return m_cached_characteristic->getParachuteMaxSpeed();
-}  // getParachuteMaxSpeed
-
-// ----------------------------------------------------------------------------
-float KartProperties::getFrictionKartFriction() const
-{
-    return m_cached_characteristic->getFrictionKartFriction();
-}  // getFrictionKartFriction
-
-// ----------------------------------------------------------------------------
-float KartProperties::getBubblegumDuration() const
-{
-    return m_cached_characteristic->getBubblegumDuration();
-}  // getBubblegumDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getBubblegumSpeedFraction() const
-{
-    return m_cached_characteristic->getBubblegumSpeedFraction();
-}  // getBubblegumSpeedFraction
-
-// ----------------------------------------------------------------------------
-float KartProperties::getBubblegumTorque() const
-{
-    return m_cached_characteristic->getBubblegumTorque();
-}  // getBubblegumTorque
-
+// The other characteristic getters are inline in kart_properties.hpp and
+// read the values resolved by CachedCharacteristic.
 // ----------------------------------------------------------------------------
 int KartProperties::getBubblegumFadeInTicks() const
 {
     return stk_config->time2Ticks(m_cached_characteristic
-                                  ->getBubblegumFadeInTime());
+                                  ->getValues().m_bubblegum_fade_in_time);
 }  // getBubblegumFadeInTime
 
-// ----------------------------------------------------------------------------
-float KartProperties::getBubblegumShieldDuration() const
-{
-    return m_cached_characteristic->getBubblegumShieldDuration();
-}  // getBubblegumShieldDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getZipperDuration() const
-{
-    return m_cached_characteristic->getZipperDuration();
-}  // getZipperDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getZipperForce() const
-{
-    return m_cached_characteristic->getZipperForce();
-}  // getZipperForce
-
-// ----------------------------------------------------------------------------
-float KartProperties::getZipperSpeedGain() const
-{
-    return m_cached_characteristic->getZipperSpeedGain();
-}  // getZipperSpeedGain
-
-// ----------------------------------------------------------------------------
-float KartProperties::getZipperMaxSpeedIncrease() const
-{
-    return m_cached_characteristic->getZipperMaxSpeedIncrease();
-}  // getZipperMaxSpeedIncrease
-
-// ----------------------------------------------------------------------------
-float KartProperties::getZipperFadeOutTime() const
-{
-    return m_cached_characteristic->getZipperFadeOutTime();
-}  // getZipperFadeOutTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSwatterDuration() const
-{
-    return m_cached_characteristic->getSwatterDuration();
-}  // getSwatterDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSwatterDistance() const
-{
-    return m_cached_characteristic->getSwatterDistance();
-}  // getSwatterDistance
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSwatterSquashDuration() const
-{
-    return m_cached_characteristic->getSwatterSquashDuration();
-}  // getSwatterSquashDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSwatterSquashSlowdown() const
-{
-    return m_cached_characteristic->getSwatterSquashSlowdown();
-}  // getSwatterSquashSlowdown
-
-// ----------------------------------------------------------------------------
-float KartProperties::getPlungerBandMaxLength() const
-{
-    return m_cached_characteristic->getPlungerBandMaxLength();
-}  // getPlungerBandMaxLength
-
-// ----------------------------------------------------------------------------
-float KartProperties::getPlungerBandForce() const
-{
-    return m_cached_characteristic->getPlungerBandForce();
-}  // getPlungerBandForce
-
-// ----------------------------------------------------------------------------
-float KartProperties::getPlungerBandDuration() const
-{
-    return m_cached_characteristic->getPlungerBandDuration();
-}  // getPlungerBandDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getPlungerBandSpeedIncrease() const
-{
-    return m_cached_characteristic->getPlungerBandSpeedIncrease();
-}  // getPlungerBandSpeedIncrease
-
 // ----------------------------------------------------------------------------
 int KartProperties::getPlungerBandFadeOutTicks() const
 {
     return stk_config->time2Ticks(m_cached_characteristic
-                                   ->getPlungerBandFadeOutTime());
+                                   ->getValues().m_plunger_band_fade_out_time);
 }  // getPlungerBandFadeOutTime
 
-// ----------------------------------------------------------------------------
-float KartProperties::getPlungerInFaceTime() const
-{
-    return m_cached_characteristic->getPlungerInFaceTime();
-}  // getPlungerInFaceTime
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getStartupTime() const
-{
-    return m_cached_characteristic->getStartupTime();
-}  // getStartupTime
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getStartupBoost() const
-{
-    return m_cached_characteristic->getStartupBoost();
-}  // getStartupBoost
-
-// ----------------------------------------------------------------------------
-float KartProperties::getRescueDuration() const
-{
-    return m_cached_characteristic->getRescueDuration();
-}  // getRescueDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getRescueVertOffset() const
-{
-    return m_cached_characteristic->getRescueVertOffset();
-}  // getRescueVertOffset
-
-// ----------------------------------------------------------------------------
-float KartProperties::getRescueHeight() const
-{
-    return m_cached_characteristic->getRescueHeight();
-}  // getRescueHeight
-
-// ----------------------------------------------------------------------------
-float KartProperties::getExplosionDuration() const
-{
-    return m_cached_characteristic->getExplosionDuration();
-}  // getExplosionDuration
-
-// ----------------------------------------------------------------------------
-float KartProperties::getExplosionRadius() const
-{
-    return m_cached_characteristic->getExplosionRadius();
-}  // getExplosionRadius
-
-// ----------------------------------------------------------------------------
-float KartProperties::getExplosionInvulnerabilityTime() const
-{
-    return m_cached_characteristic->getExplosionInvulnerabilityTime();
-}  // getExplosionInvulnerabilityTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroDuration() const
-{
-    return m_cached_characteristic->getNitroDuration();
-}  // getNitroDuration
-
-// ------------------------------------------------------------------------
-float KartProperties::getNitroEngineForce() const
-{
-    return m_cached_characteristic->getNitroEngineForce();
-}  // getNitroEngineForce
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroEngineMult() const
-{
-    return m_cached_characteristic->getNitroEngineMult();
-}  // getNitroEngineMult
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroConsumption() const
-{
-    return m_cached_characteristic->getNitroConsumption();
-}  // getNitroConsumption
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroSmallContainer() const
-{
-    return m_cached_characteristic->getNitroSmallContainer();
-}  // getNitroSmallContainer
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroBigContainer() const
-{
-    return m_cached_characteristic->getNitroBigContainer();
-}  // getNitroBigContainer
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroMaxSpeedIncrease() const
-{
-    return m_cached_characteristic->getNitroMaxSpeedIncrease();
-}  // getNitroMaxSpeedIncrease
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroFadeOutTime() const
-{
-    return m_cached_characteristic->getNitroFadeOutTime();
-}  // getNitroFadeOutTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getNitroMax() const
-{
-    return m_cached_characteristic->getNitroMax();
-}  // getNitroMax
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamDurationFactor() const
-{
-    return m_cached_characteristic->getSlipstreamDurationFactor();
-}  // getSlipstreamDurationFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamBaseSpeed() const
-{
-    return m_cached_characteristic->getSlipstreamBaseSpeed();
-}  // getSlipstreamBaseSpeed
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamLength() const
-{
-    return m_cached_characteristic->getSlipstreamLength();
-}  // getSlipstreamLength
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamWidth() const
-{
-    return m_cached_characteristic->getSlipstreamWidth();
-}  // getSlipstreamWidth
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamInnerFactor() const
-{
-    return m_cached_characteristic->getSlipstreamInnerFactor();
-}  // getSlipstreamInnerFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamMinCollectTime() const
-{
-    return m_cached_characteristic->getSlipstreamMinCollectTime();
-}  // getSlipstreamMinCollectTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamMaxCollectTime() const
-{
-    return m_cached_characteristic->getSlipstreamMaxCollectTime();
-}  // getSlipstreamMaxCollectTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamAddPower() const
-{
-    return m_cached_characteristic->getSlipstreamAddPower();
-}  // getSlipstreamAddPower
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamMinSpeed() const
-{
-    return m_cached_characteristic->getSlipstreamMinSpeed();
-}  // getSlipstreamMinSpeed
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSlipstreamMaxSpeedIncrease() const
-{
-    return m_cached_characteristic->getSlipstreamMaxSpeedIncrease();
-}  // getSlipstreamMaxSpeedIncrease
-
 // ----------------------------------------------------------------------------
 int KartProperties::getSlipstreamFadeOutTicks() const
 {
     return stk_config->time2Ticks(m_cached_characteristic
-                                  ->getSlipstreamFadeOutTime());
+                                  ->getValues().m_slipstream_fade_out_time);
 }  // getSlipstreamFadeOutTime
 
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidIncrease() const
-{
-    return m_cached_characteristic->getSkidIncrease();
-}  // getSkidIncrease
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidDecrease() const
-{
-    return m_cached_characteristic->getSkidDecrease();
-}  // getSkidDecrease
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidMax() const
-{
-    return m_cached_characteristic->getSkidMax();
-}  // getSkidMax
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidTimeTillMax() const
-{
-    return m_cached_characteristic->getSkidTimeTillMax();
-}  // getSkidTimeTillMax
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidVisual() const
-{
-    return m_cached_characteristic->getSkidVisual();
-}  // getSkidVisual
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidVisualTime() const
-{
-    return m_cached_characteristic->getSkidVisualTime();
-}  // getSkidVisualTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidRevertVisualTime() const
-{
-    return m_cached_characteristic->getSkidRevertVisualTime();
-}  // getSkidRevertVisualTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidMinSpeed() const
-{
-    return m_cached_characteristic->getSkidMinSpeed();
-}  // getSkidMinSpeed
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getSkidTimeTillBonus() const
-{
-    return m_cached_characteristic->getSkidTimeTillBonus();
-}  // getSkidTimeTillBonus
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getSkidBonusSpeed() const
-{
-    return m_cached_characteristic->getSkidBonusSpeed();
-}  // getSkidBonusSpeed
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getSkidBonusTime() const
-{
-    return m_cached_characteristic->getSkidBonusTime();
-}  // getSkidBonusTime
-
-// ----------------------------------------------------------------------------
-std::vector<float> KartProperties::getSkidBonusForce() const
-{
-    return m_cached_characteristic->getSkidBonusForce();
-}  // getSkidBonusForce
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidPhysicalJumpTime() const
-{
-    return m_cached_characteristic->getSkidPhysicalJumpTime();
-}  // getSkidPhysicalJumpTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidGraphicalJumpTime() const
-{
-    return m_cached_characteristic->getSkidGraphicalJumpTime();
-}  // getSkidGraphicalJumpTime
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidPostSkidRotateFactor() const
-{
-    return m_cached_characteristic->getSkidPostSkidRotateFactor();
-}  // getSkidPostSkidRotateFactor
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidReduceTurnMin() const
-{
-    return m_cached_characteristic->getSkidReduceTurnMin();
-}  // getSkidReduceTurnMin
-
-// ----------------------------------------------------------------------------
-float KartProperties::getSkidReduceTurnMax() const
-{
-    return m_cached_characteristic->getSkidReduceTurnMax();
-}  // getSkidReduceTurnMax
-
-// ----------------------------------------------------------------------------
-bool KartProperties::getSkidEnabled() const
-{
-    return m_cached_characteristic->getSkidEnabled();
-}  // getSkidEnabled
-
-/* <characteristics-end kpgetter> */
 
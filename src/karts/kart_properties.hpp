@@ -33,13 +33,13 @@ using namespace irr;
 
 #include "audio/sfx_manager.hpp"
 #include "io/xml_node.hpp"
+#include "karts/cached_characteristic.hpp"
 #include "race/race_manager.hpp"
 #include "utils/interpolation_array.hpp"
 #include "utils/vec3.hpp"
 
 class AbstractCharacteristic;
 class AIProperties;
-class CachedCharacteristic;
 class CombinedCharacteristic;
 class KartModel;
 class Material;
@@ -378,137 +378,244 @@ public:
     // To update the code, use tools/update_characteristics.py
     /* <characteristics-start kpdefs> */
 
-    float getSuspensionStiffness() const;
-    float getSuspensionRest() const;
-    float getSuspensionTravel() const;
-    bool getSuspensionExpSpringResponse() const;
-    float getSuspensionMaxForce() const;
-
-    float getStabilityRollInfluence() const;
-    float getStabilityChassisLinearDamping() const;
-    float getStabilityChassisAngularDamping() const;
-    float getStabilityDownwardImpulseFactor() const;
-    float getStabilityTrackConnectionAccel() const;
-    std::vector<float> getStabilityAngularFactor() const;
-    float getStabilitySmoothFlyingImpulse() const;
-
-    InterpolationArray getTurnRadius() const;
-    float getTurnTimeResetSteer() const;
-    InterpolationArray getTurnTimeFullSteer() const;
-
-    float getEnginePower() const;
-    float getEngineMaxSpeed() const;
-    float getEngineGenericMaxSpeed() const;
-    float getEngineBrakeFactor() const;
-    float getEngineBrakeTimeIncrease() const;
-    float getEngineMaxSpeedReverseRatio() const;
-
-    std::vector<float> getGearSwitchRatio() const;
-    std::vector<float> getGearPowerIncrease() const;
-
-    float getMass() const;
-
-    float getWheelsDampingRelaxation() const;
-    float getWheelsDampingCompression() const;
-
-    float getCameraDistance() const;
-    float getCameraForwardUpAngle() const;
-    float getCameraBackwardUpAngle() const;
-
-    float getJumpAnimationTime() const;
-
-    float getLeanMax() const;
-    float getLeanSpeed() const;
-
-    float getAnvilDuration() const;
-    float getAnvilWeight() const;
-    float getAnvilSpeedFactor() const;
-
-    float getParachuteFriction() const;
-    int   getParachuteDuration() const;
-    int   getParachuteDurationOther() const;
-    float getParachuteDurationRankMult() const;
-    float getParachuteDurationSpeedMult() const;
-    float getParachuteLboundFraction() const;
-    float getParachuteUboundFraction() const;
-    float getParachuteMaxSpeed() const;
-
-    float getFrictionKartFriction() const;
-
-    float getBubblegumDuration() const;
-    float getBubblegumSpeedFraction() const;
-    float getBubblegumTorque() const;
+    float getSuspensionStiffness() const
+        { return m_cached_characteristic->getValues().m_suspension_stiffness; }
+    float getSuspensionRest() const
+        { return m_cached_characteristic->getValues().m_suspension_rest; }
+    float getSuspensionTravel() const
+        { return m_cached_characteristic->getValues().m_suspension_travel; }
+    bool getSuspensionExpSpringResponse() const
+        { return m_cached_characteristic->getValues().m_suspension_exp_spring_response; }
+    float getSuspensionMaxForce() const
+        { return m_cached_characteristic->getValues().m_suspension_max_force; }
+
+    float getStabilityRollInfluence() const
+        { return m_cached_characteristic->getValues().m_stability_roll_influence; }
+    float getStabilityChassisLinearDamping() const
+        { return m_cached_characteristic->getValues().m_stability_chassis_linear_damping; }
+    float getStabilityChassisAngularDamping() const
+        { return m_cached_characteristic->getValues().m_stability_chassis_angular_damping; }
+    float getStabilityDownwardImpulseFactor() const
+        { return m_cached_characteristic->getValues().m_stability_downward_impulse_factor; }
+    float getStabilityTrackConnectionAccel() const
+        { return m_cached_characteristic->getValues().m_stability_track_connection_accel; }
+    const std::vector<float>& getStabilityAngularFactor() const
+        { return m_cached_characteristic->getValues().m_stability_angular_factor; }
+    float getStabilitySmoothFlyingImpulse() const
+        { return m_cached_characteristic->getValues().m_stability_smooth_flying_impulse; }
+
+    const InterpolationArray& getTurnRadius() const
+        { return m_cached_characteristic->getValues().m_turn_radius; }
+    float getTurnTimeResetSteer() const
+        { return m_cached_characteristic->getValues().m_turn_time_reset_steer; }
+    const InterpolationArray& getTurnTimeFullSteer() const
+        { return m_cached_characteristic->getValues().m_turn_time_full_steer; }
+
+    float getEnginePower() const
+        { return m_cached_characteristic->getValues().m_engine_power; }
+    float getEngineMaxSpeed() const
+        { return m_cached_characteristic->getValues().m_engine_max_speed; }
+    float getEngineGenericMaxSpeed() const
+        { return m_cached_characteristic->getValues().m_engine_generic_max_speed; }
+    float getEngineBrakeFactor() const
+        { return m_cached_characteristic->getValues().m_engine_brake_factor; }
+    float getEngineBrakeTimeIncrease() const
+        { return m_cached_characteristic->getValues().m_engine_brake_time_increase; }
+    float getEngineMaxSpeedReverseRatio() const
+        { return m_cached_characteristic->getValues().m_engine_max_speed_reverse_ratio; }
+
+    const std::vector<float>& getGearSwitchRatio() const
+        { return m_cached_characteristic->getValues().m_gear_switch_ratio; }
+    const std::vector<float>& getGearPowerIncrease() const
+        { return m_cached_characteristic->getValues().m_gear_power_increase; }
+
+    float getMass() const
+        { return m_cached_characteristic->getValues().m_mass; }
+
+    float getWheelsDampingRelaxation() const
+        { return m_cached_characteristic->getValues().m_wheels_damping_relaxation; }
+    float getWheelsDampingCompression() const
+        { return m_cached_characteristic->getValues().m_wheels_damping_compression; }
+
+    float getCameraDistance() const
+        { return m_cached_characteristic->getValues().m_camera_distance; }
+    float getCameraForwardUpAngle() const
+        { return m_cached_characteristic->getValues().m_camera_forward_up_angle; }
+    float getCameraBackwardUpAngle() const
+        { return m_cached_characteristic->getValues().m_camera_backward_up_angle; }
+
+    float getJumpAnimationTime() const
+        { return m_cached_characteristic->getValues().m_jump_animation_time; }
+
+    float getLeanMax() const
+        { return m_cached_characteristic->getValues().m_lean_max; }
+    float getLeanSpeed() const
+        { return m_cached_characteristic->getValues().m_lean_speed; }
+
+    float getAnvilDuration() const
+        { return m_cached_characteristic->getValues().m_anvil_duration; }
+    float getAnvilWeight() const
+        { return m_cached_characteristic->getValues().m_anvil_weight; }
+    float getAnvilSpeedFactor() const
+        { return m_cached_characteristic->getValues().m_anvil_speed_factor; }
+
+    float getParachuteFriction() const
+        { return m_cached_characteristic->getValues().m_parachute_friction; }
+    int getParachuteDuration() const
+        { return m_cached_characteristic->getValues().m_parachute_duration; }
+    int getParachuteDurationOther() const
+        { return m_cached_characteristic->getValues().m_parachute_duration_other; }
+    float getParachuteDurationRankMult() const
+        { return m_cached_characteristic->getValues().m_parachute_duration_rank_mult; }
+    float getParachuteDurationSpeedMult() const
+        { return m_cached_characteristic->getValues().m_parachute_duration_speed_mult; }
+    float getParachuteLboundFraction() const
+        { return m_cached_characteristic->getValues().m_parachute_lbound_fraction; }
+    float getParachuteUboundFraction() const
+        { return m_cached_characteristic->getValues().m_parachute_ubound_fraction; }
+    float getParachuteMaxSpeed() const
+        { return m_cached_characteristic->getValues().m_parachute_max_speed; }
+
+    float getFrictionKartFriction() const
+        { return m_cached_characteristic->getValues().m_friction_kart_friction; }
+
+    float getBubblegumDuration() const
+        { return m_cached_characteristic->getValues().m_bubblegum_duration; }
+    float getBubblegumSpeedFraction() const
+        { return m_cached_characteristic->getValues().m_bubblegum_speed_fraction; }
+    float getBubblegumTorque() const
+        { return m_cached_characteristic->getValues().m_bubblegum_torque; }
     int   getBubblegumFadeInTicks() const;
-    float getBubblegumShieldDuration() const;
-
-    float getZipperDuration() const;
-    float getZipperForce() const;
-    float getZipperSpeedGain() const;
-    float getZipperMaxSpeedIncrease() const;
-    float getZipperFadeOutTime() const;
-
-    float getSwatterDuration() const;
-    float getSwatterDistance() const;
-    float getSwatterSquashDuration() const;
-    float getSwatterSquashSlowdown() const;
-
-    float getPlungerBandMaxLength() const;
-    float getPlungerBandForce() const;
-    float getPlungerBandDuration() const;
-    float getPlungerBandSpeedIncrease() const;
+    float getBubblegumShieldDuration() const
+        { return m_cached_characteristic->getValues().m_bubblegum_shield_duration; }
+
+    float getZipperDuration() const
+        { return m_cached_characteristic->getValues().m_zipper_duration; }
+    float getZipperForce() const
+        { return m_cached_characteristic->getValues().m_zipper_force; }
+    float getZipperSpeedGain() const
+        { return m_cached_characteristic->getValues().m_zipper_speed_gain; }
+    float getZipperMaxSpeedIncrease() const
+        { return m_cached_characteristic->getValues().m_zipper_max_speed_increase; }
+    float getZipperFadeOutTime() const
+        { return m_cached_characteristic->getValues().m_zipper_fade_out_time; }
+
+    float getSwatterDuration() const
+        { return m_cached_characteristic->getValues().m_swatter_duration; }
+    float getSwatterDistance() const
+        { return m_cached_characteristic->getValues().m_swatter_distance; }
+    float getSwatterSquashDuration() const
+        { return m_cached_characteristic->getValues().m_swatter_squash_duration; }
+    float getSwatterSquashSlowdown() const
+        { return m_cached_characteristic->getValues().m_swatter_squash_slowdown; }
+
+    float getPlungerBandMaxLength() const
+        { return m_cached_characteristic->getValues().m_plunger_band_max_length; }
+    float getPlungerBandForce() const
+        { return m_cached_characteristic->getValues().m_plunger_band_force; }
+    float getPlungerBandDuration() const
+        { return m_cached_characteristic->getValues().m_plunger_band_duration; }
+    float getPlungerBandSpeedIncrease() const
+        { return m_cached_characteristic->getValues().m_plunger_band_speed_increase; }
     int   getPlungerBandFadeOutTicks() const;
-    float getPlungerInFaceTime() const;
-
-    std::vector<float> getStartupTime() const;
-    std::vector<float> getStartupBoost() const;
-
-    float getRescueDuration() const;
-    float getRescueVertOffset() const;
-    float getRescueHeight() const;
-
-    float getExplosionDuration() const;
-    float getExplosionRadius() const;
-    float getExplosionInvulnerabilityTime() const;
-
-    float getNitroDuration() const;
-    float getNitroEngineForce() const;
-    float getNitroEngineMult() const;
-    float getNitroConsumption() const;
-    float getNitroSmallContainer() const;
-    float getNitroBigContainer() const;
-    float getNitroMaxSpeedIncrease() const;
-    float getNitroFadeOutTime() const;
-    float getNitroMax() const;
-    float getSlipstreamDurationFactor() const;
-    float getSlipstreamBaseSpeed() const;
-    float getSlipstreamLength() const;
-    float getSlipstreamWidth() const;
-    float getSlipstreamInnerFactor() const;
-    float getSlipstreamMinCollectTime() const;
-    float getSlipstreamMaxCollectTime() const;
-    float getSlipstreamAddPower() const;
-    float getSlipstreamMinSpeed() const;
-    float getSlipstreamMaxSpeedIncrease() const;
+    float getPlungerInFaceTime() const
+        { return m_cached_characteristic->getValues().m_plunger_in_face_time; }
+
+    const std::vector<float>& getStartupTime() const
+        { return m_cached_characteristic->getValues().m_startup_time; }
+    const std::vector<float>& getStartupBoost() const
+        { return m_cached_characteristic->getValues().m_startup_boost; }
+
+    float getRescueDuration() const
+        { return m_cached_characteristic->getValues().m_rescue_duration; }
+    float getRescueVertOffset() const
+        { return m_cached_characteristic->getValues().m_rescue_vert_offset; }
+    float getRescueHeight() const
+        { return m_cached_characteristic->getValues().m_rescue_height; }
+
+    float getExplosionDuration() const
+        { return m_cached_characteristic->getValues().m_explosion_duration; }
+    float getExplosionRadius() const
+        { return m_cached_characteristic->getValues().m_explosion_radius; }
+    float getExplosionInvulnerabilityTime() const
+        { return m_cached_characteristic->getValues().m_explosion_invulnerability_time; }
+
+    float getNitroDuration() const
+        { return m_cached_characteristic->getValues().m_nitro_duration; }
+    float getNitroEngineForce() const
+        { return m_cached_characteristic->getValues().m_nitro_engine_force; }
+    float getNitroEngineMult() const
+        { return m_cached_characteristic->getValues().m_nitro_engine_mult; }
+    float getNitroConsumption() const
+        { return m_cached_characteristic->getValues().m_nitro_consumption; }
+    float getNitroSmallContainer() const
+        { return m_cached_characteristic->getValues().m_nitro_small_container; }
+    float getNitroBigContainer() const
+        { return m_cached_characteristic->getValues().m_nitro_big_container; }
+    float getNitroMaxSpeedIncrease() const
+        { return m_cached_characteristic->getValues().m_nitro_max_speed_increase; }
+    float getNitroFadeOutTime() const
+        { return m_cached_characteristic->getValues().m_nitro_fade_out_time; }
+    float getNitroMax() const
+        { return m_cached_characteristic->getValues().m_nitro_max; }
+    float getSlipstreamDurationFactor() const
+        { return m_cached_characteristic->getValues().m_slipstream_duration_factor; }
+    float getSlipstreamBaseSpeed() const
+        { return m_cached_characteristic->getValues().m_slipstream_base_speed; }
+    float getSlipstreamLength() const
+        { return m_cached_characteristic->getValues().m_slipstream_length; }
+    float getSlipstreamWidth() const
+        { return m_cached_characteristic->getValues().m_slipstream_width; }
+    float getSlipstreamInnerFactor() const
+        { return m_cached_characteristic->getValues().m_slipstream_inner_factor; }
+    float getSlipstreamMinCollectTime() const
+        { return m_cached_characteristic->getValues().m_slipstream_min_collect_time; }
+    float getSlipstreamMaxCollectTime() const
+        { return m_cached_characteristic->getValues().m_slipstream_max_collect_time; }
+    float getSlipstreamAddPower() const
+        { return m_cached_characteristic->getValues().m_slipstream_add_power; }
+    float getSlipstreamMinSpeed() const
+        { return m_cached_characteristic->getValues().m_slipstream_min_speed; }
+    float getSlipstreamMaxSpeedIncrease() const
+        { return m_cached_characteristic->getValues().m_slipstream_max_speed_increase; }
     int getSlipstreamFadeOutTicks() const;
 
-    float getSkidIncrease() const;
-    float getSkidDecrease() const;
-    float getSkidMax() const;
-    float getSkidTimeTillMax() const;
-    float getSkidVisual() const;
-    float getSkidVisualTime() const;
-    float getSkidRevertVisualTime() const;
-    float getSkidMinSpeed() const;
-    std::vector<float> getSkidTimeTillBonus() const;
-    std::vector<float> getSkidBonusSpeed() const;
-    std::vector<float> getSkidBonusTime() const;
-    std::vector<float> getSkidBonusForce() const;
-    float getSkidPhysicalJumpTime() const;
-    float getSkidGraphicalJumpTime() const;
-    float getSkidPostSkidRotateFactor() const;
-    float getSkidReduceTurnMin() const;
-    float getSkidReduceTurnMax() const;
-    bool getSkidEnabled() const;
+    float getSkidIncrease() const
+        { return m_cached_characteristic->getValues().m_skid_increase; }
+    float getSkidDecrease() const
+        { return m_cached_characteristic->getValues().m_skid_decrease; }
+    float getSkidMax() const
+        { return m_cached_characteristic->getValues().m_skid_max; }
+    float getSkidTimeTillMax() const
+        { return m_cached_characteristic->getValues().m_skid_time_till_max; }
+    float getSkidVisual() const
+        { return m_cached_characteristic->getValues().m_skid_visual; }
+    float getSkidVisualTime() const
+        { return m_cached_characteristic->getValues().m_skid_visual_time; }
+    float getSkidRevertVisualTime() const
+        { return m_cached_characteristic->getValues().m_skid_revert_visual_time; }
+    float getSkidMinSpeed() const
+        { return m_cached_characteristic->getValues().m_skid_min_speed; }
+    const std::vector<float>& getSkidTimeTillBonus() const
+        { return m_cached_characteristic->getValues().m_skid_time_till_bonus; }
+    const std::vector<float>& getSkidBonusSpeed() const
+        { return m_cached_characteristic->getValues().m_skid_bonus_speed; }
+    const std::vector<float>& getSkidBonusTime() const
+        { return m_cached_characteristic->getValues().m_skid_bonus_time; }
+    const std::vector<float>& getSkidBonusForce() const
+        { return m_cached_characteristic->getValues().m_skid_bonus_force; }
+    float getSkidPhysicalJumpTime() const
+        { return m_cached_characteristic->getValues().m_skid_physical_jump_time; }
+    float getSkidGraphicalJumpTime() const
+        { return m_cached_characteristic->getValues().m_skid_graphical_jump_time; }
+    float getSkidPostSkidRotateFactor() const
+        { return m_cached_characteristic->getValues().m_skid_post_skid_rotate_factor; }
+    float getSkidReduceTurnMin() const
+        { return m_cached_characteristic->getValues().m_skid_reduce_turn_min; }
+    float getSkidReduceTurnMax() const
+        { return m_cached_characteristic->getValues().m_skid_reduce_turn_max; }
+    bool getSkidEnabled() const
+        { return m_cached_characteristic->getValues().m_skid_enabled; }
     // ------------------------------------------------------------------------
     /** Returns minimum time during which nitro is consumed when pressing nitro
     *  key, to prevent using nitro in very short bursts
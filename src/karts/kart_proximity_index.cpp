@@ -0,0 +1,382 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "karts/kart_proximity_index.hpp"
+
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include "LinearMath/btTransform.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+/** Removes all karts from the index. */
+void KartProximityIndex::clear()
+{
+    m_entries.clear();
+    m_max_reach = 0.0f;
+    m_ticks = -1;
+}   // clear
+
+// ----------------------------------------------------------------------------
+/** Adds a kart to the index. finalize() must be called after all karts
+ *  were added.
+ *  \param id World id of the kart.
+ *  \param xyz Position of the kart.
+ *  \param reach Distance up to which this kart influences other karts (e.g.
+ *         its slipstream), see getKartsReaching().
+ */
+void KartProximityIndex::addKart(unsigned int id, const Vec3 &xyz,
+                                 float reach)
+{
+    Entry entry;
+    entry.m_id    = id;
+    entry.m_xyz   = xyz;
+    entry.m_reach = std::max(reach, 0.0f);
+    m_entries.push_back(entry);
+    m_max_reach = std::max(m_max_reach, entry.m_reach);
+}   // addKart
+
+// ----------------------------------------------------------------------------
+/** Sorts the karts after all karts were added.
+ *  \param ticks The world ticks for which the index is valid.
+ */
+void KartProximityIndex::finalize(int ticks)
+{
+    std::sort(m_entries.begin(), m_entries.end());
+    m_ticks = ticks;
+}   // finalize
+
+// ----------------------------------------------------------------------------
+/** Returns the first kart with an X coordinate not less than x. */
+std::vector<KartProximityIndex::Entry>::const_iterator
+    KartProximityIndex::lowerBound(float x) const
+{
+    return std::lower_bound(m_entries.begin(), m_entries.end(), x,
+        [](const Entry &e, float x) { return e.m_xyz.getX() < x; });
+}   // lowerBound
+
+// ----------------------------------------------------------------------------
+/** Returns all karts within a distance of a point.
+ *  \param center The point.
+ *  \param radius Maximum distance.
+ *  \param ids Returns the world ids of the karts, sorted by id.
+ */
+void KartProximityIndex::getKartsInRadius(const Vec3 &center, float radius,
+                                          std::vector<unsigned int> *ids)
+                                          const
+{
+    ids->clear();
+    const float max_x = center.getX() + radius;
+    const float radius2 = radius * radius;
+    for (auto it = lowerBound(center.getX() - radius);
+         it != m_entries.end() && it->m_xyz.getX() <= max_x; it++)
+    {
+        if ((it->m_xyz - center).length2() <= radius2)
+            ids->push_back(it->m_id);
+    }
+    std::sort(ids->begin(), ids->end());
+}   // getKartsInRadius
+
+// ----------------------------------------------------------------------------
+/** Returns all karts within a distance of a point, and within a cone
+ *  around a direction.
+ *  \param origin The tip of the cone.
+ *  \param direction The direction of the cone.
+ *  \param min_cos Cosine of the half opening angle of the cone.
+ *  \param radius Maximum distance.
+ *  \param ids Returns the world ids of the karts, sorted by id.
+ */
+void KartProximityIndex::getKartsInCone(const Vec3 &origin,
+                                        const Vec3 &direction, float min_cos,
+                                        float radius,
+                                        std::vector<unsigned int> *ids) const
+{
+    ids->clear();
+    const float max_x = origin.getX() + radius;
+    const float radius2 = radius * radius;
+    const float direction2 = direction.length2();
+    for (auto it = lowerBound(origin.getX() - radius);
+         it != m_entries.end() && it->m_xyz.getX() <= max_x; it++)
+    {
+        Vec3 to_kart = it->m_xyz - origin;
+        if (to_kart.length2() > radius2)
+            continue;
+        // Same as Vec3::angle without acos, a kart at the origin (NaN) is
+        // inside
+        float c = to_kart.dot(direction) /
+            sqrtf(direction2 * to_kart.length2());
+        if (c < min_cos)
+            continue;
+        ids->push_back(it->m_id);
+    }
+    std::sort(ids->begin(), ids->end());
+}   // getKartsInCone
+
+// ----------------------------------------------------------------------------
+/** Returns all karts which reach a point, i.e. the distance between the
+ *  point and the kart is at most the reach of the kart plus extra_reach.
+ *  \param xyz The point.
+ *  \param extra_reach Added to the reach of each kart.
+ *  \param ids Returns the world ids of the karts, sorted by id.
+ */
+void KartProximityIndex::getKartsReaching(const Vec3 &xyz, float extra_reach,
+                                          std::vector<unsigned int> *ids)
+                                          const
+{
+    ids->clear();
+    const float window = m_max_reach + extra_reach;
+    const float max_x = xyz.getX() + window;
+    for (auto it = lowerBound(xyz.getX() - window);
+         it != m_entries.end() && it->m_xyz.getX() <= max_x; it++)
+    {
+        const float reach = it->m_reach + extra_reach;
+        if ((it->m_xyz - xyz).length2() <= reach * reach)
+            ids->push_back(it->m_id);
+    }
+    std::sort(ids->begin(), ids->end());
+}   // getKartsReaching
+
+// ----------------------------------------------------------------------------
+/** Returns the n karts nearest to a point. The karts are tested in order of
+ *  their X distance to the point, so the search stops as soon as the X
+ *  distance alone is larger than the distance of the n-th nearest kart.
+ *  \param center The point.
+ *  \param n Maximum number of karts to return.
+ *  \param ids Returns the world ids of the karts, sorted by distance and
+ *         then by id.
+ *  \param distance2 Optional function which returns the squared distance
+ *         of a kart, or a negative value if the kart should be ignored. It
+ *         must not be less than the squared X distance between the kart and
+ *         the point. By default the squared euclidean distance is used.
+ */
+void KartProximityIndex::getNearestKarts(const Vec3 &center, unsigned int n,
+                           std::vector<unsigned int> *ids,
+                           const std::function<float(unsigned int)> &distance2)
+                           const
+{
+    ids->clear();
+    if (n == 0)
+        return;
+
+    // The nearest karts found so far, sorted by distance and id
+    std::vector<std::pair<float, unsigned int> > nearest;
+    auto left  = lowerBound(center.getX());
+    auto right = left;
+    while (left != m_entries.begin() || right != m_entries.end())
+    {
+        std::vector<Entry>::const_iterator it;
+        if (right == m_entries.end() ||
+            (left != m_entries.begin() &&
+             center.getX() - (left - 1)->m_xyz.getX() <
+             right->m_xyz.getX() - center.getX()))
+        {
+            it = --left;
+        }
+        else
+            it = right++;
+
+        // All remaining karts are further away along X than this one
+        const float dx = it->m_xyz.getX() - center.getX();
+        if (nearest.size() == n && dx * dx > nearest.back().first)
+            break;
+
+        const float d2 = distance2 ? distance2(it->m_id)
+                                   : (it->m_xyz - center).length2();
+        if (!(d2 >= 0.0f))
+            continue;
+        std::pair<float, unsigned int> candidate(d2, it->m_id);
+        if (nearest.size() == n && !(candidate < nearest.back()))
+            continue;
+        nearest.insert(std::upper_bound(nearest.begin(), nearest.end(),
+                                        candidate), candidate);
+        if (nearest.size() > n)
+            nearest.pop_back();
+    }
+    for (auto &p : nearest)
+        ids->push_back(p.second);
+}   // getNearestKarts
+
+// ----------------------------------------------------------------------------
+/** Compares all queries with testing every kart, and compares the time
+ *  needed for a slipstream like test of all pairs of 30 karts.
+ */
+void KartProximityIndex::unitTesting()
+{
+    const unsigned int num_karts = 30;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> height(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> reach(0.0f, 20.0f);
+
+    for (int test = 0; test < 100; test++)
+    {
+        std::vector<Vec3> xyz;
+        std::vector<float> reaches;
+        KartProximityIndex index;
+        for (unsigned int i = 0; i < num_karts; i++)
+        {
+            // Some karts share the X coordinate to test the ordering by id
+            float x = i % 5 == 0 ? 10.0f : pos(rng);
+            xyz.push_back(Vec3(x, height(rng), pos(rng)));
+            reaches.push_back(reach(rng));
+        }
+        // Add the karts in a random order, the result must not depend on it
+        std::vector<unsigned int> order;
+        for (unsigned int i = 0; i < num_karts; i++)
+            order.push_back(i);
+        std::shuffle(order.begin(), order.end(), rng);
+        for (unsigned int i : order)
+            index.addKart(i, xyz[i], reaches[i]);
+        index.finalize(test);
+        if (!index.isValid(test) || index.isValid(test + 1))
+            Log::fatal("KartProximityIndex", "Wrong validity of the index.");
+
+        for (int query = 0; query < 20; query++)
+        {
+            Vec3 center(pos(rng), height(rng), pos(rng));
+            if (query % 4 == 0)
+                center = xyz[query % num_karts];
+            const float radius = reach(rng) * 3.0f;
+            Vec3 direction(pos(rng), 0.0f, pos(rng));
+
+            std::vector<unsigned int> expected_radius, expected_cone,
+                                      expected_reaching, ids;
+            unsigned int nearest = 0, nearest_odd = 1;
+            for (unsigned int i = 0; i < num_karts; i++)
+            {
+                Vec3 d = xyz[i] - center;
+                if (d.length2() <= radius * radius)
+                {
+                    expected_radius.push_back(i);
+                    float c = d.dot(direction) /
+                        sqrtf(direction.length2() * d.length2());
+                    if (!(c < 0.54f))
+                        expected_cone.push_back(i);
+                }
+                float r = reaches[i] + 1.0f;
+                if (d.length2() <= r * r)
+                    expected_reaching.push_back(i);
+                if (d.length2() < (xyz[nearest] - center).length2())
+                    nearest = i;
+                if (i % 2 == 1 &&
+                    d.length2() < (xyz[nearest_odd] - center).length2())
+                    nearest_odd = i;
+            }
+            index.getKartsInRadius(center, radius, &ids);
+            if (ids != expected_radius)
+                Log::fatal("KartProximityIndex", "Wrong karts in radius.");
+            index.getKartsInCone(center, direction, 0.54f, radius, &ids);
+            if (ids != expected_cone)
+                Log::fatal("KartProximityIndex", "Wrong karts in cone.");
+            index.getKartsReaching(center, 1.0f, &ids);
+            if (ids != expected_reaching)
+                Log::fatal("KartProximityIndex", "Wrong karts reaching.");
+            index.getNearestKarts(center, 1, &ids);
+            if (ids.size() != 1 || ids[0] != nearest)
+                Log::fatal("KartProximityIndex", "Wrong nearest kart.");
+            index.getNearestKarts(center, 1, &ids, [&](unsigned int id)
+                {
+                    return id % 2 == 1 ? (xyz[id] - center).length2() : -1.0f;
+                });
+            if (ids.size() != 1 || ids[0] != nearest_odd)
+            {
+                Log::fatal("KartProximityIndex",
+                           "Wrong nearest kart with a filter.");
+            }
+            index.getNearestKarts(center, num_karts + 1, &ids);
+            if (ids.size() != num_karts)
+                Log::fatal("KartProximityIndex", "Wrong number of karts.");
+            for (unsigned int i = 1; i < ids.size(); i++)
+            {
+                float d0 = (xyz[ids[i - 1]] - center).length2();
+                float d1 = (xyz[ids[i]] - center).length2();
+                if (d0 > d1 || (d0 == d1 && ids[i - 1] > ids[i]))
+                {
+                    Log::fatal("KartProximityIndex",
+                               "Nearest karts are not sorted.");
+                }
+            }
+            if (ids[0] != nearest)
+                Log::fatal("KartProximityIndex", "Wrong nearest kart.");
+        }
+    }
+
+    // Slipstream like test between all pairs of 30 karts on a 1 km track,
+    // transforming each kart into the frame of every other kart in range
+    std::uniform_real_distribution<float> track(0.0f, 1000.0f);
+    std::vector<btTransform> trans;
+    for (unsigned int i = 0; i < num_karts; i++)
+    {
+        float t = track(rng);
+        trans.push_back(btTransform(btQuaternion(btVector3(0, 1, 0), t),
+            Vec3(t, 0.0f, 10.0f * sinf(t * 0.01f))));
+    }
+    const float range = 15.0f;
+    const int iterations = 2000;
+    float sum_brute = 0.0f, sum_index = 0.0f;
+    double start = StkTime::getRealTime();
+    for (int it = 0; it < iterations; it++)
+    {
+        for (unsigned int i = 0; i < num_karts; i++)
+        {
+            for (unsigned int j = 0; j < num_karts; j++)
+            {
+                if (i == j)
+                    continue;
+                Vec3 lc = trans[j].inverse()(trans[i].getOrigin());
+                if (lc.length2() <= range * range)
+                    sum_brute += lc.getZ();
+            }
+        }
+    }
+    double brute_time = StkTime::getRealTime() - start;
+
+    start = StkTime::getRealTime();
+    std::vector<unsigned int> ids;
+    for (int it = 0; it < iterations; it++)
+    {
+        // The index is rebuilt once per tick
+        KartProximityIndex index;
+        for (unsigned int i = 0; i < num_karts; i++)
+            index.addKart(i, trans[i].getOrigin(), range + 0.1f);
+        index.finalize(it);
+        for (unsigned int i = 0; i < num_karts; i++)
+        {
+            index.getKartsReaching(trans[i].getOrigin(), 0.0f, &ids);
+            for (unsigned int j : ids)
+            {
+                if (i == j)
+                    continue;
+                Vec3 lc = trans[j].inverse()(trans[i].getOrigin());
+                if (lc.length2() <= range * range)
+                    sum_index += lc.getZ();
+            }
+        }
+    }
+    double index_time = StkTime::getRealTime() - start;
+    if (sum_brute != sum_index)
+        Log::fatal("KartProximityIndex", "Different slipstream results.");
+    Log::info("KartProximityIndex", "%d karts, %d ticks: %.2f ms testing all "
+        "pairs, %.2f ms with index.", num_karts, iterations,
+        brute_time * 1000.0, index_time * 1000.0);
+}   // unitTesting
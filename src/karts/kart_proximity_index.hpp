@@ -0,0 +1,99 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_KART_PROXIMITY_INDEX_HPP
+#define HEADER_KART_PROXIMITY_INDEX_HPP
+
+#include "utils/vec3.hpp"
+
+#include <functional>
+#include <vector>
+
+/**
+  * \brief A spatial index of all karts, used to find the karts close to a
+  *  point without testing every kart.
+  *  The karts are sorted along the X axis, so a query only tests the karts
+  *  whose X coordinate is in range. The index is built by the world once
+  *  per tick after the physics update (see World::getKartProximityIndex),
+  *  so it uses the kart positions of the last physics update. All queries
+  *  return world kart ids in a well defined order (by id, or by distance
+  *  and then id), so results do not depend on the order in which karts
+  *  were added, and rewinds replay identically.
+  * \ingroup karts
+  */
+class KartProximityIndex
+{
+private:
+    struct Entry
+    {
+        /** World id of the kart. */
+        unsigned int m_id;
+        /** Position of the kart. */
+        Vec3         m_xyz;
+        /** Distance up to which this kart influences other karts. */
+        float        m_reach;
+        // --------------------------------------------------------------------
+        bool operator<(const Entry &other) const
+        {
+            return m_xyz.getX() < other.m_xyz.getX() ||
+                (m_xyz.getX() == other.m_xyz.getX() && m_id < other.m_id);
+        }
+    };   // struct Entry
+
+    /** All karts sorted by X coordinate, and id for identical X. */
+    std::vector<Entry> m_entries;
+
+    /** Largest reach of all karts. */
+    float m_max_reach;
+
+    /** World ticks for which the index was built, -1 if it is invalid. */
+    int m_ticks;
+
+    std::vector<Entry>::const_iterator lowerBound(float x) const;
+
+public:
+         KartProximityIndex() : m_max_reach(0.0f), m_ticks(-1) {}
+    void clear();
+    void addKart(unsigned int id, const Vec3 &xyz, float reach = 0.0f);
+    void finalize(int ticks);
+    void getKartsInRadius(const Vec3 &center, float radius,
+                          std::vector<unsigned int> *ids) const;
+    void getKartsInCone(const Vec3 &origin, const Vec3 &direction,
+                        float min_cos, float radius,
+                        std::vector<unsigned int> *ids) const;
+    void getKartsReaching(const Vec3 &xyz, float extra_reach,
+                          std::vector<unsigned int> *ids) const;
+    void getNearestKarts(const Vec3 &center, unsigned int n,
+                         std::vector<unsigned int> *ids,
+                         const std::function<float(unsigned int)>
+                             &distance2 = nullptr) const;
+    static void unitTesting();
+    // ------------------------------------------------------------------------
+    /** Marks the index as outdated, e.g. after a rewind moved the karts. */
+    void invalidate()                                       { m_ticks = -1; }
+    // ------------------------------------------------------------------------
+    /** Returns true if the index was built for the given world ticks. */
+    bool isValid(int ticks) const          { return m_ticks >= 0 &&
+                                                    m_ticks == ticks; }
+    // ------------------------------------------------------------------------
+    /** Returns the number of karts in the index. */
+    unsigned int size() const      { return (unsigned int)m_entries.size(); }
+};   // KartProximityIndex
+
+#endif
@@ -159,6 +159,31 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
         return nullptr;
 
     ru->push_back(getUniqueIdentity());
+    return saveKartState(/*local_copy*/false);
+}   // saveState
+
+// ----------------------------------------------------------------------------
+/** Client: saves the predicted state of this kart, which is restored if the
+ *  server skips this kart in the state of the same ticks. Unlike saveState
+ *  the physics values are saved with full precision, and the kart is not
+ *  changed (saveState rounds the values of the body).
+ *  \return The address of the memory buffer with the state, or NULL if
+ *          the kart is eliminated.
+ */
+BareNetworkString* KartRewinder::saveLocalState()
+{
+    if (m_eliminated)
+        return nullptr;
+    return saveKartState(/*local_copy*/true);
+}   // saveLocalState
+
+// ----------------------------------------------------------------------------
+/** Saves the state of this kart, see saveState and saveLocalState.
+ *  \param local_copy If the physics values are saved with full precision
+ *         for a state only used locally.
+ */
+BareNetworkString* KartRewinder::saveKartState(bool local_copy)
+{
     const int MEMSIZE = 17*sizeof(float) + 9+3;
 
     BareNetworkString *buffer = new BareNetworkString(MEMSIZE);
@@ -200,6 +225,8 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
         bool_for_each_data_2 |= (1 << 3);
     if (m_bubblegum_torque_sign)
         bool_for_each_data_2 |= (1 << 4);
+    if (local_copy)
+        bool_for_each_data_2 |= (1 << 5);
     buffer->addUInt8(bool_for_each_data_2);
 
     if (m_bubblegum_ticks > 0)
@@ -220,8 +247,13 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
     }
     else
     {
-        CompressNetworkBody::compress(
-            m_body.get(), m_motion_state.get(), buffer);
+        if (local_copy)
+            CompressNetworkBody::copy(m_body.get(), buffer);
+        else
+        {
+            CompressNetworkBody::compress(
+                m_body.get(), m_motion_state.get(), buffer);
+        }
 
         if (m_vehicle->getTimedRotationTicks() > 0)
         {
@@ -255,7 +287,18 @@ BareNetworkString* KartRewinder::saveState(std::vector<std::string>* ru)
     m_skidding->saveState(buffer);
 
     return buffer;
-}   // saveState
+}   // saveKartState
+
+// ----------------------------------------------------------------------------
+/** Returns the body compressed in saveState, which is only saved if the kart
+ *  is not eliminated and has no kart animation. */
+btRigidBody* KartRewinder::getNetworkBody(btMotionState** ms)
+{
+    if (m_eliminated || m_kart_animation != NULL)
+        return NULL;
+    *ms = m_motion_state.get();
+    return m_body.get();
+}   // getNetworkBody
 
 // ----------------------------------------------------------------------------
 /** Actually rewind to the specified state. 
@@ -267,6 +310,20 @@ void KartRewinder::restoreState(BareNetworkString *buffer, int count)
 {
     m_has_server_state = true;
 
+    // The server skipped this kart because it is far away from the local
+    // karts (see GameProtocol::sendState), use the local prediction
+    if (count == 0)
+    {
+        BareNetworkString* local =
+            RewindManager::get()->getLocalKartState(getUniqueIdentity());
+        if (local)
+        {
+            local->reset();
+            restoreState(local, local->size());
+        }
+        return;
+    }
+
     // 1) Steering and other controls
     // ------------------------------
     getControls().rewindTo(buffer);
@@ -296,6 +353,7 @@ void KartRewinder::restoreState(BareNetworkString *buffer, int count)
     bool read_attachment = ((bool_for_each_data_2 >> 2) & 1) == 1;
     bool read_powerup = ((bool_for_each_data_2 >> 3) & 1) == 1;
     m_bubblegum_torque_sign = ((bool_for_each_data_2 >> 4) & 1) == 1;
+    bool local_copy = ((bool_for_each_data_2 >> 5) & 1) == 1;
 
     if (read_bubblegum)
         m_bubblegum_ticks = buffer->getUInt16();
@@ -367,8 +425,16 @@ void KartRewinder::restoreState(BareNetworkString *buffer, int count)
 
         // Clear any forces applied (like by plunger or bubble gum torque)
         m_body->clearForces();
-        CompressNetworkBody::decompress(
-            buffer, m_body.get(), m_motion_state.get());
+        if (local_copy)
+        {
+            CompressNetworkBody::copyToBody(
+                buffer, m_body.get(), m_motion_state.get());
+        }
+        else
+        {
+            CompressNetworkBody::decompress(
+                buffer, m_body.get(), m_motion_state.get());
+        }
         // Update kart transform in case that there are access to its value
         // before Moveable::update() is called (which updates the transform)
         m_transform = m_body->getWorldTransform();
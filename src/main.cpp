@@ -190,9 +190,14 @@
 #include "graphics/irr_driver.hpp"
 #include "graphics/material_manager.hpp"
 #include "graphics/particle_kind_manager.hpp"
+#include "graphics/particle_simulation.hpp"
 #include "graphics/referee.hpp"
+#include "graphics/render_stats.hpp"
 #include "graphics/sp/sp_base.hpp"
+#include "graphics/sp/sp_culling.hpp"
+#include "graphics/sp/sp_mesh_node.hpp"
 #include "graphics/sp/sp_shader.hpp"
+#include "graphics/sp/sp_texture_manager.hpp"
 #include "guiengine/engine.hpp"
 #include "guiengine/event_handler.hpp"
 #include "guiengine/dialog_queue.hpp"
@@ -200,15 +205,18 @@
 #include "input/input_manager.hpp"
 #include "input/keyboard_device.hpp"
 #include "input/wiimote_manager.hpp"
+#include "io/cache_archive.hpp"
 #include "io/file_manager.hpp"
 #include "items/attachment_manager.hpp"
 #include "items/item_manager.hpp"
 #include "items/network_item_manager.hpp"
 #include "items/powerup_manager.hpp"
 #include "items/projectile_manager.hpp"
+#include "karts/cached_characteristic.hpp"
 #include "karts/combined_characteristic.hpp"
 #include "karts/controller/ai_base_lap_controller.hpp"
 #include "karts/kart_model.hpp"
+#include "karts/kart_proximity_index.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/kart_properties_manager.hpp"
 #include "modes/cutscene_world.hpp"
@@ -216,9 +224,11 @@
 #include "modes/profile_world.hpp"
 #include "network/protocols/connect_to_server.hpp"
 #include "network/protocols/client_lobby.hpp"
+#include "network/protocols/game_protocol.hpp"
 #include "network/protocols/server_lobby.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
+#include "network/packet_statistics.hpp"
 #include "network/rewind_manager.hpp"
 #include "network/rewind_queue.hpp"
 #include "network/server.hpp"
@@ -231,6 +241,7 @@
 #include "race/grand_prix_manager.hpp"
 #include "race/highscore_manager.hpp"
 #include "race/history.hpp"
+#include "race/history_benchmark.hpp"
 #include "race/race_manager.hpp"
 #include "replay/replay_play.hpp"
 #include "replay/replay_recorder.hpp"
@@ -585,9 +596,26 @@ void cmdLineHelp()
                               "laps.\n"
     "       --profile-time=n   Enable automatic driven profile mode for n "
                               "seconds.\n"
+    "       --render-stats=f   Record LOD, culling and instancing statistics of\n"
+    "                          each frame in profile mode, and write them to\n"
+    "                          f.csv and f.json at the end of the race.\n"
     "       --unlock-all       Permanently unlock all karts and tracks for testing.\n"
     "       --no-unlock-all    Disable unlock-all (i.e. base unlocking on player achievement).\n"
     "       --no-graphics      Do not display the actual race.\n"
+    "       --history-benchmark=f1,f2 Replay the history files without graphics as fast as\n"
+    "                          possible, report the cost per tick of the subsystems and\n"
+    "                          check that the replays are deterministic.\n"
+    "       --benchmark-runs=n Replay each history file n times (default 2).\n"
+    "       --benchmark-physics-threads=n1,n2 Repeat the replays with each number of\n"
+    "                          physics threads.\n"
+    "       --texture-benchmark=dir Compress all textures in dir with and without\n"
+    "                          splitting large textures over all loading threads.\n"
+    "       --particle-benchmark Simulate weather, nitro and skidding particles on the\n"
+    "                          CPU with and without SIMD and render threads.\n"
+    "       --cull-benchmark   Cull a large scene against the camera and shadow\n"
+    "                          frustums with and without SIMD and render threads.\n"
+    "       --physics-threads=n Number of threads used in physics, 0 and 1 use no\n"
+    "                          additional thread.\n"
     "       --sp-shader-debug  Enables debug in sp shader, it will print all unavailable uniforms.\n"
     "       --demo-mode=t      Enables demo mode after t seconds of idle time in "
                                "main menu.\n"
@@ -935,6 +963,7 @@ int handleCmdLinePreliminary()
     if (CommandLine::has("--seed", &n))
     {
         srand(n);
+        HistoryBenchmark::setSeed(n);
         Log::info("main", "STK using random seed (%d)", n);
     }
 
@@ -1578,6 +1607,46 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
         race_manager->setNumLaps(999999); // profile end depends on time
     }   // --profile-time
 
+    if (CommandLine::has("--render-stats", &s))
+    {
+        if (!ProfileWorld::isProfileMode())
+        {
+            Log::warn("main", "--render-stats is only used together with "
+                      "--profile-laps or --profile-time.");
+        }
+        RenderStats::enable(s);
+    }   // --render-stats
+
+    if (CommandLine::has("--benchmark-runs", &n))
+    {
+        if (n < 1)
+        {
+            Log::error("main", "Invalid number of benchmark runs: %i.", n);
+            return 0;
+        }
+        HistoryBenchmark::setNumRuns(n);
+    }   // --benchmark-runs
+
+    if (CommandLine::has("--benchmark-physics-threads", &s))
+    {
+        if (!HistoryBenchmark::setPhysicsThreads(s))
+        {
+            Log::error("main", "Invalid list of physics threads: %s.",
+                       s.c_str());
+            return 0;
+        }
+    }   // --benchmark-physics-threads
+
+    if (CommandLine::has("--physics-threads", &n))
+    {
+        if (n < 0)
+        {
+            Log::error("main", "Invalid number of physics threads: %i.", n);
+            return 0;
+        }
+        UserConfigParams::m_physics_threads = n;
+    }   // --physics-threads
+
     if(CommandLine::has("--history"))
     {
         history->setReplayHistory(true);
@@ -1928,6 +1997,13 @@ int main(int argc, char *argv[] )
         else
             ServerConfig::loadServerConfig();
 
+        if (CommandLine::has("--history-benchmark", &s))
+        {
+            HistoryBenchmark::setHistoryFiles(s);
+            ProfileWorld::disableGraphics();
+            UserConfigParams::m_enable_sound = false;
+        }
+
         if (CommandLine::has("--wan-server", &s))
         {
             if (no_graphics)
@@ -2211,6 +2287,46 @@ int main(int argc, char *argv[] )
         }
 #endif
 
+        // Benchmark replays of recorded races
+        // ===================================
+        if (HistoryBenchmark::isEnabled())
+        {
+            int ret = HistoryBenchmark::run();
+            Log::flushBuffers();
+            exit(ret);
+        }
+
+#ifndef SERVER_ONLY
+        // Benchmark texture compression
+        // =============================
+        if (CommandLine::has("--texture-benchmark", &s))
+        {
+            int ret = SP::SPTextureManager::get()->benchmarkCompression(s);
+            Log::flushBuffers();
+            exit(ret);
+        }
+
+        // Benchmark the CPU particle simulation
+        // =====================================
+        if (CommandLine::has("--particle-benchmark"))
+        {
+            int ret = ParticleSimulation::runBenchmark(
+                irr_driver->getRenderWorkerPool());
+            Log::flushBuffers();
+            exit(ret);
+        }
+
+        // Benchmark the frustum culling
+        // =============================
+        if (CommandLine::has("--cull-benchmark"))
+        {
+            int ret = SP::SPCulling::runBenchmark(
+                irr_driver->getRenderWorkerPool());
+            Log::flushBuffers();
+            exit(ret);
+        }
+#endif
+
         // Replay a race
         // =============
         if(history->replayHistory())
@@ -2436,12 +2552,20 @@ void runUnitTests()
     Log::info("UnitTest", "=====================");
     Log::info("UnitTest", "MiniGLM");
     MiniGLM::unitTesting();
+    Log::info("UnitTest", "SPMeshNode skinning");
+    SP::SPMeshNode::unitTesting();
     Log::info("UnitTest", "GraphicsRestrictions");
     GraphicsRestrictions::unitTesting();
     Log::info("UnitTest", "NetworkString");
     NetworkString::unitTesting();
+    Log::info("UnitTest", "GameProtocol");
+    GameProtocol::unitTesting();
     Log::info("UnitTest", "TransportAddress");
     TransportAddress::unitTesting();
+    Log::info("UnitTest", "PacketStatistics");
+    PacketStatistics::unitTesting();
+    Log::info("UnitTest", "CacheArchive");
+    CacheArchive::unitTesting();
     Log::info("UnitTest", "StringUtils::versionToInt");
     StringUtils::unitTesting();
 
@@ -2481,6 +2605,10 @@ void runUnitTests()
 
     Log::info("UnitTest", "Kart characteristics");
     CombinedCharacteristic::unitTesting();
+    CachedCharacteristic::unitTesting();
+
+    Log::info("UnitTest", "KartProximityIndex");
+    KartProximityIndex::unitTesting();
 
     Log::info("UnitTest", "Arena Graph");
     ArenaGraph::unitTesting();
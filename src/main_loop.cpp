@@ -39,6 +39,7 @@
 #include "network/race_event_manager.hpp"
 #include "network/rewind_manager.hpp"
 #include "network/stk_host.hpp"
+#include "network/tick_budget_monitor.hpp"
 #include "online/request_manager.hpp"
 #include "race/history.hpp"
 #include "race/race_manager.hpp"
@@ -362,10 +363,23 @@ void MainLoop::run()
 
         PROFILER_PUSH_CPU_MARKER("Main loop", 0xFF, 0x00, 0xF7);
 
-        left_over_time += getLimitedDt();
-        int num_steps   = stk_config->time2Ticks(left_over_time);
+        int num_steps;
         float dt = stk_config->ticks2Time(1);
-        left_over_time -= num_steps * dt ;
+        if (NetworkConfig::get()->isServer() &&
+            ProfileWorld::isNoGraphics() && !ProfileWorld::isProfileMode())
+        {
+            // A server without graphics sleeps until the absolute deadline
+            // of the next tick instead of polling the millisecond timer,
+            // which keeps the tick rate steady and the idle cpu usage low
+            m_tick_scheduler.setTickDuration(dt);
+            num_steps = m_tick_scheduler.waitForNextTick();
+        }
+        else
+        {
+            left_over_time += getLimitedDt();
+            num_steps = stk_config->time2Ticks(left_over_time);
+            left_over_time -= num_steps * dt ;
+        }
 
         // Shutdown next frame if shutdown request is sent while loading the
         // world
@@ -498,6 +512,13 @@ void MainLoop::run()
                                        World::getWorld()->getTicksSinceStart());
                 }
 
+                // Only ticks with a world count for the tick budget of a
+                // server, the lobby alone is cheap
+                const bool measure_tick = World::getWorld() &&
+                    NetworkConfig::get()->isServer();
+                if (measure_tick)
+                    TickBudgetMonitor::startTick();
+
                 PROFILER_PUSH_CPU_MARKER("Protocol manager update",
                                          0x7F, 0x00, 0x7F);
                 if (auto pm = ProtocolManager::lock())
@@ -513,6 +534,9 @@ void MainLoop::run()
                 }
                 PROFILER_POP_CPU_MARKER();
 
+                if (measure_tick && World::getWorld())
+                    TickBudgetMonitor::endTick();
+
                 // We need to check again because update_race may have requested
                 // the main loop to abort; and it's not a good idea to continue
                 // since the GUI engine is no more to be called then.
@@ -527,6 +551,8 @@ void MainLoop::run()
                     m_frame_before_loading_world = false;
                     m_curr_time = StkTime::getRealTimeMs();
                     left_over_time = 0.0f;
+                    // Don't catch up the ticks missed while loading the world
+                    m_tick_scheduler.restart();
                     break;
                 }
 
@@ -21,6 +21,7 @@
 #define HEADER_MAIN_LOOP_HPP
 
 #include "utils/synchronised.hpp"
+#include "utils/tick_scheduler.hpp"
 #include "utils/types.hpp"
 #include <atomic>
 
@@ -44,6 +45,9 @@ private:
 
     Synchronised<int> m_ticks_adjustment;
 
+    /** Paces the ticks of a server without graphics. */
+    TickScheduler m_tick_scheduler;
+
     uint64_t m_curr_time;
     uint64_t m_prev_time;
     unsigned m_parent_pid;
@@ -65,6 +69,9 @@ public:
     // ------------------------------------------------------------------------
     void setFrameBeforeLoadingWorld()  { m_frame_before_loading_world = true; }
     // ------------------------------------------------------------------------
+    /** Returns the tick scheduler used by a server without graphics. */
+    TickScheduler* getTickScheduler()        { return &m_tick_scheduler; }
+    // ------------------------------------------------------------------------
     void setTicksAdjustment(int ticks)
     {
         m_ticks_adjustment.lock();
@@ -21,6 +21,7 @@
 #include "main_loop.hpp"
 #include "graphics/camera.hpp"
 #include "graphics/irr_driver.hpp"
+#include "graphics/render_stats.hpp"
 #include "karts/kart_with_stats.hpp"
 #include "karts/controller/controller.hpp"
 #include "tracks/track.hpp"
@@ -154,6 +155,10 @@ void ProfileWorld::update(int ticks)
 {
     StandardRace::update(ticks);
 
+    // Drop the render statistics of the frames drawn while the track was
+    // loaded, so that only the race itself is measured.
+    if (m_frame_count == 0)
+        RenderStats::reset();
     m_frame_count++;
     video::IVideoDriver *driver = irr_driver->getVideoDriver();
     io::IAttributes   *attr = irr_driver->getSceneManager()->getParameters();
@@ -217,6 +222,11 @@ void ProfileWorld::enterRaceOverState()
                      (float)m_num_transparent/m_frame_count);
         Log::verbose("profile", "Average # transp. effect nodes: %f",
                      (float)m_num_trans_effect/m_frame_count);
+        if (RenderStats::isEnabled())
+        {
+            RenderStats::printStatistics();
+            RenderStats::write();
+        }
     }
 
     // Print race statistics for each individual kart
@@ -30,6 +30,7 @@
 #include "graphics/material.hpp"
 #include "graphics/material_manager.hpp"
 #include "graphics/render_info.hpp"
+#include "graphics/slip_stream.hpp"
 #include "guiengine/modaldialog.hpp"
 #include "guiengine/screen_keyboard.hpp"
 #include "io/file_manager.hpp"
@@ -78,6 +79,7 @@
 #include "tracks/track_object_manager.hpp"
 #include "utils/constants.hpp"
 #include "utils/profiler.hpp"
+#include "utils/tick_profiler.hpp"
 #include "utils/translation.hpp"
 #include "utils/string_utils.hpp"
 
@@ -315,6 +317,7 @@ void World::initTeamArrows(AbstractKart* k)
 void World::reset(bool restart)
 {
     RewindManager::get()->reset();
+    m_kart_proximity_index.invalidate();
 
     // If m_saved_race_gui is set, it means that the restart was done
     // when the race result gui was being shown. In this case restore the
@@ -851,6 +854,7 @@ void World::moveKartTo(AbstractKart* kart, const btTransform &transform)
     kart->setRotation(pos.getRotation());
 
     kart->getBody()->setCenterOfMassTransform(pos);
+    m_kart_proximity_index.invalidate();
     // The raycast to determine the terrain underneath the kart is done from
     // the centre point of the 4 wheel positions. After a rescue, the wheel
     // positions need to be updated (otherwise the raycast will be done from
@@ -1090,14 +1094,19 @@ void World::update(int ticks)
     WorldStatus::update(ticks);
     PROFILER_POP_CPU_MARKER();
     PROFILER_PUSH_CPU_MARKER("World::update (RewindManager)", 0x20, 0x7F, 0x40);
+    TickProfiler::start(TickProfiler::TP_REWIND);
     RewindManager::get()->update(ticks);
+    TickProfiler::stop(TickProfiler::TP_REWIND);
     PROFILER_POP_CPU_MARKER();
 
     PROFILER_PUSH_CPU_MARKER("World::update (Track object manager)", 0x20, 0x7F, 0x40);
+    TickProfiler::start(TickProfiler::TP_TRACK_OBJECTS);
     Track::getCurrentTrack()->getTrackObjectManager()->update(stk_config->ticks2Time(ticks));
+    TickProfiler::stop(TickProfiler::TP_TRACK_OBJECTS);
     PROFILER_POP_CPU_MARKER();
 
     PROFILER_PUSH_CPU_MARKER("World::update (Kart::upate)", 0x40, 0x7F, 0x00);
+    TickProfiler::start(TickProfiler::TP_KARTS);
 
     // Update all the karts. This in turn will also update the controller,
     // which causes all AI steering commands set. So in the following 
@@ -1113,17 +1122,26 @@ void World::update(int ticks)
         if (isStartPhase())
             m_karts[i]->makeKartRest();
     }
+    TickProfiler::stop(TickProfiler::TP_KARTS);
     PROFILER_POP_CPU_MARKER();
     if(race_manager->isRecordingRace()) ReplayRecorder::get()->update(ticks);
 
     PROFILER_PUSH_CPU_MARKER("World::update (projectiles)", 0xa0, 0x7F, 0x00);
+    TickProfiler::start(TickProfiler::TP_PROJECTILES);
     projectile_manager->update(ticks);
+    TickProfiler::stop(TickProfiler::TP_PROJECTILES);
     PROFILER_POP_CPU_MARKER();
 
     PROFILER_PUSH_CPU_MARKER("World::update (physics)", 0xa0, 0x7F, 0x00);
+    TickProfiler::start(TickProfiler::TP_PHYSICS);
     Physics::getInstance()->update(ticks);
+    TickProfiler::stop(TickProfiler::TP_PHYSICS);
     PROFILER_POP_CPU_MARKER();
 
+    // The karts only move in the physics update, so the index can be used
+    // until the next one (the world time is increased after this function)
+    updateKartProximityIndex(getTicksSinceStart() + ticks);
+
     PROFILER_POP_CPU_MARKER();
 
 #ifdef DEBUG
@@ -1131,6 +1149,36 @@ void World::update(int ticks)
 #endif
 }   // update
 
+// ----------------------------------------------------------------------------
+/** Rebuilds the spatial index of all karts which are not eliminated.
+ *  \param ticks The world ticks for which the index is valid.
+ */
+void World::updateKartProximityIndex(int ticks)
+{
+    m_kart_proximity_index.clear();
+    for (unsigned int i = 0; i < m_karts.size(); i++)
+    {
+        AbstractKart* kart = m_karts[i].get();
+        if (kart->isEliminated())
+            continue;
+        m_kart_proximity_index.addKart(i, kart->getXYZ(),
+            kart->getSlipstream()->getMaxRange());
+    }
+    m_kart_proximity_index.finalize(ticks);
+}   // updateKartProximityIndex
+
+// ----------------------------------------------------------------------------
+/** Returns the spatial index of all karts which are not eliminated. It is
+ *  rebuilt after each physics update, or at the first query after it was
+ *  invalidated (e.g. by a rewind or a reset).
+ */
+const KartProximityIndex& World::getKartProximityIndex()
+{
+    if (!m_kart_proximity_index.isValid(getTicksSinceStart()))
+        updateKartProximityIndex(getTicksSinceStart());
+    return m_kart_proximity_index;
+}   // getKartProximityIndex
+
 // ----------------------------------------------------------------------------
 /** Only updates the track. The order in which the various parts of STK are
  *  updated is quite important (i.e. the track can't be updated as part of
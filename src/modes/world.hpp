@@ -32,6 +32,7 @@
 #include <stdexcept>
 
 #include "graphics/weather.hpp"
+#include "karts/kart_proximity_index.hpp"
 #include "modes/world_status.hpp"
 #include "race/highscores.hpp"
 #include "states_screens/race_gui_base.hpp"
@@ -112,6 +113,9 @@ protected:
     KartList                  m_karts;
     RandomGenerator           m_random;
 
+    /** Spatial index of all karts, rebuilt once per tick. */
+    KartProximityIndex        m_kart_proximity_index;
+
     AbstractKart* m_fastest_kart;
     /** Number of eliminated karts. */
     int         m_eliminated_karts;
@@ -132,6 +136,7 @@ protected:
     bool        m_use_highscores;
 
     void  updateHighscores  (int* best_highscore_rank);
+    void  updateKartProximityIndex(int ticks);
     void  resetAllKarts     ();
     Controller*
           loadAIController  (AbstractKart *kart);
@@ -319,6 +324,12 @@ public:
     /** Returns all karts. */
     const KartList & getKarts() const { return m_karts; }
     // ------------------------------------------------------------------------
+    const KartProximityIndex& getKartProximityIndex();
+    // ------------------------------------------------------------------------
+    /** Rebuilds the kart proximity index at the next query, e.g. after
+     *  karts were moved by a rewind. */
+    void invalidateKartProximityIndex() { m_kart_proximity_index.invalidate(); }
+    // ------------------------------------------------------------------------
     /** Returns the number of currently active (i.e.non-elikminated) karts. */
     unsigned int    getCurrentNumKarts() const { return (int)m_karts.size() -
                                                          m_eliminated_karts; }
@@ -0,0 +1,241 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "network/bit_packer.hpp"
+
+#include "network/network_string.hpp"
+#include "utils/string_utils.hpp"
+
+#include <assert.h>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// ----------------------------------------------------------------------------
+/** Creates a bit writer which appends to the given network string.
+ *  \param bns The network string to append to.
+ */
+BitWriter::BitWriter(BareNetworkString *bns)
+{
+    m_bns      = bns;
+    m_bits     = 0;
+    m_num_bits = 0;
+}   // BitWriter
+
+// ----------------------------------------------------------------------------
+BitWriter::~BitWriter()
+{
+    flush();
+}   // ~BitWriter
+
+// ----------------------------------------------------------------------------
+/** Appends the lowest num_bits of value.
+ *  \param value The value to write.
+ *  \param num_bits Number of bits to write, between 1 and 32.
+ */
+BitWriter& BitWriter::writeBits(uint32_t value, unsigned num_bits)
+{
+    assert(num_bits > 0 && num_bits <= 32);
+    const uint64_t mask = (uint64_t(1) << num_bits) - 1;
+    m_bits = (m_bits << num_bits) | (value & mask);
+    m_num_bits += num_bits;
+    while (m_num_bits >= 8)
+    {
+        m_num_bits -= 8;
+        m_bns->addUInt8(uint8_t(m_bits >> m_num_bits));
+    }
+    return *this;
+}   // writeBits
+
+// ----------------------------------------------------------------------------
+/** Writes an unsigned integer in groups of 7 bits, each followed by a bit
+ *  that indicates if more groups follow. Values below 128 take 8 bits.
+ */
+BitWriter& BitWriter::writeVarUInt(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        writeBits(uint32_t(value & 0x7f) | 0x80, 8);
+        value >>= 7;
+    }
+    return writeBits(uint32_t(value), 8);
+}   // writeVarUInt
+
+// ----------------------------------------------------------------------------
+/** Writes a signed integer with zigzag encoding (0, -1, 1, -2, ...), so
+ *  that values with a small magnitude take few bits.
+ */
+BitWriter& BitWriter::writeVarInt(int64_t value)
+{
+    const uint64_t zigzag = (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+    return writeVarUInt(zigzag);
+}   // writeVarInt
+
+// ----------------------------------------------------------------------------
+/** Writes a float clamped to [min, max] using num_bits bits. The maximum
+ *  error is (max - min) / (2^(num_bits+1) - 2).
+ */
+BitWriter& BitWriter::writeQuantizedFloat(float value, float min, float max,
+                                          unsigned num_bits)
+{
+    assert(max > min);
+    const double steps = double((uint64_t(1) << num_bits) - 1);
+    double f = (double(value) - min) / (double(max) - min);
+    // NaN fails both comparisons and is written as min
+    if (!(f > 0.0))
+        f = 0.0;
+    else if (f > 1.0)
+        f = 1.0;
+    return writeBits(uint32_t(std::floor(f * steps + 0.5)), num_bits);
+}   // writeQuantizedFloat
+
+// ----------------------------------------------------------------------------
+/** Writes the 32 bits of a float, for values that must not be rounded. */
+BitWriter& BitWriter::writeFloat(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return writeBits(bits, 32);
+}   // writeFloat
+
+// ----------------------------------------------------------------------------
+/** Writes the length of a UTF-8 string as variable length integer, followed
+ *  by its bytes. Unlike BareNetworkString::encodeString there is no limit
+ *  of 255 bytes.
+ */
+BitWriter& BitWriter::writeString(const std::string &value)
+{
+    writeVarUInt(value.size());
+    for (unsigned int i = 0; i < value.size(); i++)
+        writeBits(uint8_t(value[i]), 8);
+    return *this;
+}   // writeString
+
+// ----------------------------------------------------------------------------
+/** Writes a wide string as UTF-8 string. */
+BitWriter& BitWriter::writeString(const irr::core::stringw &value)
+{
+    return writeString(StringUtils::wideToUtf8(value));
+}   // writeString
+
+// ----------------------------------------------------------------------------
+/** Pads the bits written so far with zeros to a full byte and appends it
+ *  to the network string.
+ */
+void BitWriter::flush()
+{
+    if (m_num_bits > 0)
+        writeBits(0, 8 - m_num_bits);
+    m_bits = 0;
+}   // flush
+
+// ============================================================================
+/** Creates a bit reader which reads from the current position of the given
+ *  network string.
+ */
+BitReader::BitReader(const BareNetworkString *bns)
+{
+    m_bns      = bns;
+    m_bits     = 0;
+    m_num_bits = 0;
+}   // BitReader
+
+// ----------------------------------------------------------------------------
+/** Reads num_bits bits (between 1 and 32). */
+uint32_t BitReader::readBits(unsigned num_bits)
+{
+    assert(num_bits > 0 && num_bits <= 32);
+    while (m_num_bits < num_bits)
+    {
+        m_bits = (m_bits << 8) | m_bns->getUInt8();
+        m_num_bits += 8;
+    }
+    m_num_bits -= num_bits;
+    const uint64_t mask = (uint64_t(1) << num_bits) - 1;
+    return uint32_t((m_bits >> m_num_bits) & mask);
+}   // readBits
+
+// ----------------------------------------------------------------------------
+/** Reads an integer written by BitWriter::writeVarUInt. */
+uint64_t BitReader::readVarUInt()
+{
+    uint64_t value = 0;
+    // A 64 bit value needs at most 10 groups of 7 bits
+    for (unsigned shift = 0; shift < 70; shift += 7)
+    {
+        const uint32_t group = readBits(8);
+        value |= uint64_t(group & 0x7f) << shift;
+        if ((group & 0x80) == 0)
+            return value;
+    }
+    throw std::out_of_range("readVarUInt too many groups.");
+}   // readVarUInt
+
+// ----------------------------------------------------------------------------
+/** Reads a signed integer written by BitWriter::writeVarInt. */
+int64_t BitReader::readVarInt()
+{
+    const uint64_t zigzag = readVarUInt();
+    return int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+}   // readVarInt
+
+// ----------------------------------------------------------------------------
+/** Reads a float written by BitWriter::writeQuantizedFloat with the same
+ *  range and number of bits.
+ */
+float BitReader::readQuantizedFloat(float min, float max, unsigned num_bits)
+{
+    const double steps = double((uint64_t(1) << num_bits) - 1);
+    const uint32_t q = readBits(num_bits);
+    return float(min + (double(max) - min) * (q / steps));
+}   // readQuantizedFloat
+
+// ----------------------------------------------------------------------------
+/** Reads a float written by BitWriter::writeFloat. */
+float BitReader::readFloat()
+{
+    const uint32_t bits = readBits(32);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}   // readFloat
+
+// ----------------------------------------------------------------------------
+/** Reads a string written by BitWriter::writeString. */
+void BitReader::readString(std::string *out)
+{
+    const uint64_t len = readVarUInt();
+    // Check the length first, a corrupted length must not allocate memory
+    if (len > m_bns->size() + m_num_bits / 8)
+        throw std::out_of_range("readString out of range.");
+    out->resize((size_t)len);
+    for (size_t i = 0; i < (size_t)len; i++)
+        (*out)[i] = char(readBits(8));
+}   // readString
+
+// ----------------------------------------------------------------------------
+/** Reads a UTF-8 string written by BitWriter::writeString and converts it to
+ *  a wide string.
+ */
+void BitReader::readString(irr::core::stringw *out)
+{
+    std::string s;
+    readString(&s);
+    *out = StringUtils::utf8ToWide(s);
+}   // readString
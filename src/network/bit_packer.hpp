@@ -0,0 +1,109 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+/*! \file bit_packer.hpp
+ *  \brief Bit level writer and reader on top of a BareNetworkString, used by
+ *  the compact network codec.
+ */
+
+#ifndef HEADER_BIT_PACKER_HPP
+#define HEADER_BIT_PACKER_HPP
+
+#include "utils/types.hpp"
+
+#include "irrString.h"
+
+#include <string>
+
+class BareNetworkString;
+
+/** \brief Appends values with an arbitrary number of bits to a network
+ *  string. Besides raw bit fields it supports variable length integers
+ *  (7 bit groups with a continuation bit), zigzag encoded signed integers,
+ *  floats quantized to a fixed range and UTF-8 strings with a variable
+ *  length prefix. Bits are written most significant bit first, and the last
+ *  byte is padded with zeros by flush(), which is also called by the
+ *  destructor. Afterwards normal (byte aligned) values can be appended to
+ *  the network string again.
+ *  \ingroup network
+ */
+class BitWriter
+{
+private:
+    /** The network string the bytes are appended to. */
+    BareNetworkString *m_bns;
+
+    /** Bits which have not been written to the network string yet. Only
+     *  the lowest m_num_bits are valid. */
+    uint64_t m_bits;
+
+    /** Number of valid bits in m_bits, always less than 8 between calls. */
+    unsigned m_num_bits;
+
+public:
+             BitWriter(BareNetworkString *bns);
+            ~BitWriter();
+    BitWriter& writeBits(uint32_t value, unsigned num_bits);
+    BitWriter& writeVarUInt(uint64_t value);
+    BitWriter& writeVarInt(int64_t value);
+    BitWriter& writeQuantizedFloat(float value, float min, float max,
+                                   unsigned num_bits);
+    BitWriter& writeFloat(float value);
+    BitWriter& writeString(const std::string &value);
+    BitWriter& writeString(const irr::core::stringw &value);
+    void flush();
+    // ------------------------------------------------------------------------
+    BitWriter& writeBool(bool value)      { return writeBits(value ? 1 : 0, 1); }
+};   // class BitWriter
+
+// ============================================================================
+/** \brief Reads values written by a BitWriter from a network string. Bytes
+ *  are only taken from the network string when they are needed, so after
+ *  the last bit field has been read, the network string is positioned at
+ *  the first byte after the (padded) bit fields. Reading past the end of
+ *  the network string throws std::out_of_range, like the byte aligned
+ *  getters of BareNetworkString.
+ *  \ingroup network
+ */
+class BitReader
+{
+private:
+    /** The network string the bytes are read from. */
+    const BareNetworkString *m_bns;
+
+    /** Bits read from the network string, but not consumed yet. */
+    uint64_t m_bits;
+
+    /** Number of valid bits in m_bits. */
+    unsigned m_num_bits;
+
+public:
+             BitReader(const BareNetworkString *bns);
+    uint32_t readBits(unsigned num_bits);
+    uint64_t readVarUInt();
+    int64_t  readVarInt();
+    float    readQuantizedFloat(float min, float max, unsigned num_bits);
+    float    readFloat();
+    void     readString(std::string *out);
+    void     readString(irr::core::stringw *out);
+    // ------------------------------------------------------------------------
+    bool readBool()                            { return readBits(1) != 0; }
+};   // class BitReader
+
+#endif
@@ -0,0 +1,127 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/compress_network_body.hpp"
+
+#include <cstring>
+
+namespace CompressNetworkBody
+{
+    /** The batch prepared by prepareBatch, whose bodies are written by
+     *  compress without compressing them again. */
+    static Batch* g_prepared = NULL;
+
+    // ------------------------------------------------------------------------
+    /** Compresses the transformations and velocities of all bodies of a
+     *  batch in one pass, using the batched (SIMD) conversions of MiniGLM,
+     *  and sets the rounded values in the bodies like compress does. The
+     *  result is identical to calling compress for each body.
+     */
+    void compressBatch(Batch* batch)
+    {
+        const size_t n = batch->m_bodies.size();
+        assert(batch->m_motion_states.size() == n);
+        batch->m_compressed.resize(n);
+        batch->m_rotations.resize(n);
+        batch->m_compressed_q.resize(n);
+        batch->m_velocities.resize(n * 6);
+        batch->m_half_velocities.resize(n * 6);
+        CompressedBody* out = batch->m_compressed.data();
+        for (size_t i = 0; i < n; i++)
+        {
+            const btRigidBody* body = batch->m_bodies[i];
+            const btTransform& trans = body->getWorldTransform();
+            out[i].m_x = trans.getOrigin().x();
+            out[i].m_y = trans.getOrigin().y();
+            out[i].m_z = trans.getOrigin().z();
+            batch->m_rotations[i] = trans.getRotation();
+            const btVector3& lv = body->getLinearVelocity();
+            const btVector3& av = body->getAngularVelocity();
+            float* v = &batch->m_velocities[i * 6];
+            v[0] = lv.x(); v[1] = lv.y(); v[2] = lv.z();
+            v[3] = av.x(); v[4] = av.y(); v[5] = av.z();
+        }
+        compressQuaternionBatch(batch->m_rotations.data(),
+                                batch->m_compressed_q.data(), n);
+        toFloat16Batch(batch->m_velocities.data(),
+                       batch->m_half_velocities.data(), n * 6);
+        // Set the rounded values, identical to setCompressedValues
+        toFloat32Batch(batch->m_half_velocities.data(),
+                       batch->m_velocities.data(), n * 6);
+        for (size_t i = 0; i < n; i++)
+        {
+            out[i].m_compressed_q = batch->m_compressed_q[i];
+            memcpy(out[i].m_velocity, &batch->m_half_velocities[i * 6],
+                   sizeof(out[i].m_velocity));
+            btTransform trans;
+            trans.setOrigin(btVector3(out[i].m_x, out[i].m_y, out[i].m_z));
+            trans.setRotation(decompressbtQuaternion(out[i].m_compressed_q));
+            const float* v = &batch->m_velocities[i * 6];
+            setBodyValues(trans, btVector3(v[0], v[1], v[2]),
+                btVector3(v[3], v[4], v[5]), batch->m_bodies[i],
+                batch->m_motion_states[i]);
+        }
+    }   // compressBatch
+
+    // ------------------------------------------------------------------------
+    /** Compresses all bodies that will be saved in the next state in one
+     *  batch. The following calls of compress with a network string for
+     *  these bodies then only write the prepared values, until
+     *  clearPreparedBatch is called. The batch must stay alive until then.
+     */
+    void prepareBatch(Batch* batch)
+    {
+        compressBatch(batch);
+        batch->m_next = 0;
+        g_prepared = batch;
+    }   // prepareBatch
+
+    // ------------------------------------------------------------------------
+    void clearPreparedBatch()
+    {
+        g_prepared = NULL;
+    }   // clearPreparedBatch
+
+    // ------------------------------------------------------------------------
+    /** Returns the values prepared for a body, or NULL if the body is not
+     *  part of the prepared batch. The rewinders save their state in the
+     *  order in which the batch was filled, so usually the body is the next
+     *  one. Bodies that are not saved (e.g. karts skipped in this state) are
+     *  skipped by searching forward. */
+    const CompressedBody* getPrepared(const btRigidBody* body)
+    {
+        if (!g_prepared)
+            return NULL;
+        const std::vector<btRigidBody*>& bodies = g_prepared->m_bodies;
+        for (size_t i = g_prepared->m_next; i < bodies.size(); i++)
+        {
+            if (bodies[i] == body)
+            {
+                g_prepared->m_next = i + 1;
+                return &g_prepared->m_compressed[i];
+            }
+        }
+        // Saved out of order, search the bodies before
+        for (size_t i = 0; i < g_prepared->m_next; i++)
+        {
+            if (bodies[i] == body)
+                return &g_prepared->m_compressed[i];
+        }
+        return NULL;
+    }   // getPrepared
+}
@@ -25,10 +25,79 @@
 #include "LinearMath/btMotionState.h"
 #include "btBulletDynamicsCommon.h"
 
+#include <vector>
+
 namespace CompressNetworkBody
 {
     using namespace MiniGLM;
     // ------------------------------------------------------------------------
+    /** The compressed transformation and velocities of one body, in the
+     *  order in which they are written to a network state. */
+    struct CompressedBody
+    {
+        float m_x, m_y, m_z;
+        uint32_t m_compressed_q;
+        /** Linear and angular velocity as half floats. */
+        short m_velocity[6];
+    };
+    // ------------------------------------------------------------------------
+    /** The bodies of one state that are compressed together, and the
+     *  temporary buffers used for it. It is kept by the RewindManager and
+     *  reused for each state, so compressing does not allocate memory once
+     *  the buffers are large enough. */
+    struct Batch
+    {
+        std::vector<btRigidBody*>   m_bodies;
+        std::vector<btMotionState*> m_motion_states;
+        /** The compressed values of m_bodies, in the same order. */
+        std::vector<CompressedBody> m_compressed;
+        /** Index of the body which compress is expected to write next. */
+        size_t m_next;
+
+        std::vector<btQuaternion>   m_rotations;
+        std::vector<uint32_t>       m_compressed_q;
+        std::vector<float>          m_velocities;
+        std::vector<short>          m_half_velocities;
+        // --------------------------------------------------------------------
+        Batch() : m_next(0) {}
+        // --------------------------------------------------------------------
+        /** Removes all bodies, but keeps the memory of all buffers. */
+        void clear()
+        {
+            m_bodies.clear();
+            m_motion_states.clear();
+            m_compressed.clear();
+            m_next = 0;
+        }   // clear
+        // --------------------------------------------------------------------
+        void add(btRigidBody* body, btMotionState* ms)
+        {
+            m_bodies.push_back(body);
+            m_motion_states.push_back(ms);
+        }   // add
+    };   // Batch
+    // ------------------------------------------------------------------------
+    void compressBatch(Batch* batch);
+    void prepareBatch(Batch* batch);
+    void clearPreparedBatch();
+    const CompressedBody* getPrepared(const btRigidBody* body);
+    // ------------------------------------------------------------------------
+    /** Sets body and motion state of bullet object with the given (already
+     *  rounded) values. */
+    inline void setBodyValues(const btTransform& trans, const btVector3& lv,
+                              const btVector3& av, btRigidBody* body,
+                              btMotionState* ms)
+    {
+        body->setWorldTransform(trans);
+        ms->setWorldTransform(trans);
+        body->setInterpolationWorldTransform(trans);
+        body->setLinearVelocity(lv);
+        body->setAngularVelocity(av);
+        body->setInterpolationLinearVelocity(lv);
+        body->setInterpolationAngularVelocity(av);
+        body->updateInertiaTensor();
+    }   // setBodyValues
+    // ------------------------------------------------------------------------
     /** Set body and motion state of bullet object with compressed values. */
     inline void setCompressedValues(float x, float y, float z,
                                     uint32_t compressed_q,
@@ -41,27 +110,49 @@ namespace CompressNetworkBody
         trans.setRotation(decompressbtQuaternion(compressed_q));
         btVector3 lv(toFloat32(lvx), toFloat32(lvy), toFloat32(lvz));
         btVector3 av(toFloat32(avx), toFloat32(avy), toFloat32(avz));
-
-        body->setWorldTransform(trans);
-        ms->setWorldTransform(trans);
-        body->setInterpolationWorldTransform(trans);
-        body->setLinearVelocity(lv);
-        body->setAngularVelocity(av);
-        body->setInterpolationLinearVelocity(lv);
-        body->setInterpolationAngularVelocity(av);
-        body->updateInertiaTensor();
+        setBodyValues(trans, lv, av, body, ms);
     }   // setCompressedValues
     // ------------------------------------------------------------------------
+    /** Writes the compressed values of a body to a network string. */
+    inline void write(const CompressedBody& cb, BareNetworkString* bns)
+    {
+        bns->addFloat(cb.m_x).addFloat(cb.m_y).addFloat(cb.m_z)
+            .addUInt32(cb.m_compressed_q);
+        for (int i = 0; i < 6; i++)
+            bns->addUInt16(cb.m_velocity[i]);
+    }   // write
+    // ------------------------------------------------------------------------
+    /** Reads the compressed values of a body from a network string. */
+    inline void read(const BareNetworkString* bns, CompressedBody* cb)
+    {
+        cb->m_x = bns->getFloat();
+        cb->m_y = bns->getFloat();
+        cb->m_z = bns->getFloat();
+        cb->m_compressed_q = bns->getUInt32();
+        for (int i = 0; i < 6; i++)
+            cb->m_velocity[i] = bns->getUInt16();
+    }   // read
+    // ------------------------------------------------------------------------
     /** Compress transformation and velocities of bullet object, it will
      *  call MiniGLM::compressQuaternion for compress quaternion of
      *  transformation and convert linear and angular velocities to half floats
      *  it can be used by client to locally round values to make sure client
      *  and server have similar state when saving state if you don't provoide
-     *  bns.
+     *  bns. If the body was already compressed by prepareBatch, the prepared
+     *  values are written.
      */
     inline void compress(btRigidBody* body, btMotionState* ms,
                          BareNetworkString* bns = NULL)
     {
+        if (bns)
+        {
+            const CompressedBody* cb = getPrepared(body);
+            if (cb)
+            {
+                write(*cb, bns);
+                return;
+            }
+        }
         float x = body->getWorldTransform().getOrigin().x();
         float y = body->getWorldTransform().getOrigin().y();
         float z = body->getWorldTransform().getOrigin().z();
@@ -84,6 +175,28 @@ namespace CompressNetworkBody
             .addUInt16(avx).addUInt16(avy).addUInt16(avz);
     }   // compress
     // ------------------------------------------------------------------------
+    /** Writes the transformation and velocities of a body with full
+     *  precision, without rounding or changing the body. This is used for
+     *  states only kept locally, see copyToBody. */
+    inline void copy(const btRigidBody* body, BareNetworkString* bns)
+    {
+        const btTransform& trans = body->getWorldTransform();
+        bns->add(trans.getOrigin()).add(trans.getRotation())
+            .add(body->getLinearVelocity()).add(body->getAngularVelocity());
+    }   // copy
+    // ------------------------------------------------------------------------
+    /** Sets a body to the values written by copy. */
+    inline void copyToBody(const BareNetworkString* bns, btRigidBody* body,
+                           btMotionState* ms)
+    {
+        btTransform trans;
+        trans.setOrigin(bns->getVec3());
+        trans.setRotation(bns->getQuat());
+        btVector3 lv = bns->getVec3();
+        btVector3 av = bns->getVec3();
+        setBodyValues(trans, lv, av, body, ms);
+    }   // copyToBody
+    // ------------------------------------------------------------------------
     /* Called during rewind when restoring data from game state. */
     inline void decompress(const BareNetworkString* bns,
                            btRigidBody* body, btMotionState* ms)
@@ -42,6 +42,7 @@ constexpr bool isConnectionRequestPacket(unsigned char* data, size_t length)
 Event::Event(ENetEvent* event, std::shared_ptr<STKPeer> peer)
 {
     m_arrival_time = (double)StkTime::getTimeSinceEpoch();
+    m_receive_time = std::chrono::steady_clock::now();
     m_pdi = PDI_TIMEOUT;
     m_peer = peer;
 
@@ -85,6 +86,10 @@ Event::Event(ENetEvent* event, std::shared_ptr<STKPeer> peer)
             m_data = new NetworkString(event->packet->data, 
                 (int)event->packet->dataLength);
         }
+        m_peer->countPacket(PacketStatistics::PS_RECEIVED,
+            PacketStatistics::getMessageType((uint8_t*)m_data->getData(),
+            m_data->getTotalSize()), m_data->getTotalSize(),
+            (unsigned)event->packet->dataLength);
     }
     else
         m_data = NULL;
@@ -30,6 +30,7 @@
 
 #include "enet/enet.h"
 
+#include <chrono>
 #include <memory>
 
 class STKPeer;
@@ -86,6 +87,9 @@ private:
     /** Arrivial time of the event, for timeouts. */
     double m_arrival_time;
 
+    /** When the event was received, to measure the dispatch latency. */
+    std::chrono::steady_clock::time_point m_receive_time;
+
     /** For disconnection event, a bit more info is provided. */
     PeerDisconnectInfo m_pdi;
 
@@ -121,6 +125,10 @@ public:
     /** Returns the arrival time of this event. */
     double getArrivalTime() const { return m_arrival_time; }
     // ------------------------------------------------------------------------
+    /** Returns when the event was received on the monotonic clock. */
+    std::chrono::steady_clock::time_point getReceiveTime() const
+                                                    { return m_receive_time; }
+    // ------------------------------------------------------------------------
     PeerDisconnectInfo getPeerDisconnectInfo() const { return m_pdi; }
     // ------------------------------------------------------------------------
 
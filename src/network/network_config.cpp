@@ -60,6 +60,10 @@ NetworkConfig::NetworkConfig()
     m_joined_server_version = 0;
     m_network_ai_tester = false;
     m_state_frequency = 10;
+    m_compact_codec = false;
+    m_redundant_actions = false;
+    m_partial_states = false;
+    m_state_near_distance = 0.0f;
 }   // NetworkConfig
 
 // ----------------------------------------------------------------------------
@@ -97,6 +97,19 @@ private:
      *  available in same version. */
     std::vector<std::string> m_server_capabilities;
 
+    /** True if the server accepted the compact network codec. */
+    bool m_compact_codec;
+
+    /** True if the server accepted unreliable redundant controller actions. */
+    bool m_redundant_actions;
+
+    /** True if the server may skip the states of far away karts. */
+    bool m_partial_states;
+
+    /** Distance within which the server always sends the states of karts
+     *  near the local karts, if it uses partial states. */
+    float m_state_near_distance;
+
 public:
     /** Singleton get, which creates this object if necessary. */
     static NetworkConfig *get()
@@ -239,10 +252,38 @@ public:
     void setServerCapabilities(std::vector<std::string>& caps)
                                    { m_server_capabilities = std::move(caps); }
     // ------------------------------------------------------------------------
-    void clearServerCapabilities()           { m_server_capabilities.clear(); }
+    void clearServerCapabilities()
+    {
+        m_server_capabilities.clear();
+        m_compact_codec = false;
+        m_redundant_actions = false;
+        m_partial_states = false;
+    }   // clearServerCapabilities
     // ------------------------------------------------------------------------
     const std::vector<std::string>& getServerCapabilities() const
                                               { return m_server_capabilities; }
+    // ------------------------------------------------------------------------
+    void setCompactCodec(bool val)                   { m_compact_codec = val; }
+    // ------------------------------------------------------------------------
+    /** Returns true if the joined server uses the compact (bit packed) codec
+     *  for controller actions, player lists and states. */
+    bool useCompactCodec() const                    { return m_compact_codec; }
+    // ------------------------------------------------------------------------
+    void setRedundantActions(bool val)           { m_redundant_actions = val; }
+    // ------------------------------------------------------------------------
+    /** Returns true if controller actions are sent unreliably to the joined
+     *  server, repeating the ones not acknowledged yet. */
+    bool useRedundantActions() const            { return m_redundant_actions; }
+    // ------------------------------------------------------------------------
+    void setPartialStates(bool val)                 { m_partial_states = val; }
+    // ------------------------------------------------------------------------
+    /** Returns true if the joined server may skip far away karts in states,
+     *  which are then restored from the local prediction. */
+    bool usePartialStates() const                  { return m_partial_states; }
+    // ------------------------------------------------------------------------
+    void setStateNearDistance(float val)       { m_state_near_distance = val; }
+    // ------------------------------------------------------------------------
+    float getStateNearDistance() const        { return m_state_near_distance; }
 
 };   // class NetworkConfig
 
@@ -16,16 +16,20 @@
 //  along with this program; if not, write to the Free Software
 //  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
+#include "io/file_manager.hpp"
 #include "network/network_config.hpp"
 #include "network/network_player_profile.hpp"
+#include "network/protocol_manager.hpp"
 #include "network/server_config.hpp"
 #include "network/stk_host.hpp"
 #include "network/stk_peer.hpp"
+#include "network/tick_budget_monitor.hpp"
 #include "network/protocols/server_lobby.hpp"
 #include "utils/time.hpp"
 #include "utils/vs.hpp"
 #include "main_loop.hpp"
 
+#include <fstream>
 #include <iostream>
 #include <limits>
 
@@ -43,6 +47,22 @@ void showHelp()
     std::cout << "listpeers, List all peers with host ID and IP." << std::endl;
     std::cout << "listban, List IP ban list of server." << std::endl;
     std::cout << "speedstats, Show upload and download speed." << std::endl;
+    std::cout << "tickstats, Show tick jitter and overrun histograms." <<
+        std::endl;
+    std::cout << "resettickstats, Reset tick jitter and overrun histograms."
+        << std::endl;
+    std::cout << "budgetstats, Show tick budget and degradation steps." <<
+        std::endl;
+    std::cout << "packetstats [#], Show packets and bytes per message type "
+        "of all peers or # peer." << std::endl;
+    std::cout << "resetpacketstats, Reset packet statistics of all peers." <<
+        std::endl;
+    std::cout << "dumppacketstats, Write packet statistics of all peers to "
+        "a file." << std::endl;
+    std::cout << "eventstats, Show network event dispatch latency." <<
+        std::endl;
+    std::cout << "reseteventstats, Reset network event dispatch latency." <<
+        std::endl;
 }   // showHelp
 
 // ----------------------------------------------------------------------------
@@ -136,6 +156,64 @@ void mainLoop(STKHost* host)
                 "   Download speed (KBps): " <<
                 (float)host->getDownloadSpeed() / 1024.0f  << std::endl;
         }
+        else if (str == "tickstats")
+        {
+            std::cout << main_loop->getTickScheduler()->getStatistics() <<
+                std::endl;
+        }
+        else if (str == "resettickstats")
+        {
+            main_loop->getTickScheduler()->resetStatistics();
+        }
+        else if (str == "budgetstats")
+        {
+            std::cout << TickBudgetMonitor::getStatistics() << std::endl;
+        }
+        else if (str == "packetstats" && number != -1)
+        {
+            std::shared_ptr<STKPeer> peer = host->findPeerByHostId(number);
+            if (peer)
+                std::cout << peer->getPacketStatistics()->toString();
+            else
+                std::cout << "Unknown host id: " << number << std::endl;
+        }
+        else if (str == "packetstats")
+        {
+            std::cout << host->getPacketStatistics()->toString();
+        }
+        else if (str == "resetpacketstats")
+        {
+            host->getPacketStatistics()->reset();
+            for (auto& peer : host->getPeers())
+                peer->getPacketStatistics()->reset();
+        }
+        else if (str == "dumppacketstats")
+        {
+            const std::string filename =
+                file_manager->getUserConfigFile("packet_statistics.txt");
+            std::ofstream out(filename);
+            out << "All peers\n" << host->getPacketStatistics()->toString();
+            for (auto& peer : host->getPeers())
+            {
+                out << "\nPeer " << peer->getHostId() << " " <<
+                    peer->getAddress().toString() << "\n" <<
+                    peer->getPacketStatistics()->toString();
+            }
+            if (out.good())
+                std::cout << "Written to " << filename << std::endl;
+            else
+                std::cout << "Cannot write " << filename << std::endl;
+        }
+        else if (str == "eventstats")
+        {
+            if (auto pm = ProtocolManager::lock())
+                std::cout << pm->getDispatchStatistics() << std::endl;
+        }
+        else if (str == "reseteventstats")
+        {
+            if (auto pm = ProtocolManager::lock())
+                pm->resetDispatchStatistics();
+        }
         else
         {
             std::cout << "Unknown command: " << str << std::endl;
@@ -17,11 +17,15 @@
 
 #include "network/network_string.hpp"
 
+#include "network/bit_packer.hpp"
+#include "utils/log.hpp"
 #include "utils/string_utils.hpp"
 
 #include <algorithm>   // for std::min
+#include <cmath>
 #include <iomanip>
 #include <ostream>
+#include <random>
 
 // ============================================================================
 /** Unit testing function.
@@ -57,6 +61,188 @@ void NetworkString::unitTesting()
     std::string log = slog.getLogMessage();
     assert(log=="0x000 | 00 01 02 03 04 05 06 07  08 09 0a 0b 0c 0d 0e 0f   | ................\n"
                 "0x010 | 10 11 12 13 14 15 16 17  18 19 1a 1b               | ............\n");
+
+    // Round trip fuzz test of the compact codec: random sequences of bit
+    // fields, variable length integers, quantized floats and strings,
+    // interleaved with byte aligned values
+    // The reads must not be done inside assert, which is compiled out in
+    // release builds
+    auto check = [](bool ok, const char* what)
+    {
+        if (!ok)
+            Log::fatal("NetworkString", "Compact codec test failed: %s.",
+                       what);
+    };
+    std::mt19937 rng(42);
+    enum { OP_BITS, OP_BOOL, OP_VARUINT, OP_VARINT, OP_FLOAT,
+           OP_EXACT_FLOAT, OP_STRING, OP_WSTRING, OP_BYTE_ALIGNED,
+           OP_COUNT };
+    struct Op
+    {
+        int                m_type;
+        unsigned           m_num_bits;
+        uint64_t           m_value;
+        float              m_float;
+        std::string        m_string;
+        irr::core::stringw m_wstring;
+    };
+    for (unsigned iteration = 0; iteration < 1000; iteration++)
+    {
+        std::vector<Op> ops(rng() % 32);
+        BareNetworkString bns;
+        BitWriter bw(&bns);
+        for (Op& op : ops)
+        {
+            op.m_type = rng() % OP_COUNT;
+            op.m_num_bits = 1 + rng() % 32;
+            // Use all magnitudes of values, small ones are the common case
+            op.m_value = (uint64_t(rng()) << 32 | rng()) >> (rng() % 64);
+            switch (op.m_type)
+            {
+            case OP_BITS:
+                op.m_value &= (uint64_t(1) << op.m_num_bits) - 1;
+                bw.writeBits(uint32_t(op.m_value), op.m_num_bits);
+                break;
+            case OP_BOOL:
+                op.m_value &= 1;
+                bw.writeBool(op.m_value != 0);
+                break;
+            case OP_VARUINT:
+                bw.writeVarUInt(op.m_value);
+                break;
+            case OP_VARINT:
+                bw.writeVarInt(int64_t(op.m_value));
+                break;
+            case OP_FLOAT:
+                op.m_float = std::uniform_real_distribution<float>
+                    (-150.0f, 150.0f)(rng);
+                bw.writeQuantizedFloat(op.m_float, -100.0f, 100.0f,
+                                        op.m_num_bits);
+                break;
+            case OP_EXACT_FLOAT:
+                op.m_float = std::uniform_real_distribution<float>
+                    (-1.0f, 1.0f)(rng);
+                bw.writeFloat(op.m_float);
+                break;
+            case OP_STRING:
+                for (unsigned i = rng() % 300; i > 0; i--)
+                    op.m_string.push_back(char(rng()));
+                bw.writeString(op.m_string);
+                break;
+            case OP_WSTRING:
+                // Any character of the basic multilingual plane except
+                // surrogates can be converted to UTF-8 and back
+                for (unsigned i = rng() % 20; i > 0; i--)
+                    op.m_wstring.append(wchar_t(1 + rng() % 0xd7ff));
+                bw.writeString(op.m_wstring);
+                break;
+            case OP_BYTE_ALIGNED:
+                bw.flush();
+                bns.addUInt16(uint16_t(op.m_value));
+                break;
+            }
+        }
+        bw.flush();
+
+        // Decode the full string and all truncated versions of it, the
+        // truncated ones must fail with std::out_of_range only
+        const std::vector<uint8_t> full = bns.getBuffer();
+        for (unsigned len = 0; len <= full.size(); len++)
+        {
+            if (len < full.size() && rng() % 4 != 0)
+                continue;
+            BareNetworkString in;
+            in.getBuffer().assign(full.begin(), full.begin() + len);
+            BitReader br(&in);
+            try
+            {
+                for (const Op& op : ops)
+                {
+                    switch (op.m_type)
+                    {
+                    case OP_BITS:
+                        check(br.readBits(op.m_num_bits) == op.m_value,
+                              "bits");
+                        break;
+                    case OP_BOOL:
+                        check(br.readBool() == (op.m_value != 0), "bool");
+                        break;
+                    case OP_VARUINT:
+                        check(br.readVarUInt() == op.m_value, "varuint");
+                        break;
+                    case OP_VARINT:
+                        check(br.readVarInt() == int64_t(op.m_value),
+                              "varint");
+                        break;
+                    case OP_FLOAT:
+                    {
+                        float f = br.readQuantizedFloat(-100.0f, 100.0f,
+                                                         op.m_num_bits);
+                        float expected = std::max(-100.0f,
+                                                  std::min(100.0f, op.m_float));
+                        float error = 200.0f / ((uint64_t(1) << op.m_num_bits)
+                                                - 1);
+                        check(fabsf(f - expected) <= error * 0.5f + 1e-4f,
+                              "quantized float");
+                        break;
+                    }
+                    case OP_EXACT_FLOAT:
+                        check(br.readFloat() == op.m_float, "float");
+                        break;
+                    case OP_STRING:
+                    {
+                        std::string str;
+                        br.readString(&str);
+                        check(str == op.m_string, "string");
+                        break;
+                    }
+                    case OP_WSTRING:
+                    {
+                        irr::core::stringw str;
+                        br.readString(&str);
+                        check(str == op.m_wstring, "wide string");
+                        break;
+                    }
+                    case OP_BYTE_ALIGNED:
+                        // Skip the padding bits of the last byte
+                        br = BitReader(&in);
+                        check(in.getUInt16() == uint16_t(op.m_value),
+                              "byte aligned value");
+                        break;
+                    }
+                }
+                check(len == full.size(), "truncated string was read");
+                check(in.size() == 0, "data left after reading");
+            }
+            catch (std::out_of_range&)
+            {
+                check(len < full.size(), "full string not readable");
+            }
+        }   // for len <= full.size()
+    }   // for iteration < 1000
+
+    // Random data must not make the reader allocate huge strings
+    for (unsigned iteration = 0; iteration < 1000; iteration++)
+    {
+        BareNetworkString in;
+        std::vector<uint8_t>& garbage = in.getBuffer();
+        for (unsigned i = rng() % 64; i > 0; i--)
+            garbage.push_back(uint8_t(rng()));
+        BitReader br(&in);
+        try
+        {
+            while (true)
+            {
+                std::string str;
+                br.readString(&str);
+                check(str.size() < garbage.size(),
+                      "string longer than the data");
+            }
+        }
+        catch (std::out_of_range&)
+        {
+        }
+    }
 }   // unitTesting
 
 // ============================================================================
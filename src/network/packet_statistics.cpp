@@ -0,0 +1,246 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "network/packet_statistics.hpp"
+
+#include "network/protocol.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/time.hpp"
+
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+/** Upper limits (inclusive) of the packet size histogram buckets in bytes,
+ *  the last bucket takes all larger packets. 1400 bytes is about the
+ *  largest packet which is not fragmented. */
+static const unsigned BUCKET_LIMITS[] = { 32, 64, 128, 256, 512, 1024, 1400 };
+
+// ----------------------------------------------------------------------------
+void PacketStatistics::Counter::reset()
+{
+    m_packets = 0;
+    m_bytes = 0;
+    m_wire_bytes = 0;
+    m_sizes.fill(0);
+    m_second_bytes.fill(0);
+    m_second.fill(0);
+}   // Counter::reset
+
+// ----------------------------------------------------------------------------
+/** Adds one packet.
+ *  \param size Size of the message.
+ *  \param wire_size Size of the packet given to enet.
+ *  \param second Current time in seconds, for the rolling rate.
+ */
+void PacketStatistics::Counter::add(unsigned size, unsigned wire_size,
+                                    uint64_t second)
+{
+    m_packets++;
+    m_bytes += size;
+    m_wire_bytes += wire_size;
+    int bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && wire_size > BUCKET_LIMITS[bucket])
+        bucket++;
+    m_sizes[bucket]++;
+
+    const int slot = (int)(second % RATE_SECONDS);
+    if (m_second[slot] != second)
+    {
+        m_second[slot] = second;
+        m_second_bytes[slot] = 0;
+    }
+    m_second_bytes[slot] += wire_size;
+}   // Counter::add
+
+// ----------------------------------------------------------------------------
+/** Returns the average wire bytes per second of the last RATE_SECONDS
+ *  seconds.
+ *  \param now Current time in seconds.
+ */
+float PacketStatistics::Counter::getRate(uint64_t now) const
+{
+    uint64_t bytes = 0;
+    for (int i = 0; i < RATE_SECONDS; i++)
+    {
+        if (m_second[i] + RATE_SECONDS > now)
+            bytes += m_second_bytes[i];
+    }
+    return (float)bytes / (float)RATE_SECONDS;
+}   // Counter::getRate
+
+// ----------------------------------------------------------------------------
+/** Returns the protocol type (without the synchronous flag) in the high
+ *  byte and the message type in the low byte of a message. Messages of
+ *  all protocols start with their message type after the protocol type.
+ */
+uint16_t PacketStatistics::getMessageType(const uint8_t *data, unsigned size)
+{
+    if (size == 0)
+        return 0;
+    const uint16_t protocol = data[0] & ~PROTOCOL_SYNCHRONOUS;
+    return (uint16_t)(protocol << 8 | (size > 1 ? data[1] : 0));
+}   // getMessageType
+
+// ----------------------------------------------------------------------------
+/** Returns a readable name for a message type, e.g. lobby/12. */
+std::string PacketStatistics::getMessageName(uint16_t message)
+{
+    if (message == PING_MESSAGE)
+        return "ping";
+    std::string protocol;
+    switch (message >> 8)
+    {
+    case PROTOCOL_CONNECTION:        protocol = "connection";  break;
+    case PROTOCOL_LOBBY_ROOM:        protocol = "lobby";       break;
+    case PROTOCOL_GAME_EVENTS:       protocol = "game-events"; break;
+    case PROTOCOL_CONTROLLER_EVENTS: protocol = "controller";  break;
+    case PROTOCOL_SILENT:            protocol = "silent";      break;
+    default: protocol = StringUtils::toString(message >> 8);   break;
+    }
+    return protocol + "/" + StringUtils::toString(message & 0xFF);
+}   // getMessageName
+
+// ----------------------------------------------------------------------------
+/** Adds one packet.
+ *  \param direction If the packet was sent or received.
+ *  \param message Protocol and message type, see getMessageType.
+ *  \param size Size of the message.
+ *  \param wire_size Size of the packet given to or received from enet.
+ */
+void PacketStatistics::add(Direction direction, uint16_t message,
+                           unsigned size, unsigned wire_size)
+{
+    const uint64_t second = StkTime::getRealTimeMs() / 1000;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters[direction][message].add(size, wire_size, second);
+    m_total[direction].add(size, wire_size, second);
+}   // add
+
+// ----------------------------------------------------------------------------
+/** Removes all counters. */
+void PacketStatistics::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int i = 0; i < PS_COUNT; i++)
+    {
+        m_counters[i].clear();
+        m_total[i].reset();
+    }
+}   // reset
+
+// ----------------------------------------------------------------------------
+/** Returns a table with the counters of all message types for both
+ *  directions, largest first.
+ */
+std::string PacketStatistics::toString() const
+{
+    const uint64_t now = StkTime::getRealTimeMs() / 1000;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    for (int i = 0; i < PS_COUNT; i++)
+    {
+        const Counter &total = m_total[i];
+        out << (i == PS_SENT ? "Sent" : "Received") << ": "
+            << total.m_packets << " packets, " << total.m_bytes
+            << " bytes, " << total.m_wire_bytes << " wire bytes, "
+            << total.getRate(now) / 1024.0f << " KBps over the last "
+            << RATE_SECONDS << " seconds\n";
+        if (m_counters[i].empty())
+            continue;
+        out << std::setw(16) << "message" << std::setw(9) << "packets"
+            << std::setw(11) << "bytes" << std::setw(11) << "wire"
+            << std::setw(8) << "KBps";
+        for (int b = 0; b < NUM_BUCKETS - 1; b++)
+            out << std::setw(7) << ("<=" + StringUtils::toString(
+                BUCKET_LIMITS[b]));
+        out << std::setw(7) << (">" + StringUtils::toString(
+            BUCKET_LIMITS[NUM_BUCKETS - 2])) << "\n";
+
+        std::multimap<uint64_t, uint16_t, std::greater<uint64_t> > sorted;
+        for (auto &c : m_counters[i])
+            sorted.insert(std::make_pair(c.second.m_wire_bytes, c.first));
+        for (auto &s : sorted)
+        {
+            const Counter &c = m_counters[i].at(s.second);
+            out << std::setw(16) << getMessageName(s.second)
+                << std::setw(9) << c.m_packets << std::setw(11) << c.m_bytes
+                << std::setw(11) << c.m_wire_bytes << std::setw(8)
+                << c.getRate(now) / 1024.0f;
+            for (int b = 0; b < NUM_BUCKETS; b++)
+                out << std::setw(7) << c.m_sizes[b];
+            out << "\n";
+        }
+    }
+    return out.str();
+}   // toString
+
+// ----------------------------------------------------------------------------
+void PacketStatistics::unitTesting()
+{
+    auto check = [](bool ok, const char* what)
+    {
+        if (!ok)
+            Log::fatal("PacketStatistics", "Test failed: %s.", what);
+    };
+    const uint8_t lobby[] = { PROTOCOL_LOBBY_ROOM | PROTOCOL_SYNCHRONOUS, 7 };
+    const uint8_t controller[] = { PROTOCOL_CONTROLLER_EVENTS, 3, 0, 0 };
+    check(getMessageType(lobby, 2) == (PROTOCOL_LOBBY_ROOM << 8 | 7),
+          "lobby message type");
+    check(getMessageType(controller, 1) == PROTOCOL_CONTROLLER_EVENTS << 8,
+          "controller message type");
+    check(getMessageType(NULL, 0) == 0, "empty message type");
+
+    PacketStatistics ps;
+    ps.add(PS_SENT, lobby, 2, 2);
+    ps.add(PS_SENT, lobby, 2, 40);
+    ps.add(PS_SENT, controller, 4, 2000);
+    ps.add(PS_RECEIVED, PING_MESSAGE, 64, 64);
+    const uint16_t lobby_type = getMessageType(lobby, 2);
+    check(ps.m_counters[PS_SENT].size() == 2, "number of sent types");
+    auto it = ps.m_counters[PS_SENT].find(lobby_type);
+    check(it != ps.m_counters[PS_SENT].end(), "lobby counter");
+    const Counter& lc = it->second;
+    check(lc.m_packets == 2, "lobby packets");
+    check(lc.m_bytes == 4, "lobby bytes");
+    check(lc.m_wire_bytes == 42, "lobby wire bytes");
+    check(lc.m_sizes[0] == 1 && lc.m_sizes[1] == 1, "lobby sizes");
+    check(ps.m_total[PS_SENT].m_packets == 3, "total sent packets");
+    check(ps.m_total[PS_SENT].m_sizes[NUM_BUCKETS - 1] == 1,
+          "total sent sizes");
+    check(ps.m_total[PS_RECEIVED].m_sizes[1] == 1, "total received sizes");
+
+    // The rolling rate only includes the last RATE_SECONDS seconds
+    Counter c;
+    c.add(10, 100, 5);
+    c.add(10, 100, 5 + RATE_SECONDS - 1);
+    check(c.getRate(5 + RATE_SECONDS - 1) == 200.0f / RATE_SECONDS,
+          "rate in the window");
+    c.add(10, 300, 5 + RATE_SECONDS);
+    check(c.getRate(5 + RATE_SECONDS) == 400.0f / RATE_SECONDS,
+          "rate after the window moved");
+    check(c.getRate(5 + 3 * RATE_SECONDS) == 0.0f, "rate after a pause");
+
+    ps.reset();
+    check(ps.m_counters[PS_SENT].empty(), "counters after reset");
+    check(ps.m_total[PS_RECEIVED].m_packets == 0, "total after reset");
+}   // unitTesting
@@ -0,0 +1,117 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_PACKET_STATISTICS_HPP
+#define HEADER_PACKET_STATISTICS_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+/** \brief Counts the packets and bytes sent and received, broken down by
+ *  protocol and message type (the first two bytes of each message). For
+ *  each type the totals, a histogram of the packet sizes and the bytes of
+ *  the last seconds (for a rolling rate) are kept. Each STKPeer has one
+ *  instance, and the STKHost one for all peers together. All functions
+ *  can be called from any thread.
+ * \ingroup network
+ */
+class PacketStatistics : public NoCopy
+{
+public:
+    enum Direction
+    {
+        PS_SENT,
+        PS_RECEIVED,
+        PS_COUNT
+    };
+
+    /** The message type used for the ping packets of STKHost, which are not
+     *  NetworkStrings. */
+    static const uint16_t PING_MESSAGE = 0xFFFF;
+
+private:
+    /** Number of packet size histogram buckets, see BUCKET_LIMITS in the
+     *  .cpp file. */
+    static const int NUM_BUCKETS = 8;
+
+    /** Number of seconds the rolling rate is computed over. */
+    static const int RATE_SECONDS = 10;
+
+    struct Counter
+    {
+        /** Total number of packets. */
+        uint64_t m_packets;
+
+        /** Total size of the messages. */
+        uint64_t m_bytes;
+
+        /** Total size of the packets as given to enet, which includes the
+         *  encryption overhead. */
+        uint64_t m_wire_bytes;
+
+        /** Number of packets per size bucket. */
+        std::array<uint64_t, NUM_BUCKETS> m_sizes;
+
+        /** Wire bytes in each of the last seconds, and the second each
+         *  slot belongs to. */
+        std::array<uint64_t, RATE_SECONDS> m_second_bytes;
+        std::array<uint64_t, RATE_SECONDS> m_second;
+        // --------------------------------------------------------------------
+        Counter() { reset(); }
+        void reset();
+        void add(unsigned size, unsigned wire_size, uint64_t second);
+        float getRate(uint64_t now) const;
+    };   // Counter
+
+    /** The counters for each direction, indexed by protocol type in the
+     *  high byte and message type in the low byte. */
+    std::array<std::map<uint16_t, Counter>, PS_COUNT> m_counters;
+
+    /** The sum of all message types for each direction. */
+    std::array<Counter, PS_COUNT> m_total;
+
+    mutable std::mutex m_mutex;
+
+    static std::string getMessageName(uint16_t message);
+
+public:
+    static uint16_t getMessageType(const uint8_t *data, unsigned size);
+    // ------------------------------------------------------------------------
+    void add(Direction direction, uint16_t message, unsigned size,
+             unsigned wire_size);
+    // ------------------------------------------------------------------------
+    void add(Direction direction, const uint8_t *data, unsigned size,
+             unsigned wire_size)
+    {
+        add(direction, getMessageType(data, size), size, wire_size);
+    }   // add
+    // ------------------------------------------------------------------------
+    void reset();
+    // ------------------------------------------------------------------------
+    std::string toString() const;
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+};   // PacketStatistics
+
+#endif
@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <errno.h>
 #include <functional>
+#include <sstream>
 #include <typeinfo>
 
 // ============================================================================
@@ -65,6 +66,7 @@ ProtocolManager::ProtocolManager()
 {
     m_exit.store(false);
     m_all_protocols.resize(PROTOCOL_MAX);
+    resetDispatchStatistics();
 }   // ProtocolManager
 
 // ----------------------------------------------------------------------------
@@ -76,19 +78,17 @@ ProtocolManager::~ProtocolManager()
         m_all_protocols[i].abort();
     }
 
-    m_sync_events_to_process.lock();
-    for (EventList::iterator i =m_sync_events_to_process.getData().begin();
-                             i!=m_sync_events_to_process.getData().end(); ++i)
+    m_sync_inbox.popAll(&m_sync_events_to_process);
+    for (EventList::iterator i =m_sync_events_to_process.begin();
+                             i!=m_sync_events_to_process.end(); ++i)
         delete *i;
-    m_sync_events_to_process.getData().clear();
-    m_sync_events_to_process.unlock();
+    m_sync_events_to_process.clear();
 
-    m_async_events_to_process.lock();
-    for (EventList::iterator i = m_async_events_to_process.getData().begin();
-                             i!= m_async_events_to_process.getData().end(); ++i)
+    m_async_inbox.popAll(&m_async_events_to_process);
+    for (EventList::iterator i = m_async_events_to_process.begin();
+                             i!= m_async_events_to_process.end(); ++i)
         delete *i;
-    m_async_events_to_process.getData().clear();
-    m_async_events_to_process.unlock();
+    m_async_events_to_process.clear();
 
     m_requests.lock();
     m_requests.getData().clear();
@@ -115,24 +115,86 @@ void ProtocolManager::abort()
 // ----------------------------------------------------------------------------
 /** \brief Function that processes incoming events.
  *  This function is called by the network manager each time there is an
- *  incoming packet.
+ *  incoming packet. It must only be called by one thread at a time, which
+ *  is the network thread (or the thread connecting to a server before the
+ *  network thread is started).
  */
 void ProtocolManager::propagateEvent(Event* event)
 {
     if (event->isSynchronous())
+        m_sync_inbox.push(event);
+    else
+        m_async_inbox.push(event);
+}   // propagateEvent
+
+// ----------------------------------------------------------------------------
+/** Moves all new events from an inbox to the list of events to process,
+ *  and records how long they waited.
+ *  \param async True for the asynchronous events (called from the
+ *         ProtocolManager thread), false for the synchronous ones (called
+ *         from the main thread).
+ */
+void ProtocolManager::takeNewEvents(bool async)
+{
+    EventList new_events;
+    (async ? m_async_inbox : m_sync_inbox).popAll(&new_events);
+    if (new_events.empty())
+        return;
+
+    DispatchStatistics &ds = m_dispatch_statistics[async ? 1 : 0];
+    const auto now = std::chrono::steady_clock::now();
+    uint64_t total = 0;
+    uint64_t max_latency = ds.m_max_latency.load(std::memory_order_relaxed);
+    for (Event* event : new_events)
     {
-        m_sync_events_to_process.lock();
-        m_sync_events_to_process.getData().push_back(event);
-        m_sync_events_to_process.unlock();
+        const uint64_t latency = (uint64_t)std::chrono::duration_cast
+            <std::chrono::microseconds>(now - event->getReceiveTime()).count();
+        total += latency;
+        max_latency = std::max(max_latency, latency);
     }
-    else
+    ds.m_events.fetch_add(new_events.size(), std::memory_order_relaxed);
+    ds.m_total_latency.fetch_add(total, std::memory_order_relaxed);
+    ds.m_max_latency.store(max_latency, std::memory_order_relaxed);
+
+    EventList &events = async ? m_async_events_to_process
+                              : m_sync_events_to_process;
+    events.splice(events.end(), new_events);
+}   // takeNewEvents
+
+// ----------------------------------------------------------------------------
+/** Returns the number of events, their average and maximum time from being
+ *  received until they are taken from the inbox, and how often an inbox
+ *  was full, for the network console. */
+std::string ProtocolManager::getDispatchStatistics() const
+{
+    std::ostringstream out;
+    for (int i = 0; i < 2; i++)
     {
-        m_async_events_to_process.lock();
-        m_async_events_to_process.getData().push_back(event);
-        m_async_events_to_process.unlock();
+        const DispatchStatistics &ds = m_dispatch_statistics[i];
+        const uint64_t events = ds.m_events.load();
+        out << (i == 0 ? "Synchronous" : "Asynchronous") << " events: "
+            << events << ", latency average "
+            << (events > 0 ? ds.m_total_latency.load() / events : 0)
+            << " us, max " << ds.m_max_latency.load() << " us, inbox full "
+            << (i == 0 ? m_sync_inbox : m_async_inbox).getOverflowCount()
+            << " times";
+        if (i == 0)
+            out << "\n";
     }
-    return;
-}   // propagateEvent
+    return out.str();
+}   // getDispatchStatistics
+
+// ----------------------------------------------------------------------------
+/** Resets the dispatch latency statistics. */
+void ProtocolManager::resetDispatchStatistics()
+{
+    for (DispatchStatistics &ds : m_dispatch_statistics)
+    {
+        ds.m_events.store(0);
+        ds.m_total_latency.store(0);
+        ds.m_max_latency.store(0);
+    }
+}   // resetDispatchStatistics
 
 // ----------------------------------------------------------------------------
 /** \brief Asks the manager to start a protocol.
@@ -428,12 +490,11 @@ void ProtocolManager::update(int ticks)
     assert(std::this_thread::get_id() != m_asynchronous_update_thread.get_id());
 
     // before updating, notify protocols that they have received events
-    m_sync_events_to_process.lock();
-    EventList::iterator i = m_sync_events_to_process.getData().begin();
+    takeNewEvents(/*async*/false);
+    EventList::iterator i = m_sync_events_to_process.begin();
 
-    while (i != m_sync_events_to_process.getData().end())
+    while (i != m_sync_events_to_process.end())
     {
-        m_sync_events_to_process.unlock();
         bool can_be_deleted = true;
         try
         {
@@ -446,11 +507,10 @@ void ProtocolManager::update(int ticks)
                 "Synchronous event error from %s: %s", name.c_str(), e.what());
             Log::error("ProtocolManager", (*i)->data().getLogMessage().c_str());
         }
-        m_sync_events_to_process.lock();
         if (can_be_deleted)
         {
             delete *i;
-            i = m_sync_events_to_process.getData().erase(i);
+            i = m_sync_events_to_process.erase(i);
         }
         else
         {
@@ -458,7 +518,6 @@ void ProtocolManager::update(int ticks)
             ++i;
         }
     }
-    m_sync_events_to_process.unlock();
 
     // Now update all protocols.
     for (unsigned int i = 0; i < m_all_protocols.size(); i++)
@@ -484,12 +543,10 @@ void ProtocolManager::asynchronousUpdate()
     PROFILER_PUSH_CPU_MARKER("Message delivery", 255, 0, 0);
     // First deliver asynchronous messages for all protocols
     // =====================================================
-    m_async_events_to_process.lock();
-    EventList::iterator i = m_async_events_to_process.getData().begin();
-    while (i != m_async_events_to_process.getData().end())
+    takeNewEvents(/*async*/true);
+    EventList::iterator i = m_async_events_to_process.begin();
+    while (i != m_async_events_to_process.end())
     {
-        m_async_events_to_process.unlock();
-
         m_all_protocols[(*i)->getType()].lock();
         bool result = true;
         try
@@ -506,11 +563,10 @@ void ProtocolManager::asynchronousUpdate()
         }
         m_all_protocols[(*i)->getType()].unlock();
 
-        m_async_events_to_process.lock();
         if (result)
         {
             delete *i;
-            i = m_async_events_to_process.getData().erase(i);
+            i = m_async_events_to_process.erase(i);
         }
         else
         {
@@ -519,7 +575,6 @@ void ProtocolManager::asynchronousUpdate()
             ++i;
         }
     }   // while i != m_events_to_process.end()
-    m_async_events_to_process.unlock();
 
     PROFILER_POP_CPU_MARKER();
     PROFILER_PUSH_CPU_MARKER("Message delivery", 255, 0, 0);
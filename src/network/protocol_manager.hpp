@@ -26,6 +26,7 @@
 #include "network/network_string.hpp"
 #include "network/protocol.hpp"
 #include "utils/no_copy.hpp"
+#include "utils/single_producer_queue.hpp"
 #include "utils/singleton.hpp"
 #include "utils/synchronised.hpp"
 #include "utils/types.hpp"
@@ -33,6 +34,7 @@
 #include <atomic>
 #include <list>
 #include <memory>
+#include <string>
 #include <vector>
 #include <thread>
 
@@ -110,7 +112,9 @@ public:
  *  The sender selects if a message is synchronous or asynchronous. The
  *  network layer (separate thread) calls propagateEvent in the
  *  ProtocolManager, which will add the event to the synchronous or
- *  asynchornous queue.
+ *  asynchornous inbox. The inboxes are lock-free queues with the network
+ *  thread as the only producer, and the main thread or the ProtocolManager
+ *  thread as the only consumer, which takes all new events at once.
  *  Protocol start/pause/... requests are also stored in a separate queue,
  *  which is thread-safe, and requests will be handled by the ProtocolManager
  *  thread, to ensure that they are processed independently from the
@@ -201,13 +205,35 @@ private:
     /** A list of network events - messages, disconnect and disconnects. */
     typedef std::list<Event*> EventList;
 
+    /** Size of the lock-free part of the event inboxes. */
+    static const unsigned INBOX_SIZE = 1024;
+
+    /** New network events to pass synchronously to protocols, filled by the
+     *  network thread. */
+    SingleProducerQueue<Event*, INBOX_SIZE> m_sync_inbox;
+
+    /** New network events to pass asynchronously to protocols, filled by
+     *  the network thread. */
+    SingleProducerQueue<Event*, INBOX_SIZE> m_async_inbox;
+
     /** Contains the network events to pass synchronously to protocols
-     *  (i.e. from the main thread). */
-    Synchronised<EventList> m_sync_events_to_process;
+     *  (i.e. from the main thread). Only used by the main thread. */
+    EventList m_sync_events_to_process;
 
     /** Contains the network events to pass asynchronously to protocols
-    *  (i.e. from the separate ProtocolManager thread). */
-    Synchronised<EventList> m_async_events_to_process;
+    *  (i.e. from the separate ProtocolManager thread). Only used by the
+    *  ProtocolManager thread. */
+    EventList m_async_events_to_process;
+
+    /** How long events waited in the synchronous (index 0) and asynchronous
+     *  (index 1) inbox, read by the network console. */
+    struct DispatchStatistics
+    {
+        std::atomic<uint64_t> m_events;
+        std::atomic<uint64_t> m_total_latency;
+        std::atomic<uint64_t> m_max_latency;
+    };
+    DispatchStatistics m_dispatch_statistics[2];
 
     /** Contains the requests to start/pause etc... protocols. */
     Synchronised< std::vector<ProtocolRequest> > m_requests;
@@ -222,6 +248,7 @@ private:
     static std::weak_ptr<ProtocolManager> m_protocol_manager;
 
     bool         sendEvent(Event* event);
+    void         takeNewEvents(bool async);
 
     virtual void startProtocol(std::shared_ptr<Protocol> protocol);
     virtual void terminateProtocol(std::shared_ptr<Protocol> protocol);
@@ -243,6 +270,8 @@ public:
     void      requestTerminate(std::shared_ptr<Protocol> protocol);
     void      findAndTerminate(ProtocolType type);
     void      update(int ticks);
+    std::string getDispatchStatistics() const;
+    void      resetDispatchStatistics();
     // ------------------------------------------------------------------------
     bool isExiting() const                            { return m_exit.load(); }
     // ------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 #include "karts/kart_properties.hpp"
 #include "karts/kart_properties_manager.hpp"
 #include "modes/linear_world.hpp"
+#include "network/bit_packer.hpp"
 #include "network/crypto.hpp"
 #include "network/event.hpp"
 #include "network/game_setup.hpp"
@@ -57,6 +58,8 @@
 #include "tracks/track_manager.hpp"
 #include "utils/log.hpp"
 
+#include <algorithm>
+
 // ============================================================================
 /** The protocol that manages starting a race with the server. It uses a 
  *  finite state machine:
@@ -122,6 +125,8 @@ void ClientLobby::setup()
     m_server_send_live_load_world = false;
     m_auto_back_to_lobby_time = std::numeric_limits<uint64_t>::max();
     m_start_live_game_time = std::numeric_limits<uint64_t>::max();
+    m_live_join_state.clear();
+    m_live_join_state_time = 0.0;
     m_received_server_result = false;
     TracksScreen::getInstance()->resetVote();
     LobbyProtocol::setup();
@@ -168,7 +173,8 @@ bool ClientLobby::notifyEvent(Event* event)
         case LE_SERVER_OWNERSHIP:      becomingServerOwner();      break;
         case LE_BAD_TEAM:              handleBadTeam();            break;
         case LE_BAD_CONNECTION:        handleBadConnection();      break;
-        case LE_LIVE_JOIN_ACK:        liveJoinAcknowledged(event); break;
+        case LE_LIVE_JOIN_ACK:  liveJoinAcknowledged(event->data()); break;
+        case LE_LIVE_JOIN_CHUNK:    liveJoinChunkReceived(event);  break;
         case LE_KART_INFO:             handleKartInfo(event);      break;
         case LE_START_RACE:            startGame(event);           break;
         default:
@@ -317,6 +323,35 @@ std::vector<std::shared_ptr<NetworkPlayerProfile> >
                              bool* is_specator) const
 {
     std::vector<std::shared_ptr<NetworkPlayerProfile> > players;
+    if (NetworkConfig::get()->useCompactCodec())
+    {
+        BitReader br(&data);
+        unsigned player_count = (unsigned)br.readVarUInt();
+        for (unsigned i = 0; i < player_count; i++)
+        {
+            core::stringw player_name;
+            br.readString(&player_name);
+            uint32_t host_id = (uint32_t)br.readVarUInt();
+            float kart_color = br.readFloat();
+            uint32_t online_id = (uint32_t)br.readVarUInt();
+            PerPlayerDifficulty ppd = (PerPlayerDifficulty)br.readVarUInt();
+            uint8_t local_id = (uint8_t)br.readVarUInt();
+            KartTeam team = (KartTeam)br.readVarInt();
+            std::string country_id;
+            br.readString(&country_id);
+            if (is_specator && host_id == STKHost::get()->getMyHostId())
+                *is_specator = false;
+            auto player = std::make_shared<NetworkPlayerProfile>(peer,
+                player_name, host_id, kart_color, online_id, ppd, local_id,
+                team, country_id);
+            std::string kart_name;
+            br.readString(&kart_name);
+            player->setKartName(kart_name);
+            players.push_back(player);
+        }
+        return players;
+    }
+
     unsigned player_count = data.getUInt8();
     for (unsigned i = 0; i < player_count; i++)
     {
@@ -360,8 +395,11 @@ void ClientLobby::update(int ticks)
         ns->addUInt8(LE_CONNECTION_REQUESTED)
             .addUInt32(ServerConfig::m_server_version)
             .encodeString(StringUtils::getUserAgentString())
-            // Reserved for future to supply list of network capabilities
-            .addUInt16(0);
+            // List of network capabilities supported by this client
+            .addUInt16(4).encodeString(std::string("compact_codec"))
+            .encodeString(std::string("redundant_actions"))
+            .encodeString(std::string("partial_states"))
+            .encodeString(std::string("chunked_live_join"));
 
         auto all_k = kart_properties_manager->getAllAvailableKarts();
         auto all_t = track_manager->getAllTrackIdentifiers();
@@ -613,6 +651,12 @@ void ClientLobby::connectionAccepted(Event* event)
         data.decodeString(&cap);
         caps.push_back(cap);
     }
+    NetworkConfig::get()->setCompactCodec(std::find(caps.begin(), caps.end(),
+        "compact_codec") != caps.end());
+    NetworkConfig::get()->setRedundantActions(std::find(caps.begin(),
+        caps.end(), "redundant_actions") != caps.end());
+    NetworkConfig::get()->setPartialStates(std::find(caps.begin(),
+        caps.end(), "partial_states") != caps.end());
     NetworkConfig::get()->setServerCapabilities(caps);
 
     float auto_start_timer = data.getFloat();
@@ -621,6 +665,8 @@ void ClientLobby::connectionAccepted(Event* event)
     if (auto_start_timer != std::numeric_limits<float>::max())
         NetworkingLobby::getInstance()->setStartingTimerTo(auto_start_timer);
     m_server_enabled_chat = data.getUInt8() == 1;
+    if (NetworkConfig::get()->usePartialStates())
+        NetworkConfig::get()->setStateNearDistance(data.getFloat());
 }   // connectionAccepted
 
 //-----------------------------------------------------------------------------
@@ -1140,17 +1186,17 @@ void ClientLobby::finishedLoadingWorld()
 }   // finishedLoadingWorld
 
 //-----------------------------------------------------------------------------
-void ClientLobby::liveJoinAcknowledged(Event* event)
+void ClientLobby::liveJoinAcknowledged(const NetworkString& data)
 {
     World* w = World::getWorld();
     if (!w)
         return;
 
-    const NetworkString& data = event->data();
+    const double start_time = StkTime::getRealTime();
     m_start_live_game_time = data.getUInt64();
     powerup_manager->setRandomSeed(m_start_live_game_time);
 
-    unsigned check_structure_count = event->data().getUInt8();
+    unsigned check_structure_count = data.getUInt8();
     LinearWorld* lw = dynamic_cast<LinearWorld*>(World::getWorld());
     if (lw)
         lw->handleServerCheckStructureCount(check_structure_count);
@@ -1203,8 +1249,51 @@ void ClientLobby::liveJoinAcknowledged(Event* event)
             }
         }
     }
+    Log::info("ClientLobby", "Live join state restored in %.2f ms.",
+        (StkTime::getRealTime() - start_time) * 1000.0);
 }   // liveJoinAcknowledged
 
+//-----------------------------------------------------------------------------
+/** Called when a part of the live join state is received. Once all parts
+ *  are there, they are handled like a single LE_LIVE_JOIN_ACK message.
+ */
+void ClientLobby::liveJoinChunkReceived(Event* event)
+{
+    const NetworkString& data = event->data();
+    const unsigned total = data.getUInt32();
+    const unsigned offset = data.getUInt32();
+    if (offset == 0)
+    {
+        m_live_join_state.clear();
+        m_live_join_state_time = StkTime::getRealTime();
+    }
+    if (offset != m_live_join_state.size())
+    {
+        Log::warn("ClientLobby", "Live join chunk at %d, expected %d.",
+            offset, (int)m_live_join_state.size());
+        m_live_join_state.clear();
+        return;
+    }
+    m_live_join_state.insert(m_live_join_state.end(), data.getCurrentData(),
+        data.getCurrentData() + data.size());
+    if (m_live_join_state.size() < total)
+        return;
+
+    Log::info("ClientLobby", "Live join state with %d bytes received in "
+        "%.2f ms.", total,
+        (StkTime::getRealTime() - m_live_join_state_time) * 1000.0);
+    // The chunks contain the complete message including the protocol type
+    NetworkString ack(m_live_join_state.data(),
+        (int)m_live_join_state.size());
+    m_live_join_state.clear();
+    if (ack.getUInt8() != LE_LIVE_JOIN_ACK)
+    {
+        Log::warn("ClientLobby", "Invalid live join state.");
+        return;
+    }
+    liveJoinAcknowledged(ack);
+}   // liveJoinChunkReceived
+
 //-----------------------------------------------------------------------------
 void ClientLobby::finishLiveJoin()
 {
@@ -111,6 +111,12 @@ private:
 
     uint64_t m_start_live_game_time;
 
+    /** The chunks of the live join state received so far. */
+    std::vector<uint8_t> m_live_join_state;
+
+    /** Real time when the first chunk of the live join state arrived. */
+    double m_live_join_state_time;
+
     /** The state of the finite state machine. */
     std::atomic<ClientState> m_state;
 
@@ -127,7 +133,8 @@ private:
 
     irr::core::stringw m_total_players;
 
-    void liveJoinAcknowledged(Event* event);
+    void liveJoinAcknowledged(const NetworkString& data);
+    void liveJoinChunkReceived(Event* event);
     void handleKartInfo(Event* event);
     void finishLiveJoin();
     std::vector<std::shared_ptr<NetworkPlayerProfile> >
@@ -22,20 +22,28 @@
 #include "karts/abstract_kart.hpp"
 #include "karts/controller/player_controller.hpp"
 #include "modes/world.hpp"
+#include "network/bit_packer.hpp"
 #include "network/event.hpp"
 #include "network/network_config.hpp"
 #include "network/game_setup.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
 #include "network/protocol_manager.hpp"
+#include "network/rewinder.hpp"
 #include "network/rewind_info.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/server_config.hpp"
 #include "network/stk_host.hpp"
 #include "network/stk_peer.hpp"
 #include "utils/log.hpp"
 #include "utils/time.hpp"
 #include "main_loop.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <set>
+
 // ============================================================================
 std::weak_ptr<GameProtocol> GameProtocol::m_game_protocol;
 // ============================================================================
@@ -57,7 +65,8 @@ GameProtocol::GameProtocol()
             : Protocol( PROTOCOL_CONTROLLER_EVENTS)
 {
     m_data_to_send = getNetworkString();
-
+    m_unacked_sent_ticks = -1;
+    m_next_action_seq = 0;
 }   // GameProtocol
 
 //-----------------------------------------------------------------------------
@@ -72,6 +81,41 @@ GameProtocol::~GameProtocol()
  */
 void GameProtocol::sendActions()
 {
+    if (NetworkConfig::get()->useRedundantActions())
+    {
+        // Send unreliable, but repeat all actions the server has not
+        // acknowledged yet once per tick, so a lost packet does not delay
+        // later actions until it is resent
+        std::lock_guard<std::mutex> lock(m_unacked_actions_mutex);
+        // Can be called from the lobby and while the world is deleted
+        World* world = World::getWorld();
+        if (!world)
+            return;
+        const int ticks = world->getTicksSinceStart();
+        if (m_all_actions.empty() &&
+            (m_unacked_actions.empty() || ticks == m_unacked_sent_ticks))
+            return;
+        // A tick can span several frames, so the actions of one tick can be
+        // split over packets. Each action gets a sequence number, which the
+        // server uses to find the repeated ones.
+        for (Action& a : m_all_actions)
+        {
+            a.m_seq = m_next_action_seq++;
+            m_unacked_actions.push_back(a);
+        }
+        m_all_actions.clear();
+        m_unacked_sent_ticks = ticks;
+
+        std::vector<Action> actions;
+        getRedundantActions(m_unacked_actions, &actions);
+        m_data_to_send->clear();
+        encodeActions(m_data_to_send, actions,
+                      NetworkConfig::get()->useCompactCodec(),
+                      /*sequence*/true);
+        sendToServer(m_data_to_send, /*reliable*/ false);
+        return;
+    }
+
     if (m_all_actions.size() == 0) return;   // nothing to do
 
     // Clear left-over data from previous frame. This way the network
@@ -83,27 +127,20 @@ void GameProtocol::sendActions()
             "Too many actions unsent %d.", (int)m_all_actions.size());
         m_all_actions.resize(255);
     }
-    m_data_to_send->addUInt8(GP_CONTROLLER_ACTION)
-                   .addUInt8(uint8_t(m_all_actions.size()));
-
-    // Add all actions
-    for (auto& a : m_all_actions)
+    if (Network::m_connection_debug)
     {
-        if (Network::m_connection_debug)
+        for (auto& a : m_all_actions)
         {
             Log::verbose("GameProtocol",
                 "Controller action: %d %d %d %d %d %d",
                 a.m_ticks, a.m_kart_id, a.m_action, a.m_value, a.m_value_l,
                 a.m_value_r);
         }
-        m_data_to_send->addUInt32(a.m_ticks);
-        m_data_to_send->addUInt8(a.m_kart_id);
-        const auto& c = compressAction(a);
-        m_data_to_send->addUInt8(std::get<0>(c)).addUInt16(std::get<1>(c))
-            .addUInt16(std::get<2>(c)).addUInt16(std::get<3>(c));
-    }   // for a in m_all_actions
+    }
+    encodeActions(m_data_to_send, m_all_actions,
+                  NetworkConfig::get()->useCompactCodec(), /*sequence*/false);
 
-    // FIXME: for now send reliable
+    // Servers which do not acknowledge actions need them reliable
     sendToServer(m_data_to_send, /*reliable*/ true);
     m_all_actions.clear();
 }   // sendActions
@@ -124,8 +161,12 @@ bool GameProtocol::notifyEventAsynchronous(Event* event)
     uint8_t message_type = data.getUInt8();
     switch (message_type)
     {
-    case GP_CONTROLLER_ACTION: handleControllerAction(event); break;
-    case GP_STATE:             handleState(event);            break;
+    case GP_CONTROLLER_ACTION: handleControllerAction(event, false); break;
+    case GP_STATE:             handleState(event, false);     break;
+    case GP_CONTROLLER_ACTION_COMPACT:
+                               handleControllerAction(event, true); break;
+    case GP_STATE_COMPACT:     handleState(event, true);      break;
+    case GP_ACTIONS_ACK:       handleActionsAck(event);       break;
     case GP_ADJUST_TIME:       handleAdjustTime(event);       break;
     //case GP_ITEM_UPDATE:       handleItemUpdate(event);       break;
     case GP_ITEM_CONFIRMATION: handleItemEventConfirmation(event); break;
@@ -136,6 +177,184 @@ bool GameProtocol::notifyEventAsynchronous(Event* event)
     return true;
 }   // notifyEventAsynchronous
 
+//-----------------------------------------------------------------------------
+/** Writes a list of controller actions into a network string, including the
+ *  message type.
+ *  \param ns The network string to write to.
+ *  \param actions The actions to write, at most 255.
+ *  \param compact If true, the compact codec is used: the ticks are sent as
+ *         difference to the previous action, and all values as variable
+ *         length integers.
+ *  \param sequence If true, the sequence number of the first action is
+ *         sent, the other actions have the following numbers.
+ */
+void GameProtocol::encodeActions(NetworkString *ns,
+                                 const std::vector<Action>& actions,
+                                 bool compact, bool sequence)
+{
+    assert(actions.size() <= 255);
+    const uint32_t seq = actions.empty() ? 0 : actions.front().m_seq;
+    if (compact)
+    {
+        ns->addUInt8(GP_CONTROLLER_ACTION_COMPACT);
+        BitWriter bw(ns);
+        bw.writeVarUInt(actions.size());
+        if (sequence)
+            bw.writeVarUInt(seq);
+        int previous_ticks = 0;
+        for (auto& a : actions)
+        {
+            const auto& c = compressAction(a);
+            bw.writeVarInt(a.m_ticks - previous_ticks)
+                .writeVarUInt(a.m_kart_id)
+                .writeBits(std::get<0>(c), 8)
+                .writeVarInt((int16_t)std::get<1>(c))
+                .writeVarUInt(std::get<2>(c))
+                .writeVarUInt(std::get<3>(c));
+            previous_ticks = a.m_ticks;
+        }
+        return;
+    }
+
+    ns->addUInt8(GP_CONTROLLER_ACTION).addUInt8(uint8_t(actions.size()));
+    if (sequence)
+        ns->addUInt32(seq);
+    for (auto& a : actions)
+    {
+        ns->addUInt32(a.m_ticks);
+        ns->addUInt8(a.m_kart_id);
+        const auto& c = compressAction(a);
+        ns->addUInt8(std::get<0>(c)).addUInt16(std::get<1>(c))
+            .addUInt16(std::get<2>(c)).addUInt16(std::get<3>(c));
+    }   // for a in actions
+}   // encodeActions
+
+//-----------------------------------------------------------------------------
+/** Reads a list of controller actions written by encodeActions (after the
+ *  message type). Throws std::out_of_range on truncated data.
+ *  \param ns The network string to read from.
+ *  \param compact If the compact codec was used.
+ *  \param sequence If sequence numbers were sent.
+ *  \param actions The decoded actions are appended here.
+ */
+void GameProtocol::decodeActions(const NetworkString &ns, bool compact,
+                                 bool sequence, std::vector<Action> *actions)
+{
+    unsigned count = 0;
+    int ticks = 0;
+    uint32_t seq = 0;
+    BitReader br(&ns);
+    if (compact)
+    {
+        count = (unsigned)br.readVarUInt();
+        if (count > 255)
+            throw std::out_of_range("Too many controller actions.");
+        if (sequence)
+            seq = (uint32_t)br.readVarUInt();
+    }
+    else
+    {
+        count = ns.getUInt8();
+        if (sequence)
+            seq = ns.getUInt32();
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        Action a;
+        uint8_t w;
+        uint16_t x, y, z;
+        if (compact)
+        {
+            ticks += (int)br.readVarInt();
+            a.m_kart_id = (int)br.readVarUInt();
+            w = (uint8_t)br.readBits(8);
+            x = (uint16_t)br.readVarInt();
+            y = (uint16_t)br.readVarUInt();
+            z = (uint16_t)br.readVarUInt();
+        }
+        else
+        {
+            ticks = ns.getUInt32();
+            a.m_kart_id = ns.getUInt8();
+            w = ns.getUInt8();
+            x = ns.getUInt16();
+            y = ns.getUInt16();
+            z = ns.getUInt16();
+        }
+        a.m_ticks = ticks;
+        a.m_seq   = seq + i;
+        std::tie(a.m_action, a.m_value, a.m_value_l, a.m_value_r) =
+            decompressAction(w, x, y, z);
+        actions->push_back(a);
+    }
+}   // decodeActions
+
+//-----------------------------------------------------------------------------
+/** Selects the unacknowledged actions to send in the next packet: the oldest
+ *  ones, at most 255. So each packet contains consecutive sequence numbers.
+ *  \param unacked All unacknowledged actions, sorted by sequence numbers.
+ *  \param actions The actions to send.
+ */
+void GameProtocol::getRedundantActions(const std::vector<Action>& unacked,
+                                       std::vector<Action> *actions)
+{
+    size_t count = unacked.size();
+    if (count > 255)
+    {
+        count = 255;
+        Log::warn("GameProtocol", "Too many actions unacknowledged %d.",
+                  (int)unacked.size());
+    }
+    actions->assign(unacked.begin(), unacked.begin() + count);
+}   // getRedundantActions
+
+//-----------------------------------------------------------------------------
+/** Removes all actions which the server has acknowledged.
+ *  \param seq All actions up to this sequence number have been received by
+ *         the server.
+ *  \param unacked The unacknowledged actions, sorted by sequence numbers.
+ */
+void GameProtocol::removeAckedActions(uint32_t seq,
+                                      std::vector<Action> *unacked)
+{
+    auto it = unacked->begin();
+    while (it != unacked->end() && it->m_seq <= seq)
+        it++;
+    unacked->erase(unacked->begin(), it);
+}   // removeAckedActions
+
+//-----------------------------------------------------------------------------
+/** Removes the actions of a packet which were already received in an
+ *  earlier packet. Each packet contains all actions not acknowledged when
+ *  it was sent, with consecutive sequence numbers, so all actions before
+ *  the next expected sequence number are known, even if unreliable packets
+ *  arrive out of order.
+ *  \param next_seq The sequence number of the next new action of the
+ *         client, updated with the actions of this packet.
+ *  \param actions The actions of a packet.
+ */
+void GameProtocol::removeRepeatedActions(uint32_t *next_seq,
+                                         std::vector<Action> *actions)
+{
+    const uint32_t first_new = *next_seq;
+    auto it = std::remove_if(actions->begin(), actions->end(),
+        [first_new](const Action& a) { return a.m_seq < first_new; });
+    actions->erase(it, actions->end());
+    if (!actions->empty())
+        *next_seq = actions->back().m_seq + 1;
+}   // removeRepeatedActions
+
+//-----------------------------------------------------------------------------
+/** Called on a client when the server acknowledged controller actions. */
+void GameProtocol::handleActionsAck(Event *event)
+{
+    assert(NetworkConfig::get()->isClient());
+    const uint32_t seq = event->data().getUInt32();
+    std::lock_guard<std::mutex> lock(m_unacked_actions_mutex);
+    removeAckedActions(seq, &m_unacked_actions);
+}   // handleActionsAck
+
 //-----------------------------------------------------------------------------
 /** Called from the local kart controller when an action (like steering,
  *  acceleration, ...) was triggered. It sends a message with the new info
@@ -157,6 +376,7 @@ void GameProtocol::controllerAction(int kart_id, PlayerAction action,
     a.m_value_l = val_l;
     a.m_value_r = val_r;
     a.m_ticks   = World::getWorld()->getTicksSinceStart();
+    a.m_seq     = 0;
 
     m_all_actions.push_back(a);
     const auto& c = compressAction(a);
@@ -176,55 +396,68 @@ void GameProtocol::controllerAction(int kart_id, PlayerAction action,
  *  RewindManager's network event queue. The server will also send this 
  *  event immediately to all clients (except to the original sender).
  */
-void GameProtocol::handleControllerAction(Event *event)
+void GameProtocol::handleControllerAction(Event *event, bool compact)
 {
     STKPeer* peer = event->getPeer();
     if (NetworkConfig::get()->isServer() && (peer->isWaitingForGame() ||
         peer->getAvailableKartIDs().empty()))
         return;
     NetworkString &data = event->data();
-    uint8_t count = data.getUInt8();
+    const bool redundant = NetworkConfig::get()->isServer() &&
+                           peer->useRedundantActions();
+    std::vector<Action> actions;
+    decodeActions(data, compact, redundant, &actions);
+    if (redundant && !actions.empty())
+    {
+        // All actions of this packet are received, acknowledge them and
+        // remove the ones repeated from previous packets
+        NetworkString *ack = getNetworkString(5);
+        ack->addUInt8(GP_ACTIONS_ACK).addUInt32(actions.back().m_seq);
+        peer->sendPacket(ack, /*reliable*/false);
+        delete ack;
+        removeRepeatedActions(
+            &m_next_received_action_seqs[peer->getHostId()], &actions);
+        if (actions.empty())
+        {
+            peer->updateLastActivity();
+            return;
+        }
+    }
     bool will_trigger_rewind = false;
     //int rewind_delta = 0;
-    int cur_ticks = 0;
     const int not_rewound = RewindManager::get()->getNotRewoundWorldTicks();
-    for (unsigned int i = 0; i < count; i++)
+    for (const Action& a : actions)
     {
-        cur_ticks = data.getUInt32();
         // Since this is running in a thread, it might be called during
         // a rewind, i.e. with an incorrect world time. So the event
         // time needs to be compared with the World time independent
         // of any rewinding.
-        if (cur_ticks < not_rewound && !will_trigger_rewind)
+        if (a.m_ticks < not_rewound && !will_trigger_rewind)
         {
             will_trigger_rewind = true;
-            //rewind_delta = not_rewound - cur_ticks;
+            //rewind_delta = not_rewound - a.m_ticks;
         }
-        uint8_t kart_id = data.getUInt8();
         if (NetworkConfig::get()->isServer() &&
-            !peer->availableKartID(kart_id))
+            !peer->availableKartID(a.m_kart_id))
         {
             Log::warn("GameProtocol", "Wrong kart id %d from %s.",
-                kart_id, peer->getAddress().toString().c_str());
+                a.m_kart_id, peer->getAddress().toString().c_str());
             return;
         }
 
-        uint8_t w = data.getUInt8();
-        uint16_t x = data.getUInt16();
-        uint16_t y = data.getUInt16();
-        uint16_t z = data.getUInt16();
         if (Network::m_connection_debug)
         {
-            const auto& a = decompressAction(w, x, y, z);
             Log::verbose("GameProtocol",
                 "Controller action: %d %d %d %d %d %d",
-                cur_ticks, kart_id, std::get<0>(a), std::get<1>(a),
-                std::get<2>(a), std::get<3>(a));
+                a.m_ticks, a.m_kart_id, a.m_action, a.m_value, a.m_value_l,
+                a.m_value_r);
         }
+        const auto& c = compressAction(a);
         BareNetworkString *s = new BareNetworkString(3);
-        s->addUInt8(kart_id).addUInt8(w).addUInt16(x).addUInt16(y)
-            .addUInt16(z);
-        RewindManager::get()->addNetworkEvent(this, s, cur_ticks);
+        s->addUInt8(a.m_kart_id).addUInt8(std::get<0>(c))
+            .addUInt16(std::get<1>(c)).addUInt16(std::get<2>(c))
+            .addUInt16(std::get<3>(c));
+        RewindManager::get()->addNetworkEvent(this, s, a.m_ticks);
     }
 
     if (data.size() > 0)
@@ -235,10 +468,24 @@ void GameProtocol::handleControllerAction(Event *event)
     if (NetworkConfig::get()->isServer())
     {
         // Send update to all clients except the original sender if the event
-        // is after the server time
+        // is after the server time, in the codec each client negotiated
         peer->updateLastActivity();
         if (!will_trigger_rewind)
-            STKHost::get()->sendPacketExcept(peer, &data, false);
+        {
+            for (bool use_compact : { false, true })
+            {
+                NetworkString* ns = getNetworkString();
+                encodeActions(ns, actions, use_compact, /*sequence*/false);
+                STKHost::get()->sendPacketToAllPeersWith(
+                    [peer, use_compact](STKPeer* p)
+                    {
+                        return !p->isSamePeer(peer) && p->isValidated() &&
+                            !p->isWaitingForGame() &&
+                            p->useCompactCodec() == use_compact;
+                    }, ns, false/*reliable*/);
+                delete ns;
+            }
+        }
 
         // FIXME unless there is a network jitter more than 100ms (more than
         // server delay), time adjust is not necessary
@@ -390,21 +637,319 @@ void GameProtocol::finalizeState(std::vector<std::string>& cur_rewinder)
 
 // ----------------------------------------------------------------------------
 /** Called when the last state information has been added and the message
- *  can be sent to the clients.
+ *  can be sent to the clients. Clients which negotiated the compact codec
+ *  get the state converted by buildState(). For clients which support
+ *  partial states the karts far away from their own karts are only sent
+ *  within the bandwidth budget set by ServerConfig::m_state_budget.
  */
 void GameProtocol::sendState()
 {
     assert(NetworkConfig::get()->isServer());
-    sendMessageToPeers(m_data_to_send, /*reliable*/false);
+    auto peers = STKHost::get()->getPeers();
+    bool needs_conversion = false;
+    for (auto& p : peers)
+        needs_conversion |= p->useCompactCodec() || p->usePartialStates();
+    if (!needs_conversion)
+    {
+        m_state_priorities.clear();
+        sendMessageToPeers(m_data_to_send, /*reliable*/false);
+        return;
+    }
+
+    std::vector<StateEntry> entries;
+    const int ticks = getStateEntries(&entries);
+    NetworkString* compact_state = NULL;
+    std::set<uint32_t> host_ids;
+    for (auto& p : peers)
+    {
+        if (!p->isValidated() || p->isWaitingForGame())
+            continue;
+        host_ids.insert(p->getHostId());
+        std::vector<bool> selected;
+        if (p->usePartialStates() &&
+            selectStatesForPeer(p.get(), entries, &selected))
+        {
+            NetworkString* ns = buildState(ticks, entries, &selected,
+                p->useCompactCodec());
+            p->sendPacket(ns, /*reliable*/false);
+            delete ns;
+        }
+        else if (p->useCompactCodec())
+        {
+            if (!compact_state)
+            {
+                compact_state = buildState(ticks, entries, NULL,
+                    /*compact*/true);
+            }
+            p->sendPacket(compact_state, /*reliable*/false);
+        }
+        else
+            p->sendPacket(m_data_to_send, /*reliable*/false);
+    }
+    delete compact_state;
+
+    // Remove the priorities of disconnected peers
+    for (auto it = m_state_priorities.begin();
+         it != m_state_priorities.end();)
+    {
+        if (host_ids.find(it->first) == host_ids.end())
+            it = m_state_priorities.erase(it);
+        else
+            it++;
+    }
 }   // sendState
 
+// ----------------------------------------------------------------------------
+/** Finds the name, position and size of all rewinder states in the
+ *  finalized state in m_data_to_send.
+ *  \param entries Returns one entry for each rewinder state.
+ *  \return The ticks of the state.
+ */
+int GameProtocol::getStateEntries(std::vector<StateEntry> *entries)
+{
+    m_data_to_send->reset();
+    m_data_to_send->skip(1/*protocol type*/ + 1/*gp event type*/);
+    const int ticks = m_data_to_send->getUInt32();
+    const unsigned rewinder_size = m_data_to_send->getUInt8();
+    entries->resize(rewinder_size);
+    for (unsigned i = 0; i < rewinder_size; i++)
+        m_data_to_send->decodeString(&(*entries)[i].m_name);
+    // Each rewinder using has added one state
+    for (unsigned i = 0; i < rewinder_size; i++)
+    {
+        (*entries)[i].m_size = m_data_to_send->getUInt16();
+        (*entries)[i].m_offset = m_data_to_send->getCurrentOffset();
+        m_data_to_send->skip((*entries)[i].m_size);
+    }
+    m_data_to_send->reset();
+    return ticks;
+}   // getStateEntries
+
+// ----------------------------------------------------------------------------
+/** Creates a state message from the rewinder states in m_data_to_send.
+ *  Rewinder states which are not selected keep their name, but are sent
+ *  with a size of 0, so that the client does not consider the kart as
+ *  disconnected (see KartRewinder::restoreState).
+ *  In the compact codec the ticks, the rewinder names and the sizes of all
+ *  rewinder states are bit packed at the beginning, followed by the
+ *  unchanged rewinder states.
+ *  \param ticks Ticks of the state.
+ *  \param entries The rewinder states in m_data_to_send.
+ *  \param selected Which rewinder states are sent, NULL for all.
+ *  \param compact If the compact codec is used.
+ *  \return A new network string, which must be freed by the caller.
+ */
+NetworkString* GameProtocol::buildState(int ticks,
+                                        const std::vector<StateEntry>& entries,
+                                        const std::vector<bool>* selected,
+                                        bool compact)
+{
+    NetworkString* ns = getNetworkString(m_data_to_send->getTotalSize());
+    std::vector<uint16_t> sizes;
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        sizes.push_back(selected && !(*selected)[i] ?
+            0 : entries[i].m_size);
+    }
+    if (compact)
+    {
+        ns->addUInt8(GP_STATE_COMPACT);
+        BitWriter bw(ns);
+        bw.writeVarUInt(ticks);
+        bw.writeVarUInt((uint32_t)entries.size());
+        for (const StateEntry& entry : entries)
+            bw.writeString(entry.m_name);
+        for (uint16_t size : sizes)
+            bw.writeVarUInt(size);
+    }
+    else
+    {
+        ns->addUInt8(GP_STATE).addUInt32(ticks)
+            .addUInt8((uint8_t)entries.size());
+        for (const StateEntry& entry : entries)
+            ns->encodeString(entry.m_name);
+    }
+    const uint8_t* data = (const uint8_t*)m_data_to_send->getData();
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        if (!compact)
+            ns->addUInt16(sizes[i]);
+        ns->getBuffer().insert(ns->getBuffer().end(),
+            data + entries[i].m_offset,
+            data + entries[i].m_offset + sizes[i]);
+    }
+    return ns;
+}   // buildState
+
+// ----------------------------------------------------------------------------
+/** Selects the rewinder states sent to a peer according to the distance
+ *  of the karts to the nearest kart of this peer.
+ *  \param peer The peer to send the state to.
+ *  \param entries The rewinder states in m_data_to_send.
+ *  \param selected Returns which rewinder states are sent.
+ *  \return False if the full state should be sent (e.g. for spectators).
+ */
+bool GameProtocol::selectStatesForPeer(STKPeer *peer,
+                                       const std::vector<StateEntry>& entries,
+                                       std::vector<bool> *selected)
+{
+    World* w = World::getWorld();
+    const std::set<unsigned>& kart_ids = peer->getAvailableKartIDs();
+    if (!w || kart_ids.empty() || ServerConfig::m_state_budget <= 0)
+        return false;
+
+    std::vector<Vec3> own_karts;
+    for (unsigned id : kart_ids)
+    {
+        if (id < w->getNumKarts() && !w->getKart(id)->isEliminated())
+            own_karts.push_back(w->getKart(id)->getXYZ());
+    }
+    if (own_karts.empty())
+        return false;
+
+    auto& priorities = m_state_priorities[peer->getHostId()];
+    std::vector<float> distances(entries.size(), -1.0f);
+    std::vector<uint16_t> sizes(entries.size());
+    std::vector<StatePriority> entry_priorities(entries.size());
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        const std::string& name = entries[i].m_name;
+        sizes[i] = entries[i].m_size;
+        // Only karts are sent less often, other rewinders (e.g. physical
+        // objects) already skip unchanged states
+        if (name.size() != 2 || name[0] != RN_KART)
+            continue;
+        unsigned id = (uint8_t)name[1];
+        if (id >= w->getNumKarts())
+            continue;
+        if (kart_ids.find(id) != kart_ids.end())
+        {
+            distances[i] = 0.0f;
+            continue;
+        }
+        const Vec3& xyz = w->getKart(id)->getXYZ();
+        float d = std::numeric_limits<float>::max();
+        for (const Vec3& own : own_karts)
+            d = std::min(d, (xyz - own).length());
+        distances[i] = d;
+        entry_priorities[i] = priorities[name];
+    }
+
+    const int state_frequency = NetworkConfig::get()->getStateFrequency();
+    selectStates(distances, sizes, ServerConfig::m_state_near_distance,
+        ServerConfig::m_state_budget / state_frequency,
+        /*max_skipped*/state_frequency, &entry_priorities, selected);
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        if (distances[i] > 0.0f)
+            priorities[entries[i].m_name] = entry_priorities[i];
+    }
+    return true;
+}   // selectStatesForPeer
+
+// ----------------------------------------------------------------------------
+/** Selects the rewinder states sent in a state. States with a negative
+ *  distance (not karts), or within the near distance are always sent.
+ *  The priority of each far state increases with each skipped state,
+ *  faster the closer it is. Far states are then sent with the highest
+ *  priority first as long as the budget allows, and regardless of the
+ *  budget if they were skipped max_skipped times already.
+ *  \param distances Distance of each state to the nearest kart of a peer.
+ *  \param sizes Size of each state.
+ *  \param near_distance States within this distance are always sent.
+ *  \param budget Bytes available for far states.
+ *  \param max_skipped Maximum number of consecutive skipped states.
+ *  \param priorities The priority of each state, which are updated.
+ *  \param selected Returns which rewinder states are sent.
+ */
+void GameProtocol::selectStates(const std::vector<float>& distances,
+                                const std::vector<uint16_t>& sizes,
+                                float near_distance, int budget,
+                                int max_skipped,
+                                std::vector<StatePriority> *priorities,
+                                std::vector<bool> *selected)
+{
+    selected->assign(distances.size(), false);
+    std::vector<unsigned> far_states;
+    for (unsigned i = 0; i < distances.size(); i++)
+    {
+        StatePriority& sp = (*priorities)[i];
+        if (distances[i] <= near_distance)
+            (*selected)[i] = true;
+        else if (sp.m_skipped >= max_skipped)
+        {
+            (*selected)[i] = true;
+            budget -= sizes[i];
+        }
+        else
+        {
+            sp.m_priority += near_distance / distances[i];
+            far_states.push_back(i);
+        }
+    }
+    std::stable_sort(far_states.begin(), far_states.end(),
+        [priorities](unsigned a, unsigned b)
+        {
+            return (*priorities)[a].m_priority > (*priorities)[b].m_priority;
+        });
+    for (unsigned i : far_states)
+    {
+        if (sizes[i] > budget)
+            continue;
+        (*selected)[i] = true;
+        budget -= sizes[i];
+    }
+    for (unsigned i = 0; i < distances.size(); i++)
+    {
+        if ((*selected)[i])
+            (*priorities)[i] = StatePriority();
+        else
+            (*priorities)[i].m_skipped++;
+    }
+}   // selectStates
+
 // ----------------------------------------------------------------------------
 /** Called when a new full state is received form the server.
+ *  \param compact If the state uses the compact codec, in which case it is
+ *         converted back to the format expected by RewindInfoState.
  */
-void GameProtocol::handleState(Event *event)
+void GameProtocol::handleState(Event *event, bool compact)
 {
     assert(NetworkConfig::get()->isClient());
     NetworkString &data = event->data();
+    if (compact)
+    {
+        BitReader br(&data);
+        int ticks = (int)br.readVarUInt();
+        unsigned rewinder_size = (unsigned)br.readVarUInt();
+        if (rewinder_size > data.size())
+            throw std::out_of_range("Too many rewinders in state.");
+        std::vector<std::string> rewinder_using(rewinder_size);
+        for (unsigned i = 0; i < rewinder_size; i++)
+            br.readString(&rewinder_using[i]);
+        std::vector<uint16_t> sizes(rewinder_size);
+        for (unsigned i = 0; i < rewinder_size; i++)
+            sizes[i] = (uint16_t)br.readVarUInt();
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(data.size() + rewinder_size * 2);
+        for (uint16_t size : sizes)
+        {
+            if (size > data.size())
+                throw std::out_of_range("State size out of range.");
+            buffer.push_back((size >> 8) & 0xff);
+            buffer.push_back(size & 0xff);
+            const uint8_t* start = (const uint8_t*)data.getCurrentData();
+            buffer.insert(buffer.end(), start, start + size);
+            data.skip(size);
+        }
+        // The memory for bns will be handled in the RewindInfoState object
+        RewindInfoState* ris = new RewindInfoState(ticks, 0, rewinder_using,
+            buffer);
+        RewindManager::get()->addNetworkRewindInfo(ris);
+        return;
+    }
+
     int ticks          = data.getUInt32();
 
     // Check for updated rewinder using
@@ -462,3 +1007,225 @@ void GameProtocol::addInitialTicks(STKPeer* p, int ticks)
         p->getHostId(), ticks);
     m_initial_ticks[p] = ticks;
 }   // addInitialTicks
+
+// ----------------------------------------------------------------------------
+/** Simulates a client sending controller actions to the server over a link
+ *  with latency, jitter and packet loss: once reliable (a lost packet is
+ *  resent after a round trip, and later packets wait for it) and once
+ *  unreliable with redundant actions. Each packet that arrives later than
+ *  the jitter tolerance of the server causes a rewind on the server and on
+ *  all other clients. Checks that with redundant actions all actions arrive
+ *  exactly once and in order, and that they cause fewer rewinds.
+ */
+void GameProtocol::unitTesting()
+{
+    auto check = [](bool ok, const char* what)
+    {
+        if (!ok)
+            Log::fatal("GameProtocol", "Test failed: %s.", what);
+    };
+    const int latency   = 12;   // one way, 100ms at 120 ticks per second
+    const int jitter    = 3;
+    const int tolerance = 6;    // allowed delay on top of the latency
+    const int duration  = 120 * 600;
+    // Actions are sent each frame, with several frames per tick (e.g. at
+    // 360 fps) the actions of one tick are split over packets
+    const int frames_per_tick = 3;
+    for (float loss : { 0.02f, 0.05f, 0.2f })
+    {
+        std::mt19937 rng(7);
+        auto lost = [&rng, loss]()
+            { return std::uniform_real_distribution<float>()(rng) < loss; };
+        auto delay = [&rng]() { return latency + (int)(rng() % (jitter + 1)); };
+
+        std::vector<Action> all;
+        std::vector<int> frames;
+        for (int f = 0; f < duration * frames_per_tick; f++)
+        {
+            if (rng() % 16 != 0)
+                continue;
+            for (unsigned i = 1 + rng() % 3; i > 0; i--)
+            {
+                Action a;
+                a.m_ticks   = f / frames_per_tick;
+                a.m_seq     = 0;
+                a.m_kart_id = rng() % 2;
+                a.m_action  = (PlayerAction)(rng() % PA_COUNT);
+                a.m_value   = rng() % 32768;
+                a.m_value_l = (int)(rng() % 65535) - 32767;
+                a.m_value_r = (int)(rng() % 65535) - 32767;
+                all.push_back(a);
+                frames.push_back(f);
+            }
+        }
+
+        // Reliable: one packet for the actions of each tick
+        std::set<int> rewinds_reliable;
+        int delivered = 0;
+        for (unsigned i = 0; i < all.size(); i++)
+        {
+            if (i > 0 && all[i].m_ticks == all[i - 1].m_ticks)
+                continue;
+            int arrival = all[i].m_ticks + delay();
+            while (lost())
+                arrival += 2 * latency;
+            delivered = std::max(delivered, arrival);
+            if (delivered - all[i].m_ticks > latency + tolerance)
+                rewinds_reliable.insert(delivered);
+        }
+
+        // Unreliable with redundant actions, sent each frame with new
+        // actions, and each tick while there are unacknowledged actions
+        std::set<int> rewinds_redundant;
+        std::vector<Action> unacked, received;
+        uint32_t next_seq = 0, next_received_seq = 0;
+        std::multimap<int, std::vector<uint8_t> > to_server;
+        std::multimap<int, uint32_t> acks;
+        unsigned next = 0, bytes = 0;
+        int sent_ticks = -1;
+        for (int f = 0; f < (duration + 100 * latency) * frames_per_tick; f++)
+        {
+            const int t = f / frames_per_tick;
+            for (auto it = acks.begin(); it != acks.end() && it->first <= t;)
+            {
+                removeAckedActions(it->second, &unacked);
+                it = acks.erase(it);
+            }
+            bool new_actions = false;
+            while (next < all.size() && frames[next] == f)
+            {
+                unacked.push_back(all[next++]);
+                unacked.back().m_seq = next_seq++;
+                new_actions = true;
+            }
+            if (new_actions || (!unacked.empty() && t != sent_ticks))
+            {
+                sent_ticks = t;
+                std::vector<Action> actions;
+                getRedundantActions(unacked, &actions);
+                NetworkString ns(PROTOCOL_CONTROLLER_EVENTS);
+                encodeActions(&ns, actions, /*compact*/f % 2 == 0,
+                              /*sequence*/true);
+                bytes += ns.getTotalSize();
+                if (!lost())
+                    to_server.emplace(t + delay(), ns.getBuffer());
+            }
+
+            for (auto it = to_server.begin();
+                 it != to_server.end() && it->first <= t;)
+            {
+                NetworkString ns(it->second.data(), (int)it->second.size());
+                const uint8_t type = ns.getUInt8();
+                std::vector<Action> actions;
+                decodeActions(ns, type == GP_CONTROLLER_ACTION_COMPACT,
+                              /*sequence*/true, &actions);
+                check(ns.size() == 0, "decoded actions size");
+                if (!lost())
+                    acks.emplace(t + delay(), actions.back().m_seq);
+                removeRepeatedActions(&next_received_seq, &actions);
+                for (const Action& a : actions)
+                {
+                    received.push_back(a);
+                    if (t - a.m_ticks > latency + tolerance)
+                        rewinds_redundant.insert(t);
+                }
+                it = to_server.erase(it);
+            }
+        }
+
+        check(unacked.empty(), "all actions acknowledged");
+        check(received.size() == all.size(), "number of received actions");
+        for (unsigned i = 0; i < all.size(); i++)
+        {
+            check(received[i].m_ticks   == all[i].m_ticks   &&
+                  received[i].m_kart_id == all[i].m_kart_id &&
+                  received[i].m_action  == all[i].m_action  &&
+                  received[i].m_value   == all[i].m_value   &&
+                  received[i].m_value_l == all[i].m_value_l &&
+                  received[i].m_value_r == all[i].m_value_r,
+                  "received actions in order");
+        }
+        Log::info("GameProtocol", "%d%% loss: %d rewinds with reliable "
+            "actions, %d with redundant actions (%u bytes sent).",
+            (int)(loss * 100.0f + 0.5f), (int)rewinds_reliable.size(),
+            (int)rewinds_redundant.size(), bytes);
+        if (rewinds_redundant.size() >= rewinds_reliable.size())
+        {
+            Log::fatal("GameProtocol", "Redundant actions did not reduce "
+                       "the number of rewinds.");
+        }
+    }
+
+    // Selection of kart states for partial states: 16 karts on a line with
+    // the own kart at 0, and a few other rewinders which are always sent
+    std::vector<float> distances;
+    std::vector<uint16_t> sizes;
+    for (unsigned i = 0; i < 16; i++)
+    {
+        distances.push_back(i * 20.0f);
+        sizes.push_back(60);
+    }
+    for (unsigned i = 0; i < 4; i++)
+    {
+        distances.push_back(-1.0f);
+        sizes.push_back(40);
+    }
+    const float near_distance = 40.0f;
+    const int budget = 2048 / 10;
+    const int max_skipped = 10;
+    std::vector<StatePriority> priorities(distances.size());
+    std::vector<int> last_sent(distances.size(), -1);
+    std::vector<int> num_sent(distances.size(), 0);
+    unsigned full_bytes = 0, partial_bytes = 0;
+    const int num_states = 100;
+    for (int state = 0; state < num_states; state++)
+    {
+        std::vector<bool> selected;
+        selectStates(distances, sizes, near_distance, budget, max_skipped,
+                     &priorities, &selected);
+        for (unsigned i = 0; i < distances.size(); i++)
+        {
+            full_bytes += sizes[i];
+            if (distances[i] <= near_distance && !selected[i])
+            {
+                Log::fatal("GameProtocol", "Near state %u was skipped.", i);
+            }
+            if (!selected[i])
+                continue;
+            num_sent[i]++;
+            partial_bytes += sizes[i];
+            if (state - last_sent[i] > max_skipped + 1)
+            {
+                Log::fatal("GameProtocol", "State %u was skipped %d times.",
+                           i, state - last_sent[i] - 1);
+            }
+            last_sent[i] = state;
+        }
+    }
+    // Far karts are sent less often, the farthest ones least often: each
+    // far kart in at most 3/4 and the farthest one in at most 1/4 of all
+    // states
+    for (unsigned i = 0; i < 16; i++)
+    {
+        if (distances[i] <= near_distance)
+            continue;
+        const int max_sent = i == 15 ? num_states / 4 : num_states * 3 / 4;
+        if (num_sent[i] > max_sent)
+        {
+            Log::fatal("GameProtocol", "Far state %u was sent %d times.", i,
+                       num_sent[i]);
+        }
+        if (num_sent[i] > num_sent[i - 1] + 1)
+        {
+            Log::fatal("GameProtocol", "State %u was sent more often than "
+                       "the closer state %u.", i, i - 1);
+        }
+    }
+    Log::info("GameProtocol", "Partial states: %u of %u bytes sent (%d%%).",
+        partial_bytes, full_bytes, (int)(partial_bytes * 100 / full_bytes));
+    if (partial_bytes * 2 > full_bytes)
+    {
+        Log::fatal("GameProtocol", "Partial states did not reduce the "
+                   "state size.");
+    }
+}   // unitTesting
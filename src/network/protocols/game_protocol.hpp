@@ -29,6 +29,7 @@
 #include <cstdlib>
 #include <map>
 #include <mutex>
+#include <string>
 #include <vector>
 #include <tuple>
 
@@ -49,7 +50,12 @@ private:
            GP_STATE,
            GP_ITEM_UPDATE,
            GP_ITEM_CONFIRMATION,
-           GP_ADJUST_TIME
+           GP_ADJUST_TIME,
+           // Same as GP_CONTROLLER_ACTION and GP_STATE, but using the compact
+           // (bit packed) codec, only sent to peers which negotiated it
+           GP_CONTROLLER_ACTION_COMPACT,
+           GP_STATE_COMPACT,
+           GP_ACTIONS_ACK
     };
 
     /** A network string that collects all information from the server to be sent
@@ -69,20 +75,90 @@ private:
         int          m_value;
         int          m_value_l;
         int          m_value_r;
+        /** Number of the action among all actions of a client, only used
+         *  for actions sent unreliably. */
+        uint32_t     m_seq;
     };   // struct Action
 
     // List of all kart actions to send to the server
     std::vector<Action> m_all_actions;
 
-    void handleControllerAction(Event *event);
-    void handleState(Event *event);
+    /** Client: actions sent unreliably, which the server has not
+     *  acknowledged yet. They are repeated in each packet. */
+    std::vector<Action> m_unacked_actions;
+
+    /** Protects m_unacked_actions, acknowledgements are handled in the
+     *  protocol thread. */
+    std::mutex m_unacked_actions_mutex;
+
+    /** Client: world ticks when the unacknowledged actions were last sent,
+     *  to repeat them at most once per tick. */
+    int m_unacked_sent_ticks;
+
+    /** Client: sequence number of the next action sent unreliably. */
+    uint32_t m_next_action_seq;
+
+    /** Server: for each peer (by host id) the sequence number of the next
+     *  new action, used to remove repeated actions. */
+    std::map<uint32_t, uint32_t> m_next_received_action_seqs;
+
+    void handleControllerAction(Event *event, bool compact);
+    void handleState(Event *event, bool compact);
+    void handleActionsAck(Event *event);
+    static void encodeActions(NetworkString *ns,
+                              const std::vector<Action>& actions,
+                              bool compact, bool sequence);
+    static void decodeActions(const NetworkString &ns, bool compact,
+                              bool sequence, std::vector<Action> *actions);
+    static void getRedundantActions(const std::vector<Action>& unacked,
+                                    std::vector<Action> *actions);
+    static void removeAckedActions(uint32_t seq,
+                                   std::vector<Action> *unacked);
+    static void removeRepeatedActions(uint32_t *next_seq,
+                                      std::vector<Action> *actions);
+    /** Server: position of one rewinder state in m_data_to_send. */
+    struct StateEntry
+    {
+        std::string m_name;
+        unsigned    m_offset;
+        uint16_t    m_size;
+    };   // struct StateEntry
+
+    /** Server: priority of a rewinder state which was skipped for a peer,
+     *  see selectStates(). */
+    struct StatePriority
+    {
+        float m_priority;
+        int   m_skipped;
+        StatePriority() : m_priority(0.0f), m_skipped(0) {}
+    };   // struct StatePriority
+
+    /** Server: the priorities of the skipped states of each peer (by host
+     *  id) and rewinder. */
+    std::map<uint32_t, std::map<std::string, StatePriority> >
+        m_state_priorities;
+
+    int getStateEntries(std::vector<StateEntry> *entries);
+    NetworkString* buildState(int ticks,
+                              const std::vector<StateEntry>& entries,
+                              const std::vector<bool>* selected,
+                              bool compact);
+    bool selectStatesForPeer(STKPeer *peer,
+                             const std::vector<StateEntry>& entries,
+                             std::vector<bool> *selected);
+    static void selectStates(const std::vector<float>& distances,
+                             const std::vector<uint16_t>& sizes,
+                             float near_distance, int budget,
+                             int max_skipped,
+                             std::vector<StatePriority> *priorities,
+                             std::vector<bool> *selected);
     void handleAdjustTime(Event *event);
     void handleItemEventConfirmation(Event *event);
     static std::weak_ptr<GameProtocol> m_game_protocol;
     std::map<STKPeer*, int> m_initial_ticks;
     std::map<STKPeer*, double> m_last_adjustments;
     // Maximum value of values are only 32768
-    std::tuple<uint8_t, uint16_t, uint16_t, uint16_t>
+    static std::tuple<uint8_t, uint16_t, uint16_t, uint16_t>
                                                 compressAction(const Action& a)
     {
         uint8_t w = (uint8_t)(a.m_action & 63) |
@@ -92,7 +168,7 @@ private:
         uint16_t z = (uint16_t)std::abs(a.m_value_r);
         return std::make_tuple(w, x, y, z);
     }
-    std::tuple<PlayerAction, int, int, int>
+    static std::tuple<PlayerAction, int, int, int>
                decompressAction(uint8_t w, uint16_t x, uint16_t y , uint16_t z)
     {
         PlayerAction a = (PlayerAction)(w & 63);
@@ -106,6 +182,7 @@ private:
 public:
              GameProtocol();
     virtual ~GameProtocol();
+    static void unitTesting();
 
     virtual bool notifyEventAsynchronous(Event* event) OVERRIDE;
     virtual void update(int ticks) OVERRIDE {}
@@ -73,7 +73,8 @@ public:
         LE_LIVE_JOIN, // Client live join or spectate
         LE_LIVE_JOIN_ACK, // Server tell client live join or spectate succeed
         LE_KART_INFO, // Client or server exchange new kart info
-        LE_CLIENT_BACK_LOBBY // Client tell server to go back lobby
+        LE_CLIENT_BACK_LOBBY, // Client tell server to go back lobby
+        LE_LIVE_JOIN_CHUNK // Server sends a part of the live join state
     };
 
     enum RejectReason : uint8_t
@@ -27,6 +27,7 @@
 #include "karts/kart_properties_manager.hpp"
 #include "modes/capture_the_flag.hpp"
 #include "modes/linear_world.hpp"
+#include "network/bit_packer.hpp"
 #include "network/crypto.hpp"
 #include "network/event.hpp"
 #include "network/game_setup.hpp"
@@ -253,6 +254,7 @@ void ServerLobby::setup()
     m_item_seed = 0;
     m_winner_peer_id = 0;
     m_client_starting_time = 0;
+    m_live_join_streams.clear();
     auto players = STKHost::get()->getPlayersForNewGame();
     if (m_game_setup->isGrandPrix() && !m_game_setup->isGrandPrixStarted())
     {
@@ -651,7 +653,10 @@ void ServerLobby::asynchronousUpdate()
             }
 
             NetworkString* load_world_message = getLoadWorldMessage(players,
-                false/*live_join*/);
+                false/*live_join*/, false/*compact*/);
+            NetworkString* load_world_message_compact =
+                getLoadWorldMessage(players, false/*live_join*/,
+                true/*compact*/);
             m_game_setup->setHitCaptureTime(m_battle_hit_capture_limit,
                 m_battle_time_limit);
             uint16_t flag_return_time = (uint16_t)stk_config->time2Ticks(
@@ -665,8 +670,20 @@ void ServerLobby::asynchronousUpdate()
             // Reset for next state usage
             resetPeersReady();
             m_state = LOAD_WORLD;
-            sendMessageToPeers(load_world_message);
+            STKHost::get()->sendPacketToAllPeersWith(
+                [](STKPeer* p)
+                {
+                    return p->isValidated() && !p->isWaitingForGame() &&
+                        !p->useCompactCodec();
+                }, load_world_message);
+            STKHost::get()->sendPacketToAllPeersWith(
+                [](STKPeer* p)
+                {
+                    return p->isValidated() && !p->isWaitingForGame() &&
+                        p->useCompactCodec();
+                }, load_world_message_compact);
             delete load_world_message;
+            delete load_world_message_compact;
         }
         break;
     }
@@ -677,9 +694,37 @@ void ServerLobby::asynchronousUpdate()
 }   // asynchronousUpdate
 
 //-----------------------------------------------------------------------------
+/** Encodes the list of players for the load world message and live join.
+ *  \param bns The network string to append to.
+ *  \param players The players to encode.
+ *  \param compact If true, use the compact (bit packed) codec, which must
+ *         have been negotiated with the receiving peer.
+ */
 void ServerLobby::encodePlayers(BareNetworkString* bns,
-        std::vector<std::shared_ptr<NetworkPlayerProfile> >& players) const
+        std::vector<std::shared_ptr<NetworkPlayerProfile> >& players,
+        bool compact) const
 {
+    if (compact)
+    {
+        BitWriter bw(bns);
+        bw.writeVarUInt(players.size());
+        for (unsigned i = 0; i < players.size(); i++)
+        {
+            std::shared_ptr<NetworkPlayerProfile>& player = players[i];
+            bw.writeString(player->getName())
+                .writeVarUInt(player->getHostId())
+                .writeFloat(player->getDefaultKartColor())
+                .writeVarUInt(player->getOnlineId())
+                .writeVarUInt(player->getPerPlayerDifficulty())
+                .writeVarUInt(player->getLocalPlayerId())
+                .writeVarInt(race_manager->teamEnabled() ?
+                             player->getTeam() : KART_TEAM_NONE)
+                .writeString(player->getCountryId())
+                .writeString(player->getKartName());
+        }
+        return;
+    }
+
     bns->addUInt8((uint8_t)players.size());
     for (unsigned i = 0; i < players.size(); i++)
     {
@@ -700,7 +745,7 @@ void ServerLobby::encodePlayers(BareNetworkString* bns,
 //-----------------------------------------------------------------------------
 NetworkString* ServerLobby::getLoadWorldMessage(
     std::vector<std::shared_ptr<NetworkPlayerProfile> >& players,
-    bool live_join) const
+    bool live_join, bool compact) const
 {
     NetworkString* load_world_message = getNetworkString();
     load_world_message->setSynchronous(true);
@@ -708,7 +753,7 @@ NetworkString* ServerLobby::getLoadWorldMessage(
     load_world_message->addUInt32(m_winner_peer_id);
     m_default_vote->encode(load_world_message);
     load_world_message->addUInt8(live_join ? 1 : 0);
-    encodePlayers(load_world_message, players);
+    encodePlayers(load_world_message, players, compact);
     load_world_message->addUInt32(m_item_seed);
     if (race_manager->isBattleMode())
     {
@@ -856,7 +901,7 @@ void ServerLobby::liveJoinRequest(Event* event)
     std::vector<std::shared_ptr<NetworkPlayerProfile> > players =
         getLivePlayers();
     NetworkString* load_world_message = getLoadWorldMessage(players,
-        true/*live_join*/);
+        true/*live_join*/, peer->useCompactCodec());
     peer->sendPacket(load_world_message, true/*reliable*/);
     delete load_world_message;
     peer->updateLastActivity();
@@ -1018,6 +1063,7 @@ void ServerLobby::finishedLoadingLiveJoinClient(Event* event)
         spectator = true;
     }
 
+    const double start_time = StkTime::getRealTime();
     const uint8_t cc = (uint8_t)CheckManager::get()->getCheckStructureCount();
     NetworkString* ns = getNetworkString(10);
     ns->setSynchronous(true);
@@ -1038,19 +1084,90 @@ void ServerLobby::finishedLoadingLiveJoinClient(Event* event)
         // starting of race
         std::vector<std::shared_ptr<NetworkPlayerProfile> > players =
             getLivePlayers();
-        encodePlayers(ns, players);
+        encodePlayers(ns, players, peer->useCompactCodec());
     }
 
     m_peers_ready[peer] = false;
-    peer->setWaitingForGame(false);
     peer->setSpectator(spectator);
 
-    peer->sendPacket(ns, true/*reliable*/);
+    const double save_time = (StkTime::getRealTime() - start_time) * 1000.0;
+    const int chunk_size = ServerConfig::m_live_join_chunk_size;
+    if (peer->useChunkedLiveJoin() && chunk_size > 0 &&
+        ns->getTotalSize() > (unsigned)chunk_size)
+    {
+        // Send the state in chunks (one per update, see sendLiveJoinChunks),
+        // which spreads its bandwidth over several updates instead of
+        // queueing it at once. The peer only gets game states and actions
+        // once the last chunk is queued, so they follow the complete state.
+        LiveJoinStream stream;
+        stream.m_peer       = peer;
+        stream.m_data       = ns->getBuffer();
+        stream.m_sent       = 0;
+        stream.m_chunk_size = chunk_size;
+        stream.m_start_time = start_time;
+        m_live_join_streams.push_back(stream);
+        Log::info("ServerLobby", "Live join state for %s has %d bytes, saved "
+            "in %.2f ms, sending in %d chunks.",
+            peer->getAddress().toString().c_str(), (int)ns->getTotalSize(),
+            save_time,
+            (int)(ns->getTotalSize() + chunk_size - 1) / chunk_size);
+    }
+    else
+    {
+        Log::info("ServerLobby", "Live join state for %s has %d bytes, saved "
+            "in %.2f ms.", peer->getAddress().toString().c_str(),
+            (int)ns->getTotalSize(), save_time);
+        peer->sendPacket(ns, true/*reliable*/);
+        peer->setWaitingForGame(false);
+    }
     delete ns;
     updatePlayerList();
     peer->updateLastActivity();
 }   // finishedLoadingLiveJoinClient
 
+//-----------------------------------------------------------------------------
+/** Sends the next chunk of each live join state which is still being
+ *  streamed. The client puts the chunks together and handles them like a
+ *  single LE_LIVE_JOIN_ACK message. Once the last chunk is queued the peer
+ *  is in the game, and gets game states and actions.
+ */
+void ServerLobby::sendLiveJoinChunks()
+{
+    for (auto it = m_live_join_streams.begin();
+         it != m_live_join_streams.end();)
+    {
+        std::shared_ptr<STKPeer> peer = it->m_peer.lock();
+        if (!peer || peer->isDisconnected())
+        {
+            it = m_live_join_streams.erase(it);
+            continue;
+        }
+        const unsigned total = (unsigned)it->m_data.size();
+        const unsigned len = std::min(it->m_chunk_size, total - it->m_sent);
+        NetworkString* chunk = getNetworkString(9 + len);
+        chunk->setSynchronous(true);
+        chunk->addUInt8(LE_LIVE_JOIN_CHUNK).addUInt32(total)
+            .addUInt32(it->m_sent);
+        *chunk += BareNetworkString(
+            (const char*)it->m_data.data() + it->m_sent, len);
+        peer->sendPacket(chunk, true/*reliable*/);
+        delete chunk;
+
+        it->m_sent += len;
+        if (it->m_sent < total)
+        {
+            it++;
+            continue;
+        }
+        Log::info("ServerLobby", "Live join state for %s sent after %.2f ms.",
+            peer->getAddress().toString().c_str(),
+            (StkTime::getRealTime() - it->m_start_time) * 1000.0);
+        peer->setWaitingForGame(false);
+        it = m_live_join_streams.erase(it);
+        updatePlayerList();
+    }
+}   // sendLiveJoinChunks
+
 //-----------------------------------------------------------------------------
 /** Simple finite state machine.  Once this
  *  is known, register the server and its address with the stk server so that
@@ -1109,6 +1226,9 @@ void ServerLobby::update(int ticks)
     else
         resetGameStartedProgress();
 
+    if (!m_live_join_streams.empty())
+        sendLiveJoinChunks();
+
     if (w && w->getPhase() == World::RACE_PHASE)
     {
         storePlayingTrack(track_manager->getTrackIndexByIdent(
@@ -2116,6 +2236,16 @@ void ServerLobby::connectionRequested(Event* event)
         data.decodeString(&cap);
         caps.push_back(cap);
     }
+    // Use the compact codec only if both sides support it, the accepted
+    // capability is sent back in the connection accepted message
+    event->getPeer()->setCompactCodec(ServerConfig::m_compact_codec &&
+        std::find(caps.begin(), caps.end(), "compact_codec") != caps.end());
+    event->getPeer()->setRedundantActions(std::find(caps.begin(), caps.end(),
+        "redundant_actions") != caps.end());
+    event->getPeer()->setPartialStates(ServerConfig::m_state_budget > 0 &&
+        std::find(caps.begin(), caps.end(), "partial_states") != caps.end());
+    event->getPeer()->setChunkedLiveJoin(std::find(caps.begin(), caps.end(),
+        "chunked_live_join") != caps.end());
     event->getPeer()->setClientCapabilities(caps);
 
     std::set<std::string> client_karts, client_tracks;
@@ -2379,12 +2509,25 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
     message_ack->addUInt8(LE_CONNECTION_ACCEPTED).addUInt32(peer->getHostId())
         .addUInt32(ServerConfig::m_server_version);
 
-    // Reserved for future to supply list of network capabilities
-    message_ack->addUInt16(0);
+    // List of network capabilities accepted for this peer
+    std::vector<std::string> accepted_caps;
+    if (peer->useCompactCodec())
+        accepted_caps.push_back("compact_codec");
+    if (peer->useRedundantActions())
+        accepted_caps.push_back("redundant_actions");
+    if (peer->usePartialStates())
+        accepted_caps.push_back("partial_states");
+    if (peer->useChunkedLiveJoin())
+        accepted_caps.push_back("chunked_live_join");
+    message_ack->addUInt16((uint16_t)accepted_caps.size());
+    for (const std::string& cap : accepted_caps)
+        message_ack->encodeString(cap);
 
     message_ack->addFloat(auto_start_timer)
         .addUInt32(ServerConfig::m_state_frequency)
         .addUInt8(ServerConfig::m_chat ? 1 : 0);
+    if (peer->usePartialStates())
+        message_ack->addFloat(ServerConfig::m_state_near_distance);
 
     peer->setSpectator(false);
     if (game_started)
@@ -178,6 +178,23 @@ private:
 
     uint64_t m_client_starting_time;
 
+    /** A live join state which is sent to a peer in chunks. */
+    struct LiveJoinStream
+    {
+        std::weak_ptr<STKPeer> m_peer;
+        /** The complete live join acknowledgement message. */
+        std::vector<uint8_t> m_data;
+        /** Number of bytes of m_data which have been sent. */
+        unsigned m_sent;
+        /** Maximum number of bytes sent per update. */
+        unsigned m_chunk_size;
+        /** Real time when the state was saved, for statistics. */
+        double m_start_time;
+    };
+
+    /** Live join states which are still being sent. */
+    std::vector<LiveJoinStream> m_live_join_streams;
+
     // connection management
     void clientDisconnected(Event* event);
     void connectionRequested(Event* event);
@@ -189,6 +206,7 @@ private:
     bool registerServer(bool now);
     void finishedLoadingWorldClient(Event *event);
     void finishedLoadingLiveJoinClient(Event *event);
+    void sendLiveJoinChunks();
     void kickHost(Event* event);
     void changeTeam(Event* event);
     void handleChat(Event* event);
@@ -282,9 +300,10 @@ private:
         std::vector<std::shared_ptr<NetworkPlayerProfile> >& players) const;
     NetworkString* getLoadWorldMessage(
         std::vector<std::shared_ptr<NetworkPlayerProfile> >& players,
-        bool live_join) const;
+        bool live_join, bool compact) const;
     void encodePlayers(BareNetworkString* bns,
-        std::vector<std::shared_ptr<NetworkPlayerProfile> >& players) const;
+        std::vector<std::shared_ptr<NetworkPlayerProfile> >& players,
+        bool compact) const;
     std::vector<std::shared_ptr<NetworkPlayerProfile> > getLivePlayers() const;
     void setPlayerKarts(const NetworkString& ns, STKPeer* peer) const;
     void liveJoinRequest(Event* event);
@@ -19,13 +19,17 @@
 #include "network/rewind_manager.hpp"
 
 #include "graphics/irr_driver.hpp"
+#include "karts/controller/controller.hpp"
+#include "karts/kart_rewinder.hpp"
 #include "modes/world.hpp"
+#include "network/compress_network_body.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
 #include "network/protocols/game_protocol.hpp"
 #include "network/rewinder.hpp"
 #include "network/rewind_info.hpp"
 #include "network/smooth_network_body.hpp"
+#include "network/tick_budget_monitor.hpp"
 #include "physics/physics.hpp"
 #include "race/history.hpp"
 #include "tracks/check_manager.hpp"
@@ -61,6 +65,7 @@ void RewindManager::destroy()
  */
 RewindManager::RewindManager()
 {
+    m_body_batch.reset(new CompressNetworkBody::Batch());
     reset();
 }   // RewindManager
 
@@ -90,6 +95,7 @@ void RewindManager::reset()
 
     clearExpiredRewinder();
     m_rewind_queue.reset();
+    m_local_kart_state.clear();
 }   // reset
 
 // ----------------------------------------------------------------------------    
@@ -158,6 +164,21 @@ void RewindManager::saveState()
     m_overall_state_size = 0;
     std::vector<std::string> rewinder_using;
 
+    // Compress the bodies of all rewinders in one batch, saveState then only
+    // writes the prepared values
+    m_body_batch->clear();
+    for (auto& p : m_all_rewinder)
+    {
+        auto r = p.second.lock();
+        if (!r)
+            continue;
+        btMotionState* ms = NULL;
+        btRigidBody* body = r->getNetworkBody(&ms);
+        if (body)
+            m_body_batch->add(body, ms);
+    }
+    CompressNetworkBody::prepareBatch(m_body_batch.get());
+
     for (auto& p : m_all_rewinder)
     {
         // TODO: check if it's worth passing in a sufficiently large buffer from
@@ -172,6 +193,7 @@ void RewindManager::saveState()
         }
         delete buffer;    // buffer can be freed
     }
+    CompressNetworkBody::clearPreparedBatch();
     gp->finalizeState(rewinder_using);
     PROFILER_POP_CPU_MARKER();
 }   // saveState
@@ -205,17 +227,92 @@ void RewindManager::update(int ticks_not_used)
             if (auto r = p.second.lock())
                 ret.push_back(r->getLocalStateRestoreFunction());
         }
+        if (NetworkConfig::get()->usePartialStates())
+            saveLocalKartStates(ticks);
     }
     else
     {
+        // The state is always saved, since this rounds the physics values
+        // like the clients do at each state tick. A server over its tick
+        // budget then only sends every n-th state, which the clients can
+        // still rewind to, since they save each state ticks locally.
         saveState();
         PROFILER_PUSH_CPU_MARKER("RewindManager - send state", 0x20, 0x7F, 0x40);
-        if (auto gp = GameProtocol::lock())
+        auto gp = GameProtocol::lock();
+        if (gp && TickBudgetMonitor::isDue(
+            TickBudgetMonitor::DS_STATE_FREQUENCY,
+            (ticks + 1) / m_state_frequency))
             gp->sendState();
     }
     PROFILER_POP_CPU_MARKER();
 }   // update
 
+// ----------------------------------------------------------------------------
+/** Client: saves the predicted state of the karts which the server may
+ *  skip in the state of the same ticks. The server always sends the karts
+ *  of this client and the karts near them (see
+ *  GameProtocol::selectStatesForPeer), so those are not saved. The kart
+ *  positions of the server differ slightly from the local prediction, so
+ *  karts a bit closer than the near distance are saved too.
+ *  \param ticks The ticks of the state.
+ */
+void RewindManager::saveLocalKartStates(int ticks)
+{
+    World* w = World::getWorld();
+    std::vector<Vec3> local_karts;
+    for (unsigned i = 0; i < w->getNumKarts(); i++)
+    {
+        AbstractKart* kart = w->getKart(i);
+        if (kart->getController()->isLocalPlayerController() &&
+            !kart->isEliminated())
+            local_karts.push_back(kart->getXYZ());
+    }
+    const float save_distance =
+        NetworkConfig::get()->getStateNearDistance() * 0.75f;
+
+    auto& states = m_local_kart_state[ticks];
+    states.clear();
+    for (unsigned i = 0; i < w->getNumKarts(); i++)
+    {
+        KartRewinder* kr = dynamic_cast<KartRewinder*>(w->getKart(i));
+        if (!kr || kr->getController()->isLocalPlayerController())
+            continue;
+        bool near = false;
+        for (const Vec3& xyz : local_karts)
+        {
+            if ((kr->getXYZ() - xyz).length() < save_distance)
+            {
+                near = true;
+                break;
+            }
+        }
+        if (near)
+            continue;
+        BareNetworkString* buffer = kr->saveLocalState();
+        if (buffer)
+            states[kr->getUniqueIdentity()].reset(buffer);
+    }
+    if (states.empty())
+        m_local_kart_state.erase(ticks);
+}   // saveLocalKartStates
+
+// ----------------------------------------------------------------------------
+/** Returns the predicted state of a kart at the current world ticks, or
+ *  NULL if it was not saved.
+ *  \param name Unique identity of the kart rewinder.
+ */
+BareNetworkString* RewindManager::getLocalKartState(const std::string& name)
+                                                                          const
+{
+    auto it = m_local_kart_state.find(World::getWorld()->getTicksSinceStart());
+    if (it == m_local_kart_state.end())
+        return NULL;
+    auto state = it->second.find(name);
+    if (state == it->second.end())
+        return NULL;
+    return state->second.get();
+}   // getLocalKartState
+
 // ----------------------------------------------------------------------------
 /** Replays all events from the last event played till the specified time.
  *  \param world_ticks Up to (and inclusive) which time events will be replayed.
@@ -356,6 +453,16 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
         m_rewind_queue.next();
         current = m_rewind_queue.getCurrent();
     }
+    // The karts were moved by the restored states
+    world->invalidateKartProximityIndex();
+    for (auto it = m_local_kart_state.begin();
+         it != m_local_kart_state.end();)
+    {
+        if (it->first <= exact_rewind_ticks)
+            it = m_local_kart_state.erase(it);
+        else
+            break;
+    }
 
     // Update check line, so the cannon animation can be replayed correctly
     CheckManager::get()->resetAfterRewind();
@@ -374,6 +481,12 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
     { 
         m_rewind_queue.replayAllEvents(world->getTicksSinceStart());
 
+        // Update the predicted kart states with the corrected simulation
+        if (NetworkConfig::get()->usePartialStates() &&
+            world->getTicksSinceStart() > exact_rewind_ticks &&
+            shouldSaveState(world->getTicksSinceStart()))
+            saveLocalKartStates(world->getTicksSinceStart());
+
         // Now simulate the next time step
         if (!fast_forward)
             world->updateWorld(1);
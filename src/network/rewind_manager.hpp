@@ -32,10 +32,12 @@
 #include <string>
 #include <vector>
 
+class BareNetworkString;
 class Rewinder;
 class RewindInfo;
 class RewindInfoEventFunction;
 class EventRewinder;
+namespace CompressNetworkBody { struct Batch; }
 
 /** \ingroup network
  *  This class manages rewinding. It keeps track of:
@@ -94,6 +96,12 @@ private:
 
     std::map<int, std::vector<std::function<void()> > > m_local_state;
 
+    /** Client: the predicted states of the far away karts at each state
+     *  ticks. The server can skip these karts in a state, which are then
+     *  restored from here (see KartRewinder::restoreState). */
+    std::map<int, std::map<std::string, std::shared_ptr<BareNetworkString> > >
+        m_local_kart_state;
+
     /** A list of all objects that can be rewound. */
     std::map<std::string, std::weak_ptr<Rewinder> > m_all_rewinder;
 
@@ -116,6 +124,10 @@ private:
 
     std::vector<RewindInfoEventFunction*> m_pending_rief;
 
+    /** The bodies compressed for the state that is saved, reused for each
+     *  state. */
+    std::unique_ptr<CompressNetworkBody::Batch> m_body_batch;
+
     RewindManager();
    ~RewindManager();
     // ------------------------------------------------------------------------
@@ -133,6 +145,8 @@ private:
     }
     // ------------------------------------------------------------------------
     void mergeRewindInfoEventFunction();
+    // ------------------------------------------------------------------------
+    void saveLocalKartStates(int ticks);
 
 public:
     // First static functions to manage rewinding.
@@ -180,6 +194,8 @@ public:
     // ------------------------------------------------------------------------
     bool addRewinder(std::shared_ptr<Rewinder> rewinder);
     // ------------------------------------------------------------------------
+    BareNetworkString* getLocalKartState(const std::string& name) const;
+    // ------------------------------------------------------------------------
     /** Returns true if currently a rewind is happening. */
     bool isRewinding() const { return m_is_rewinding; }
 
@@ -26,6 +26,8 @@
 #include <vector>
 
 class BareNetworkString;
+class btMotionState;
+class btRigidBody;
 
 enum RewinderName : char
 {
@@ -99,6 +101,12 @@ public:
      */
     virtual void undoState(BareNetworkString *buffer) = 0;
 
+    // -------------------------------------------------------------------------
+    /** Returns the physics body (and its motion state) which will be
+     *  compressed in the next saveState call, or NULL if saveState will not
+     *  save a body. The RewindManager uses this to compress the bodies of
+     *  all rewinders in one batch. */
+    virtual btRigidBody* getNetworkBody(btMotionState** ms)  { return NULL; }
     // -------------------------------------------------------------------------
     /** Nothing to do here. */
     virtual void reset() {}
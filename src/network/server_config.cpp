@@ -37,6 +37,7 @@ static std::vector<UserConfigParam*> g_server_params;
 #include "network/network_config.hpp"
 #include "network/protocols/lobby_protocol.hpp"
 #include "network/stk_host.hpp"
+#include "network/tick_budget_monitor.hpp"
 #include "race/race_manager.hpp"
 #include "utils/string_utils.hpp"
 
@@ -307,6 +308,7 @@ void loadServerLobbyFromConfig()
         m_state_frequency.revertToDefaults();
     }
     NetworkConfig::get()->setStateFrequency(m_state_frequency);
+    TickBudgetMonitor::init();
 
     if (m_server_difficulty > RaceManager::DIFFICULTY_LAST)
         m_server_difficulty = RaceManager::DIFFICULTY_LAST;
@@ -319,6 +319,49 @@ namespace ServerConfig
         "more rewind, which clients with slow device may have problem playing "
         "this server, use the default value is recommended."));
 
+    SERVER_CFG_PREFIX BoolServerConfigParam m_compact_codec
+        SERVER_CFG_DEFAULT(BoolServerConfigParam(true, "compact-codec",
+        "If true, controller actions, player lists and states are sent bit "
+        "packed (variable length integers, quantized floats and UTF-8 "
+        "strings) to clients which support it, which saves bandwidth. Older "
+        "clients always use the previous fixed width format."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_state_budget
+        SERVER_CFG_DEFAULT(IntServerConfigParam(2048, "state-budget",
+        "Bytes per second each client may receive for the states of karts "
+        "which are far away from all its own karts. Far karts are sent "
+        "less often, ordered by distance and how long they have been "
+        "skipped, and every kart is still sent at least once per second. "
+        "Set to 0 to always send the states of all karts."));
+    SERVER_CFG_PREFIX FloatServerConfigParam m_state_near_distance
+        SERVER_CFG_DEFAULT(FloatServerConfigParam(40.0f,
+        "state-near-distance", "Karts within this distance (in meters) "
+        "of any kart of a client are always included in the states sent "
+        "to it."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_live_join_chunk_size
+        SERVER_CFG_DEFAULT(IntServerConfigParam(1024, "live-join-chunk-size",
+        "Size in bytes of the parts in which the current world state is "
+        "sent to a player who live joins or spectates, one part per server "
+        "update, instead of one large packet. Set to 0 to always send the "
+        "world state in one packet. Older clients always get one packet."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_tick_budget
+        SERVER_CFG_DEFAULT(IntServerConfigParam(80, "tick-budget",
+        "Percentage of the duration of one physics tick which the server may "
+        "use on average for updating the game. If it needs more for several "
+        "seconds, the steps in tick-budget-degradation are applied one after "
+        "another until it is within the budget again, and reverted once "
+        "there is enough time left. Set to 0 to disable."));
+
+    SERVER_CFG_PREFIX StringServerConfigParam m_tick_budget_degradation
+        SERVER_CFG_DEFAULT(StringServerConfigParam(
+        "state-frequency ai", "tick-budget-degradation",
+        "Space separated list of the steps applied in order when the server "
+        "is over its tick budget: state-frequency halves the states sent per "
+        "second and ai updates the AI karts every second tick only. A step "
+        "can be listed more than once to halve the rate again."));
+
     SERVER_CFG_PREFIX StringToUIntServerConfigParam m_server_ip_ban_list
         SERVER_CFG_DEFAULT(StringToUIntServerConfigParam("server-ip-ban-list",
         "ip: IP in X.X.X.X/Y (CIDR) format for banning, use Y of 32 for a "
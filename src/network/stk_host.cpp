@@ -848,6 +848,10 @@ void STKHost::mainLoop()
                     !sl->isRacing() || it->second->isWaitingForGame()))
                 {
                     need_destroy_packet = false;
+                    it->second->countPacket(PacketStatistics::PS_SENT,
+                        PacketStatistics::PING_MESSAGE,
+                        (unsigned)packet->dataLength,
+                        (unsigned)packet->dataLength);
                     enet_peer_send(it->first, EVENT_CHANNEL_UNENCRYPTED, packet);
                 }
 
@@ -971,6 +975,10 @@ void STKHost::mainLoop()
                 auto& peer = m_peers.at(event.peer);
                 if (isPingPacket(event.packet->data, event.packet->dataLength))
                 {
+                    peer->countPacket(PacketStatistics::PS_RECEIVED,
+                        PacketStatistics::PING_MESSAGE,
+                        (unsigned)event.packet->dataLength,
+                        (unsigned)event.packet->dataLength);
                     if (!is_server)
                     {
                         BareNetworkString ping_packet((char*)event.packet->data,
@@ -24,6 +24,7 @@
 
 #include "network/network.hpp"
 #include "network/network_string.hpp"
+#include "network/packet_statistics.hpp"
 #include "network/transport_address.hpp"
 #include "utils/synchronised.hpp"
 #include "utils/time.hpp"
@@ -145,6 +146,9 @@ private:
 
     std::atomic<uint32_t> m_download_speed;
 
+    /** Packets sent to and received from all peers. */
+    PacketStatistics m_packet_statistics;
+
     std::atomic<uint32_t> m_players_in_game;
 
     std::atomic<uint32_t> m_players_waiting;
@@ -359,6 +363,9 @@ public:
     /* Return download speed in bytes per second. */
     unsigned getDownloadSpeed() const       { return m_download_speed.load(); }
     // ------------------------------------------------------------------------
+    /** Returns the statistics of the packets of all peers. */
+    PacketStatistics* getPacketStatistics()      { return &m_packet_statistics; }
+    // ------------------------------------------------------------------------
     void updatePlayers(unsigned* ingame = NULL,
                        unsigned* waiting = NULL,
                        unsigned* total = NULL);
@@ -44,6 +44,10 @@ STKPeer::STKPeer(ENetPeer *enet_peer, STKHost* host, uint32_t host_id)
     m_spectator.store(false);
     m_disconnected.store(false);
     m_warned_for_high_ping.store(false);
+    m_compact_codec.store(false);
+    m_redundant_actions.store(false);
+    m_partial_states.store(false);
+    m_chunked_live_join.store(false);
     m_last_activity.store((int64_t)StkTime::getRealTimeMs());
 }   // STKPeer
 
@@ -134,12 +138,32 @@ void STKPeer::sendPacket(NetworkString *data, bool reliable, bool encrypted)
                 packet->dataLength, a.toString().c_str(),
                 StkTime::getRealTime());
         }
+        countPacket(PacketStatistics::PS_SENT,
+            PacketStatistics::getMessageType((uint8_t*)data->getData(),
+            data->getTotalSize()), data->getTotalSize(),
+            (unsigned)packet->dataLength);
         m_host->addEnetCommand(m_enet_peer, packet,
                 encrypted ? EVENT_CHANNEL_NORMAL : EVENT_CHANNEL_UNENCRYPTED,
                 ECT_SEND_PACKET);
     }
 }   // sendPacket
 
+//-----------------------------------------------------------------------------
+/** Counts a packet sent to or received from this peer, both in the
+ *  statistics of this peer and of the host.
+ *  \param direction If the packet was sent or received.
+ *  \param message Protocol and message type, see
+ *         PacketStatistics::getMessageType.
+ *  \param size Size of the message.
+ *  \param wire_size Size of the packet given to or received from enet.
+ */
+void STKPeer::countPacket(PacketStatistics::Direction direction,
+                          uint16_t message, unsigned size, unsigned wire_size)
+{
+    m_packet_statistics.add(direction, message, size, wire_size);
+    m_host->getPacketStatistics()->add(direction, message, size, wire_size);
+}   // countPacket
+
 //-----------------------------------------------------------------------------
 /** Returns if the peer is connected or not.
  */
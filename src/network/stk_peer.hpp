@@ -23,6 +23,7 @@
 #ifndef STK_PEER_HPP
 #define STK_PEER_HPP
 
+#include "network/packet_statistics.hpp"
 #include "network/transport_address.hpp"
 #include "utils/no_copy.hpp"
 #include "utils/time.hpp"
@@ -104,6 +105,23 @@ protected:
      *  features available in same version. */
     std::vector<std::string> m_client_capabilities;
 
+    /** True if the compact network codec was negotiated with this peer. */
+    std::atomic_bool m_compact_codec;
+
+    /** True if this peer sends controller actions unreliably, repeating
+     *  the ones not acknowledged yet. */
+    std::atomic_bool m_redundant_actions;
+
+    /** True if the states of karts far away from the karts of this peer
+     *  can be skipped. */
+    std::atomic_bool m_partial_states;
+
+    /** True if the live join state can be sent in chunks to this peer. */
+    std::atomic_bool m_chunked_live_join;
+
+    /** Packets sent to and received from this peer. */
+    PacketStatistics m_packet_statistics;
+
 public:
     STKPeer(ENetPeer *enet_peer, STKHost* host, uint32_t host_id);
     // ------------------------------------------------------------------------
@@ -241,6 +259,34 @@ public:
     // ------------------------------------------------------------------------
     const std::vector<std::string>& getClientCapabilities() const
                                               { return m_client_capabilities; }
+    // ------------------------------------------------------------------------
+    void setCompactCodec(bool val)              { m_compact_codec.store(val); }
+    // ------------------------------------------------------------------------
+    /** Returns true if packets to and from this peer use the compact (bit
+     *  packed) codec for controller actions, player lists and states. */
+    bool useCompactCodec() const              { return m_compact_codec.load(); }
+    // ------------------------------------------------------------------------
+    void setRedundantActions(bool val)      { m_redundant_actions.store(val); }
+    // ------------------------------------------------------------------------
+    /** Returns true if the controller actions received from this peer need
+     *  to be deduplicated and acknowledged. */
+    bool useRedundantActions() const      { return m_redundant_actions.load(); }
+    // ------------------------------------------------------------------------
+    void setPartialStates(bool val)            { m_partial_states.store(val); }
+    // ------------------------------------------------------------------------
+    /** Returns true if states sent to this peer can skip far away karts. */
+    bool usePartialStates() const            { return m_partial_states.load(); }
+    // ------------------------------------------------------------------------
+    void setChunkedLiveJoin(bool val)     { m_chunked_live_join.store(val); }
+    // ------------------------------------------------------------------------
+    /** Returns true if the live join state can be streamed in chunks. */
+    bool useChunkedLiveJoin() const     { return m_chunked_live_join.load(); }
+    // ------------------------------------------------------------------------
+    void countPacket(PacketStatistics::Direction direction, uint16_t message,
+                     unsigned size, unsigned wire_size);
+    // ------------------------------------------------------------------------
+    /** Returns the statistics of the packets of this peer. */
+    PacketStatistics* getPacketStatistics()      { return &m_packet_statistics; }
 };   // STKPeer
 
 #endif // STK_PEER_HPP
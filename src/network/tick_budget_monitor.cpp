@@ -0,0 +1,240 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "network/tick_budget_monitor.hpp"
+
+#include "config/stk_config.hpp"
+#include "network/server_config.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+
+#include <sstream>
+
+bool TickBudgetMonitor::m_enabled = false;
+std::vector<TickBudgetMonitor::DegradationStep> TickBudgetMonitor::m_steps;
+unsigned TickBudgetMonitor::m_level = 0;
+std::array<int, TickBudgetMonitor::DS_COUNT> TickBudgetMonitor::m_intervals
+    = {{ 1, 1 }};
+float TickBudgetMonitor::m_budget = 0.0f;
+int TickBudgetMonitor::m_window_size = 1;
+TickProfiler::TickSample TickBudgetMonitor::m_window_sum;
+int TickBudgetMonitor::m_window_ticks = 0;
+int TickBudgetMonitor::m_overloaded_windows = 0;
+int TickBudgetMonitor::m_idle_windows = 0;
+TickProfiler::TickSample TickBudgetMonitor::m_last_average;
+uint64_t TickBudgetMonitor::m_total_windows = 0;
+uint64_t TickBudgetMonitor::m_total_overloaded_windows = 0;
+uint64_t TickBudgetMonitor::m_degradations = 0;
+uint64_t TickBudgetMonitor::m_recoveries = 0;
+std::mutex TickBudgetMonitor::m_statistics_mutex;
+
+/** Number of consecutive windows over the budget before the next step is
+ *  applied. */
+static const int DEGRADE_WINDOWS = 3;
+
+/** Number of consecutive windows below RECOVER_FRACTION of the budget
+ *  before the last step is reverted. Together with the lower threshold
+ *  this avoids switching back and forth. */
+static const int RECOVER_WINDOWS = 10;
+static const float RECOVER_FRACTION = 0.5f;
+
+// ----------------------------------------------------------------------------
+/** Returns the name of a step as used in the server configuration. */
+const char* TickBudgetMonitor::getStepName(DegradationStep step)
+{
+    switch (step)
+    {
+    case DS_STATE_FREQUENCY: return "state-frequency";
+    case DS_AI:              return "ai";
+    case DS_COUNT:           break;
+    }
+    return "unknown";
+}   // getStepName
+
+// ----------------------------------------------------------------------------
+/** Reads the budget and the degradation steps from the server configuration
+ *  and starts monitoring if a budget is set. Called when a server is
+ *  started.
+ */
+void TickBudgetMonitor::init()
+{
+    std::vector<DegradationStep> all_steps;
+    const std::string steps = ServerConfig::m_tick_budget_degradation;
+    for (const std::string &name : StringUtils::split(steps, ' '))
+    {
+        if (name.empty())
+            continue;
+        int step = 0;
+        while (step < DS_COUNT && name != getStepName((DegradationStep)step))
+            step++;
+        if (step == DS_COUNT)
+        {
+            Log::warn("TickBudgetMonitor",
+                      "Unknown degradation step '%s' is ignored.",
+                      name.c_str());
+            continue;
+        }
+        all_steps.push_back((DegradationStep)step);
+    }
+
+    const int budget = ServerConfig::m_tick_budget;
+    m_enabled = budget > 0;
+    m_budget = stk_config->ticks2Time(1) * 1.0e6f * (float)budget / 100.0f;
+    m_window_size = stk_config->getPhysicsFPS();
+    m_window_sum.fill(0.0f);
+    m_window_ticks = 0;
+    m_overloaded_windows = 0;
+    m_idle_windows = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        m_steps = all_steps;
+        m_last_average.fill(0.0f);
+        m_total_windows = 0;
+        m_total_overloaded_windows = 0;
+        m_degradations = 0;
+        m_recoveries = 0;
+    }
+    setLevel(0);
+    if (m_enabled)
+        TickProfiler::enable(true, /*keep_samples*/false);
+}   // init
+
+// ----------------------------------------------------------------------------
+/** Applies the first level steps of the configuration and reverts all
+ *  others.
+ */
+void TickBudgetMonitor::setLevel(unsigned level)
+{
+    std::lock_guard<std::mutex> lock(m_statistics_mutex);
+    m_level = level;
+    m_intervals.fill(1);
+    for (unsigned i = 0; i < m_level; i++)
+        m_intervals[m_steps[i]] *= 2;
+}   // setLevel
+
+// ----------------------------------------------------------------------------
+/** Starts measuring one tick of the server. */
+void TickBudgetMonitor::startTick()
+{
+    if (m_enabled)
+        TickProfiler::start(TickProfiler::TP_TOTAL);
+}   // startTick
+
+// ----------------------------------------------------------------------------
+/** Ends measuring one tick of the server, and evaluates the budget after
+ *  each window.
+ */
+void TickBudgetMonitor::endTick()
+{
+    if (!m_enabled)
+        return;
+    TickProfiler::stop(TickProfiler::TP_TOTAL);
+    TickProfiler::endTick();
+    const TickProfiler::TickSample &sample = TickProfiler::getLastSample();
+    for (unsigned int i = 0; i < TickProfiler::TP_COUNT; i++)
+        m_window_sum[i] += sample[i];
+    if (++m_window_ticks < m_window_size)
+        return;
+    evaluateWindow();
+    m_window_sum.fill(0.0f);
+    m_window_ticks = 0;
+}   // endTick
+
+// ----------------------------------------------------------------------------
+/** Compares the average cost of the ticks in the last window with the
+ *  budget, and applies or reverts a degradation step if the server was
+ *  over or well below its budget for long enough.
+ */
+void TickBudgetMonitor::evaluateWindow()
+{
+    const float average = m_window_sum[TickProfiler::TP_TOTAL] /
+                          (float)m_window_ticks;
+    const bool overloaded = average > m_budget;
+    {
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        for (unsigned int i = 0; i < TickProfiler::TP_COUNT; i++)
+            m_last_average[i] = m_window_sum[i] / (float)m_window_ticks;
+        m_total_windows++;
+        if (overloaded)
+            m_total_overloaded_windows++;
+    }
+
+    if (overloaded)
+    {
+        m_idle_windows = 0;
+        if (++m_overloaded_windows < DEGRADE_WINDOWS ||
+            m_level >= m_steps.size())
+            return;
+        m_overloaded_windows = 0;
+        Log::warn("TickBudgetMonitor", "Ticks take %.0f us on average, "
+                  "budget is %.0f us, applying step %d: %s.", average,
+                  m_budget, m_level + 1, getStepName(m_steps[m_level]));
+        setLevel(m_level + 1);
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        m_degradations++;
+    }
+    else if (average < m_budget * RECOVER_FRACTION)
+    {
+        m_overloaded_windows = 0;
+        if (++m_idle_windows < RECOVER_WINDOWS || m_level == 0)
+            return;
+        m_idle_windows = 0;
+        Log::info("TickBudgetMonitor", "Ticks take %.0f us on average, "
+                  "budget is %.0f us, reverting step %d: %s.", average,
+                  m_budget, m_level, getStepName(m_steps[m_level - 1]));
+        setLevel(m_level - 1);
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        m_recoveries++;
+    }
+    else
+    {
+        m_overloaded_windows = 0;
+        m_idle_windows = 0;
+    }
+}   // evaluateWindow
+
+// ----------------------------------------------------------------------------
+/** Returns the budget, the applied steps and the average cost of each phase
+ *  in the last window, for the network console. Can be called from any
+ *  thread.
+ */
+std::string TickBudgetMonitor::getStatistics()
+{
+    if (!m_enabled)
+        return "Tick budget monitor is disabled.";
+    std::lock_guard<std::mutex> lock(m_statistics_mutex);
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    out << "Tick budget " << m_budget << " us, windows over budget "
+        << m_total_overloaded_windows << "/" << m_total_windows
+        << ", steps applied " << m_degradations << ", reverted "
+        << m_recoveries << "\nActive steps:";
+    if (m_level == 0)
+        out << " none";
+    for (unsigned i = 0; i < m_level; i++)
+        out << " " << getStepName(m_steps[i]);
+    out << "\nAverage us per tick in the last second:";
+    for (unsigned int i = 0; i < TickProfiler::TP_COUNT; i++)
+    {
+        out << " " << TickProfiler::getPhaseName((TickProfiler::TickPhase)i)
+            << " " << m_last_average[i];
+    }
+    return out.str();
+}   // getStatistics
@@ -0,0 +1,121 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_TICK_BUDGET_MONITOR_HPP
+#define HEADER_TICK_BUDGET_MONITOR_HPP
+
+#include "utils/tick_profiler.hpp"
+
+#include <array>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** \brief Detects when a server can not simulate the game in real time
+ *  anymore and reduces its work until it can. The cost of each tick is
+ *  measured with the TickProfiler, and averaged over windows of one second.
+ *  If several windows in a row are over the configured budget, the next
+ *  configured degradation step is applied (less states sent or less
+ *  frequent AI updates). Once the cost is well below the budget for
+ *  a longer time, the last step is reverted again.
+ *  All functions except getStatistics are called from the main thread.
+ * \ingroup network
+ */
+class TickBudgetMonitor
+{
+public:
+    /** The possible degradation steps. */
+    enum DegradationStep
+    {
+        DS_STATE_FREQUENCY,
+        DS_AI,
+        DS_COUNT
+    };
+
+private:
+    /** True if the server monitors its tick budget. */
+    static bool m_enabled;
+
+    /** The configured steps in the order they are applied. */
+    static std::vector<DegradationStep> m_steps;
+
+    /** Number of steps currently applied. */
+    static unsigned m_level;
+
+    /** For each step, only every n-th tick does the work. */
+    static std::array<int, DS_COUNT> m_intervals;
+
+    /** Budget of a tick in microseconds. */
+    static float m_budget;
+
+    /** Number of ticks in one window. */
+    static int m_window_size;
+
+    /** Accumulated times of the current window. */
+    static TickProfiler::TickSample m_window_sum;
+
+    /** Number of ticks in the current window. */
+    static int m_window_ticks;
+
+    /** Number of consecutive windows over the budget. */
+    static int m_overloaded_windows;
+
+    /** Number of consecutive windows well below the budget. */
+    static int m_idle_windows;
+
+    /** Average times of the last complete window, shown in the console. */
+    static TickProfiler::TickSample m_last_average;
+
+    /** Number of windows and of windows over budget since the start. */
+    static uint64_t m_total_windows, m_total_overloaded_windows;
+
+    /** Number of times a step was applied or reverted. */
+    static uint64_t m_degradations, m_recoveries;
+
+    /** The statistics are read by the network console thread. */
+    static std::mutex m_statistics_mutex;
+
+    static void setLevel(unsigned level);
+    static void evaluateWindow();
+
+public:
+    static void        init();
+    static void        startTick();
+    static void        endTick();
+    static std::string getStatistics();
+    static const char* getStepName(DegradationStep step);
+    // ------------------------------------------------------------------------
+    /** Returns true if the tick budget is monitored. */
+    static bool isEnabled() { return m_enabled; }
+    // ------------------------------------------------------------------------
+    /** Returns n if the work of the given step should only be done every
+     *  n-th tick, 1 if the step is not applied. */
+    static int getInterval(DegradationStep step) { return m_intervals[step]; }
+    // ------------------------------------------------------------------------
+    /** Returns true if the work of the given step should be done in this
+     *  tick. The offset allows to distribute the work of several objects
+     *  (e.g. karts) over the ticks. */
+    static bool isDue(DegradationStep step, int ticks, int offset = 0)
+    {
+        return (ticks + offset) % m_intervals[step] == 0;
+    }   // isDue
+};   // TickBudgetMonitor
+
+#endif
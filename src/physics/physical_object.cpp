@@ -844,6 +844,13 @@ BareNetworkString* PhysicalObject::saveState(std::vector<std::string>* ru)
     return buffer;
 }   // saveState
 
+// ----------------------------------------------------------------------------
+btRigidBody* PhysicalObject::getNetworkBody(btMotionState** ms)
+{
+    *ms = m_motion_state;
+    return m_body;
+}   // getNetworkBody
+
 // ----------------------------------------------------------------------------
 void PhysicalObject::restoreState(BareNetworkString *buffer, int count)
 {
@@ -286,6 +286,7 @@ public:
     virtual void saveTransform();
     virtual void computeError();
     virtual BareNetworkString* saveState(std::vector<std::string>* ru);
+    virtual btRigidBody* getNetworkBody(btMotionState** ms);
     virtual void undoEvent(BareNetworkString *buffer) {}
     virtual void rewindToEvent(BareNetworkString *buffer) {}
     virtual void restoreState(BareNetworkString *buffer, int count);
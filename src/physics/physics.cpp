@@ -43,6 +43,9 @@
 #include "tracks/track.hpp"
 #include "tracks/track_object.hpp"
 #include "utils/profiler.hpp"
+#include "utils/worker_pool.hpp"
+
+#include <algorithm>
 
 // ----------------------------------------------------------------------------
 /** Initialise physics.
@@ -51,7 +54,8 @@
 Physics::Physics() : btSequentialImpulseConstraintSolver()
 {
     m_collision_conf      = new btDefaultCollisionConfiguration();
-    m_dispatcher          = new btCollisionDispatcher(m_collision_conf);
+    m_dispatcher          = new STKCollisionDispatcher(m_collision_conf);
+    m_worker_pool         = NULL;
 }   // Physics
 
 //-----------------------------------------------------------------------------
@@ -75,6 +79,15 @@ void Physics::init(const Vec3 &world_min, const Vec3 &world_max)
     m_debug_drawer = new IrrDebugDrawer();
     m_dynamics_world->setDebugDrawer(m_debug_drawer);
 
+    // The deterministic parallel code is always used, even without extra
+    // threads, so that the results are the same for any number of threads.
+    // Bullet's sequential code batches small islands and gives different
+    // results.
+    m_worker_pool = new WorkerPool("PhysicsWorker",
+        std::max((int)UserConfigParams::m_physics_threads, 1));
+    m_dispatcher->setWorkerPool(m_worker_pool);
+    m_dynamics_world->setWorkerPool(m_worker_pool);
+
     // Get the solver settings from the config file
     btContactSolverInfo& info = m_dynamics_world->getSolverInfo();
     info.m_numIterations = stk_config->m_solver_iterations;
@@ -95,6 +108,7 @@ Physics::~Physics()
     delete m_axis_sweep;
     delete m_dispatcher;
     delete m_collision_conf;
+    delete m_worker_pool;
 }   // ~Physics
 
 // ----------------------------------------------------------------------------
@@ -526,7 +540,8 @@ void Physics::KartKartCollision(AbstractKart *kart_a,
 }   // KartKartCollision
 
 //-----------------------------------------------------------------------------
-/** This function is called at each internal bullet timestep. It is used
+/** This function is called at the end of each internal bullet timestep,
+ *  after all islands were solved by the dynamics world. It is used
  *  here to do the collision handling: using the contact manifolds after a
  *  physics time step might miss some collisions (when more than one internal
  *  time step was done, and the collision is added and removed). So this
@@ -534,26 +549,22 @@ void Physics::KartKartCollision(AbstractKart *kart_a,
  *  actual physics timestep. This list only stores a collision if it's not
  *  already in the list, so a collisions which is reported more than once is
  *  nevertheless only handled once.
- *  The list of collision
  *  Parameters: see bullet documentation for details.
  */
-btScalar Physics::solveGroup(btCollisionObject** bodies, int numBodies,
-                             btPersistentManifold** manifold,int numManifolds,
-                             btTypedConstraint** constraints,
-                             int numConstraints,
-                             const btContactSolverInfo& info,
-                             btIDebugDraw* debugDrawer,
-                             btStackAlloc* stackAlloc,
-                             btDispatcher* dispatcher)
+void Physics::allSolved(const btContactSolverInfo& info,
+                        btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc)
+{
+    btSequentialImpulseConstraintSolver::allSolved(info, debugDrawer,
+                                                   stackAlloc);
+    handleContactManifolds();
+}   // allSolved
+
+//-----------------------------------------------------------------------------
+/** Collects all collisions from the contact manifolds of the dispatcher, see
+ *  allSolved.
+ */
+void Physics::handleContactManifolds()
 {
-    btScalar returnValue=
-        btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies,
-                                                        manifold, numManifolds,
-                                                        constraints,
-                                                        numConstraints, info,
-                                                        debugDrawer,
-                                                        stackAlloc,
-                                                        dispatcher);
     int currentNumManifolds = m_dispatcher->getNumManifolds();
     // We can't explode a rocket in a loop, since a rocket might collide with
     // more than one object, and/or more than once with each object (if there
@@ -725,9 +736,7 @@ btScalar Physics::solveGroup(btCollisionObject** bodies, int numBodies,
         else
             assert("Unknown user pointer");           // 4) Should never happen
     }   // for i<numManifolds
-
-    return returnValue;
-}   // solveGroup
+}   // handleContactManifolds
 
 // ----------------------------------------------------------------------------
 /** A debug draw function to show the track and all karts.
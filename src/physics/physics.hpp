@@ -30,6 +30,7 @@
 #include "btBulletDynamicsCommon.h"
 
 #include "physics/irr_debug_drawer.hpp"
+#include "physics/stk_collision_dispatcher.hpp"
 #include "physics/stk_dynamics_world.hpp"
 #include "physics/user_pointer.hpp"
 #include "utils/singleton.hpp"
@@ -37,6 +38,7 @@
 class AbstractKart;
 class STKDynamicsWorld;
 class Vec3;
+class WorkerPool;
 
 /**
   * \ingroup physics
@@ -144,11 +146,14 @@ private:
     /** Used in physics debugging to draw the physics world. */
     IrrDebugDrawer                  *m_debug_drawer;
 
-    btCollisionDispatcher           *m_dispatcher;
+    STKCollisionDispatcher          *m_dispatcher;
     btBroadphaseInterface           *m_axis_sweep;
     btDefaultCollisionConfiguration *m_collision_conf;
     CollisionList                    m_all_collisions;
 
+    /** Threads for collision detection and island solving. */
+    WorkerPool                      *m_worker_pool;
+
     /** Singleton. */
     static Physics                  *m_physics;
 
@@ -158,6 +163,8 @@ private:
     // Give the singleton access to the constructor
     friend class AbstractSingleton<Physics>;
 
+    void  handleContactManifolds();
+
 public:
     void  init             (const Vec3 &min_world, const Vec3 &max_world);
     void  addKart          (const AbstractKart *k);
@@ -177,12 +184,9 @@ public:
     /** Returns true if the debug drawer is enabled. */
     bool  isDebug() const     {return m_debug_drawer->debugEnabled(); }
     IrrDebugDrawer* getDebugDrawer() { return m_debug_drawer; }
-    virtual btScalar solveGroup(btCollisionObject** bodies, int numBodies,
-                                btPersistentManifold** manifold,int numManifolds,
-                                btTypedConstraint** constraints,int numConstraints,
-                                const btContactSolverInfo& info,
-                                btIDebugDraw* debugDrawer, btStackAlloc* stackAlloc,
-                                btDispatcher* dispatcher);
+    virtual void allSolved(const btContactSolverInfo& info,
+                           btIDebugDraw* debugDrawer,
+                           btStackAlloc* stackAlloc);
 };
 
 #endif // HEADER_PHYSICS_HPP
@@ -0,0 +1,214 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "physics/stk_collision_dispatcher.hpp"
+
+#include "utils/worker_pool.hpp"
+
+// ----------------------------------------------------------------------------
+STKCollisionDispatcher::STKCollisionDispatcher(btCollisionConfiguration *config)
+                      : btCollisionDispatcher(config)
+{
+    m_worker_pool = NULL;
+}   // STKCollisionDispatcher
+
+// ----------------------------------------------------------------------------
+btPersistentManifold* STKCollisionDispatcher::getNewManifold(void *b0, void *b1)
+{
+    std::lock_guard<std::mutex> lock(m_pool_mutex);
+    return btCollisionDispatcher::getNewManifold(b0, b1);
+}   // getNewManifold
+
+// ----------------------------------------------------------------------------
+void STKCollisionDispatcher::releaseManifold(btPersistentManifold *manifold)
+{
+    std::lock_guard<std::mutex> lock(m_pool_mutex);
+    btCollisionDispatcher::releaseManifold(manifold);
+}   // releaseManifold
+
+// ----------------------------------------------------------------------------
+void* STKCollisionDispatcher::allocateCollisionAlgorithm(int size)
+{
+    std::lock_guard<std::mutex> lock(m_pool_mutex);
+    return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+}   // allocateCollisionAlgorithm
+
+// ----------------------------------------------------------------------------
+void STKCollisionDispatcher::freeCollisionAlgorithm(void *ptr)
+{
+    std::lock_guard<std::mutex> lock(m_pool_mutex);
+    btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+}   // freeCollisionAlgorithm
+
+// ----------------------------------------------------------------------------
+/** Returns the union-find root of a pair (with path halving). */
+int STKCollisionDispatcher::findRoot(int n)
+{
+    while (m_parent[n] != n)
+    {
+        m_parent[n] = m_parent[m_parent[n]];
+        n = m_parent[n];
+    }
+    return n;
+}   // findRoot
+
+// ----------------------------------------------------------------------------
+/** Splits the overlapping pairs into groups which can be processed in
+ *  parallel. Bullet temporarily replaces the shape and transform of an
+ *  object with compound shape while testing its children, so all pairs
+ *  with the same compound object must be in the same group. The root of a
+ *  group is always its smallest pair index, so the groups and the order of
+ *  pairs in them only depend on the order of the pair cache.
+ */
+void STKCollisionDispatcher::buildGroups(btBroadphasePairArray &pairs)
+{
+    const int num_pairs = pairs.size();
+    m_parent.resize(num_pairs);
+    for (int i = 0; i < num_pairs; i++)
+        m_parent[i] = i;
+
+    m_object_owner.clear();
+    for (int i = 0; i < num_pairs; i++)
+    {
+        const btCollisionObject *obj[2] =
+        {
+            (btCollisionObject*)pairs[i].m_pProxy0->m_clientObject,
+            (btCollisionObject*)pairs[i].m_pProxy1->m_clientObject
+        };
+        for (unsigned int j = 0; j < 2; j++)
+        {
+            if (!obj[j]->getCollisionShape()->isCompound())
+                continue;
+            auto owner = m_object_owner.find(obj[j]);
+            if (owner == m_object_owner.end())
+            {
+                m_object_owner[obj[j]] = i;
+                continue;
+            }
+            int a = findRoot(i);
+            int b = findRoot(owner->second);
+            if (a < b)
+                m_parent[b] = a;
+            else if (b < a)
+                m_parent[a] = b;
+        }
+    }
+
+    // Number the groups in the order of their root, then sort the pairs
+    // by group (counting sort, which keeps the pair order in a group).
+    m_group_of_pair.resize(num_pairs);
+    m_group_start.clear();
+    for (int i = 0; i < num_pairs; i++)
+    {
+        int root = findRoot(i);
+        if (root == i)
+        {
+            m_group_of_pair[i] = (int)m_group_start.size();
+            m_group_start.push_back(0);
+        }
+        else
+            m_group_of_pair[i] = m_group_of_pair[root];
+        m_group_start[m_group_of_pair[i]]++;
+    }
+    int offset = 0;
+    for (unsigned int g = 0; g < m_group_start.size(); g++)
+    {
+        int count = m_group_start[g];
+        m_group_start[g] = offset;
+        offset += count;
+    }
+    m_group_start.push_back(offset);
+
+    m_group_pairs.resize(num_pairs);
+    std::vector<int> next(m_group_start.begin(), m_group_start.end() - 1);
+    for (int i = 0; i < num_pairs; i++)
+        m_group_pairs[next[m_group_of_pair[i]]++] = i;
+}   // buildGroups
+
+// ----------------------------------------------------------------------------
+/** Sorts the manifolds in the order of the overlapping pairs and of the
+ *  manifolds in each collision algorithm, which does not depend on the
+ *  order in which the threads created them.
+ */
+void STKCollisionDispatcher::sortManifolds(btBroadphasePairArray &pairs)
+{
+    const int num_manifolds = m_manifoldsPtr.size();
+    m_sorted_manifolds.clear();
+    m_manifold_done.assign(num_manifolds, false);
+    for (int i = 0; i < pairs.size(); i++)
+    {
+        if (!pairs[i].m_algorithm)
+            continue;
+        m_pair_manifolds.resize(0);
+        pairs[i].m_algorithm->getAllContactManifolds(m_pair_manifolds);
+        for (int j = 0; j < m_pair_manifolds.size(); j++)
+        {
+            int index = m_pair_manifolds[j]->m_index1a;
+            if (m_manifold_done[index])
+                continue;
+            m_manifold_done[index] = true;
+            m_sorted_manifolds.push_back(m_pair_manifolds[j]);
+        }
+    }
+    // Manifolds which are not owned by a pair algorithm were not created
+    // during the dispatch, so they keep their relative order.
+    for (int i = 0; i < num_manifolds; i++)
+    {
+        if (!m_manifold_done[i])
+            m_sorted_manifolds.push_back(m_manifoldsPtr[i]);
+    }
+    for (int i = 0; i < num_manifolds; i++)
+    {
+        m_manifoldsPtr[i] = m_sorted_manifolds[i];
+        m_manifoldsPtr[i]->m_index1a = i;
+    }
+}   // sortManifolds
+
+// ----------------------------------------------------------------------------
+/** Runs the narrowphase for all overlapping pairs. With a worker pool the
+ *  independent groups of pairs are processed in parallel, otherwise this
+ *  is bullet's sequential implementation.
+ */
+void STKCollisionDispatcher::dispatchAllCollisionPairs(
+                                           btOverlappingPairCache *pair_cache,
+                                           const btDispatcherInfo &info,
+                                           btDispatcher *dispatcher)
+{
+    if (!m_worker_pool)
+    {
+        btCollisionDispatcher::dispatchAllCollisionPairs(pair_cache, info,
+                                                         dispatcher);
+        return;
+    }
+
+    btBroadphasePairArray &pairs = pair_cache->getOverlappingPairArray();
+    buildGroups(pairs);
+    btNearCallback near_callback = getNearCallback();
+    m_worker_pool->parallelFor((unsigned int)m_group_start.size() - 1,
+        [this, &pairs, &info, near_callback](unsigned int group,
+                                             unsigned int thread)
+        {
+            for (int i = m_group_start[group]; i < m_group_start[group + 1];
+                 i++)
+            {
+                near_callback(pairs[m_group_pairs[i]], *this, info);
+            }
+        });
+    sortManifolds(pairs);
+}   // dispatchAllCollisionPairs
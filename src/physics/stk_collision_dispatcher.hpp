@@ -0,0 +1,91 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_STK_COLLISION_DISPATCHER_HPP
+#define HEADER_STK_COLLISION_DISPATCHER_HPP
+
+#include "btBulletCollisionCommon.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class WorkerPool;
+
+/** \brief A collision dispatcher which can run the narrowphase collision
+ *  detection of all overlapping pairs in parallel.
+ *  Pairs which share an object that bullet modifies temporarily during
+ *  collision detection (objects with a compound shape) are put into the
+ *  same group, and each group is processed by one thread in the order of
+ *  the pair cache. The allocation of manifolds and collision algorithms is
+ *  protected by a mutex. Since manifolds are then created in a random
+ *  order, the array of manifolds is sorted afterwards in the order of the
+ *  overlapping pairs, which makes the following island building, solving
+ *  and collision handling independent of the number of threads.
+ *  Without a worker pool the dispatcher behaves like btCollisionDispatcher.
+ * \ingroup physics
+ */
+class STKCollisionDispatcher : public btCollisionDispatcher
+{
+private:
+    /** The threads used in dispatchAllCollisionPairs, or NULL. */
+    WorkerPool *m_worker_pool;
+
+    /** Protects the manifold and collision algorithm pools. */
+    std::mutex m_pool_mutex;
+
+    /** Union-find parent of each pair, used to build the groups. */
+    std::vector<int> m_parent;
+
+    /** Index of the group each pair belongs to. */
+    std::vector<int> m_group_of_pair;
+
+    /** Start of each group in m_group_pairs (plus one end entry). */
+    std::vector<int> m_group_start;
+
+    /** Indices of the pairs of all groups, sorted by group. */
+    std::vector<int> m_group_pairs;
+
+    /** The first pair that uses an object with compound shape. */
+    std::unordered_map<const btCollisionObject*, int> m_object_owner;
+
+    /** Temporary arrays used when sorting the manifolds. */
+    std::vector<btPersistentManifold*> m_sorted_manifolds;
+    std::vector<bool> m_manifold_done;
+    btManifoldArray m_pair_manifolds;
+
+    int  findRoot(int n);
+    void buildGroups(btBroadphasePairArray &pairs);
+    void sortManifolds(btBroadphasePairArray &pairs);
+
+public:
+             STKCollisionDispatcher(btCollisionConfiguration *config);
+    virtual btPersistentManifold* getNewManifold(void *b0, void *b1);
+    virtual void releaseManifold(btPersistentManifold *manifold);
+    virtual void* allocateCollisionAlgorithm(int size);
+    virtual void freeCollisionAlgorithm(void *ptr);
+    virtual void dispatchAllCollisionPairs(btOverlappingPairCache *pair_cache,
+                                           const btDispatcherInfo &info,
+                                           btDispatcher *dispatcher);
+    // ------------------------------------------------------------------------
+    /** Sets the worker pool to use, NULL disables parallel processing. */
+    void setWorkerPool(WorkerPool *pool) { m_worker_pool = pool; }
+};   // STKCollisionDispatcher
+
+#endif
@@ -0,0 +1,186 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "physics/stk_dynamics_world.hpp"
+
+#include "utils/worker_pool.hpp"
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+
+#include <algorithm>
+
+namespace
+{
+    // ------------------------------------------------------------------------
+    /** Returns the island of a constraint, see btGetConstraintIslandId. */
+    int getConstraintIsland(const btTypedConstraint *c)
+    {
+        const btCollisionObject &a = c->getRigidBodyA();
+        const btCollisionObject &b = c->getRigidBodyB();
+        return a.getIslandTag() >= 0 ? a.getIslandTag() : b.getIslandTag();
+    }   // getConstraintIsland
+}   // anonymous namespace
+
+// ============================================================================
+/** Collects the bodies, manifolds and constraints of all islands which
+ *  bullet would pass to the constraint solver, so that they can be solved
+ *  later in parallel. It is kept by the world, so that the arrays are only
+ *  allocated once. */
+class STKDynamicsWorld::IslandCollector
+                             : public btSimulationIslandManager::IslandCallback
+{
+public:
+    /** Index ranges of one island in the arrays below. */
+    struct Island
+    {
+        int m_first_body, m_num_bodies;
+        int m_first_manifold, m_num_manifolds;
+        int m_first_constraint, m_num_constraints;
+    };
+    std::vector<Island> m_islands;
+    std::vector<btCollisionObject*> m_bodies;
+    std::vector<btPersistentManifold*> m_manifolds;
+    /** All constraints, sorted by island. */
+    std::vector<btTypedConstraint*> m_constraints;
+    // ------------------------------------------------------------------------
+    /** Removes all islands, but keeps the memory of the arrays. */
+    void clear()
+    {
+        m_islands.clear();
+        m_bodies.clear();
+        m_manifolds.clear();
+        m_constraints.clear();
+    }   // clear
+    // ------------------------------------------------------------------------
+    virtual void ProcessIsland(btCollisionObject **bodies, int num_bodies,
+                               btPersistentManifold **manifolds,
+                               int num_manifolds, int island_id)
+    {
+        Island island;
+        island.m_first_constraint = 0;
+        island.m_num_constraints  = (int)m_constraints.size();
+        // A negative id means that islands are not split, so all
+        // constraints belong to this call.
+        if (island_id >= 0)
+        {
+            auto first = std::lower_bound(m_constraints.begin(),
+                m_constraints.end(), island_id,
+                [](const btTypedConstraint *c, int id)
+                {
+                    return getConstraintIsland(c) < id;
+                });
+            auto last = std::upper_bound(first, m_constraints.end(),
+                island_id,
+                [](int id, const btTypedConstraint *c)
+                {
+                    return id < getConstraintIsland(c);
+                });
+            island.m_first_constraint =
+                (int)(first - m_constraints.begin());
+            island.m_num_constraints = (int)(last - first);
+        }
+        if (num_manifolds + island.m_num_constraints == 0)
+            return;
+        island.m_first_body     = (int)m_bodies.size();
+        island.m_num_bodies     = num_bodies;
+        island.m_first_manifold = (int)m_manifolds.size();
+        island.m_num_manifolds  = num_manifolds;
+        m_bodies.insert(m_bodies.end(), bodies, bodies + num_bodies);
+        m_manifolds.insert(m_manifolds.end(), manifolds,
+                           manifolds + num_manifolds);
+        m_islands.push_back(island);
+    }   // ProcessIsland
+};   // IslandCollector
+
+// ----------------------------------------------------------------------------
+STKDynamicsWorld::~STKDynamicsWorld()
+{
+    setWorkerPool(NULL);
+    delete m_island_collector;
+}   // ~STKDynamicsWorld
+
+// ----------------------------------------------------------------------------
+/** Sets the worker pool used to solve the islands in parallel, NULL uses
+ *  bullet's sequential implementation.
+ */
+void STKDynamicsWorld::setWorkerPool(WorkerPool *pool)
+{
+    for (btSequentialImpulseConstraintSolver *solver : m_island_solvers)
+        delete solver;
+    m_island_solvers.clear();
+    m_worker_pool = pool;
+    if (!pool)
+        return;
+    for (unsigned int i = 0; i < pool->getNumThreads(); i++)
+        m_island_solvers.push_back(new btSequentialImpulseConstraintSolver());
+}   // setWorkerPool
+
+// ----------------------------------------------------------------------------
+/** Solves all contacts and constraints. With a worker pool each island is
+ *  solved on its own (instead of batching small islands), using the solver
+ *  of the thread that picks it up. The solvers are reset before each
+ *  island, so the result only depends on the island. The world's own
+ *  solver is only notified with prepareSolve and allSolved.
+ */
+void STKDynamicsWorld::solveConstraints(btContactSolverInfo &solver_info)
+{
+    if (!m_worker_pool)
+    {
+        btDiscreteDynamicsWorld::solveConstraints(solver_info);
+        return;
+    }
+
+    if (!m_island_collector)
+        m_island_collector = new IslandCollector();
+    IslandCollector &collector = *m_island_collector;
+    collector.clear();
+    for (int i = 0; i < m_constraints.size(); i++)
+        collector.m_constraints.push_back(m_constraints[i]);
+    std::stable_sort(collector.m_constraints.begin(),
+                     collector.m_constraints.end(),
+                     [](const btTypedConstraint *a, const btTypedConstraint *b)
+                     {
+                         return getConstraintIsland(a) <
+                                getConstraintIsland(b);
+                     });
+
+    m_constraintSolver->prepareSolve(getNumCollisionObjects(),
+                                     getDispatcher()->getNumManifolds());
+    m_islandManager->buildAndProcessIslands(getDispatcher(), this,
+                                            &collector);
+
+    m_worker_pool->parallelFor((unsigned int)collector.m_islands.size(),
+        [this, &collector, &solver_info](unsigned int n, unsigned int thread)
+        {
+            const IslandCollector::Island &island = collector.m_islands[n];
+            btSequentialImpulseConstraintSolver *solver =
+                m_island_solvers[thread];
+            solver->reset();
+            solver->solveGroup(
+                collector.m_bodies.data() + island.m_first_body,
+                island.m_num_bodies,
+                collector.m_manifolds.data() + island.m_first_manifold,
+                island.m_num_manifolds,
+                collector.m_constraints.data() + island.m_first_constraint,
+                island.m_num_constraints, solver_info, NULL, NULL,
+                getDispatcher());
+        });
+
+    m_constraintSolver->allSolved(solver_info, m_debugDrawer, m_stackAlloc);
+}   // solveConstraints
@@ -21,12 +21,33 @@
 
 #include "btBulletDynamicsCommon.h"
 
+#include <vector>
+
+class WorkerPool;
+
 /** A thin wrapper around bullet's btDiscreteDynamicsWorld. Used to
  *  be able to query and set the 'left over' time from a previous
  *  time step, which is needed for more precise rewind/replays.
+ *  If a worker pool is set, the simulation islands are solved in parallel,
+ *  each one with a separate solver, so that the result does not depend on
+ *  the number of threads.
  */
 class STKDynamicsWorld : public btDiscreteDynamicsWorld
 {
+private:
+    /** The threads used to solve the islands, or NULL. */
+    WorkerPool *m_worker_pool;
+
+    /** One constraint solver for each thread of the worker pool. */
+    std::vector<btSequentialImpulseConstraintSolver*> m_island_solvers;
+
+    class IslandCollector;
+    /** The islands of the current step, created when first used. */
+    IslandCollector *m_island_collector;
+
+protected:
+    virtual void solveConstraints(btContactSolverInfo &solver_info);
+
 public:
     /** The standard constructor which just created a btDiscreteDynamicsWorld. */
     STKDynamicsWorld(btDispatcher*             dispatcher,
@@ -38,8 +59,12 @@ public:
                                              constraintSolver,
                                              collisionConfiguration)
     {
+        m_worker_pool      = NULL;
+        m_island_collector = NULL;
     }
-
+    virtual ~STKDynamicsWorld();
+    void setWorkerPool(WorkerPool *pool);
+    // ------------------------------------------------------------------------
     /** Resets m_localTime to 0. This allows more precise replay of
      *  physics, which is important for replaying histories. */
     void resetLocalTime() { m_localTime = 0; }
@@ -38,7 +38,9 @@ bool History::m_online_history_replay = false;
  */
 History::History()
 {
-    m_replay_history = false;
+    m_replay_history  = false;
+    m_loop_replay     = true;
+    m_replay_finished = false;
 }   // History
 
 //-----------------------------------------------------------------------------
@@ -111,6 +113,11 @@ void History::updateReplay(int world_ticks)
     if(m_event_index >= m_all_input_events.size())
     {
         Log::info("History", "Replay finished");
+        if (!m_loop_replay)
+        {
+            m_replay_finished = true;
+            return;
+        }
         m_event_index= 0;
         // This is useful to use a reproducable rewind problem:
         // replay it with history, for debugging only
@@ -183,25 +190,30 @@ void History::Save()
 }   // Save
 
 //-----------------------------------------------------------------------------
-/** Loads a history from history.dat in the current directory.
+/** Loads a history file. The file is first searched relative to the
+ *  current directory, then in the user config directory.
+ *  \param filename Name of the history file, default is history.dat.
  */
-void History::Load()
+void History::Load(const std::string &filename)
 {
     char s[1024], s1[1024];
     int  n;
 
-    FILE *fd = fopen("history.dat","r");
+    FILE *fd = fopen(filename.c_str(),"r");
     if(fd)
-        Log::info("History", "Reading ./history.dat");
+        Log::info("History", "Reading '%s'.", filename.c_str());
     else
     {
-        std::string fn = file_manager->getUserConfigFile("history.dat");
+        std::string fn = file_manager->getUserConfigFile(filename);
         fd = fopen(fn.c_str(), "r");
         if(fd)
             Log::info("History", "Reading '%s'.", fn.c_str());
     }
     if(!fd)
-        Log::fatal("History", "Could not open history.dat");
+        Log::fatal("History", "Could not open '%s'.", filename.c_str());
+
+    m_kart_ident.clear();
+    m_replay_finished = false;
 
     if (fgets(s, 1023, fd) == NULL)
         Log::fatal("History", "Could not read history.dat.");
@@ -40,6 +40,14 @@ private:
     /** Points to the last used input event index. */
     unsigned int m_event_index;
 
+    /** If true (default) the world is reset and the replay starts again
+     *  when the end of the history is reached. */
+    bool m_loop_replay;
+
+    /** Set when the end of the history was reached and the replay is
+     *  not looped. */
+    bool m_replay_finished;
+
     /** The identities of the karts to use. */
     std::vector<std::string> m_kart_ident;
 
@@ -66,7 +74,7 @@ public:
           History        ();
     void  initRecording  ();
     void  Save           ();
-    void  Load           ();
+    void  Load           (const std::string &filename = "history.dat");
     void  updateReplay(int world_ticks);
     void  addEvent(int kart_id, PlayerAction pa, int value);
 
@@ -82,6 +90,13 @@ public:
     // ------------------------------------------------------------------------
     /** Set if replay is enabled or not. */
     void  setReplayHistory(bool b) { m_replay_history=b;  }
+    // ------------------------------------------------------------------------
+    /** Sets if the replay should restart at the end of the history. */
+    void  setLoopReplay(bool b) { m_loop_replay = b; }
+    // ------------------------------------------------------------------------
+    /** Returns true if a not looped replay has reached the end of the
+     *  history. */
+    bool  isReplayFinished() const { return m_replay_finished; }
 };
 
 extern History* history;
@@ -0,0 +1,191 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "race/history_benchmark.hpp"
+
+#include "config/user_config.hpp"
+#include "karts/abstract_kart.hpp"
+#include "modes/world.hpp"
+#include "race/history.hpp"
+#include "race/race_manager.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/tick_profiler.hpp"
+
+#include "LinearMath/btTransform.h"
+
+#include <stdlib.h>
+
+std::vector<std::string> HistoryBenchmark::m_history_files;
+int HistoryBenchmark::m_num_runs = 2;
+int HistoryBenchmark::m_seed     = 0;
+std::vector<int> HistoryBenchmark::m_physics_threads;
+
+// ----------------------------------------------------------------------------
+/** Sets the history files to replay.
+ *  \param files Comma separated list of history files.
+ */
+void HistoryBenchmark::setHistoryFiles(const std::string &files)
+{
+    m_history_files = StringUtils::split(files, ',');
+}   // setHistoryFiles
+
+// ----------------------------------------------------------------------------
+/** Sets the numbers of physics threads to use for the replays.
+ *  \param threads Comma separated list of thread counts.
+ *  \return False if the list contains an invalid number.
+ */
+bool HistoryBenchmark::setPhysicsThreads(const std::string &threads)
+{
+    m_physics_threads.clear();
+    for (const std::string &s : StringUtils::split(threads, ','))
+    {
+        int n = -1;
+        if (!StringUtils::fromString(s, n) || n < 0)
+            return false;
+        m_physics_threads.push_back(n);
+    }
+    return true;
+}   // setPhysicsThreads
+
+// ----------------------------------------------------------------------------
+/** Replays one history file from start to end, one tick after the other
+ *  without waiting for real time.
+ *  \param filename The history file to replay.
+ *  \return The final transforms of all karts.
+ */
+std::vector<btTransform> HistoryBenchmark::replay(const std::string &filename)
+{
+    srand(m_seed);
+    history->Load(filename);
+    race_manager->setupPlayerKartInfo();
+    race_manager->startNew(false);
+
+    World *world = World::getWorld();
+    TickProfiler::reset();
+    while (true)
+    {
+        history->updateReplay(world->getTicksSinceStart());
+        if (history->isReplayFinished())
+            break;
+        TickProfiler::start(TickProfiler::TP_TOTAL);
+        world->updateWorld(1);
+        TickProfiler::stop(TickProfiler::TP_TOTAL);
+        TickProfiler::endTick();
+        world->updateTime(1);
+    }
+
+    std::vector<btTransform> transforms;
+    for (unsigned int i = 0; i < world->getNumKarts(); i++)
+        transforms.push_back(world->getKart(i)->getTrans());
+    race_manager->exitRace();
+    return transforms;
+}   // replay
+
+// ----------------------------------------------------------------------------
+/** Compares the final kart transforms of a replay with the reference.
+ *  \param filename The replayed history file.
+ *  \param run Number of the run (starting with 1).
+ *  \param reference The transforms of the first replay.
+ *  \param transforms The transforms of this replay.
+ *  \return Number of karts with different transforms.
+ */
+int HistoryBenchmark::compare(const std::string &filename, int run,
+                              const std::vector<btTransform> &reference,
+                              const std::vector<btTransform> &transforms)
+{
+    if (transforms.size() != reference.size())
+    {
+        Log::error("HistoryBenchmark", "%s: number of karts differs.",
+                   filename.c_str());
+        return 1;
+    }
+    int mismatches = 0;
+    for (unsigned int i = 0; i < transforms.size(); i++)
+    {
+        const btVector3 &p0 = reference[i].getOrigin();
+        const btVector3 &p1 = transforms[i].getOrigin();
+        const btQuaternion q0 = reference[i].getRotation();
+        const btQuaternion q1 = transforms[i].getRotation();
+        // Check for bitwise identical results, rewinds depend on it
+        if (p0 == p1 && q0 == q1)
+            continue;
+        Log::error("HistoryBenchmark",
+            "%s run %d: kart %d at %f %f %f rotation %f %f %f %f, "
+            "expected %f %f %f rotation %f %f %f %f.",
+            filename.c_str(), run, i, p1.getX(), p1.getY(),
+            p1.getZ(), q1.getX(), q1.getY(), q1.getZ(), q1.getW(),
+            p0.getX(), p0.getY(), p0.getZ(), q0.getX(), q0.getY(),
+            q0.getZ(), q0.getW());
+        mismatches++;
+    }
+    return mismatches;
+}   // compare
+
+// ----------------------------------------------------------------------------
+/** Runs the benchmark for all history files.
+ *  \return 0 if all replays of each history file ended with identical kart
+ *          transforms, 1 otherwise.
+ */
+int HistoryBenchmark::run()
+{
+    history->setReplayHistory(true);
+    history->setLoopReplay(false);
+    TickProfiler::enable(true);
+
+    const int configured_threads = UserConfigParams::m_physics_threads;
+    std::vector<int> all_threads = m_physics_threads;
+    if (all_threads.empty())
+        all_threads.push_back(configured_threads);
+
+    int mismatches = 0;
+    for (const std::string &filename : m_history_files)
+    {
+        // All thread counts must give the same result
+        std::vector<btTransform> ref;
+        int run = 0;
+        for (int threads : all_threads)
+        {
+            UserConfigParams::m_physics_threads = threads;
+            for (int i = 0; i < m_num_runs; i++)
+            {
+                run++;
+                std::vector<btTransform> transforms = replay(filename);
+                TickProfiler::printStatistics(StringUtils::insertValues(
+                    "%s (run %d, %d physics threads)", filename.c_str(),
+                    run, threads));
+                if (ref.empty())
+                    ref = transforms;
+                else
+                    mismatches += compare(filename, run, ref, transforms);
+            }
+        }   // for threads in all_threads
+    }   // for filename in m_history_files
+
+    UserConfigParams::m_physics_threads = configured_threads;
+    TickProfiler::enable(false);
+    if (mismatches > 0)
+    {
+        Log::error("HistoryBenchmark",
+                   "Replays are not deterministic, %d mismatches.",
+                   mismatches);
+        return 1;
+    }
+    Log::info("HistoryBenchmark", "All replays are deterministic.");
+    return 0;
+}   // run
@@ -0,0 +1,73 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_HISTORY_BENCHMARK_HPP
+#define HEADER_HISTORY_BENCHMARK_HPP
+
+#include <string>
+#include <vector>
+
+class btTransform;
+
+/**
+  * \brief Replays a set of recorded history files without graphics as fast
+  *  as possible, and reports the cost per tick of the simulation subsystems.
+  *  Each file is replayed several times with the same random seed, and the
+  *  final transforms of all karts are compared between the runs, so that
+  *  a performance change can be checked for both speed and determinism.
+  *  Optionally the replays are repeated with different numbers of physics
+  *  threads, which must all give the same results.
+  * \ingroup race
+  */
+class HistoryBenchmark
+{
+private:
+    /** The history files to replay. */
+    static std::vector<std::string> m_history_files;
+
+    /** How often each history file is replayed. */
+    static int m_num_runs;
+
+    /** The random seed used for each run. */
+    static int m_seed;
+
+    /** The numbers of physics threads to benchmark, empty to use the
+     *  configured number only. */
+    static std::vector<int> m_physics_threads;
+
+    static std::vector<btTransform> replay(const std::string &filename);
+    static int compare(const std::string &filename, int run,
+                       const std::vector<btTransform> &reference,
+                       const std::vector<btTransform> &transforms);
+
+public:
+    static int  run();
+    static void setHistoryFiles(const std::string &files);
+    static bool setPhysicsThreads(const std::string &threads);
+    // ------------------------------------------------------------------------
+    /** Returns true if the benchmark was requested on the command line. */
+    static bool isEnabled() { return !m_history_files.empty(); }
+    // ------------------------------------------------------------------------
+    /** Sets how often each history file is replayed. */
+    static void setNumRuns(int n) { m_num_runs = n; }
+    // ------------------------------------------------------------------------
+    /** Sets the random seed used for each run. */
+    static void setSeed(int seed) { m_seed = seed; }
+};   // HistoryBenchmark
+
+#endif
@@ -30,15 +30,19 @@
 #include <algorithm>
 #include <queue>
 
+/** Maximum number of entries (nodes times path trees) of the path tree
+ *  cache, about 6 MB. Navmeshes with up to 1024 nodes keep all trees. */
+static const unsigned int MAX_PATH_TREE_ENTRIES = 1024 * 1024;
+
 // -----------------------------------------------------------------------------
 ArenaGraph::ArenaGraph(const std::string &navmesh, const XMLNode *node)
           : Graph()
 {
     loadNavmesh(navmesh);
     buildGraph();
-    // Compute shortest distance from all nodes
-    for (unsigned int i = 0; i < getNumNodes(); i++)
-        computeDijkstra(i);
+    // The shortest paths are computed when needed, see getPathTree()
+    const unsigned int n = std::max(getNumNodes(), 1u);
+    setMaxPathTrees(std::max(16u, std::min(n, MAX_PATH_TREE_ENTRIES / n)));
 
     setNearbyNodesOfAllNodes();
     if (node && race_manager->getMinorMode() == RaceManager::MINOR_MODE_SOCCER)
@@ -179,45 +183,87 @@ void ArenaGraph::buildGraph()
 {
     const unsigned int n_nodes = getNumNodes();
 
-    m_distance_matrix = std::vector<std::vector<float>>
-        (n_nodes, std::vector<float>(n_nodes, 9999.9f));
+    m_adjacent_distance.clear();
+    m_adjacent_distance.resize(n_nodes);
     for (unsigned int i = 0; i < n_nodes; i++)
     {
         ArenaNode* cur_node = getNode(i);
         for (const int& adjacent : cur_node->getAdjacentNodes())
         {
             Vec3 diff = getNode(adjacent)->getCenter() - cur_node->getCenter();
-            float distance = diff.length();
-            m_distance_matrix[i][adjacent] = distance;
+            m_adjacent_distance[i].push_back(diff.length());
         }
-        m_distance_matrix[i][i] = 0.0f;
     }
+}   // buildGraph
 
-    // Allocate and initialise the previous node data structure:
-    m_parent_node = std::vector<std::vector<int16_t>>
-        (n_nodes, std::vector<int16_t>(n_nodes, Graph::UNKNOWN_SECTOR));
-    for (unsigned int i = 0; i < n_nodes; i++)
+// ----------------------------------------------------------------------------
+/** Sets the maximum number of path trees kept in memory, and discards all
+ *  trees computed so far.
+ */
+void ArenaGraph::setMaxPathTrees(unsigned int n)
+{
+    m_max_path_trees = n;
+    m_path_trees.clear();
+    m_path_trees.reserve(n);
+    m_path_tree_index.clear();
+    m_path_tree_index.resize(getNumNodes(), -1);
+    m_path_tree_counter = 0;
+}   // setMaxPathTrees
+
+// ----------------------------------------------------------------------------
+/** Returns the shortest paths from all nodes to the specified node. They are
+ *  computed if necessary, replacing the least recently used path tree if
+ *  too many are in memory. The returned reference is only valid until the
+ *  next call.
+ *  \param target The node to which the paths lead.
+ */
+const ArenaGraph::PathTree& ArenaGraph::getPathTree(int target) const
+{
+    int index = m_path_tree_index[target];
+    if (index < 0)
     {
-        for (unsigned int j = 0; j < n_nodes; j++)
+        if (m_path_trees.size() < m_max_path_trees)
         {
-            if (i == j || m_distance_matrix[i][j] >= 9899.9f)
-                m_parent_node[i][j] = -1;
-            else
-                m_parent_node[i][j] = i;
-        }   // for j
-    }   // for i
-
-}   // buildGraph
+            index = (int)m_path_trees.size();
+            m_path_trees.push_back(PathTree());
+        }
+        else
+        {
+            index = 0;
+            for (unsigned int i = 1; i < m_path_trees.size(); i++)
+            {
+                if (m_path_trees[i].m_last_used <
+                    m_path_trees[index].m_last_used)
+                    index = i;
+            }
+            m_path_tree_index[m_path_trees[index].m_target] = -1;
+        }
+        PathTree &tree = m_path_trees[index];
+        tree.m_target = target;
+        computeDijkstra(target, &tree.m_distance, &tree.m_parent);
+        m_path_tree_index[target] = index;
+    }
+    m_path_trees[index].m_last_used = ++m_path_tree_counter;
+    return m_path_trees[index];
+}   // getPathTree
 
 // ----------------------------------------------------------------------------
 /** Dijkstra shortest path computation. It computes the shortest distance from
  *  the specified node 'source' to all other nodes. At the end of the
- *  computation, m_distance_matrix[i][j] stores the shortest path distance from
- *  source to j and m_parent_node[source][j] stores the last vertex visited on
- *  the shortest path from i to j before visiting j. Suppose the shortest path
- *  from i to j is i->......->k->j  then m_parent_node[i][j] = k
+ *  computation, distance[j] stores the shortest path distance from source to
+ *  j and parent[j] stores the last vertex visited on the shortest path from
+ *  source to j before visiting j. Suppose the shortest path from source to j
+ *  is source->......->k->j then parent[j] = k
+ *  \param settled If not NULL, the nodes in the order in which their
+ *         shortest distance became known.
+ *  \param max_settled If not 0, stop once this many nodes (apart from
+ *         source) and all nodes with the same distance as the last one are
+ *         settled. The distances of the other nodes are then not final.
  */
-void ArenaGraph::computeDijkstra(int source)
+void ArenaGraph::computeDijkstra(int source, std::vector<float> *distance,
+                                 std::vector<int16_t> *parent,
+                                 std::vector<int> *settled,
+                                 unsigned int max_settled) const
 {
     // Stores the distance (float) to 'source' from a specified node (int)
     typedef std::pair<int, float> IndDistPair;
@@ -231,32 +277,56 @@ void ArenaGraph::computeDijkstra(int source)
         }
     };
 
+    const unsigned int n = getNumNodes();
+    distance->assign(n, 9999.9f);
+    parent->assign(n, Graph::UNKNOWN_SECTOR);
+    const std::vector<int> &source_adjacent =
+        getNode(source)->getAdjacentNodes();
+    for (unsigned int i = 0; i < source_adjacent.size(); i++)
+    {
+        (*distance)[source_adjacent[i]] = m_adjacent_distance[source][i];
+        (*parent)[source_adjacent[i]] = source;
+    }
+    (*distance)[source] = 0.0f;
+    (*parent)[source] = Graph::UNKNOWN_SECTOR;
+
     std::priority_queue<IndDistPair, std::vector<IndDistPair>, Shortest> queue;
     IndDistPair begin(source, 0.0f);
     queue.push(begin);
-    const unsigned int n = getNumNodes();
     std::vector<bool> visited;
     visited.resize(n, false);
+    unsigned int num_settled = 0;
+    float last_settled_distance = 0.0f;
     while (!queue.empty())
     {
+        if (max_settled > 0 && num_settled > max_settled &&
+            queue.top().second > last_settled_distance)
+            break;
         // Get element with shortest path
         IndDistPair current = queue.top();
         queue.pop();
         int cur_index = current.first;
         if (visited[cur_index]) continue;
         visited[cur_index] = true;
-
-        for (const int& adjacent : getNode(cur_index)->getAdjacentNodes())
+        num_settled++;
+        last_settled_distance = current.second;
+        if (settled)
+            settled->push_back(cur_index);
+
+        const std::vector<int> &adjacent_nodes =
+            getNode(cur_index)->getAdjacentNodes();
+        for (unsigned int i = 0; i < adjacent_nodes.size(); i++)
         {
+            const int adjacent = adjacent_nodes[i];
             // Distance already computed, can be ignored
             if (visited[adjacent]) continue;
 
             float new_dist =
-                current.second + m_distance_matrix[cur_index][adjacent];
-            if (new_dist < m_distance_matrix[source][adjacent])
+                current.second + m_adjacent_distance[cur_index][i];
+            if (new_dist < (*distance)[adjacent])
             {
-                m_distance_matrix[source][adjacent] = new_dist;
-                m_parent_node[source][adjacent] = cur_index;
+                (*distance)[adjacent] = new_dist;
+                (*parent)[adjacent] = cur_index;
             }
             IndDistPair pair(adjacent, new_dist);
             queue.push(pair);
@@ -268,28 +338,45 @@ void ArenaGraph::computeDijkstra(int source)
 /** THIS FUNCTION IS ONLY USED FOR UNIT-TESTING, to verify that the new
  *  Dijkstra algorithm gives the same results.
  *  computeFloydWarshall() computes the shortest distance between any two
- *  nodes. At the end of the computation, m_distance_matrix[i][j] stores the
- *  shortest path distance from i to j and m_parent_node[i][j] stores the last
+ *  nodes. At the end of the computation, distance[i][j] stores the
+ *  shortest path distance from i to j and parent[i][j] stores the last
  *  vertex visited on the shortest path from i to j before visiting j. Suppose
  *  the shortest path from i to j is i->......->k->j  then
- *  m_parent_node[i][j] = k
+ *  parent[i][j] = k
  */
-void ArenaGraph::computeFloydWarshall()
+void ArenaGraph::computeFloydWarshall(
+                          std::vector<std::vector<float> > *distance,
+                          std::vector<std::vector<int16_t> > *parent) const
 {
     unsigned int n = getNumNodes();
 
+    std::vector<std::vector<float> > &d = *distance;
+    std::vector<std::vector<int16_t> > &p = *parent;
+    d.assign(n, std::vector<float>(n, 9999.9f));
+    p.assign(n, std::vector<int16_t>(n, Graph::UNKNOWN_SECTOR));
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const std::vector<int> &adjacent_nodes =
+            getNode(i)->getAdjacentNodes();
+        for (unsigned int j = 0; j < adjacent_nodes.size(); j++)
+        {
+            d[i][adjacent_nodes[j]] = m_adjacent_distance[i][j];
+            p[i][adjacent_nodes[j]] = i;
+        }
+        d[i][i] = 0.0f;
+        p[i][i] = Graph::UNKNOWN_SECTOR;
+    }
+
     for (unsigned int k = 0; k < n; k++)
     {
         for (unsigned int i = 0; i < n; i++)
         {
             for (unsigned int j = 0; j < n; j++)
             {
-                if ((m_distance_matrix[i][k] + m_distance_matrix[k][j]) <
-                    m_distance_matrix[i][j])
+                if ((d[i][k] + d[k][j]) < d[i][j])
                 {
-                    m_distance_matrix[i][j] =
-                        m_distance_matrix[i][k] + m_distance_matrix[k][j];
-                    m_parent_node[i][j] = m_parent_node[k][j];
+                    d[i][j] = d[i][k] + d[k][j];
+                    p[i][j] = p[k][j];
                 }
             }
         }
@@ -336,24 +423,37 @@ void ArenaGraph::setNearbyNodesOfAllNodes()
 {
     // Only save the nearby 8 nodes
     const unsigned int try_count = 8;
-    for (unsigned int i = 0; i < getNumNodes(); i++)
+    const unsigned int n = getNumNodes();
+    std::vector<float> dist;
+    std::vector<int16_t> parent;
+    for (unsigned int i = 0; i < n; i++)
     {
-        // Get the distance to all nodes at i
-        ArenaNode* cur_node = getNode(i);
-        std::vector<int> nearby_nodes;
-        std::vector<float> dist = m_distance_matrix[i];
-
-        // Skip the same node
-        dist[i] = 999999.0f;
-        for (unsigned int j = 0; j < try_count; j++)
+        // Only compute the shortest distances until the nearest nodes are
+        // known, then pick them by distance (and index if equal)
+        std::vector<int> settled;
+        computeDijkstra(i, &dist, &parent, &settled, try_count);
+        settled.erase(settled.begin());
+        std::sort(settled.begin(), settled.end(), [&dist](int a, int b)
+            {
+                return dist[a] < dist[b] || (dist[a] == dist[b] && a < b);
+            });
+        if (settled.size() > try_count)
+            settled.resize(try_count);
+
+        // If not enough nodes can be reached, use the unreachable nodes
+        // with the lowest indices (and node 0 if there are too few nodes)
+        std::vector<bool> used(n, false);
+        used[i] = true;
+        for (int node : settled)
+            used[node] = true;
+        for (unsigned int j = 0; j < n && settled.size() < try_count; j++)
         {
-            std::vector<float>::iterator it =
-                std::min_element(dist.begin(), dist.end());
-            const int pos = int(it - dist.begin());
-            nearby_nodes.push_back(pos);
-            dist[pos] = 999999.0f;
+            if (!used[j])
+                settled.push_back(j);
         }
-        cur_node->setNearbyNodes(nearby_nodes);
+        while (settled.size() < try_count)
+            settled.push_back(0);
+        getNode(i)->setNearbyNodes(settled);
     }
 
 }   // setNearbyNodesOfAllNodes
@@ -380,7 +480,9 @@ std::vector<int16_t> ArenaGraph::getPathFromTo(int from, int to,
  *  Instead of using hand-tuned test cases we use the tested, verified and
  *  easier to understand Floyd-Warshall algorithm to compute the distances,
  *  and check if the (significanty faster) Dijkstra algorithm gives the same
- *  results. For now we use the cave mesh as test case.
+ *  results. It also checks that a small path tree cache, as used for big
+ *  navmeshes, gives the same results as keeping all trees. For now we use
+ *  the cave mesh as test case.
  */
 void ArenaGraph::unitTesting()
 {
@@ -389,30 +491,35 @@ void ArenaGraph::unitTesting()
 
     double s = StkTime::getRealTime();
     ArenaGraph* ag = new ArenaGraph(navmesh_file_name);
+    const unsigned int n = ag->getNumNodes();
+    std::vector< std::vector< float > > distance_matrix(n);
+    std::vector< std::vector< int16_t > > parent_node(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        distance_matrix[i] = ag->getPathTree(i).m_distance;
+        parent_node[i] = ag->getPathTree(i).m_parent;
+    }
     double e = StkTime::getRealTime();
     Log::error("Time", "Dijkstra       %lf", e-s);
 
-    // Save the Dijkstra results
-    std::vector< std::vector< float > > distance_matrix = ag->m_distance_matrix;
-    std::vector< std::vector< int16_t > > parent_node = ag->m_parent_node;
-    ag->buildGraph();
-
     // Now compute results with Floyd-Warshall
+    std::vector< std::vector< float > > fw_distance;
+    std::vector< std::vector< int16_t > > fw_parent;
     s = StkTime::getRealTime();
-    ag->computeFloydWarshall();
+    ag->computeFloydWarshall(&fw_distance, &fw_parent);
     e = StkTime::getRealTime();
     Log::error("Time", "Floyd-Warshall %lf", e-s);
 
     int error_count = 0;
-    for(unsigned int i=0; i<ag->m_distance_matrix.size(); i++)
+    for(unsigned int i=0; i<n; i++)
     {
-        for(unsigned int j=0; j<ag->m_distance_matrix[i].size(); j++)
+        for(unsigned int j=0; j<n; j++)
         {
-            if(ag->m_distance_matrix[i][j] - distance_matrix[i][j] > 0.001f)
+            if(fw_distance[i][j] - distance_matrix[i][j] > 0.001f)
             {
                 Log::error("ArenaGraph",
                            "Incorrect distance %d, %d: Dijkstra: %f F.W.: %f",
-                           i, j, distance_matrix[i][j], ag->m_distance_matrix[i][j]);
+                           i, j, distance_matrix[i][j], fw_distance[i][j]);
                 error_count++;
             }    // if distance is too different
 
@@ -424,16 +531,16 @@ void ArenaGraph::unitTesting()
             // debugging in the feature
 #undef TEST_PARENT_POLY_EVEN_THOUGH_MANY_FALSE_POSITIVES
 #ifdef TEST_PARENT_POLY_EVEN_THOUGH_MANY_FALSE_POSITIVES
-            if(ag->m_parent_node[i][j] != parent_node[i][j])
+            if(fw_parent[i][j] != parent_node[i][j])
             {
                 error_count++;
                 std::vector<int16_t> dijkstra_path = getPathFromTo(i, j, parent_node);
-                std::vector<int16_t> floyd_path = getPathFromTo(i, j, ag->m_parent_node);
+                std::vector<int16_t> floyd_path = getPathFromTo(i, j, fw_parent);
                 if(dijkstra_path.size()!=floyd_path.size())
                 {
                     Log::error("ArenaGraph",
                                "Incorrect path length %d, %d: Dijkstra: %d F.W.: %d",
-                               i, j, parent_node[i][j], ag->m_parent_node[i][j]);
+                               i, j, parent_node[i][j], fw_parent[i][j]);
                     continue;
                 }
                 Log::error("ArenaGraph", "Path problems from %d to %d:",
@@ -451,6 +558,29 @@ void ArenaGraph::unitTesting()
         }   // for j
     }   // for i
 
+    // A cache with only a few path trees must give the same results, even
+    // when trees are replaced while iterating
+    ag->setMaxPathTrees(3);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        for (unsigned int j = 0; j < n; j++)
+        {
+            if (ag->getDistance(j, i) != distance_matrix[i][j] ||
+                ag->getNextNode(j, i) != parent_node[i][j] ||
+                ag->getDistance(i, j) != distance_matrix[j][i])
+            {
+                Log::error("ArenaGraph", "Path tree cache differs for "
+                           "%d, %d.", i, j);
+                error_count++;
+            }
+        }   // for j
+    }   // for i
+    if (error_count > 0)
+    {
+        Log::fatal("ArenaGraph", "%d errors in the shortest paths.",
+                   error_count);
+    }
+
     delete ag;
 
 }   // unitTesting
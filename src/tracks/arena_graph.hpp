@@ -34,11 +34,42 @@ class XMLNode;
 class ArenaGraph : public Graph
 {
 private:
-    /** The actual graph data structure, it is an adjacency matrix. */
-    std::vector<std::vector<float>> m_distance_matrix;
+    /** The shortest paths from all nodes to one target node. */
+    struct PathTree
+    {
+        /** The node all paths lead to. */
+        int m_target;
+
+        /** Distance of each node to the target. */
+        std::vector<float> m_distance;
+
+        /** m_parent[i] is the node before i on the shortest path from the
+         *  target to i, which is the next node on the path from i to the
+         *  target (undirected graph). */
+        std::vector<int16_t> m_parent;
+
+        /** Value of m_path_tree_counter when this tree was last used. */
+        uint64_t m_last_used;
+    };
+
+    /** The distance to each adjacent node, in the same order as in
+     *  ArenaNode::getAdjacentNodes(). */
+    std::vector<std::vector<float> > m_adjacent_distance;
 
-    /** The matrix that is used to store computed shortest paths. */
-    std::vector<std::vector<int16_t>> m_parent_node;
+    /** The shortest path trees computed so far. They are only computed when
+     *  needed and the least recently used tree is replaced if there are
+     *  more than m_max_path_trees, so big navmeshes don't need a table which
+     *  grows quadratically with the number of nodes. */
+    mutable std::vector<PathTree> m_path_trees;
+
+    /** Index of the path tree of each node in m_path_trees, or -1. */
+    mutable std::vector<int> m_path_tree_index;
+
+    /** Counts the uses of path trees to find the least recently used one. */
+    mutable uint64_t m_path_tree_counter;
+
+    /** Maximum number of path trees kept in memory. */
+    unsigned int m_max_path_trees;
 
     /** Used in soccer mode to colorize the goal lines in minimap. */
     std::set<int> m_red_node;
@@ -54,9 +85,17 @@ private:
     // ------------------------------------------------------------------------
     void setNearbyNodesOfAllNodes();
     // ------------------------------------------------------------------------
-    void computeDijkstra(int n);
+    void computeDijkstra(int source, std::vector<float> *distance,
+                         std::vector<int16_t> *parent,
+                         std::vector<int> *settled = NULL,
+                         unsigned int max_settled = 0) const;
+    // ------------------------------------------------------------------------
+    void computeFloydWarshall(std::vector<std::vector<float> > *distance,
+                          std::vector<std::vector<int16_t> > *parent) const;
+    // ------------------------------------------------------------------------
+    const PathTree& getPathTree(int target) const;
     // ------------------------------------------------------------------------
-    void computeFloydWarshall();
+    void setMaxPathTrees(unsigned int n);
     // ------------------------------------------------------------------------
     static std::vector<int16_t> getPathFromTo(int from, int to,
                      const std::vector< std::vector< int16_t > >& parent_node);
@@ -76,23 +115,24 @@ public:
     // ------------------------------------------------------------------------
     ArenaNode* getNode(unsigned int i) const;
     // ------------------------------------------------------------------------
-    /** Returns the next node on the shortest path from i to j.
-     *  Note: m_parent_node[j][i] contains the parent of i on path from j to i,
-     *  which is the next node on the path from i to j (undirected graph)
-     */
+    /** Returns the next node on the shortest path from i to j. */
     int getNextNode(int i, int j) const
     {
         if (i == Graph::UNKNOWN_SECTOR || j == Graph::UNKNOWN_SECTOR)
             return Graph::UNKNOWN_SECTOR;
-        return (int)(m_parent_node[j][i]);
+        return (int)(getPathTree(j).m_parent[i]);
     }
     // ------------------------------------------------------------------------
-    /** Returns the distance between any two nodes */
+    /** Returns the distance between any two nodes. The path tree of 'to' is
+     *  used, since callers usually ask for the distance of many nodes to the
+     *  same target, so callers should keep 'to' fixed in loops. The distance
+     *  is summed from 'to', so it can differ in the last bits from the
+     *  distance in the other direction. */
     float getDistance(int from, int to) const
     {
         if (from == Graph::UNKNOWN_SECTOR || to == Graph::UNKNOWN_SECTOR)
             return 99999.0f;
-        return m_distance_matrix[from][to];
+        return getPathTree(to).m_distance[from];
     }
 
 };   // ArenaGraph
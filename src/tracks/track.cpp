@@ -79,7 +79,9 @@
 #include "utils/log.hpp"
 #include "utils/mini_glm.hpp"
 #include "utils/string_utils.hpp"
+#include "utils/tick_profiler.hpp"
 #include "utils/translation.hpp"
+#include "utils/vs.hpp"
 
 #include <IBillboardTextSceneNode.h>
 #include <ILightSceneNode.h>
@@ -165,6 +167,7 @@ Track::Track(const std::string &filename)
     m_cache_track           = UserConfigParams::m_cache_overworld &&
                               m_ident=="overworld";
     m_render_target         = NULL;
+    m_height_map_version    = -1;
     m_minimap_x_scale       = 1.0f;
     m_minimap_y_scale       = 1.0f;
     m_force_disable_fog     = false;
@@ -182,6 +185,8 @@ Track::Track(const std::string &filename)
 /** Destructor, removes quad data structures etc. */
 Track::~Track()
 {
+    if (m_height_map_thread.joinable())
+        m_height_map_thread.join();
     // Note that the music information in m_music is globally managed
     // by the music_manager, and is freed there. So no need to free it
     // here (esp. since various track might share the same music).
@@ -365,6 +370,9 @@ void Track::cleanup()
     if (CVS->isGLSL())
         m_sun->drop();
 #endif
+    // The height map is built from the track mesh
+    if (m_height_map_thread.joinable())
+        m_height_map_thread.join();
     delete m_track_mesh;
     m_track_mesh = NULL;
 
@@ -1613,8 +1621,12 @@ void Track::update(int ticks)
         m_startup_run = true;
     }
     float dt = stk_config->ticks2Time(ticks);
+    TickProfiler::start(TickProfiler::TP_CHECK_STRUCTURES);
     CheckManager::get()->update(dt);
+    TickProfiler::stop(TickProfiler::TP_CHECK_STRUCTURES);
+    TickProfiler::start(TickProfiler::TP_ITEMS);
     ItemManager::get()->update(ticks);
+    TickProfiler::stop(TickProfiler::TP_ITEMS);
 
     // TODO: enable onUpdate scripts if we ever find a compelling use for them
     //Scripting::ScriptEngine* script_engine = World::getWorld()->getScriptEngine();
@@ -1827,6 +1839,7 @@ void Track::loadTrackModel(bool reverse_track, unsigned int mode_id)
 #endif
     main_loop->renderGUI(3200);
 
+    material_manager->resetLookupStatistics();
     // First read the temporary materials.xml file if it exists
     try
     {
@@ -2021,6 +2034,9 @@ void Track::loadTrackModel(bool reverse_track, unsigned int mode_id)
     main_loop->renderGUI(5000);
 
     Log::info("Track", "Overall scene complexity estimated at %d", irr_driver->getSceneComplexity());
+    Log::debug("Track", "%u material lookups, %u materials compared.",
+               material_manager->getNumLookups(),
+               material_manager->getNumCompared());
     // Correct the parenting of meta library
     for (auto& p : m_meta_library)
     {
@@ -2165,6 +2181,7 @@ void Track::loadTrackModel(bool reverse_track, unsigned int mode_id)
         m_track_object_manager->removeObject(obj);
 
     createPhysicsModel(main_track_count);
+    startBuildingHeightMap();
     main_loop->renderGUI(5600);
 
     freeCachedMeshVertexBuffer();
@@ -2704,9 +2721,61 @@ void Track::itemCommand(const XMLNode *node)
 
 // ----------------------------------------------------------------------------
 
-std::vector< std::vector<float> > Track::buildHeightMap()
+/** Starts building the height map for the weather particles in a separate
+ *  thread, so that the ray casts do not delay the start of the race. This
+ *  must be called after the physics model of the track was created, and
+ *  does nothing if there are no weather particles or the height map of a
+ *  previous race on this track can be reused.
+ */
+void Track::startBuildingHeightMap()
+{
+#ifndef SERVER_ONLY
+    if (!m_sky_particles || UserConfigParams::m_particles_effects < 2 ||
+        ProfileWorld::isNoGraphics() || hasValidHeightMap())
+        return;
+
+    assert(!m_height_map_thread.joinable());
+    m_height_map.reset();
+    m_height_map_version = m_version;
+    m_height_map_min     = m_aabb_min;
+    m_height_map_max     = m_aabb_max;
+    m_height_map_thread  = std::thread([this]()
+    {
+        VS::setThreadName("HeightMap");
+        m_height_map =
+            std::make_shared<const std::vector<float> >(buildHeightMap());
+    });
+#endif
+}   // startBuildingHeightMap
+
+// ----------------------------------------------------------------------------
+/** Returns the height map of this track, see m_height_map. It waits for
+ *  the thread started in startBuildingHeightMap if necessary, or builds
+ *  the height map now if it was not started.
+ */
+std::shared_ptr<const std::vector<float> > Track::getHeightMap()
+{
+    if (m_height_map_thread.joinable())
+        m_height_map_thread.join();
+    if (!hasValidHeightMap())
+    {
+        m_height_map_version = m_version;
+        m_height_map_min     = m_aabb_min;
+        m_height_map_max     = m_aabb_max;
+        m_height_map =
+            std::make_shared<const std::vector<float> >(buildHeightMap());
+    }
+    return m_height_map;
+}   // getHeightMap
+
+// ----------------------------------------------------------------------------
+/** Casts a ray down onto the track mesh for each point of the height map
+ *  grid. Only reads the track mesh, so it can run in a separate thread.
+ *  \return The heights, row by row along the x axis.
+ */
+std::vector<float> Track::buildHeightMap() const
 {
-    std::vector< std::vector<float> > out(HEIGHT_MAP_RESOLUTION);
+    std::vector<float> out(HEIGHT_MAP_RESOLUTION * HEIGHT_MAP_RESOLUTION);
 
     float x = m_aabb_min.getX();
     const float x_len = m_aabb_max.getX() - m_aabb_min.getX();
@@ -2721,8 +2790,8 @@ std::vector< std::vector<float> > Track::buildHeightMap()
 
     for (int i=0; i<HEIGHT_MAP_RESOLUTION; i++)
     {
-        out[i].resize(HEIGHT_MAP_RESOLUTION);
         float z = m_aabb_min.getZ();
+        float *row = out.data() + i * HEIGHT_MAP_RESOLUTION;
 
         for (int j=0; j<HEIGHT_MAP_RESOLUTION; j++)
         {
@@ -2733,7 +2802,7 @@ std::vector< std::vector<float> > Track::buildHeightMap()
             m_track_mesh->castRay(pos, to, &hitpoint, &material, &normal);
             z += z_step;
 
-            out[i][j] = hitpoint.getY();
+            row[j] = hitpoint.getY();
         }   // j<HEIGHT_MAP_RESOLUTION
         x += x_step;
     }
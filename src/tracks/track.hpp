@@ -26,7 +26,9 @@
   * objects.
   */
 
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <irrlicht.h>
@@ -228,6 +230,22 @@ private:
       */
     bool                     m_internal;
 
+    /** Heights of the track on a HEIGHT_MAP_RESOLUTION x
+     *  HEIGHT_MAP_RESOLUTION grid over its bounding box, stored row by
+     *  row along the x axis. It is used to kill weather particles below
+     *  the track, built in a separate thread while the rest of the race
+     *  is loaded, and kept for later races on the same track version. */
+    std::shared_ptr<const std::vector<float> > m_height_map;
+
+    /** The thread building m_height_map, joined in getHeightMap() and
+     *  before the track mesh is deleted. */
+    std::thread              m_height_map_thread;
+
+    /** Track version and bounding box m_height_map was built for. */
+    int                      m_height_map_version;
+    Vec3                     m_height_map_min;
+    Vec3                     m_height_map_max;
+
     /** Whether this track should be available in reverse version */
     bool                     m_reverse_available;
 
@@ -402,6 +420,18 @@ private:
     void loadCurves(const XMLNode &node);
     void handleSky(const XMLNode &root, const std::string &filename);
     void freeCachedMeshVertexBuffer();
+    void startBuildingHeightMap();
+    std::vector<float> buildHeightMap() const;
+    // ------------------------------------------------------------------------
+    /** Returns true if m_height_map was built for the current version and
+     *  bounding box of this track. */
+    bool hasValidHeightMap() const
+    {
+        return m_height_map && m_height_map_version == m_version &&
+               m_height_map_min == m_aabb_min &&
+               m_height_map_max == m_aabb_max;
+    }   // hasValidHeightMap
+    // ------------------------------------------------------------------------
 public:
 
     /** Static function to get the current track. NULL if no current
@@ -446,7 +476,7 @@ public:
                                         unsigned int mode_id=0);
     bool findGround(AbstractKart *kart);
 
-    std::vector< std::vector<float> > buildHeightMap();
+    std::shared_ptr<const std::vector<float> > getHeightMap();
     void               drawMiniMap(const core::rect<s32>& dest_rect) const;
     // ------------------------------------------------------------------------
     /** Returns true if this track has an arena mode. */
@@ -152,6 +152,12 @@ public:
             return m_x[last-1];
         }   // increasing
     }   // getReverse
+    // ------------------------------------------------------------------------
+    /** Returns true if both arrays contain exactly the same points. */
+    bool operator==(const InterpolationArray &other) const
+    {
+        return m_x == other.m_x && m_y == other.m_y;
+    }   // operator==
 };    // InterpolationArray
 
 
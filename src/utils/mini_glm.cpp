@@ -19,8 +19,342 @@
 #include "utils/log.hpp"
 #include "utils/mini_glm.hpp"
 
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINI_GLM_SSE2
+#include <emmintrin.h>
+// The quaternion packing uses floating point math, which is only identical
+// to the scalar code if that uses SSE too (no x87 excess precision) and the
+// compiler can not contract a * b + c into a fused multiply-add.
+#if (defined(__SSE2_MATH__) || defined(_M_X64)) && !defined(__FMA__)
+#define MINI_GLM_SSE2_MATH
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MINI_GLM_NEON
+#include <arm_neon.h>
+#endif
+
 namespace MiniGLM
 {
+#if defined(MINI_GLM_SSE2)
+    // ------------------------------------------------------------------------
+    /** Selects a where mask is set, else b. */
+    inline __m128i blend(__m128i mask, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }   // blend
+    // ------------------------------------------------------------------------
+    inline __m128 blend(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }   // blend
+    // ------------------------------------------------------------------------
+    /** Converts 4 floats to half floats with the same algorithm as
+     *  toFloat16. Results which are denormalized halfs need a different
+     *  shift for each element, in this case false is returned and nothing
+     *  is written, so the caller can use the scalar code instead. */
+    inline bool toFloat16x4(const float* in, short* out)
+    {
+        const __m128i i = _mm_loadu_si128((const __m128i*)in);
+        const __m128i s = _mm_and_si128(_mm_srli_epi32(i, 16),
+            _mm_set1_epi32(0x00008000));
+        const __m128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(i, 23),
+            _mm_set1_epi32(0x000000ff)), _mm_set1_epi32(127 - 15));
+        const __m128i m = _mm_and_si128(i, _mm_set1_epi32(0x007fffff));
+
+        const __m128i denormal = _mm_and_si128(
+            _mm_cmpgt_epi32(e, _mm_set1_epi32(-11)),
+            _mm_cmplt_epi32(e, _mm_set1_epi32(1)));
+        if (_mm_movemask_epi8(denormal) != 0)
+            return false;
+
+        // Normalized: round to nearest, round "0.5" up, an overflow of the
+        // significand ends up in the exponent
+        __m128i rm = _mm_add_epi32(m, _mm_slli_epi32(
+            _mm_and_si128(m, _mm_set1_epi32(0x00001000)), 1));
+        const __m128i re = _mm_add_epi32(e, _mm_srli_epi32(rm, 23));
+        rm = _mm_and_si128(rm, _mm_set1_epi32(0x007fffff));
+        __m128i result = _mm_or_si128(_mm_slli_epi32(re, 10),
+            _mm_srli_epi32(rm, 13));
+        const __m128i infinity = _mm_set1_epi32(0x7c00);
+        result = blend(_mm_cmpgt_epi32(re, _mm_set1_epi32(30)), infinity,
+            result);
+
+        // Infinity or NAN, make sure a NAN does not turn into an infinity
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mn = _mm_srli_epi32(m, 13);
+        const __m128i nan_bit = _mm_andnot_si128(_mm_cmpeq_epi32(m, zero),
+            _mm_and_si128(_mm_cmpeq_epi32(mn, zero), _mm_set1_epi32(1)));
+        result = blend(_mm_cmpeq_epi32(e, _mm_set1_epi32(0xff - (127 - 15))),
+            _mm_or_si128(infinity, _mm_or_si128(mn, nan_bit)), result);
+
+        // Too small for a half: zero
+        result = _mm_andnot_si128(_mm_cmplt_epi32(e, _mm_set1_epi32(-10)),
+            result);
+        result = _mm_or_si128(s, result);
+
+        // Sign extend so that packing does not saturate
+        result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+        _mm_storel_epi64((__m128i*)out, _mm_packs_epi32(result, result));
+        return true;
+    }   // toFloat16x4
+    // ------------------------------------------------------------------------
+    /** Converts 4 half floats to floats with the same algorithm as
+     *  toFloat32, returns false for denormalized halfs, which need to be
+     *  renormalized by the scalar code. */
+    inline bool toFloat32x4(const short* in, float* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i h = _mm_unpacklo_epi16(
+            _mm_loadl_epi64((const __m128i*)in), zero);
+        const __m128i e = _mm_and_si128(_mm_srli_epi32(h, 10),
+            _mm_set1_epi32(0x0000001f));
+        const __m128i m = _mm_and_si128(h, _mm_set1_epi32(0x000003ff));
+        const __m128i e_zero = _mm_cmpeq_epi32(e, zero);
+        if (_mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi32(m, zero),
+            e_zero)) != 0)
+            return false;
+
+        __m128i exponent = _mm_slli_epi32(
+            _mm_add_epi32(e, _mm_set1_epi32(127 - 15)), 23);
+        exponent = blend(_mm_cmpeq_epi32(e, _mm_set1_epi32(31)),
+            _mm_set1_epi32(0x7f800000), exponent);
+        exponent = _mm_andnot_si128(e_zero, exponent);
+        const __m128i result = _mm_or_si128(
+            _mm_slli_epi32(_mm_srli_epi32(h, 15), 31),
+            _mm_or_si128(exponent, _mm_slli_epi32(m, 13)));
+        _mm_storeu_si128((__m128i*)out, result);
+        return true;
+    }   // toFloat32x4
+
+#elif defined(MINI_GLM_NEON)
+    // ------------------------------------------------------------------------
+    inline bool anyLane(uint32x4_t mask)
+    {
+        uint32x2_t tmp = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+        return (vget_lane_u32(tmp, 0) | vget_lane_u32(tmp, 1)) != 0;
+    }   // anyLane
+    // ------------------------------------------------------------------------
+    /** See the SSE2 version above. */
+    inline bool toFloat16x4(const float* in, short* out)
+    {
+        const uint32x4_t i = vreinterpretq_u32_f32(vld1q_f32(in));
+        const uint32x4_t s = vandq_u32(vshrq_n_u32(i, 16),
+            vdupq_n_u32(0x00008000));
+        const int32x4_t e = vsubq_s32(vreinterpretq_s32_u32(vandq_u32(
+            vshrq_n_u32(i, 23), vdupq_n_u32(0x000000ff))),
+            vdupq_n_s32(127 - 15));
+        const uint32x4_t m = vandq_u32(i, vdupq_n_u32(0x007fffff));
+
+        if (anyLane(vandq_u32(vcgtq_s32(e, vdupq_n_s32(-11)),
+            vcltq_s32(e, vdupq_n_s32(1)))))
+            return false;
+
+        uint32x4_t rm = vaddq_u32(m, vshlq_n_u32(
+            vandq_u32(m, vdupq_n_u32(0x00001000)), 1));
+        const int32x4_t re = vaddq_s32(e,
+            vreinterpretq_s32_u32(vshrq_n_u32(rm, 23)));
+        rm = vandq_u32(rm, vdupq_n_u32(0x007fffff));
+        uint32x4_t result = vorrq_u32(
+            vshlq_n_u32(vreinterpretq_u32_s32(re), 10), vshrq_n_u32(rm, 13));
+        const uint32x4_t infinity = vdupq_n_u32(0x7c00);
+        result = vbslq_u32(vcgtq_s32(re, vdupq_n_s32(30)), infinity, result);
+
+        const uint32x4_t mn = vshrq_n_u32(m, 13);
+        const uint32x4_t nan_bit = vandq_u32(
+            vmvnq_u32(vceqq_u32(m, vdupq_n_u32(0))),
+            vandq_u32(vceqq_u32(mn, vdupq_n_u32(0)), vdupq_n_u32(1)));
+        result = vbslq_u32(vceqq_s32(e, vdupq_n_s32(0xff - (127 - 15))),
+            vorrq_u32(infinity, vorrq_u32(mn, nan_bit)), result);
+
+        result = vbicq_u32(result, vcltq_s32(e, vdupq_n_s32(-10)));
+        result = vorrq_u32(s, result);
+        vst1_s16(out, vreinterpret_s16_u16(vmovn_u32(result)));
+        return true;
+    }   // toFloat16x4
+    // ------------------------------------------------------------------------
+    /** See the SSE2 version above. */
+    inline bool toFloat32x4(const short* in, float* out)
+    {
+        const uint32x4_t h =
+            vmovl_u16(vreinterpret_u16_s16(vld1_s16(in)));
+        const uint32x4_t e = vandq_u32(vshrq_n_u32(h, 10),
+            vdupq_n_u32(0x0000001f));
+        const uint32x4_t m = vandq_u32(h, vdupq_n_u32(0x000003ff));
+        const uint32x4_t e_zero = vceqq_u32(e, vdupq_n_u32(0));
+        if (anyLane(vbicq_u32(e_zero, vceqq_u32(m, vdupq_n_u32(0)))))
+            return false;
+
+        uint32x4_t exponent = vshlq_n_u32(
+            vaddq_u32(e, vdupq_n_u32(127 - 15)), 23);
+        exponent = vbslq_u32(vceqq_u32(e, vdupq_n_u32(31)),
+            vdupq_n_u32(0x7f800000), exponent);
+        exponent = vbicq_u32(exponent, e_zero);
+        const uint32x4_t result = vorrq_u32(
+            vshlq_n_u32(vshrq_n_u32(h, 15), 31),
+            vorrq_u32(exponent, vshlq_n_u32(m, 13)));
+        vst1q_f32(out, vreinterpretq_f32_u32(result));
+        return true;
+    }   // toFloat32x4
+#endif
+
+    // ------------------------------------------------------------------------
+    /** Converts n floats to half floats, see toFloat16. */
+    void toFloat16Batch(const float* in, short* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(MINI_GLM_SSE2) || defined(MINI_GLM_NEON)
+        for (; i + 4 <= n; i += 4)
+        {
+            if (!toFloat16x4(in + i, out + i))
+            {
+                for (size_t j = i; j < i + 4; j++)
+                    out[j] = toFloat16(in[j]);
+            }
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = toFloat16(in[i]);
+    }   // toFloat16Batch
+
+    // ------------------------------------------------------------------------
+    /** Converts n half floats to floats, see toFloat32. */
+    void toFloat32Batch(const short* in, float* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(MINI_GLM_SSE2) || defined(MINI_GLM_NEON)
+        for (; i + 4 <= n; i += 4)
+        {
+            if (!toFloat32x4(in + i, out + i))
+            {
+                for (size_t j = i; j < i + 4; j++)
+                    out[j] = toFloat32(in[j]);
+            }
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = toFloat32(in[i]);
+    }   // toFloat32Batch
+
+    // ------------------------------------------------------------------------
+    /** Compresses n quaternions, see compressQuaternion. With SSE2 four
+     *  quaternions are packed at the same time, one in each lane. The
+     *  length is still computed by bullet, so that it is rounded in the
+     *  same way as in the scalar code.
+     */
+    void compressQuaternionBatch(const btQuaternion* q, uint32_t* out,
+                                 size_t n)
+    {
+        size_t i = 0;
+#if defined(MINI_GLM_SSE2_MATH)
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 minus_one = _mm_set1_ps(-1.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 sign_bit = _mm_set1_ps(-0.0f);
+        const __m128 sqrt_2 = _mm_set1_ps(sqrtf(2.0f));
+        for (; i + 4 <= n; i += 4)
+        {
+            const btQuaternion* p = q + i;
+            const __m128 length = _mm_setr_ps(p[0].length(), p[1].length(),
+                p[2].length(), p[3].length());
+            assert(_mm_movemask_ps(_mm_cmpeq_ps(length, zero)) == 0);
+            __m128 c[4];
+            c[0] = _mm_setr_ps(p[0].x(), p[1].x(), p[2].x(), p[3].x());
+            c[1] = _mm_setr_ps(p[0].y(), p[1].y(), p[2].y(), p[3].y());
+            c[2] = _mm_setr_ps(p[0].z(), p[1].z(), p[2].z(), p[3].z());
+            c[3] = _mm_setr_ps(p[0].w(), p[1].w(), p[2].w(), p[3].w());
+            for (int j = 0; j < 4; j++)
+                c[j] = _mm_div_ps(c[j], length);
+
+            // Index of the first component with the largest absolute value,
+            // like std::max_element
+            __m128 largest = c[0];
+            __m128 largest_abs = _mm_andnot_ps(sign_bit, c[0]);
+            __m128i index = _mm_setzero_si128();
+            for (int j = 1; j < 4; j++)
+            {
+                __m128 abs_c = _mm_andnot_ps(sign_bit, c[j]);
+                __m128 larger = _mm_cmpgt_ps(abs_c, largest_abs);
+                largest_abs = blend(larger, abs_c, largest_abs);
+                largest = blend(larger, c[j], largest);
+                index = blend(_mm_castps_si128(larger), _mm_set1_epi32(j),
+                    index);
+            }
+
+            // The 3 remaining components in order, with the sign flipped
+            // if the largest component is negative
+            const __m128 flip = _mm_and_ps(_mm_cmplt_ps(largest, zero),
+                sign_bit);
+            __m128 rest[3];
+            rest[0] = blend(_mm_castsi128_ps(_mm_cmpeq_epi32(index,
+                _mm_setzero_si128())), c[1], c[0]);
+            rest[1] = blend(_mm_castsi128_ps(_mm_cmplt_epi32(index,
+                _mm_set1_epi32(2))), c[2], c[1]);
+            rest[2] = blend(_mm_castsi128_ps(_mm_cmplt_epi32(index,
+                _mm_set1_epi32(3))), c[3], c[2]);
+
+            // See normalizedSignedFloatsTo1010102
+            __m128i packed = _mm_slli_epi32(index, 30);
+            for (int j = 0; j < 3; j++)
+            {
+                __m128 v = _mm_mul_ps(_mm_xor_ps(rest[j], flip), sqrt_2);
+                v = _mm_min_ps(_mm_max_ps(v, minus_one), one);
+                __m128 positive = _mm_add_ps(
+                    _mm_mul_ps(v, _mm_set1_ps(511.0f)), _mm_set1_ps(0.5f));
+                __m128 negative = _mm_sub_ps(
+                    _mm_mul_ps(v, _mm_set1_ps(512.0f)), _mm_set1_ps(0.5f));
+                __m128i part = _mm_cvttps_epi32(
+                    blend(_mm_cmpgt_ps(v, zero), positive, negative));
+                part = _mm_and_si128(part, _mm_set1_epi32(1023));
+                packed = _mm_or_si128(packed, j == 0 ? part :
+                    j == 1 ? _mm_slli_epi32(part, 10) :
+                    _mm_slli_epi32(part, 20));
+            }
+            _mm_storeu_si128((__m128i*)(out + i), packed);
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = compressQuaternion(q[i]);
+    }   // compressQuaternionBatch
+
+    // ------------------------------------------------------------------------
+    /** Computes the matrix product a * b of two 4x4 matrices in the layout
+     *  of core::matrix4, with the same result as core::matrix4::operator*.
+     *  With SSE2 each column of the result is computed with 4 multiplies
+     *  and 3 adds in the same order as the scalar code.
+     *  \param out The result, which must not overlap with a or b.
+     */
+    void multiplyMatrix4(const float* a, const float* b, float* out)
+    {
+#if defined(MINI_GLM_SSE2_MATH)
+        const __m128 a0 = _mm_loadu_ps(a);
+        const __m128 a1 = _mm_loadu_ps(a + 4);
+        const __m128 a2 = _mm_loadu_ps(a + 8);
+        const __m128 a3 = _mm_loadu_ps(a + 12);
+        for (int i = 0; i < 16; i += 4)
+        {
+            __m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[i]));
+            column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[i + 1])));
+            column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[i + 2])));
+            column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[i + 3])));
+            _mm_storeu_ps(out + i, column);
+        }
+#else
+        for (int i = 0; i < 16; i += 4)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                out[i + j] = a[j] * b[i] + a[j + 4] * b[i + 1] +
+                    a[j + 8] * b[i + 2] + a[j + 12] * b[i + 3];
+            }
+        }
+#endif
+    }   // multiplyMatrix4
+
     // ------------------------------------------------------------------------
     void unitTesting()
     {
@@ -88,5 +422,126 @@ namespace MiniGLM
         Log::info("MiniGLM::unitTesting", "Result before: x:%f y:%f z:%f w:%f,"
             " after: x:%f y:%f z:%f w:%f", quat.X, quat.Y, quat.Z, quat.W,
             out_quat.X, out_quat.Y, out_quat.Z, out_quat.W);
+
+        // The batched versions must give bitwise identical results, as the
+        // values are rounded locally and sent in network states
+        Log::info("MiniGLM::unitTesting", "Batch half float conversion");
+        std::mt19937 rng(42);
+        std::vector<float> floats;
+        // Values around all interesting exponents, including the rounding
+        // boundaries, denormalized halfs, overflow, infinity and NAN
+        for (uint32_t e = 0; e < 256; e++)
+        {
+            for (uint32_t m : { 0x0u, 0x1u, 0xfffu, 0x1000u, 0x1fffu, 0x2000u,
+                                0x3000u, 0x7fefffu, 0x7ff000u, 0x7fffffu })
+            {
+                for (uint32_t s = 0; s < 2; s++)
+                {
+                    uint32_t bits = (s << 31) | (e << 23) | m;
+                    float f;
+                    memcpy(&f, &bits, 4);
+                    floats.push_back(f);
+                }
+            }
+        }
+        std::uniform_real_distribution<float> velocity(-100.0f, 100.0f);
+        for (int i = 0; i < 10000; i++)
+            floats.push_back(velocity(rng));
+        std::vector<short> halfs(floats.size());
+        toFloat16Batch(floats.data(), halfs.data(), floats.size());
+        for (unsigned i = 0; i < floats.size(); i++)
+        {
+            if (halfs[i] != toFloat16(floats[i]))
+            {
+                Log::fatal("MiniGLM::unitTesting", "toFloat16Batch of %f "
+                    "gives %d instead of %d.", floats[i], halfs[i],
+                    toFloat16(floats[i]));
+            }
+        }
+
+        std::vector<short> all_halfs(65536 + 3);
+        for (unsigned i = 0; i < all_halfs.size(); i++)
+            all_halfs[i] = (short)(i & 0xffff);
+        std::vector<float> all_floats(all_halfs.size());
+        toFloat32Batch(all_halfs.data(), all_floats.data(), all_halfs.size());
+        for (unsigned i = 0; i < all_halfs.size(); i++)
+        {
+            float expected = toFloat32(all_halfs[i]);
+            if (memcmp(&expected, &all_floats[i], 4) != 0)
+            {
+                Log::fatal("MiniGLM::unitTesting", "toFloat32Batch of %d "
+                    "gives %f instead of %f.", all_halfs[i], all_floats[i],
+                    expected);
+            }
+        }
+
+        Log::info("MiniGLM::unitTesting", "Batch quaternion compression");
+        std::vector<btQuaternion> quats =
+        {
+            btQuaternion(0.0f, 0.0f, 0.0f, 1.0f),
+            btQuaternion(0.0f, 0.0f, 0.0f, -1.0f),
+            btQuaternion(0.5f, 0.5f, 0.5f, 0.5f),
+            btQuaternion(-0.5f, 0.5f, -0.5f, 0.5f),
+            btQuaternion(0.5f, -0.5f, 0.5f, -0.5f),
+            btQuaternion(-43.0f, 20.0f, 16.0f, -88.0f),
+            btQuaternion(11.0f, 44.0f, 55.0f, 77.0f),
+            btQuaternion(-23.0f, -44.0f, -7.0f, 0.0f)
+        };
+        std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+        for (int i = 0; i < 10000; i++)
+        {
+            btQuaternion q(component(rng), component(rng), component(rng),
+                component(rng));
+            if (q.length() == 0.0f)
+                continue;
+            // Test both normalized and not normalized quaternions
+            if (i % 2 == 0)
+                q.normalize();
+            quats.push_back(q);
+        }
+        std::vector<uint32_t> packed_quats(quats.size());
+        compressQuaternionBatch(quats.data(), packed_quats.data(),
+            quats.size());
+        for (unsigned i = 0; i < quats.size(); i++)
+        {
+            if (packed_quats[i] != compressQuaternion(quats[i]))
+            {
+                Log::fatal("MiniGLM::unitTesting", "compressQuaternionBatch "
+                    "of %f %f %f %f gives %u instead of %u.", quats[i].x(),
+                    quats[i].y(), quats[i].z(), quats[i].w(), packed_quats[i],
+                    compressQuaternion(quats[i]));
+            }
+        }
+
+        Log::info("MiniGLM::unitTesting", "Matrix multiplication");
+        std::uniform_real_distribution<float> element(-10.0f, 10.0f);
+        for (int i = 0; i < 1000; i++)
+        {
+            core::matrix4 a, b;
+            for (int j = 0; j < 16; j++)
+            {
+                a[j] = element(rng);
+                b[j] = element(rng);
+            }
+            // Also test the typical transforms of skinning
+            if (i % 2 == 0)
+            {
+                a.setRotationDegrees(core::vector3df(element(rng),
+                    element(rng), element(rng)));
+                a.setTranslation(core::vector3df(element(rng)));
+            }
+            const core::matrix4 expected = a * b;
+            core::matrix4 product;
+            multiplyMatrix4(a.pointer(), b.pointer(), product.pointer());
+            for (int j = 0; j < 16; j++)
+            {
+                if (product[j] != expected[j])
+                {
+                    Log::fatal("MiniGLM::unitTesting", "multiplyMatrix4 "
+                        "gives %f instead of %f at %d.", product[j],
+                        expected[j], j);
+                }
+            }
+        }
     }
 }
@@ -610,6 +610,17 @@ namespace MiniGLM
         return trans;
     }   // decompressbtTransform
     // ------------------------------------------------------------------------
+    /* Batched versions of the conversions above, which use SSE2 / NEON if
+     * available. They produce bitwise identical results to calling the
+     * scalar functions for each element, so they can be mixed freely with
+     * them in network states. */
+    void toFloat16Batch(const float* in, short* out, size_t n);
+    void toFloat32Batch(const short* in, float* out, size_t n);
+    void compressQuaternionBatch(const btQuaternion* q, uint32_t* out,
+                                 size_t n);
+    // ------------------------------------------------------------------------
+    void multiplyMatrix4(const float* a, const float* b, float* out);
+    // ------------------------------------------------------------------------
     void unitTesting();
 }
 
@@ -0,0 +1,128 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_SINGLE_PRODUCER_QUEUE_HPP
+#define HEADER_SINGLE_PRODUCER_QUEUE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <stdint.h>
+
+/** \brief A queue with one producer and one consumer thread, which does not
+ *  need a lock as long as it does not overflow. Elements are stored in a
+ *  ring buffer of SIZE entries (a power of two). If the ring is full (e.g.
+ *  the consumer is blocked while loading a track), the producer appends
+ *  to a mutex protected overflow list until the consumer has taken all
+ *  elements, so no element is lost and the order is kept. The producer
+ *  may change over time (e.g. a thread which is started later), as long as
+ *  two threads never push at the same time.
+ * \ingroup utils
+ */
+template<typename TYPE, unsigned SIZE>
+class SingleProducerQueue : public NoCopy
+{
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two.");
+private:
+    /** The ring buffer. */
+    std::array<TYPE, SIZE> m_ring;
+
+    /** Number of elements taken from the ring, written by the consumer. */
+    std::atomic<uint32_t> m_head;
+
+    /** Number of elements added to the ring, written by the producer. */
+    std::atomic<uint32_t> m_tail;
+
+    /** True while the overflow list is used. It is only set by the
+     *  producer and only cleared by the consumer. */
+    std::atomic_bool m_overflowed;
+
+    /** Elements which did not fit into the ring. */
+    std::list<TYPE> m_overflow;
+    std::mutex m_overflow_mutex;
+
+    /** Number of elements which did not fit into the ring. */
+    std::atomic<uint64_t> m_overflow_count;
+
+    // ------------------------------------------------------------------------
+    /** Moves all elements of the ring to the end of the list. */
+    void takeRing(std::list<TYPE> *out)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        const uint32_t tail = m_tail.load(std::memory_order_acquire);
+        while (head != tail)
+            out->push_back(m_ring[head++ % SIZE]);
+        m_head.store(head, std::memory_order_release);
+    }   // takeRing
+
+public:
+    // ------------------------------------------------------------------------
+    SingleProducerQueue()
+    {
+        m_head.store(0);
+        m_tail.store(0);
+        m_overflowed.store(false);
+        m_overflow_count.store(0);
+    }   // SingleProducerQueue
+    // ------------------------------------------------------------------------
+    /** Adds an element, only called from the producer thread. */
+    void push(const TYPE &t)
+    {
+        if (!m_overflowed.load(std::memory_order_acquire))
+        {
+            const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) < SIZE)
+            {
+                m_ring[tail % SIZE] = t;
+                m_tail.store(tail + 1, std::memory_order_release);
+                return;
+            }
+        }
+        // From now on all elements go to the overflow list until the
+        // consumer has taken it, so that the order is kept
+        std::lock_guard<std::mutex> lock(m_overflow_mutex);
+        m_overflow.push_back(t);
+        m_overflowed.store(true, std::memory_order_release);
+        m_overflow_count.fetch_add(1, std::memory_order_relaxed);
+    }   // push
+    // ------------------------------------------------------------------------
+    /** Moves all elements in the queue to the end of the list in the order
+     *  they were added, only called from the consumer thread. */
+    void popAll(std::list<TYPE> *out)
+    {
+        takeRing(out);
+        if (!m_overflowed.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::mutex> lock(m_overflow_mutex);
+        // All elements in the ring were added before the first element
+        // of the overflow list, take the ones added since the first call
+        takeRing(out);
+        out->splice(out->end(), m_overflow);
+        m_overflowed.store(false, std::memory_order_release);
+    }   // popAll
+    // ------------------------------------------------------------------------
+    /** Returns how many elements did not fit into the ring. */
+    uint64_t getOverflowCount() const
+                { return m_overflow_count.load(std::memory_order_relaxed); }
+};   // SingleProducerQueue
+
+#endif
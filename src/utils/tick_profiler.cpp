@@ -0,0 +1,119 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "utils/tick_profiler.hpp"
+
+#include "utils/log.hpp"
+
+#include <algorithm>
+
+bool TickProfiler::m_enabled = false;
+std::array<TickProfiler::Clock::time_point, TickProfiler::TP_COUNT>
+                                              TickProfiler::m_start;
+TickProfiler::TickSample TickProfiler::m_current;
+std::vector<TickProfiler::TickSample> TickProfiler::m_all_samples;
+bool TickProfiler::m_keep_samples = true;
+TickProfiler::TickSample TickProfiler::m_last_sample;
+
+// ----------------------------------------------------------------------------
+/** Enables or disables the measurement.
+ *  \param keep_samples If true the samples of all ticks are kept for
+ *         printStatistics, otherwise only the last one.
+ */
+void TickProfiler::enable(bool enabled, bool keep_samples)
+{
+    m_enabled = enabled;
+    m_keep_samples = keep_samples;
+    reset();
+}   // enable
+
+// ----------------------------------------------------------------------------
+/** Removes all recorded samples. */
+void TickProfiler::reset()
+{
+    m_current.fill(0.0f);
+    m_last_sample.fill(0.0f);
+    m_all_samples.clear();
+}   // reset
+
+// ----------------------------------------------------------------------------
+/** Stores the times of the current tick as one sample, and starts the
+ *  next tick. */
+void TickProfiler::endTick()
+{
+    if (!m_enabled)
+        return;
+    m_last_sample = m_current;
+    if (m_keep_samples)
+        m_all_samples.push_back(m_current);
+    m_current.fill(0.0f);
+}   // endTick
+
+// ----------------------------------------------------------------------------
+/** Returns a short name for a phase, used when printing statistics. */
+const char* TickProfiler::getPhaseName(TickPhase phase)
+{
+    switch (phase)
+    {
+    case TP_TOTAL:            return "total";
+    case TP_REWIND:           return "rewind";
+    case TP_TRACK_OBJECTS:    return "track-objects";
+    case TP_KARTS:            return "karts";
+    case TP_AI:               return "ai";
+    case TP_PROJECTILES:      return "projectiles";
+    case TP_PHYSICS:          return "physics";
+    case TP_CHECK_STRUCTURES: return "check-structures";
+    case TP_ITEMS:            return "items";
+    case TP_COUNT:            break;
+    }
+    return "unknown";
+}   // getPhaseName
+
+// ----------------------------------------------------------------------------
+/** Prints min, median, p99, max and average time per tick of each phase
+ *  (in microseconds) for all samples recorded since the last reset.
+ *  \param title Printed in the header line of the statistics.
+ */
+void TickProfiler::printStatistics(const std::string &title)
+{
+    const size_t n = m_all_samples.size();
+    Log::info("TickProfiler", "%s: %d ticks, times in microseconds.",
+              title.c_str(), (int)n);
+    if (n == 0)
+        return;
+
+    Log::info("TickProfiler", "%-17s %9s %9s %9s %9s %9s", "phase",
+              "min", "median", "p99", "max", "average");
+    std::vector<float> values(n);
+    for (unsigned int phase = 0; phase < TP_COUNT; phase++)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            values[i] = m_all_samples[i][phase];
+            sum += values[i];
+        }
+        std::sort(values.begin(), values.end());
+        // Nearest-rank percentiles
+        size_t median = (n - 1) / 2;
+        size_t p99 = std::min(n - 1, (size_t)(0.99 * (double)n));
+        Log::info("TickProfiler", "%-17s %9.1f %9.1f %9.1f %9.1f %9.1f",
+                  getPhaseName((TickPhase)phase), values[0], values[median],
+                  values[p99], values[n - 1], (float)(sum / n));
+    }
+}   // printStatistics
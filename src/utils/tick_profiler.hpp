@@ -0,0 +1,115 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_TICK_PROFILER_HPP
+#define HEADER_TICK_PROFILER_HPP
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/** \brief Measures the cost of the simulation subsystems per physics tick.
+ *  Unlike the graphical Profiler, which buffers markers per rendered frame
+ *  for on-screen display, this records one sample per tick and phase, so
+ *  that min/median/p99 statistics can be computed for benchmarks. The
+ *  timing calls only check a static flag when profiling is disabled.
+ * \ingroup utils
+ */
+class TickProfiler
+{
+public:
+    /** The phases that are measured. Phases can be nested (e.g. the AI is
+     *  updated as part of the kart update), so the values of the phases
+     *  do not add up to the total. */
+    enum TickPhase
+    {
+        TP_TOTAL,
+        TP_REWIND,
+        TP_TRACK_OBJECTS,
+        TP_KARTS,
+        TP_AI,
+        TP_PROJECTILES,
+        TP_PHYSICS,
+        TP_CHECK_STRUCTURES,
+        TP_ITEMS,
+        TP_COUNT
+    };
+
+    /** The duration of all phases of one tick in microseconds. */
+    typedef std::array<float, TP_COUNT> TickSample;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /** True if the times should be measured. */
+    static bool m_enabled;
+
+    /** Start time of each phase in the current tick. */
+    static std::array<Clock::time_point, TP_COUNT> m_start;
+
+    /** Accumulated time of each phase in the current tick. */
+    static TickSample m_current;
+
+    /** One entry for each tick since the last reset. */
+    static std::vector<TickSample> m_all_samples;
+
+    /** If false only the last sample is kept, which is enough for the
+     *  server tick budget monitor and does not use more memory over time. */
+    static bool m_keep_samples;
+
+    /** The times of the last finished tick. */
+    static TickSample m_last_sample;
+
+public:
+    static void enable(bool enabled, bool keep_samples = true);
+    static void reset();
+    static void endTick();
+    static void printStatistics(const std::string &title);
+    static const char* getPhaseName(TickPhase phase);
+    // ------------------------------------------------------------------------
+    /** Returns true if tick profiling is enabled. */
+    static bool isEnabled() { return m_enabled; }
+    // ------------------------------------------------------------------------
+    /** Returns all samples recorded since the last reset. */
+    static const std::vector<TickSample>& getSamples() { return m_all_samples; }
+    // ------------------------------------------------------------------------
+    /** Returns the times of the last finished tick. */
+    static const TickSample& getLastSample() { return m_last_sample; }
+    // ------------------------------------------------------------------------
+    /** Marks the start of a phase in the current tick. */
+    static void start(TickPhase phase)
+    {
+        if (m_enabled)
+            m_start[phase] = Clock::now();
+    }   // start
+    // ------------------------------------------------------------------------
+    /** Marks the end of a phase in the current tick. A phase can be started
+     *  and stopped several times per tick (e.g. the AI for each kart), the
+     *  times are accumulated. */
+    static void stop(TickPhase phase)
+    {
+        if (!m_enabled)
+            return;
+        std::chrono::duration<float, std::micro> d =
+            Clock::now() - m_start[phase];
+        m_current[phase] += d.count();
+    }   // stop
+};   // TickProfiler
+
+#endif
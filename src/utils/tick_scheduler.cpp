@@ -0,0 +1,193 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "utils/tick_scheduler.hpp"
+
+#include "utils/string_utils.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#  include <errno.h>
+#  include <time.h>
+#endif
+
+namespace
+{
+    /** Upper bounds of the histogram buckets in microseconds, the last
+     *  bucket contains all larger values. */
+    const int BUCKET_LIMITS[] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000 };
+}   // anonymous namespace
+
+// ----------------------------------------------------------------------------
+void TickScheduler::Histogram::reset()
+{
+    m_count.fill(0);
+    m_total = 0;
+    m_sum   = 0.0;
+    m_max   = 0.0;
+}   // Histogram::reset
+
+// ----------------------------------------------------------------------------
+/** Adds one duration (in microseconds) to the histogram. */
+void TickScheduler::Histogram::add(double us)
+{
+    int bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && us >= BUCKET_LIMITS[bucket])
+        bucket++;
+    m_count[bucket]++;
+    m_total++;
+    m_sum += us;
+    m_max = std::max(m_max, us);
+}   // Histogram::add
+
+// ----------------------------------------------------------------------------
+std::string TickScheduler::Histogram::toString() const
+{
+    std::string s;
+    for (int i = 0; i < NUM_BUCKETS; i++)
+    {
+        if (i < NUM_BUCKETS - 1)
+            s += StringUtils::insertValues("<%d: ", BUCKET_LIMITS[i]);
+        else
+            s += StringUtils::insertValues(">=%d: ", BUCKET_LIMITS[i - 1]);
+        s += StringUtils::toString(m_count[i]) + " ";
+    }
+    s += StringUtils::insertValues("(average %d, max %d)",
+        m_total > 0 ? (int)(m_sum / (double)m_total) : 0, (int)m_max);
+    return s;
+}   // Histogram::toString
+
+// ============================================================================
+TickScheduler::TickScheduler()
+{
+    m_tick_duration = std::chrono::milliseconds(8);
+    m_started       = false;
+    m_ticks         = 0;
+}   // TickScheduler
+
+// ----------------------------------------------------------------------------
+/** Sets the duration of one tick. The current deadline is kept, the new
+ *  duration is used from the next tick on.
+ *  \param seconds Duration of a tick in seconds.
+ */
+void TickScheduler::setTickDuration(float seconds)
+{
+    m_tick_duration = std::chrono::duration_cast<Clock::duration>
+        (std::chrono::duration<double>(seconds));
+}   // setTickDuration
+
+// ----------------------------------------------------------------------------
+/** Schedules the next tick relative to the current time, e.g. after a long
+ *  pause during which no ticks should be caught up.
+ */
+void TickScheduler::restart()
+{
+    m_started = false;
+}   // restart
+
+// ----------------------------------------------------------------------------
+/** Sleeps until the absolute time deadline is reached. */
+void TickScheduler::sleepUntil(const Clock::time_point &deadline)
+{
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC with libstdc++ and libc++, so the
+    // deadline can be converted directly to a timespec.
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (deadline.time_since_epoch()).count();
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(ns / 1000000000);
+    ts.tv_nsec = (long)(ns % 1000000000);
+    // With TIMER_ABSTIME an interrupted sleep can just be restarted.
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}   // sleepUntil
+
+// ----------------------------------------------------------------------------
+/** Waits until the next tick is due.
+ *  \return Number of ticks to simulate now. This is 1 if the previous ticks
+ *          were done in time, and larger if deadlines were missed.
+ */
+int TickScheduler::waitForNextTick()
+{
+    Clock::time_point now = Clock::now();
+    if (!m_started)
+    {
+        m_started   = true;
+        m_next_tick = now + m_tick_duration;
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        m_ticks++;
+        return 1;
+    }
+
+    int num_ticks = 1;
+    if (now >= m_next_tick)
+    {
+        // Overrun: do not sleep, and return all ticks whose deadline has
+        // passed, so the deadlines stay aligned to the original schedule.
+        Clock::duration late = now - m_next_tick;
+        num_ticks += (int)(late / m_tick_duration);
+        m_next_tick += m_tick_duration * num_ticks;
+        std::lock_guard<std::mutex> lock(m_statistics_mutex);
+        m_overrun.add(std::chrono::duration<double, std::micro>(late).count());
+        m_ticks += num_ticks;
+        return num_ticks;
+    }
+
+    const Clock::time_point deadline = m_next_tick;
+    sleepUntil(deadline);
+    Clock::time_point wake = Clock::now();
+    m_next_tick += m_tick_duration;
+
+    std::lock_guard<std::mutex> lock(m_statistics_mutex);
+    m_jitter.add(std::chrono::duration<double, std::micro>
+                 (wake - deadline).count());
+    m_ticks++;
+    return num_ticks;
+}   // waitForNextTick
+
+// ----------------------------------------------------------------------------
+/** Removes all collected statistics. */
+void TickScheduler::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_statistics_mutex);
+    m_ticks = 0;
+    m_jitter.reset();
+    m_overrun.reset();
+}   // resetStatistics
+
+// ----------------------------------------------------------------------------
+/** Returns the collected statistics as a printable text, times are in
+ *  microseconds.
+ */
+std::string TickScheduler::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_statistics_mutex);
+    std::string s = StringUtils::insertValues("%s ticks, %s overruns.\n",
+        StringUtils::toString(m_ticks).c_str(),
+        StringUtils::toString(m_overrun.m_total).c_str());
+    s += "Wake up jitter (us): " + m_jitter.toString() + "\n";
+    s += "Overrun lateness (us): " + m_overrun.toString();
+    return s;
+}   // getStatistics
@@ -0,0 +1,97 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_TICK_SCHEDULER_HPP
+#define HEADER_TICK_SCHEDULER_HPP
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+/** \brief Paces the main loop of a server without graphics at a fixed tick
+ *  rate. The deadline of each tick is an absolute point in time on the
+ *  monotonic clock, and the thread sleeps until it is reached (using
+ *  clock_nanosleep on Linux), so sleep inaccuracies do not accumulate and
+ *  the server does not poll the clock every millisecond. If ticks were
+ *  missed (e.g. while loading a track) all of them are returned at once, so
+ *  the world time keeps up with real time like before.
+ *  The lateness of each wake up (jitter) and of each tick which started
+ *  after its deadline (overrun) is collected in histograms, which can be
+ *  shown in the network console.
+ * \ingroup utils
+ */
+class TickScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    /** Number of histogram buckets, see BUCKET_LIMITS in the .cpp file. */
+    static const int NUM_BUCKETS = 9;
+
+    /** A histogram of durations. */
+    struct Histogram
+    {
+        std::array<uint64_t, NUM_BUCKETS> m_count;
+        uint64_t m_total;
+        double   m_sum;
+        double   m_max;
+        // --------------------------------------------------------------------
+        Histogram() { reset(); }
+        void reset();
+        void add(double us);
+        std::string toString() const;
+    };   // Histogram
+
+    /** Duration of one tick. */
+    Clock::duration m_tick_duration;
+
+    /** Absolute time at which the next tick is due. */
+    Clock::time_point m_next_tick;
+
+    /** False until the first tick was scheduled. */
+    bool m_started;
+
+    /** Number of ticks since the statistics were reset. */
+    uint64_t m_ticks;
+
+    /** How much later than the deadline the thread woke up. */
+    Histogram m_jitter;
+
+    /** How much later than the deadline a tick started, because the
+     *  previous ticks took too long. */
+    Histogram m_overrun;
+
+    /** The statistics are read by the network console thread. */
+    mutable std::mutex m_statistics_mutex;
+
+    static void sleepUntil(const Clock::time_point &deadline);
+
+public:
+                TickScheduler();
+    void        setTickDuration(float seconds);
+    int         waitForNextTick();
+    void        restart();
+    void        resetStatistics();
+    std::string getStatistics() const;
+};   // TickScheduler
+
+#endif
@@ -0,0 +1,130 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#include "utils/worker_pool.hpp"
+
+#include "utils/vs.hpp"
+
+// ----------------------------------------------------------------------------
+/** Creates the pool.
+ *  \param name Name of the worker threads (used in the debugger).
+ *  \param num_threads Total number of threads working on the jobs,
+ *         including the thread calling parallelFor. So 1 does not start
+ *         any thread and executes all jobs in the calling thread.
+ */
+WorkerPool::WorkerPool(const std::string &name, unsigned int num_threads)
+          : m_name(name)
+{
+    m_job          = NULL;
+    m_num_jobs     = 0;
+    m_next_job.store(0);
+    m_busy_workers = 0;
+    m_generation   = 0;
+    m_exit         = false;
+    for (unsigned int i = 1; i < num_threads; i++)
+        m_threads.emplace_back(&WorkerPool::workerMain, this, i);
+}   // WorkerPool
+
+// ----------------------------------------------------------------------------
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_start_cv.notify_all();
+    for (std::thread &t : m_threads)
+        t.join();
+}   // ~WorkerPool
+
+// ----------------------------------------------------------------------------
+/** Executes jobs until all jobs of the current call have been taken. */
+void WorkerPool::runJobs(const Job &job, unsigned int num_jobs,
+                         unsigned int thread)
+{
+    while (true)
+    {
+        unsigned int n = m_next_job.fetch_add(1);
+        if (n >= num_jobs)
+            break;
+        job(n, thread);
+    }
+}   // runJobs
+
+// ----------------------------------------------------------------------------
+/** The main function of each worker thread. */
+void WorkerPool::workerMain(unsigned int thread)
+{
+    VS::setThreadName(m_name.c_str());
+    unsigned int generation = 0;
+    while (true)
+    {
+        const Job *job;
+        unsigned int num_jobs;
+        {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            m_start_cv.wait(ul, [this, generation]()
+                {
+                    return m_exit || m_generation != generation;
+                });
+            if (m_exit)
+                return;
+            generation = m_generation;
+            job        = m_job;
+            num_jobs   = m_num_jobs;
+        }
+        runJobs(*job, num_jobs, thread);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy_workers--;
+        if (m_busy_workers == 0)
+            m_done_cv.notify_one();
+    }
+}   // workerMain
+
+// ----------------------------------------------------------------------------
+/** Executes job(i, thread) for all i in [0, num_jobs) and returns when all
+ *  jobs are done.
+ *  \param num_jobs Number of jobs.
+ *  \param job The function to execute for each job.
+ */
+void WorkerPool::parallelFor(unsigned int num_jobs, const Job &job)
+{
+    if (m_threads.empty() || num_jobs < 2)
+    {
+        for (unsigned int i = 0; i < num_jobs; i++)
+            job(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job          = &job;
+        m_num_jobs     = num_jobs;
+        m_next_job.store(0);
+        m_busy_workers = (unsigned int)m_threads.size();
+        m_generation++;
+    }
+    m_start_cv.notify_all();
+    runJobs(job, num_jobs, 0);
+
+    std::unique_lock<std::mutex> ul(m_mutex);
+    m_done_cv.wait(ul, [this]() { return m_busy_workers == 0; });
+    m_job = NULL;
+}   // parallelFor
@@ -0,0 +1,101 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2019 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+
+#ifndef HEADER_WORKER_POOL_HPP
+#define HEADER_WORKER_POOL_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** \brief A small pool of persistent threads which execute a number of
+ *  independent jobs in parallel. The calling thread takes part in the work
+ *  and parallelFor only returns once all jobs are done, so the pool can be
+ *  used to split a single step (e.g. of the physics) over several cores.
+ *  The jobs are assigned dynamically to the threads, so a job must not
+ *  depend on which thread executes it if the result is expected to be
+ *  deterministic.
+ * \ingroup utils
+ */
+class WorkerPool : public NoCopy
+{
+public:
+    /** A job function. The first parameter is the index of the job, the
+     *  second the index of the thread executing it (0 is the thread which
+     *  called parallelFor), which can be used to select per thread data. */
+    typedef std::function<void(unsigned int, unsigned int)> Job;
+
+private:
+    /** The worker threads, the calling thread is not included. */
+    std::vector<std::thread> m_threads;
+
+    /** Name of the worker threads. */
+    std::string m_name;
+
+    /** Protects all following members (except m_next_job). */
+    std::mutex m_mutex;
+
+    /** Signals the workers that new jobs are available or that they
+     *  should exit. */
+    std::condition_variable m_start_cv;
+
+    /** Signals the calling thread that all workers are done. */
+    std::condition_variable m_done_cv;
+
+    /** The job function of the current parallelFor call. */
+    const Job *m_job;
+
+    /** Number of jobs of the current parallelFor call. */
+    unsigned int m_num_jobs;
+
+    /** Index of the next job to be executed. */
+    std::atomic<unsigned int> m_next_job;
+
+    /** Number of worker threads still busy with the current call. */
+    unsigned int m_busy_workers;
+
+    /** Increased for each parallelFor call, so that a worker can detect
+     *  new jobs. */
+    unsigned int m_generation;
+
+    /** Set when the pool is destroyed. */
+    bool m_exit;
+
+    void runJobs(const Job &job, unsigned int num_jobs, unsigned int thread);
+    void workerMain(unsigned int thread);
+
+public:
+                 WorkerPool(const std::string &name, unsigned int num_threads);
+                ~WorkerPool();
+    void         parallelFor(unsigned int num_jobs, const Job &job);
+    // ------------------------------------------------------------------------
+    /** Returns the number of threads including the calling thread. */
+    unsigned int getNumThreads() const
+    {
+        return (unsigned int)m_threads.size() + 1;
+    }   // getNumThreads
+};   // WorkerPool
+
+#endif
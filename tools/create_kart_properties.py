@@ -30,7 +30,7 @@ import sys
 characteristics = """Suspension: stiffness, rest, travel, expSpringResponse(bool), maxForce
 Stability: rollInfluence, chassisLinearDamping, chassisAngularDamping, downwardImpulseFactor, trackConnectionAccel, angularFactor(std::vector<float>/floatVector), smoothFlyingImpulse
 Turn: radius(InterpolationArray), timeResetSteer, timeFullSteer(InterpolationArray)
-Engine: power, maxSpeed, brakeFactor, brakeTimeIncrease, maxSpeedReverseRatio
+Engine: power, maxSpeed, genericMaxSpeed, brakeFactor, brakeTimeIncrease, maxSpeedReverseRatio
 Gear: switchRatio(std::vector<float>/floatVector), powerIncrease(std::vector<float>/floatVector)
 Mass
 Wheels: dampingRelaxation, dampingCompression
@@ -38,7 +38,7 @@ Camera: distance, forwardUpAngle, backwardUpAngle
 Jump: animationTime
 Lean: max, speed
 Anvil: duration, weight, speedFactor
-Parachute: friction, duration, durationOther, durationRankMult, durationSpeedMult, lboundFraction, uboundFraction, maxSpeed
+Parachute: friction, duration(int/float), durationOther(int/float), durationRankMult, durationSpeedMult, lboundFraction, uboundFraction, maxSpeed
 Friction: kartFriction
 Bubblegum: duration, speedFraction, torque, fadeInTime, shieldDuration
 Zipper: duration, force, speedGain, maxSpeedIncrease, fadeOutTime
@@ -47,7 +47,7 @@ Plunger: bandMaxLength, bandForce, bandDuration, bandSpeedIncrease, bandFadeOutT
 Startup: time(std::vector<float>/floatVector), boost(std::vector<float>/floatVector)
 Rescue: duration, vertOffset, height
 Explosion: duration, radius, invulnerabilityTime
-Nitro: duration, engineForce, consumption, smallContainer, bigContainer, maxSpeedIncrease, fadeOutTime, max
+Nitro: duration, engineForce, engineMult, consumption, smallContainer, bigContainer, maxSpeedIncrease, fadeOutTime, max
 Slipstream: durationFactor, baseSpeed, length, width, innerFactor, minCollectTime, maxCollectTime, addPower, minSpeed, maxSpeedIncrease, fadeOutTime
 Skid: increase, decrease, max, timeTillMax, visual, visualTime, revertVisualTime, minSpeed, timeTillBonus(std::vector<float>/floatVector), bonusSpeed(std::vector<float>/floatVector), bonusTime(std::vector<float>/floatVector), bonusForce(std::vector<float>/floatVector), physicalJumpTime, graphicalJumpTime, postSkidRotateFactor, reduceTurnMin, reduceTurnMax, enabled(bool)"""
 
@@ -168,6 +168,10 @@ def createAcGetter(groups):
             nameUnderscore = joinSubName(g, m, False)
             typeC = m.typeC
             result = "result"
+            # int characteristics are times that are converted to ticks
+            if typeC == "int":
+                typeC = "float"
+                result = "stk_config->time2Ticks(result)"
 
             print("""// ----------------------------------------------------------------------------
 {3} AbstractCharacteristic::get{1}() const
@@ -180,7 +184,7 @@ def createAcGetter(groups):
                     getName({2}).c_str());
     return {4};
 }}  // get{1}
-""".format(m.typeC, nameTitle, nameUnderscore.upper(), typeC, result))
+""".format(typeC, nameTitle, nameUnderscore.upper(), m.typeC, result))
 
 def createKpDefs(groups):
     for g in groups:
@@ -189,24 +193,24 @@ def createKpDefs(groups):
             nameTitle = joinSubName(g, m, True)
             nameUnderscore = joinSubName(g, m, False)
             typeC = m.typeC
+            if typeC != "float" and typeC != "bool" and typeC != "int":
+                typeC = "const {0}&".format(typeC)
 
-            print("    {0} get{1}() const;".
+            print("""    {0} get{1}() const
+        {{ return m_cached_characteristic->getValues().m_{2}; }}""".
                 format(typeC, nameTitle, nameUnderscore))
 
-def createKpGetter(groups):
+def createCached(groups):
+    lines = []
     for g in groups:
         for m in g.members:
             nameTitle = joinSubName(g, m, True)
             nameUnderscore = joinSubName(g, m, False)
-            typeC = m.typeC
-            result = "result"
-
-            print("""// ----------------------------------------------------------------------------
-{1} KartProperties::get{0}() const
-{{
-    return m_cached_characteristic->get{0}();
-}}  // get{0}
-""".format(nameTitle, typeC))
+            lines.append("    X({0:<20} {1:<32} {2})".format(
+                m.typeC + ",", nameTitle + ",", nameUnderscore))
+    print("#define CACHED_CHARACTERISTICS(X) \\")
+    print("\n".join(["{0:<95}\\".format(l) for l in lines[:-1]] +
+                    [lines[-1]]))
 
 def createGetType(groups):
     for g in groups:
@@ -244,8 +248,8 @@ functions = {
     "acgetter": (createAcGetter, "Implement the getters",                                  "karts/abstract_characteristic.cpp"),
     "getType":  (createGetType,  "Implement the getType function",                         "karts/abstract_characteristic.cpp"),
     "getName":  (createGetName,  "Implement the getName function",                         "karts/abstract_characteristic.cpp"),
-    "kpdefs":   (createKpDefs,   "Create the header function definitions for the getters", "karts/kart_properties.hpp"),
-    "kpgetter": (createKpGetter, "Implement the getters",                                  "karts/kart_properties.cpp"),
+    "kpdefs":   (createKpDefs,   "Create the inline getters",                              "karts/kart_properties.hpp"),
+    "cached":   (createCached,   "List the characteristics for the flat cached values",     "karts/cached_characteristic.hpp"),
     "loadXml":  (createLoadXml,  "Code to load the characteristics from an xml file",      "karts/xml_characteristic.cpp"),
 }
 